@@ -0,0 +1,60 @@
+/*
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __AUDIOBUFFERPOOL_HPP__
+#define __AUDIOBUFFERPOOL_HPP__
+
+#include "Buffer.hpp"
+#include "AudioFormat.hpp"
+#include <map>
+#include <tuple>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+/*
+  @desc Recyclable AudioBuffer pool keyed by AudioFormat and the number of samples.
+        The acquired buffer goes back to the pool automatically when the acquirer releases the shared_ptr.
+        Then the steady state processing can reuse the same buffers without heap allocation.
+*/
+class AudioBufferPool
+{
+public:
+  static const int DEFAULT_MAX_BUFFERS_PER_KEY = 8;
+
+protected:
+  typedef std::tuple<int, int, int, int> PoolKey; // encoding, channel, sampling rate, samples
+  std::mutex mMutex;
+  std::map<PoolKey, std::vector<std::shared_ptr<AudioBuffer>>> mPool;
+  int mMaxBuffersPerKey;
+
+public:
+  AudioBufferPool(int nMaxBuffersPerKey = DEFAULT_MAX_BUFFERS_PER_KEY);
+  virtual ~AudioBufferPool();
+
+  /* @desc get unused buffer for the format and the samples
+     @arg format : the AudioFormat of the buffer
+     @arg nSamples : the number of samples of the buffer
+     @arg bClear : true: zero clear the buffer. false: the previous content remains
+     @return AudioBuffer. Note that this is newly allocated (not pooled) one if all of pooled buffers are in use. */
+  std::shared_ptr<AudioBuffer> acquire(AudioFormat format, int nSamples, bool bClear = false);
+  /* @desc get number of pooled buffers (including in-use buffers) */
+  int getPooledBufferCount(void);
+  /* @desc release all of pooled buffers. Note that the in-use buffers are still valid for the acquirer. */
+  void clear(void);
+};
+
+#endif /* __AUDIOBUFFERPOOL_HPP__ */
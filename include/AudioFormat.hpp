@@ -170,11 +170,33 @@ public:
     virtual void onFormatChanged(AudioFormat format){};
   };
 
+protected:
+  // forwards the inner instance's notification to onInnerAudioFormatChanged()
+  class InnerAudioFormatListener : public AudioFormatListener
+  {
+  protected:
+    AudioBase* mpAudioBase;
+  public:
+    InnerAudioFormatListener(AudioBase* pAudioBase):AudioFormatListener(), mpAudioBase(pAudioBase){};
+    virtual ~InnerAudioFormatListener(){};
+    virtual void onFormatChanged(AudioFormat format){ mpAudioBase->onInnerAudioFormatChanged( format ); };
+  };
+
 protected:
   std::vector<std::weak_ptr<AudioFormatListener>> mAudioFormatListerners;
   AudioFormat mPreviousAudioFormat;
+  std::shared_ptr<InnerAudioFormatListener> mpInnerAudioFormatListener;
+  std::weak_ptr<AudioBase> mpInnerAudioBase;
   void notifyAudioFormatChanged(AudioFormat format);
   virtual void setAudioFormatPrimitive(AudioFormat format) = 0;
+  /*
+    @desc for the class whose getAudioFormat() returns the inner sink's / source's format.
+          the inner instance's format change (e.g. set to the inner sink directly) is notified as this instance's change.
+    @arg pInner : the inner instance. nullptr to stop the forwarding.
+  */
+  void setInnerAudioBase(std::shared_ptr<AudioBase> pInner);
+  // called when the inner instance's format is changed. the default notifies it to this instance's listeners.
+  virtual void onInnerAudioFormatChanged(AudioFormat format);
 
 public:
   AudioBase();
@@ -19,14 +19,25 @@
 
 #include "AudioFormat.hpp"
 #include "Buffer.hpp"
+#include "PcmSamplingRateConversionPrimitives.hpp"
+#include <memory>
 
 class AudioFormatAdaptor
 {
+protected:
+  static bool convertPrimitive(AudioBuffer& srcBuf, AudioBuffer& dstBuf, std::shared_ptr<PcmSamplingRateConverter>* ppSamplingRateConverter);
+
 public:
   static bool convert(AudioBuffer& srcBuf, AudioBuffer& dstBuf);
+  /*
+    @desc convert with the caller's sampling rate converter to keep the filter state across the buffers of the stream.
+          pSamplingRateConverter is (re-)created if it's nullptr or its configuration is different.
+  */
+  static bool convert(AudioBuffer& srcBuf, AudioBuffer& dstBuf, std::shared_ptr<PcmSamplingRateConverter>& pSamplingRateConverter);
 
   static bool encodingConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, AudioFormat::ENCODING dstEncoding);
   static bool samplingRateConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, int dstSamplingRate);
+  static bool samplingRateConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, int dstSamplingRate, std::shared_ptr<PcmSamplingRateConverter>& pSamplingRateConverter);
   static bool channelConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, AudioFormat::CHANNEL dstChannel);
 };
 
@@ -0,0 +1,70 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __BLOCK_SIZE_ADAPTER_FILTER_HPP__
+#define __BLOCK_SIZE_ADAPTER_FILTER_HPP__
+
+#include "Filter.hpp"
+#include "FifoBuffer.hpp"
+#include "AudioFormat.hpp"
+#include "Buffer.hpp"
+#include <memory>
+
+/*
+  @desc Filter which lets the wrapped filter process by its own window size in the pipe which has the different window size.
+        The received windows are accumulated in the internal FIFO and the wrapped filter is called for each its window.
+        The processed data is output with the minimum delay to output any window without underrun : (filter's window - gcd(pipe's window, filter's window)).
+        e.g. the 7msec filter in the 5msec pipe adds 6msec instead of the 35msec LCM window.
+        Note that the delay is zero if the pipe's window is the multiple of the filter's window.
+*/
+class BlockSizeAdapterFilter : public Filter
+{
+protected:
+  std::shared_ptr<IFilter> mpFilter;
+  int mWindowSizeUsec;
+  AudioFormat mFormat;
+  RingFifoBuffer mInFifo;
+  RingFifoBuffer mOutFifo;
+  std::shared_ptr<AudioBuffer> mpFilterInBuf;
+  std::shared_ptr<AudioBuffer> mpFilterOutBuf;
+
+protected:
+  void reset(AudioFormat format, int nSamples);
+
+public:
+  /*
+    @desc create the adapter
+    @arg pFilter : the filter to be wrapped
+    @arg nWindowSizeUsec : the window size of the pipe which calls this
+  */
+  BlockSizeAdapterFilter(std::shared_ptr<IFilter> pFilter, int nWindowSizeUsec);
+  virtual ~BlockSizeAdapterFilter();
+
+  virtual void process(AudioBuffer& inBuf, AudioBuffer& outBuf);
+  virtual std::vector<AudioFormat> getSupportedAudioFormats(void);
+  virtual int getRequiredWindowSizeUsec(void){ return mWindowSizeUsec; };
+  virtual int getLatencyUSec(void);
+  virtual int getExpectedProcessingUSec(void);
+  virtual int stateResourceConsumption(void);
+  virtual std::string toString(void){ return "BlockSizeAdapterFilter"; };
+
+  std::shared_ptr<IFilter> getFilter(void){ return mpFilter; };
+  /* @desc the delay added by the re-blocking from nWindowSize to nFilterWindowSize. the unit is same as the arguments. */
+  static int getAdditionalLatency(int nWindowSize, int nFilterWindowSize);
+  /* @return true: the filter can't process the window of nWindowSizeUsec directly */
+  static bool isAdapterRequired(int nWindowSizeUsec, int nFilterWindowSizeUsec);
+};
+
+#endif /* __BLOCK_SIZE_ADAPTER_FILTER_HPP__ */
@@ -162,6 +162,44 @@ public:
   AudioBuffer getSelectedChannelData(AudioFormat outAudioFormat, AudioFormat::ChannelMapper& mapper);
 };
 
+/*
+  @desc Precompiled channel remap of AudioBuffer::getSelectedChannelData.
+        The ChannelMapper is resolved once into the source channel index per output channel
+        and then the buffer is copied by the sample size specialized kernel without any per-sample object.
+        The output channel which isn't in the mapper is filled with 0.
+*/
+class ChannelRemapper
+{
+protected:
+  typedef void (*REMAP_FUNC)(const uint8_t* pSrc, uint8_t* pDst, const int* pSrcChannels, int nSrcChannels, int nDstChannels, int nSamples);
+
+  AudioFormat mSrcFormat;
+  AudioFormat mDstFormat;
+  AudioFormat::ChannelMapper mMapper;
+  bool mIsThrough;
+  std::vector<int> mSrcChannels; // source channel index per output channel. -1 means zero
+  REMAP_FUNC mpRemap;
+
+  static REMAP_FUNC getRemapFunc(int nSampleByte, int nDstChannels);
+
+public:
+  ChannelRemapper(AudioFormat srcFormat, AudioFormat dstFormat, AudioFormat::ChannelMapper& mapper);
+  virtual ~ChannelRemapper();
+
+  /* @desc check this is compiled for the specified configuration
+     @return true if it can be used as is */
+  bool isSameConfiguration(AudioFormat srcFormat, AudioFormat dstFormat, AudioFormat::ChannelMapper& mapper);
+  bool isSameConfiguration(AudioFormat srcFormat, AudioFormat dstFormat);
+
+  /* @desc true if the mapper is same as the source's channels. Then process() just copies the buffer */
+  bool isThrough(void){ return mIsThrough; };
+
+  /* @desc apply the channel remap
+     @arg srcBuf : source buffer which has the srcFormat
+     @arg dstBuf : output buffer. This is resized to the srcBuf's number of samples if required */
+  void process(AudioBuffer& srcBuf, AudioBuffer& dstBuf);
+};
+
 /*
   @desc This enables to handle compressed audio
 */
@@ -175,6 +213,9 @@ public:
   CompressAudioBuffer(AudioFormat format = AudioFormat(AudioFormat::ENCODING::COMPRESSED), int nChunkSize = DEFAULT_CHUNK_SIZE);
   CompressAudioBuffer& operator=(CompressAudioBuffer& buf);
 
+  /* @desc restore the chunk size to read the next frame into this instance again. The memory is reused then this doesn't allocate in the steady state. */
+  void resetChunk(void);
+
   /* @desc change AudioFormat. Usually */
   virtual void setAudioFormat( AudioFormat format, bool bForceAndSilent = false );
 
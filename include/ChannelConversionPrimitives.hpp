@@ -18,11 +18,35 @@
 #define __CHANNELCONVERSIONPRIMITIVES_HPP__
 
 #include <stdint.h>
+#include <vector>
 #include "AudioFormat.hpp"
 #include "Buffer.hpp"
+#include "CpuFeature.hpp"
 
 class ChannelConverter
 {
+public:
+  typedef CpuFeature::SIMD SIMD;
+  static constexpr int MAX_CHANNELS = 8;
+
+  /*
+    @desc The precomputed gain matrix to convert the srcChannel to the dstChannel.
+          The output channel is the sum of the gain applied source channels.
+          The gains of each output channel are normalized to sum up to 1.0 at most then the downmix never clips.
+  */
+  struct ChannelMatrix
+  {
+    int nSrcChannels;
+    int nDstChannels;
+    std::vector<float> gains; // [dst channel][src channel]
+    std::vector<float> columns; // [src channel][MAX_CHANNELS] : the gains to the output channels for the kernels
+    bool bRouting; // true if each output channel is just a copy of one source channel (or silent)
+    AudioFormat::ChannelMapper mapper; // valid if bRouting is true
+
+    ChannelMatrix():nSrcChannels(0), nDstChannels(0), bRouting(true){};
+    float getGain(int nDstChannel, int nSrcChannel) const { return gains[ nDstChannel * nSrcChannels + nSrcChannel ]; };
+  };
+
 protected:
   struct ChannelMapList
   {
@@ -32,8 +56,31 @@ protected:
   };
 
   static std::vector<ChannelConverter::ChannelMapList> getChannelConversionMapList(AudioFormat::CHANNEL srcChannel, AudioFormat::CHANNEL dstChannel);
+  static float getDownmixGain(AudioFormat::CH srcCh, AudioFormat::CH dstCh);
+  static ChannelMatrix createChannelMatrix(AudioFormat::CHANNEL srcChannel, AudioFormat::CHANNEL dstChannel);
 
 public:
+  /* @desc get the kernel set in use. it's chosen once by the detected cpu features */
+  static SIMD getSimd(void);
+  /*
+    @desc override the kernel set such as for the comparison
+    @return false if the running cpu doesn't support it
+  */
+  static bool setSimd(SIMD simd);
+
+  /*
+    @desc get the precomputed gain matrix
+    @return nullptr if the conversion isn't supported
+  */
+  static const ChannelMatrix* getChannelMatrix(AudioFormat::CHANNEL srcChannel, AudioFormat::CHANNEL dstChannel);
+
+  /*
+    @desc apply the gain matrix to the interleaved pcm
+    @arg encoding: the pcm encoding of the both pSrc and pDst
+    @arg nSamples: the number of samples (frames)
+  */
+  static bool mix(const uint8_t* pSrc, uint8_t* pDst, AudioFormat::ENCODING encoding, const ChannelMatrix& matrix, int nSamples);
+
   static bool channelConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, AudioFormat::CHANNEL dstChannel);
 };
 
@@ -25,6 +25,8 @@ class ChannelDemuxer
 public:
   static std::vector<std::shared_ptr<AudioBuffer>> perChannelDemux(std::shared_ptr<AudioBuffer> pSrcBuffer);
   static std::vector<std::shared_ptr<AudioBuffer>> perChannelDemux(std::shared_ptr<AudioBuffer> pSrcBuffer, std::vector<std::vector<AudioFormat::CH>> channels);
+  /* @desc demux into pOutBufs. the buffer is allocated only when it's missing or the format differs and resized only when the number of samples differs */
+  static void perChannelDemux(AudioBuffer& srcBuffer, const std::vector<std::vector<AudioFormat::CH>>& channels, std::vector<std::shared_ptr<AudioBuffer>>& pOutBufs);
 };
 
 #endif /* __CHANNELDEMULTIPLEXER_HPP__ */
\ No newline at end of file
@@ -25,6 +25,12 @@ class ChannelMuxer
 public:
   static std::shared_ptr<AudioBuffer> perChannelMux(std::vector<std::shared_ptr<AudioBuffer>> pSrcBufs, AudioFormat::CHANNEL outChannel);
   static std::shared_ptr<AudioBuffer> perChannelMux(std::vector<std::shared_ptr<AudioBuffer>> pSrcBufs, std::vector<std::vector<AudioFormat::CH>> channels, AudioFormat::CHANNEL outChannel);
+  /*
+    @desc mux into outBuf. it's reallocated only when the format differs and resized only when the number of samples differs.
+          the channels which aren't in channels are kept as-is.
+    @return false if pSrcBufs don't match channels or have the different encoding or size
+  */
+  static bool perChannelMux(const std::vector<std::shared_ptr<AudioBuffer>>& pSrcBufs, const std::vector<std::vector<AudioFormat::CH>>& channels, AudioFormat::CHANNEL outChannel, AudioBuffer& outBuf);
 };
 
 #endif /* __CHANNELMULTIPLEXER_HPP__ */
\ No newline at end of file
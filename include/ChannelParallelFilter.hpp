@@ -0,0 +1,68 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __CHANNEL_PARALLEL_FILTER_HPP__
+#define __CHANNEL_PARALLEL_FILTER_HPP__
+
+#include "Filter.hpp"
+#include "AudioFormat.hpp"
+#include "Buffer.hpp"
+#include "ThreadPoolExecutor.hpp"
+#include <vector>
+#include <memory>
+
+/*
+  @desc Filter which runs the channel independent filters for the channel groups in parallel.
+        The window is split into the channel groups by ChannelDemuxer and each group is processed by own filter instance on ThreadPoolExecutor.
+        Then the results are interleaved again by ChannelMuxer. process() returns after all of the groups are processed.
+        The calling thread also processes the groups then this works even if it's called on the same executor's worker.
+        Note that the wrapped filter receives the group's format (e.g. the 2ch group is CHANNEL_STEREO) instead of the original format.
+*/
+class ChannelParallelFilter : public Filter
+{
+protected:
+  AudioFormat mAudioFormat;
+  std::vector<std::shared_ptr<IFilter>> mFilters;
+  std::vector<std::vector<AudioFormat::CH>> mChannelGroups;
+  std::shared_ptr<ThreadPoolExecutor> mpExecutor;
+  // the per-group windows. they're reallocated only when the format or the size changes.
+  std::vector<std::shared_ptr<AudioBuffer>> mpGroupInBufs;
+  std::vector<std::shared_ptr<AudioBuffer>> mpGroupOutBufs;
+
+public:
+  /*
+    @desc create the filter
+    @arg audioFormat : the interleaved pcm format to be processed
+    @arg filters : the filter instance per channel group. The channels are divided into filters.size() groups in the interleaved order.
+    @arg pExecutor : the executor to run the groups. nullptr: ThreadPoolExecutor::getDefaultExecutor()
+  */
+  ChannelParallelFilter(AudioFormat audioFormat, std::vector<std::shared_ptr<IFilter>> filters, std::shared_ptr<ThreadPoolExecutor> pExecutor = nullptr);
+  virtual ~ChannelParallelFilter();
+
+  virtual void process(AudioBuffer& inBuf, AudioBuffer& outBuf);
+  virtual std::vector<AudioFormat> getSupportedAudioFormats(void);
+  virtual int getRequiredWindowSizeUsec(void);
+  virtual int getLatencyUSec(void);
+  virtual int getExpectedProcessingUSec(void);
+  virtual int stateResourceConsumption(void);
+  virtual std::string toString(void){ return "ChannelParallelFilter"; };
+
+  std::vector<std::vector<AudioFormat::CH>> getChannelGroups(void){ return mChannelGroups; };
+  /* @desc divide the format's channels into the nGroups contiguous groups in the interleaved order */
+  static std::vector<std::vector<AudioFormat::CH>> getChannelGroups(AudioFormat audioFormat, int nGroups);
+};
+
+#endif /* __CHANNEL_PARALLEL_FILTER_HPP__ */
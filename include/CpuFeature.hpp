@@ -0,0 +1,34 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __CPUFEATURE_HPP__
+#define __CPUFEATURE_HPP__
+
+class CpuFeature
+{
+public:
+  enum SIMD {
+    SCALAR,
+    SSE2,
+    AVX2
+  };
+
+  /* @desc the best SIMD instruction set of the running cpu. this is detected once. */
+  static SIMD getSimd(void);
+  static bool isSimdSupported(SIMD simd);
+};
+
+#endif /* __CPUFEATURE_HPP__ */
@@ -19,17 +19,52 @@
 
 #include "Filter.hpp"
 #include "AudioFormat.hpp"
-#include "FifoBuffer.hpp"
+#include "Buffer.hpp"
 #include <map>
+#include <vector>
 #include <memory>
 
 
+/*
+  @desc Delay lines for the interleaved pcm.
+        Each channel has the preallocated circular buffer of its delay length and the samples are exchanged with it in place.
+        If all of the channels have the same delay, one circular buffer of the frames is used and it's copied by the chunk.
+        Note that this doesn't take any lock. The caller should use this from one thread such as the filter's process().
+*/
+class DelayLine
+{
+protected:
+  int mChannels;
+  int mSampleByte;
+  bool mIsUniform;
+  std::vector<int> mDelaySamples; // per channel. [0] is for all channels if mIsUniform
+  std::vector<int> mPositions;
+  std::vector<ByteBuffer> mLines;
+
+public:
+  /*
+    @desc create the delay lines
+    @arg format: the pcm format of the processed buffer
+    @arg delaySamples: the delay (number of samples) per channel in the interleaved order
+  */
+  DelayLine(AudioFormat format, std::vector<int> delaySamples);
+  virtual ~DelayLine();
+
+  /* @desc delay the nSamples interleaved samples. pSrc and pDst may be same */
+  void process(const uint8_t* pSrc, uint8_t* pDst, int nSamples);
+  /* @desc fill the delay lines with zero */
+  void reset(void);
+
+  static int getDelaySamples(AudioFormat format, int delayUsec);
+};
+
+
 class DelayFilter : public Filter
 {
 protected:
   int mWindowSize;
   AudioFormat mAudioFormat;
-  std::shared_ptr<FifoBuffer> mpDelayBuf;
+  std::shared_ptr<DelayLine> mpDelayLine;
 
   static const int DEFAULT_PROCESSING_TIME_USEC = 100; // 0.1msec
 
@@ -50,13 +85,10 @@ public:
 
 protected:
   ChannelDelay mChannelDelay;
-  std::map<AudioFormat::CH, std::shared_ptr<FifoBuffer>> mDelayBuf;
 
 public:
   PerChannelDelayFilter(AudioFormat audioFormat, ChannelDelay channelDelay);
   virtual ~PerChannelDelayFilter();
-
-  virtual void process(AudioBuffer& inBuf, AudioBuffer& outBuf);
 };
 
 
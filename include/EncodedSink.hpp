@@ -21,6 +21,7 @@
 #include "Buffer.hpp"
 #include "Encoder.hpp"
 #include "Decoder.hpp"
+#include "PcmSamplingRateConversionPrimitives.hpp"
 #include <memory>
 
 class EncodedSink : public ISink
@@ -30,6 +31,8 @@ protected:
   bool mbTranscode;
   std::shared_ptr<IMediaCodec> mpDecoder;
   std::shared_ptr<IMediaCodec> mpEncoder;
+  // keeps the filter state across the written buffers for the PCM to PCM conversion
+  std::shared_ptr<PcmSamplingRateConverter> mpSamplingRateConverter;
 
 protected:
   virtual void ensureTranscoder(AudioFormat srcFormat, AudioFormat dstFormat);
@@ -23,8 +23,9 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <vector>
 
-class FifoBufferBase : public IUnlockable, public AudioBase
+class FifoBufferBase : public IUnlockable, public IReadyNotifier, public AudioBase
 {
 protected:
   AudioFormat mFormat;
@@ -34,20 +35,38 @@ protected:
   std::condition_variable mReadBlockEvent;
   std::mutex mReadBlockEventMutex;
   std::atomic<bool> mReadBlocked;
-  std::atomic<bool> mUnlockReadBlock;
+  // unlock() advances this. the blocking call which started before that returns instead of waiting. the later call blocks as usual.
+  std::atomic<uint64_t> mUnlockGeneration;
+  // one-shot listeners of IReadyNotifier
+  std::mutex mReadyListenerMutex;
+  std::function<void(void)> mReadReadyListener;
+  std::function<void(void)> mWriteReadyListener;
+  std::atomic<bool> mHasReadReadyListener;
+  std::atomic<bool> mHasWriteReadyListener;
 
 protected:
   FifoBufferBase(AudioFormat format = AudioFormat());
   virtual ~FifoBufferBase();
   void setAudioFormatPrimitive(AudioFormat format);
+  // should be called after the written data becomes readable / after the read data's space becomes writable
+  void notifyReadReady(void);
+  void notifyWriteReady(void);
+  // wake up the blocked read. the derived class should wake up its blocked write as well.
+  void advanceUnlockGeneration(void);
+  bool isUnlocked(uint64_t nUnlockGeneration){ return mUnlockGeneration.load() != nUnlockGeneration; };
 
 public:
   int getBufferedSamples(void);
-  int getBufferedBytes(void);
+  virtual int getBufferedBytes(void);
   void setFifoSizeLimit(int nSampleLimit);
   AudioFormat getAudioFormat(void){ return mFormat; };
-  void clearBuffer(void);
+  virtual void clearBuffer(void);
   virtual bool isAvailableFormat(AudioFormat format){ return true; };
+
+  virtual bool isReadReady(int nBytes){ return getBufferedBytes() >= nBytes; };
+  virtual bool isWriteReady(int nBytes){ return true; };
+  virtual void setReadReadyListener(std::function<void(void)> listener);
+  virtual void setWriteReadyListener(std::function<void(void)> listener);
 };
 
 class FifoBuffer : public FifoBufferBase
@@ -56,7 +75,6 @@ protected:
   std::condition_variable mWriteBlockEvent;
   std::mutex mWriteBlockEventMutex;
   std::atomic<bool> mWriteBlocked;
-  std::atomic<bool> mUnlockWriteBlock;
 
 public:
   FifoBuffer(AudioFormat format = AudioFormat());
@@ -65,6 +83,108 @@ public:
   bool read(IAudioBuffer& audioBuf);
   bool write(IAudioBuffer& audioBuf);
   virtual void unlock(void);
+  virtual bool isWriteReady(int nBytes);
+};
+
+/*
+  @desc Ring buffer for single producer and single consumer.
+        read() and write() don't take any lock in the steady state and the waiting side is woken up only if it's actually blocked.
+        Note that only one thread may call write() and only one thread may call read().
+        The ring capacity is setFifoSizeLimit()'s size and it's extended only if the written buffer and the read request don't fit in it.
+        The limit is the soft limit as FifoBuffer. The writer waits only while the buffered data is under the limit, otherwise the ring is extended.
+*/
+class RingFifoBuffer : public FifoBufferBase
+{
+public:
+  static const int CACHE_LINE_SIZE = 64;
+
+protected:
+  // producer side
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> mWritePos;
+  // consumer side
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> mReadPos;
+  std::atomic<int> mReadRequestSize;
+  std::atomic<bool> mReading;
+  // ring extension (producer) and the blocking
+  alignas(CACHE_LINE_SIZE) std::atomic<bool> mResizing;
+  // serializes the ring replacement by the producer and the clear by the other threads. both exclude the consumer by mResizing.
+  std::mutex mRingControlMutex;
+  std::condition_variable mWriteBlockEvent;
+  std::mutex mWriteBlockEventMutex;
+  std::atomic<bool> mWriteBlocked;
+
+protected:
+  void resizeRing(int nCapacity);
+  void excludeReader(void);
+  void copyToRing(uint64_t nPos, uint8_t* pSrc, int nSize);
+  void copyFromRing(uint64_t nPos, uint8_t* pDst, int nSize);
+  void notifyReader(void);
+  void notifyWriter(void);
+
+public:
+  RingFifoBuffer(AudioFormat format = AudioFormat());
+  virtual ~RingFifoBuffer();
+
+  bool read(IAudioBuffer& audioBuf);
+  bool write(IAudioBuffer& audioBuf);
+  virtual int getBufferedBytes(void);
+  virtual void clearBuffer(void);
+  virtual void unlock(void);
+  virtual bool isWriteReady(int nBytes);
+  int getCapacity(void){ return mBuf.size(); };
+};
+
+/*
+  @desc Queue of written buffers for single producer and single consumer.
+        write(buf, true) and read(buf, true) exchange the buffer's memory with the queued slot instead of copying it.
+        Then a buffer goes through this without any copy if the both sides use the same buffer size.
+        Otherwise read() copies from the queued slots. The memory given back by the consumer is reused by the producer.
+        Note that only one thread may call write() and only one thread may call read().
+*/
+class HandoffFifoBuffer : public FifoBufferBase
+{
+public:
+  static const int CACHE_LINE_SIZE = 64;
+  static const int DEFAULT_SLOTS = 4;
+
+protected:
+  std::vector<ByteBuffer> mSlots;
+  // producer side
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> mWriteSlot;
+  std::atomic<int64_t> mWrittenBytes;
+  // consumer side
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> mReadSlot;
+  std::atomic<int64_t> mReadBytes;
+  int mReadOffset;
+  // blocking
+  std::condition_variable mWriteBlockEvent;
+  std::mutex mWriteBlockEventMutex;
+  std::atomic<bool> mWriteBlocked;
+
+protected:
+  void releaseReadSlot(uint64_t nReadSlot);
+  void notifyReader(void);
+  void notifyWriter(void);
+
+public:
+  HandoffFifoBuffer(AudioFormat format = AudioFormat(), int nSlots = DEFAULT_SLOTS);
+  virtual ~HandoffFifoBuffer();
+
+  /*
+    @desc read the audioBuf's size data.
+    @arg bHandoff true: take the queued memory if the size is same. audioBuf's previous memory is given back to the producer.
+  */
+  bool read(IAudioBuffer& audioBuf, bool bHandoff = false);
+  /*
+    @desc write the audioBuf.
+    @arg bHandoff true: queue the audioBuf's memory itself. audioBuf holds a recycled memory (same size, undefined content) after this.
+  */
+  bool write(IAudioBuffer& audioBuf, bool bHandoff = false);
+  virtual int getBufferedBytes(void);
+  virtual void clearBuffer(void);
+  virtual void unlock(void);
+  virtual bool isWriteReady(int nBytes);
+  int getNumberOfSlots(void){ return mSlots.size(); };
 };
 
 #endif /* __FIFOBUFFER_HPP__ */
\ No newline at end of file
@@ -0,0 +1,107 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __GRAPH_PIPE_HPP__
+#define __GRAPH_PIPE_HPP__
+
+#include "Pipe.hpp"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <utility>
+
+/*
+  @desc Pipe which processes the filters as the DAG in one thread instead of the linear chain.
+        A filter's output can be connected to several filters (fan-out) and the several outputs connected to a filter or the sink are mixed (fan-in).
+        The filters are called in the topological order and the intermediate buffers are reused after their last reader (e.g. the crossover + per band processing + recombine needs 3 buffers).
+        addFilterToHead/Tail(), addFilterAfterFilter() and removeFilter() edit the graph as the linear chain then this works as Pipe unless connect() is used.
+        The initial graph connects the source to the sink directly. disconnect( nullptr, nullptr ) if the graph shouldn't output the input as is.
+        The updated graph is picked up at the window boundary as Pipe. Note that the block size adapter mode isn't applied to the graph.
+*/
+class GraphPipe : public Pipe
+{
+public:
+  // nullptr in connect() / disconnect() means the source (pFrom) or the sink (pTo)
+  typedef std::pair<std::shared_ptr<IFilter>, std::shared_ptr<IFilter>> Edge;
+  static const int SOURCE_SLOT = 0; // the buffer which is read from the source
+
+protected:
+  struct Step
+  {
+    std::shared_ptr<IFilter> pFilter;
+    std::vector<int> inSlots; // mixed into inSlot if the filter has several inputs
+    int inSlot;
+    int outSlot;
+  };
+  // the immutable schedule of the graph which is published with the flat filter chain
+  struct Schedule
+  {
+    std::shared_ptr<const FilterChain> pFilters;
+    std::vector<Step> steps;
+    std::vector<int> sinkInSlots; // empty: silence
+    int sinkSlot;
+    int nSlots;
+  };
+
+  // the graph. these are guarded by mMutexFilters.
+  std::vector<std::shared_ptr<IFilter>> mNodes;
+  std::vector<Edge> mEdges;
+  std::shared_ptr<const Schedule> mpSchedule; // accessed by std::atomic_load() / std::atomic_exchange()
+  std::shared_ptr<const Schedule> mpRetiredSchedule;
+  // the processing context's state
+  std::shared_ptr<const Schedule> mpProcessingSchedule;
+  std::vector<std::shared_ptr<AudioBuffer>> mSlotBuffers;
+  std::vector<const uint8_t*> mMixInputs;
+
+protected:
+  virtual std::shared_ptr<AudioBuffer> processFilters(const FilterChain& filters, std::shared_ptr<AudioBuffer>& pInBuf, std::shared_ptr<AudioBuffer>& pOutBuf);
+  std::shared_ptr<const Schedule> getProcessingSchedule(const FilterChain& filters);
+  void mixSlots(const std::vector<int>& inSlots, int nOutSlot);
+  // should be called with mMutexFilters
+  bool isNodeIncludedLocked(std::shared_ptr<IFilter> pFilter);
+  bool isConnectedLocked(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo);
+  bool isReachableLocked(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo);
+  void addNodeLocked(std::shared_ptr<IFilter> pFilter);
+  void publishGraphLocked(void);
+  std::shared_ptr<const Schedule> createScheduleLocked(void);
+
+public:
+  GraphPipe();
+  virtual ~GraphPipe();
+
+  virtual void addFilterToHead(std::shared_ptr<IFilter> pFilter);
+  virtual void addFilterToTail(std::shared_ptr<IFilter> pFilter);
+  virtual bool addFilterAfterFilter(std::shared_ptr<IFilter> pFilter, std::shared_ptr<IFilter> pPosition);
+  /* @desc remove the filter and connect its inputs to its outputs directly */
+  virtual bool removeFilter(std::shared_ptr<IFilter> pFilter);
+  virtual void clearFilters(void);
+  virtual void dump(void);
+
+  /*
+    @desc connect pFrom's output to pTo's input. The filter which isn't in the graph is added.
+    @arg pFrom : nullptr means the source
+    @arg pTo : nullptr means the sink
+    @return false if the connection exists already or it makes the cycle
+  */
+  bool connect(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo);
+  /* @desc disconnect the connection. the filters are kept in the graph. */
+  bool disconnect(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo);
+  std::vector<Edge> getConnections(void);
+  /* @desc the number of the window buffers which the current graph needs including the source's one */
+  int getNumberOfBuffers(void);
+};
+
+#endif /* __GRAPH_PIPE_HPP__ */
@@ -23,11 +23,24 @@
 #include "Sink.hpp"
 #include "Source.hpp"
 #include <string>
+#include <atomic>
 
-class InterPipeBridge : public ISource, public ISink, public IUnlockable
+#ifndef USE_RING_FIFO_BUFFER_IN_INTERPIPEBRIDGE
+#define USE_RING_FIFO_BUFFER_IN_INTERPIPEBRIDGE 1
+#endif /* USE_RING_FIFO_BUFFER_IN_INTERPIPEBRIDGE */
+
+class InterPipeBridge : public ISource, public ISink, public IUnlockable, public IBufferHandoff, public IReadyNotifier
 {
 protected:
+#if USE_RING_FIFO_BUFFER_IN_INTERPIPEBRIDGE
+  // the writer pipe and the reader pipe are only one respectively then lock-free SPSC ring buffer is usable
+  RingFifoBuffer mFifoBuffer;
+#else
   FifoBuffer mFifoBuffer;
+#endif /* USE_RING_FIFO_BUFFER_IN_INTERPIPEBRIDGE */
+  // used instead of mFifoBuffer in the handoff mode
+  HandoffFifoBuffer mHandoffFifoBuffer;
+  std::atomic<bool> mHandoffEnabled;
   int mRequiredResource;
 
 protected:
@@ -37,17 +50,35 @@ protected:
 
 public:
   InterPipeBridge(AudioFormat format = AudioFormat());
-  virtual ~InterPipeBridge(){ mFifoBuffer.unlock(); };
+  virtual ~InterPipeBridge(){ unlock(); };
   virtual bool isAvailableFormat(AudioFormat format){ return true; };
 
   virtual void dump(void){};
   virtual std::string toString(void){return "InterPipeBridge";};
 
   virtual AudioFormat getAudioFormat(void);
+  // ISource and ISink have own AudioBase. The ISink side's one handles the format and the listeners then the set through either side notifies the both sides' listeners once.
+  virtual bool setAudioFormat(AudioFormat format){ return ISink::setAudioFormat( format ); };
+  virtual void registerAudioFormatListener(std::shared_ptr<AudioFormatListener> listener){ ISink::registerAudioFormatListener( listener ); };
+  virtual void unregisterAudioFormatListener(std::shared_ptr<AudioFormatListener> listener){ ISink::unregisterAudioFormatListener( listener ); };
 
-  virtual void unlock(void){ mFifoBuffer.unlock(); };
+  virtual void unlock(void);
   virtual int stateResourceConsumption(void);
   virtual void setRequiredResourceConsumption(int nRequiredResource);
+
+  /*
+    @desc enable the handoff mode. the written buffer's memory is passed to the reader by writeHandoff() and readHandoff().
+          Note that this should be called before the writer and the reader start.
+  */
+  void setHandoffEnabled(bool bEnabled);
+  bool getHandoffEnabled(void){ return mHandoffEnabled; };
+  virtual bool writeHandoff(IAudioBuffer& buf);
+  virtual bool readHandoff(IAudioBuffer& buf);
+
+  virtual bool isReadReady(int nBytes);
+  virtual bool isWriteReady(int nBytes);
+  virtual void setReadReadyListener(std::function<void(void)> listener);
+  virtual void setWriteReadyListener(std::function<void(void)> listener);
 };
 
 #endif /* __INTERPIPEBRIDGE_HPP__ */
\ No newline at end of file
@@ -18,15 +18,26 @@
 #define __MIXER_HPP__
 
 #include "Buffer.hpp"
+#include "AudioBufferPool.hpp"
 #include <vector>
+#include <span>
 
 class Mixer
 {
-public:
-  static bool process( std::vector<std::shared_ptr<AudioBuffer>> pInBuffers, std::shared_ptr<AudioBuffer> pOutBuffer );
 protected:
-  static bool doMix( std::vector<std::shared_ptr<AudioBuffer>> pInBuffers, std::shared_ptr<AudioBuffer> pOutBuffer );
-  static bool doMixPrimitive( std::shared_ptr<AudioBuffer> pInBuffer1, std::shared_ptr<AudioBuffer> pInBuffer2, std::shared_ptr<AudioBuffer> pOutBuffer );
+  static inline AudioBufferPool mBufferPool;
+  // reused by the legacy overload per thread not to allocate them per call
+  static inline thread_local std::vector<const uint8_t*> mRawInBuffers;
+  static inline thread_local std::vector<std::shared_ptr<AudioBuffer>> mConvertedBuffers;
+
+public:
+  /* @desc mix the pInBuffers into pOutBuffer's format. the different format inputs are converted before the mix. */
+  static bool process( const std::vector<std::shared_ptr<AudioBuffer>>& pInBuffers, std::shared_ptr<AudioBuffer> pOutBuffer );
+  /*
+    @desc mix the raw buffers in one pass without the intermediate saturation.
+    @arg pRawInBuffers the buffers which have the format and nSamples. pRawOutBuffer may be one of them.
+  */
+  static bool process( std::span<const uint8_t* const> pRawInBuffers, AudioFormat format, uint8_t* pRawOutBuffer, int nSamples );
 };
 
 #endif /* __MIXER_HPP__ */
\ No newline at end of file
@@ -18,15 +18,39 @@
 #define __MIXER_PRIMITIVE_HPP__
 
 #include <stdint.h>
+#include <span>
+#include "CpuFeature.hpp"
 
 class MixerPrimitive
 {
 public:
+  typedef CpuFeature::SIMD SIMD;
+
+  /* @desc the saturating mix. the best kernel for the running cpu is used. */
   static bool mix( int8_t* pRawInBuf1, int8_t* pRawInBuf2, int8_t* pRawOutBuf, int nChannelSamples);
   static bool mix( int16_t* pRawInBuf1, int16_t* pRawInBuf2, int16_t* pRawOutBuf, int nChannelSamples);
   static bool mix( int32_t* pRawInBuf1, int32_t* pRawInBuf2, int32_t* pRawOutBuf, int nChannelSamples);
   static bool mix( float* pRawInBuf1, float* pRawInBuf2, float* pRawOutBuf, int nChannelSamples);
   static bool mix24( int8_t* pRawInBuf1, int8_t* pRawInBuf2, int8_t* pRawOutBuf, int nChannelSamples);
+
+  /*
+    @desc the N-way mix in one pass. all the inputs are accumulated by the wider type and saturated once.
+    @arg pRawInBufs the input buffers which have nChannelSamples. pRawOutBuf may be one of them.
+  */
+  static bool mix( std::span<const int8_t* const> pRawInBufs, int8_t* pRawOutBuf, int nChannelSamples);
+  static bool mix( std::span<const int16_t* const> pRawInBufs, int16_t* pRawOutBuf, int nChannelSamples);
+  static bool mix( std::span<const int32_t* const> pRawInBufs, int32_t* pRawOutBuf, int nChannelSamples);
+  static bool mix( std::span<const float* const> pRawInBufs, float* pRawOutBuf, int nChannelSamples);
+  static bool mix24( std::span<const int8_t* const> pRawInBufs, int8_t* pRawOutBuf, int nChannelSamples);
+
+  /* @desc get the kernel set in use. it's chosen once by the detected cpu features */
+  static SIMD getSimd(void);
+  static bool isSimdSupported(SIMD simd);
+  /*
+    @desc override the kernel set such as for the comparison
+    @return false if the running cpu doesn't support it
+  */
+  static bool setSimd(SIMD simd);
 };
 
 #endif /* __MIXER_PRIMITIVE_HPP__ */
\ No newline at end of file
@@ -28,7 +28,9 @@
 #include <atomic>
 #include <thread>
 #include <map>
+#include <set>
 #include <memory>
+#include <condition_variable>
 
 class MixerSplitter : public ThreadBase
 {
@@ -90,16 +92,45 @@ protected:
     SourceSinkConditionMapper(std::shared_ptr<ISink> srcSink, std::shared_ptr<ISink> dstSink, std::shared_ptr<MapCondition> argCondition):SourceSinkMapper(srcSink, dstSink), condition(argCondition){};
     virtual ~SourceSinkConditionMapper(){};
   };
+  // posts the change of the sink adaptor's pipe run state and the sink adaptor's format
+  class SourceChangeListener : public ThreadBase::RunnerListener, public AudioBase::AudioFormatListener
+  {
+  protected:
+    MixerSplitter* mpMixerSplitter;
+    std::weak_ptr<ISink> mpSource;
+  public:
+    SourceChangeListener(MixerSplitter* pMixerSplitter, std::shared_ptr<ISink> pSource):mpMixerSplitter(pMixerSplitter), mpSource(pSource){};
+    virtual ~SourceChangeListener(){};
+    virtual void onRunnerStatusChanged(bool bRunning);
+    virtual void onFormatChanged(AudioFormat format);
+  };
+  // posts the change of the sink's format
+  class SinkChangeListener : public AudioBase::AudioFormatListener
+  {
+  protected:
+    MixerSplitter* mpMixerSplitter;
+    std::weak_ptr<ISink> mpSink;
+  public:
+    SinkChangeListener(MixerSplitter* pMixerSplitter, std::shared_ptr<ISink> pSink):mpMixerSplitter(pMixerSplitter), mpSink(pSink){};
+    virtual ~SinkChangeListener(){};
+    virtual void onFormatChanged(AudioFormat format);
+  };
 
 protected:
   std::mutex mMutexSourceSink;
   std::vector<std::shared_ptr<ISink>> mpSinks;
+  std::map<std::shared_ptr<ISink>, std::shared_ptr<SinkChangeListener>> mpSinkListeners;
   std::vector<std::shared_ptr<ISink>> mpSources;
-  std::map<std::shared_ptr<ISink>, std::shared_ptr<AudioFormat>> mpSourceAudioFormats;
   std::map<std::shared_ptr<ISink>, std::weak_ptr<IPipe>> mpSourcePipes;
+  std::map<std::shared_ptr<ISink>, std::shared_ptr<SourceChangeListener>> mpSourceListeners;
   std::vector<std::shared_ptr<SourceSinkConditionMapper>> mSourceSinkMapper;
   std::map<std::shared_ptr<ISink>, std::shared_ptr<PipeMixer>> mpMixers;
-  std::atomic<bool> mbOnChanged;
+  // the change events. the sink's PipeMixer is updated. the source's change is resolved to the mapped sinks.
+  std::mutex mMutexEvent;
+  std::condition_variable mEvent;
+  std::set<std::shared_ptr<ISink>> mChangedSinks;
+  std::set<std::shared_ptr<ISink>> mChangedSources;
+  bool mbAllChanged;
 
 protected:
   virtual void process(void);
@@ -110,7 +141,19 @@ protected:
   std::shared_ptr<SourceSinkMapper> getSourceSinkMapperLocked(std::shared_ptr<ISink> pSource);
   bool removeMapperLocked(std::shared_ptr<ISink> srcSink);
   bool isPipeRunningOrNotRegistered(std::shared_ptr<ISink> srcSink);
-  bool isSituationChanged(void);
+  void postSinkChanged(std::shared_ptr<ISink> pSink);
+  void postSourceChanged(std::shared_ptr<ISink> pSource);
+  void postAllChanged(void);
+  void postMappedSinksChangedLocked(std::shared_ptr<ISink> pSource);
+  // @return true if there is the change. bWait: true: block until the change or the stop
+  bool takeChangedSinks(std::set<std::shared_ptr<ISink>>& outSinks, bool bWait);
+  void updateMixers(std::set<std::shared_ptr<ISink>>& sinks);
+  void updateMixerLocked(std::shared_ptr<ISink> pSink);
+  void stopMixers(void);
+  // the pull scheduler mode. this updates the mixers per the period and the mixers are run by the same scheduler.
+  virtual bool isStepSupported(void){ return mpPullScheduler != nullptr; };
+  virtual STEP_RESULT processStep(void);
+  virtual void finalizeStep(void);
 
 public:
   MixerSplitter();
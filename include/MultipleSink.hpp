@@ -35,10 +35,14 @@ protected:
   std::map<std::shared_ptr<ISink>, AudioFormat::ChannelMapper> mChannelMaps;
   AudioFormat mFormat;
   std::map<std::shared_ptr<ISink>, std::shared_ptr<DelayFilter>> mpDelayFilters;
+  std::map<std::shared_ptr<ISink>, std::shared_ptr<ChannelRemapper>> mpChannelRemappers;
+  std::map<std::shared_ptr<ISink>, std::shared_ptr<AudioBuffer>> mpSinkBuffers;
   int mMaxLatency;
   bool mbSupportedFormatsOpOR;
 
   void ensureDelayFiltersLocked(bool bForceRecreate = false);
+  std::shared_ptr<ChannelRemapper> getChannelRemapperLocked(std::shared_ptr<ISink> pSink, AudioFormat srcFormat, AudioFormat sinkFormat);
+  std::shared_ptr<AudioBuffer> getSinkBufferLocked(std::shared_ptr<ISink> pSink, AudioFormat sinkFormat);
   std::vector<float> getPerSinkChannelVolumesLocked(std::shared_ptr<ISink> pSink, Volume::CHANNEL_VOLUME perChannelVolumes);
   virtual int getLatencyUSecLocked(void);
   virtual void setAudioFormatPrimitive(AudioFormat format);
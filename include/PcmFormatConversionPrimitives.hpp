@@ -18,10 +18,21 @@
 #define __PCMFORMATCONVERSIONPRIMITIVES_HPP__
 
 #include <stdint.h>
+#include "CpuFeature.hpp"
 
 class PcmFormatConvert
 {
 public:
+  typedef CpuFeature::SIMD SIMD;
+
+  /* @desc get the kernel set in use. it's chosen once by the detected cpu features */
+  static SIMD getSimd(void);
+  /*
+    @desc override the kernel set such as for the comparison
+    @return false if the running cpu doesn't support it
+  */
+  static bool setSimd(SIMD simd);
+
   // from Pcm8
   static void convertPcm8ToPcm16(uint8_t* pSrc, uint16_t* pDst, int nSamples = 1);
   static void convertPcm8ToPcm24(uint8_t* pSrc, uint8_t* pDst, int nSamples = 1);
@@ -18,6 +18,9 @@
 #define __PCMSAMPLINGRATECONVERSIONPRIMITIVES_HPP__
 
 #include <stdint.h>
+#include <vector>
+#include <memory>
+#include "AudioFormat.hpp"
 
 template<typename T> static bool convert(T* pSrc, T* pDst, int32_t srcRate, int32_t dstRate, int nSamples = 1)
 {
@@ -41,4 +44,64 @@ public:
   static bool convert(float* pSrc, float* pDst, int32_t srcRate, int32_t dstRate, int nSamples = 1);
 };
 
+/*
+  @desc Stateful polyphase windowed-sinc sampling rate converter.
+        The filter history and the phase are kept across convert() then a continuous stream can be converted with any buffer size.
+        The coefficient table is computed once per conversion ratio and shared among the converters of the same ratio.
+        The integer PCMs are handled as the signed samples.
+*/
+class PcmSamplingRateConverter
+{
+public:
+  // the ratio which requires more phases than this (e.g. 44100:44101) isn't available
+  static constexpr int MAX_PHASES = 2048;
+  // the taps per phase for the upsampling. the downsampling uses the longer filter to keep the same transition band.
+  static constexpr int TAPS_PER_PHASE = 64;
+  static constexpr int MAX_TAPS_PER_PHASE = 256;
+
+protected:
+  AudioFormat::ENCODING mEncoding;
+  int mSrcRate;
+  int mDstRate;
+  int mChannels;
+  // the interpolation and the decimation factors
+  int mInterpolation;
+  int mDecimation;
+  int mTaps;
+  // [phase][tap] and the taps are in reversed order to take the dot product with the consecutive input samples
+  std::shared_ptr<const std::vector<float>> mpCoefficients;
+  float (*mDotProduct)(const float* pCoefficients, const float* pSamples, int nTaps);
+
+  // the last (mTaps - 1) input samples per channel
+  std::vector<float> mHistory;
+  // [channel][history + input samples]
+  std::vector<float> mWork;
+  std::vector<float> mOutput;
+  int mPhase;
+  int mNextIndex;
+
+protected:
+  static std::shared_ptr<const std::vector<float>> getCoefficients(int nInterpolation, int nDecimation, int nTaps, int srcRate, int dstRate);
+  void loadInput(const uint8_t* pSrc, int nSrcSamples, int nStride);
+  void storeOutput(uint8_t* pDst, int nDstSamples);
+
+public:
+  PcmSamplingRateConverter(AudioFormat::ENCODING encoding, int srcRate, int dstRate, int nChannels);
+  virtual ~PcmSamplingRateConverter();
+
+  /* @desc false if the encoding or the ratio isn't supported */
+  bool isAvailable(void);
+  bool isSameConfiguration(AudioFormat::ENCODING encoding, int srcRate, int dstRate, int nChannels);
+  /* @desc the upper bound of the output samples of the next convert() with nSrcSamples */
+  int getMaxOutputSamples(int nSrcSamples);
+  /*
+    @desc convert the interleaved nSrcSamples (per channel samples).
+    @arg pDst requires getMaxOutputSamples(nSrcSamples) samples
+    @return the number of the output samples (per channel samples)
+  */
+  int convert(const uint8_t* pSrc, uint8_t* pDst, int nSrcSamples);
+  /* @desc clear the history. use this if the stream is discontinued */
+  void reset(void);
+};
+
 #endif /* __PCMSAMPLINGRATECONVERSIONPRIMITIVES_HPP__ */
\ No newline at end of file
@@ -25,7 +25,14 @@
 #include <mutex>
 #include "ResourceManager.hpp"
 #include "PipeAndFilterCommon.hpp"
+#include "AudioBufferPool.hpp"
+#include "FifoBuffer.hpp"
+#include "BlockSizeAdapterFilter.hpp"
 #include <memory>
+#include <atomic>
+#include <map>
+#include <functional>
+#include <condition_variable>
 
 class IPipe : public ThreadBase, public IResourceConsumer, public IMuteable
 {
@@ -57,14 +64,95 @@ public:
 
 class Pipe : public IPipe
 {
+public:
+  typedef std::vector<std::shared_ptr<IFilter>> FilterChain;
+  static const int IO_PIPELINING_DEPTH = 2; // the windows in flight between the read, the filters and the write
+
 protected:
-  std::mutex mMutexFilters;
+  // invalidates the negotiated format when the source's or the sink's format is changed
+  class FormatChangeListener : public AudioBase::AudioFormatListener
+  {
+  protected:
+    Pipe* mpPipe;
+  public:
+    FormatChangeListener(Pipe* pPipe) : mpPipe(pPipe){};
+    virtual ~FormatChangeListener(){};
+    virtual void onFormatChanged(AudioFormat format){ mpPipe->invalidateNegotiatedFormat(); };
+  };
+  // the read-ahead thread of the I/O pipelining. this reads the source into mReadAheadFifo.
+  class ReadAheadThread : public ThreadBase
+  {
+  protected:
+    Pipe* mpPipe;
+    virtual void process(void);
+    virtual void unlockToStop(void);
+  public:
+    ReadAheadThread(Pipe* pPipe) : ThreadBase(), mpPipe(pPipe){};
+    virtual ~ReadAheadThread(){ stop(); };
+  };
+  // the write-behind thread of the I/O pipelining. this writes mWriteBehindFifo to the sink. stop() lets this write the remaining windows unless the pipe is stopping.
+  class WriteBehindThread : public ThreadBase
+  {
+  protected:
+    Pipe* mpPipe;
+    virtual void process(void);
+    virtual void unlockToStop(void);
+  public:
+    WriteBehindThread(Pipe* pPipe) : ThreadBase(), mpPipe(pPipe){};
+    virtual ~WriteBehindThread(){ stop(); };
+  };
+
+protected:
+  std::mutex mMutexFilters; // serializes the filter chain updates. process() doesn't take this.
   std::mutex mMutexSink;
   std::mutex mMutexSource;
-  std::vector<std::shared_ptr<IFilter>> mFilters;
+  // the immutable snapshot of the filter chain. the update publishes new one and advances mFiltersGeneration.
+  // process() checks the generation per window and loads the snapshot only when it's advanced.
+  // this is accessed by std::atomic_load() / std::atomic_exchange() since std::atomic<std::shared_ptr> isn't available in libc++.
+  std::shared_ptr<const FilterChain> mpFilters;
+  std::atomic<uint64_t> mFiltersGeneration;
+  std::shared_ptr<const FilterChain> mpRetiredFilters; // released by the next update instead of the audio thread
   std::shared_ptr<ISink> mpSink;
   std::shared_ptr<ISource> mpSource;
+  // the sink's / the source's optional interfaces which are resolved by attach instead of the cast per window. nullptr if not supported.
+  IBufferHandoff* mpHandoffSink;
+  IReadyNotifier* mpReadyNotifierSink;
+  IBufferHandoff* mpHandoffSource;
+  IReadyNotifier* mpReadyNotifierSource;
   std::atomic<bool> mFlushRequest;
+  AudioBufferPool mBufferPool;
+  // the executor mode's state which is kept across processStep()
+  std::shared_ptr<const FilterChain> mpStepFilters;
+  uint64_t mStepFiltersGeneration;
+  std::shared_ptr<AudioBuffer> mpStepInBuf;
+  std::shared_ptr<AudioBuffer> mpStepOutBuf;
+  std::shared_ptr<AudioBuffer> mpStepPendingOut; // processed but not written since the sink wasn't ready
+  // the read-ahead and the write-behind of the I/O pipelining
+  std::atomic<bool> mIoPipeliningEnabled;
+  HandoffFifoBuffer mReadAheadFifo;
+  HandoffFifoBuffer mWriteBehindFifo;
+  std::shared_ptr<ReadAheadThread> mpReadAheadThread;
+  std::shared_ptr<WriteBehindThread> mpWriteBehindThread;
+  AudioFormat mIoFormat;
+  int mIoSamples;
+  std::atomic<bool> mReadAheadStopRequest; // the reader finishes after the current window
+  std::atomic<bool> mReadAheadDone;
+  // the fifos' reader waits for the window by this instead of the blocking read then the end is notified without the data
+  std::mutex mMutexIo;
+  std::condition_variable mIoEvent;
+  std::atomic<int> mIoWaiters;
+  // the compressed passthrough's frame buffer which is reused by the processing context
+  CompressAudioBuffer mCompressedBuf;
+  // the block size adapter mode. the adapters are kept per filter across the chain updates and used by the processing context only.
+  std::atomic<bool> mBlockSizeAdapterEnabled;
+  std::map<std::shared_ptr<IFilter>, std::shared_ptr<BlockSizeAdapterFilter>> mBlockSizeAdapters;
+  // the negotiated format which is cached by the processing context. it's invalidated by the source's / the sink's AudioFormatListener, attach / detach and the filter chain update.
+  std::atomic<uint64_t> mFormatGeneration;
+  std::shared_ptr<FormatChangeListener> mpFormatChangeListener;
+  uint64_t mNegotiatedFormatGeneration;
+  bool mNegotiatedPcm;
+  bool mNegotiatedCompressed;
+  AudioFormat mNegotiatedFormat;
 
 public:
   Pipe();
@@ -92,12 +180,64 @@ public:
 
   virtual void stopAndFlush(void);
 
+  /*
+    @desc overlap the source's read of the next window and the sink's write of the previous window with the filters' processing of the current window.
+          The read and the write run on their own threads and getLatencyUSec() includes the additional windows.
+          Note that this should be called before run().
+  */
+  void setIoPipeliningEnabled(bool bEnabled){ mIoPipeliningEnabled = bEnabled; };
+  bool getIoPipeliningEnabled(void){ return mIoPipeliningEnabled; };
+  /*
+    @desc process by the minimum window size of the filters instead of the LCM of them.
+          The filter whose window doesn't fit is called with its own window through BlockSizeAdapterFilter in the same thread.
+          getLatencyUSec() includes the adapters' delay. Note that this should be called before run().
+  */
+  void setBlockSizeAdapterEnabled(bool bEnabled){ mBlockSizeAdapterEnabled = bEnabled; };
+  bool getBlockSizeAdapterEnabled(void){ return mBlockSizeAdapterEnabled; };
+
 protected:
   // Should override process() if you want to support different window size processing by several threads, etc.
   virtual void process(void);
   virtual void unlockToStop(void);
+  // process() with the I/O pipelining. this returns when the filter chain needs the different buffers as well as process()'s loop.
+  void processIoPipelining(std::shared_ptr<const FilterChain> pFilters, uint64_t nFiltersGeneration, int windowSizeUsec, std::shared_ptr<AudioBuffer> pInBuf, std::shared_ptr<AudioBuffer> pOutBuf);
+  // notify the update of the I/O pipelining's fifos and the state. this takes the lock only if someone waits.
+  void notifyIoEvent(void);
+  // @return true: nBytes is buffered in the fifo. false: the wait is ended by bEnd()
+  bool waitIoFifo(HandoffFifoBuffer& fifo, int nBytes, std::function<bool(void)> bEnd);
+  /*
+    @desc process the window which is read in pInBuf by the filters. pInBuf and pOutBuf are swapped as the working buffers.
+          Should override this if you want to process the filters in the different topology (e.g. GraphPipe).
+    @return the buffer to be written to the sink. it's valid until the next call.
+  */
+  virtual std::shared_ptr<AudioBuffer> processFilters(const FilterChain& filters, std::shared_ptr<AudioBuffer>& pInBuf, std::shared_ptr<AudioBuffer>& pOutBuf);
+  // pass a compressed frame from the source to the sink. the source and the sink which support IBufferHandoff exchange the memory instead of copying it.
+  void passThroughCompressed(void);
+  // the executor mode. the source's read and the sink's write wait with IReadyNotifier if they support it.
+  virtual bool isStepSupported(void){ return true; };
+  virtual STEP_RESULT processStep(void);
+  virtual void finalizeStep(void);
+  bool isStepReadReady(int nBytes);
+  bool isStepWriteReady(int nBytes);
+  virtual int getPullPeriodUsec(void){ return getCommonWindowSizeUsec(); };
   // Should override getFilterAudioFormat() if you want to use different algorithm to choose using Audioformat
   int getCommonWindowSizeUsec(void);
+  static int getCommonWindowSizeUsec(const FilterChain& filters);
+  // the window size of the block size adapter mode
+  static int getMinimumWindowSizeUsec(const FilterChain& filters);
+  // the filter chain to be processed. the filters are wrapped by the adapter in the block size adapter mode.
+  std::shared_ptr<const FilterChain> getProcessingFilters(void);
+  std::shared_ptr<const FilterChain> getFilters(void);
+  // the per window check is the atomic load only
+  bool isFormatNegotiationRequired(void){ return mFormatGeneration.load( std::memory_order_acquire ) != mNegotiatedFormatGeneration; };
+  void invalidateNegotiatedFormat(void){ mFormatGeneration.fetch_add( 1, std::memory_order_release ); };
+  /*
+    @desc query the source's / the sink's format and the filters' common format then cache them
+    @return true: pcm processing
+  */
+  bool negotiateFormat(void);
+  // should be called with mMutexFilters
+  void publishFiltersLocked(std::shared_ptr<const FilterChain> pFilters);
   virtual void mutePrimitive(bool bEnableMute, bool bUseZero=false);
 };
 
@@ -21,6 +21,7 @@
 #include "ResourceManager.hpp"
 #include "Volume.hpp"
 #include <string>
+#include <functional>
 
 /* block-able class should implement this */
 class IUnlockable
@@ -30,6 +31,40 @@ public:
   virtual void unlock(void) = 0;
 };
 
+/* block-able class should implement this to be waited without the blocking (e.g. ThreadBase's executor mode) */
+class IReadyNotifier
+{
+public:
+  /* @return true: read() of nBytes doesn't block */
+  virtual bool isReadReady(int nBytes) = 0;
+  /* @return true: write() of nBytes doesn't block */
+  virtual bool isWriteReady(int nBytes) = 0;
+  /*
+    @desc set the listener which is called once when the read might become ready. The listener is called from the writer's thread.
+    @arg listener : nullptr to cancel
+  */
+  virtual void setReadReadyListener(std::function<void(void)> listener) = 0;
+  /* @desc same as setReadReadyListener() for the write. The listener is called from the reader's thread. */
+  virtual void setWriteReadyListener(std::function<void(void)> listener) = 0;
+};
+
+/* buffer ownership transferable class should implement this */
+class IBufferHandoff
+{
+public:
+  /*
+    @desc write the buf by passing the ownership of the buf's memory instead of copying it.
+          buf holds another memory which has the same size after this but the content is undefined.
+    @return true: handed off. false: not handed off then the caller should use the usual write()
+  */
+  virtual bool writeHandoff(IAudioBuffer& buf) = 0;
+  /*
+    @desc read into the buf by taking the ownership of the written memory instead of copying it.
+    @return true: read. false: not read then the caller should use the usual read()
+  */
+  virtual bool readHandoff(IAudioBuffer& buf) = 0;
+};
+
 /* mute-able class should implement this */
 class IMuteable
 {
@@ -27,19 +27,65 @@
 #include <thread>
 #include <map>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 
 class PipeMixer : public ThreadBase
 {
+public:
+  static inline const int MIX_WINDOW_SAMPLES = 256;
+  // the range of the deadline mode's period which is negotiated from the sink's latency
+  static inline const int MIN_MIX_WINDOW_USEC = 1000;
+  static inline const int MAX_MIX_WINDOW_USEC = 10000;
+  enum CONCEALMENT {
+    CONCEAL_ZERO,   // the input which isn't ready is mixed as zero
+    CONCEAL_REPEAT, // the previous window is repeated once then zero
+  };
+
 protected:
   std::mutex mMutexPipe;
   std::vector<std::shared_ptr<InterPipeBridge>> mpInterPipeBridges;
   std::map<std::shared_ptr<InterPipeBridge>, std::weak_ptr<IPipe>> mpPipes;
   AudioFormat mFormat;
   std::shared_ptr<ISink> mpSink;
+  // the step mode's buffers which are kept across processStep()
+  std::vector<std::shared_ptr<AudioBuffer>> mStepBuffers;
+  std::shared_ptr<AudioBuffer> mpStepOutBuf;
+  // the compressed passthrough's frame buffer which is reused across the frames
+  CompressAudioBuffer mCompressedBuf;
+  // the deadline mode
+  std::atomic<bool> mDeadlineMixEnabled;
+  std::atomic<CONCEALMENT> mConcealment;
+  std::map<std::shared_ptr<InterPipeBridge>, int> mUnderrunCounts; // guarded by mMutexPipe
+  std::vector<int> mConsecutiveUnderruns;
+  std::vector<const uint8_t*> mMixInputs;
+  std::mutex mDeadlineMutex;
+  std::condition_variable mDeadlineEvent;
+  bool mDeadlineWakeup;
 
 protected:
   virtual void process(void);
   virtual void unlockToStop(void);
+  /*
+    the executor mode and the pull scheduler mode. this mixes one window per the step.
+    the executor mode waits for the running pipes' data as process(). the pull scheduler mode conceals the not ready data with zero.
+  */
+  virtual bool isStepSupported(void){ return true; };
+  virtual STEP_RESULT processStep(void);
+  virtual void finalizeStep(void);
+  virtual int getPullPeriodUsec(void);
+  virtual std::vector<ThreadBase*> getUpstreamRunners(void);
+  void passThroughCompressed(void);
+  // the deadline mode's loop. the period is negotiated at the beginning. this returns when the inputs or the sink's format is changed.
+  void processDeadline(void);
+  // @return false: the deadline is expired before the all of running inputs become ready
+  bool waitInputsUntil(std::chrono::steady_clock::time_point deadline, int nBytes);
+  void wakeUpDeadlineWait(void);
+  // read the ready inputs and conceal the others with counting the underrun. should be called with mMutexPipe.
+  void readOrConcealInputsLocked(std::vector<std::shared_ptr<AudioBuffer>>& buffers, int nBytes);
+  void mixBuffers(std::vector<std::shared_ptr<AudioBuffer>>& buffers, std::shared_ptr<AudioBuffer> pOutBuf);
+  int getMixWindowSamples(AudioFormat format);
   std::shared_ptr<ISink> getSinkFromPipe(std::shared_ptr<IPipe> pArgPipe);
   bool isPipeRunningOrNotRegistered(std::shared_ptr<InterPipeBridge> srcSink);
   virtual void setAudioFormatPrimitive(AudioFormat audioFormat);
@@ -56,6 +102,18 @@ public:
   virtual std::shared_ptr<ISink> allocateSinkAdaptor(std::shared_ptr<IPipe> pPipe = nullptr);
   virtual void releaseSinkAdaptor(std::shared_ptr<ISink> pSink);
   virtual std::vector<std::shared_ptr<ISink>> getSinkAdaptors(void);
+
+  /*
+    @desc mix the inputs which are ready by the period's deadline instead of waiting for the all inputs. the others are concealed.
+          The period is the sink's getLatencyUSec() within [MIN_MIX_WINDOW_USEC, MAX_MIX_WINDOW_USEC] (MIX_WINDOW_SAMPLES if the sink doesn't report it).
+          Note that this should be called before run().
+  */
+  void setDeadlineMixEnabled(bool bEnabled){ mDeadlineMixEnabled = bEnabled; };
+  bool getDeadlineMixEnabled(void){ return mDeadlineMixEnabled; };
+  void setUnderrunConcealment(CONCEALMENT concealment){ mConcealment = concealment; };
+  CONCEALMENT getUnderrunConcealment(void){ return mConcealment; };
+  /* @return the number of the windows which were concealed since the running pipe's data wasn't ready. -1 if the sink adaptor isn't attached. */
+  int getUnderrunCount(std::shared_ptr<ISink> pSinkAdaptor);
 };
 
 #endif /* __PIPEMIXER_HPP__ */
\ No newline at end of file
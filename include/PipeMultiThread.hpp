@@ -22,9 +22,17 @@
 #include <vector>
 #include <memory>
 
+/*
+  @desc Pipe which runs the filter chain by the pipelined stages. Each stage is Pipe(=thread) and they are joined by InterPipeBridge.
+        By default, the new stage is created when the window size is changed.
+        setNumberOfStages() also partitions the chain to balance the filters' stateResourceConsumption() across the stages.
+        Note that each additional stage adds one window of the latency.
+*/
 class PipeMultiThread : public IPipe
 {
 public:
+  typedef std::vector<std::shared_ptr<IFilter>> FilterChain;
+
   PipeMultiThread();
   virtual ~PipeMultiThread();
 
@@ -54,6 +62,23 @@ public:
   virtual int getLatencyUSec(void);
   virtual int stateResourceConsumption(void);
 
+  /*
+    @desc set the maximum number of the stages(=threads) and re-partition the filter chain by the cost.
+          The running pipe is stopped and restarted during the re-partition.
+    @arg nStages : 0 or 1: split only at the window size change (default).
+                   Note that the stages might be more than nStages if the window size is changed more.
+  */
+  void setNumberOfStages(int nStages);
+  int getNumberOfStages(void){ return mNumberOfStages; };
+  /* @desc get the filters' stateResourceConsumption() per stage in the signal flow order */
+  std::vector<int> getStageResourceConsumption(void);
+  /*
+    @desc don't split the stage at the window size change. the filters whose window doesn't fit are processed through BlockSizeAdapterFilter in the stage.
+          See Pipe::setBlockSizeAdapterEnabled(). The running pipe is stopped and restarted during the re-partition.
+  */
+  void setBlockSizeAdapterEnabled(bool bEnabled);
+  bool getBlockSizeAdapterEnabled(void){ return mBlockSizeAdapterEnabled; };
+
 protected:
   std::shared_ptr<IPipe> getHeadPipe(bool bCreateInstance = false);
   std::shared_ptr<IPipe> getTailPipe(bool bCreateInstance = false);
@@ -69,6 +94,19 @@ protected:
   void createAndConnectPipesToHead(std::shared_ptr<IPipe> pCurrentPipe);
   void ensureSourceSink(void);
 
+  FilterChain mFilters; // the whole filter chain in the signal flow order
+  int mNumberOfStages;
+  bool mBlockSizeAdapterEnabled;
+  // true: the stages are built from mFilters by rebuildStagesLocked() instead of the incremental update
+  bool isStagePartitioned(void){ return ( mNumberOfStages > 1 ) || mBlockSizeAdapterEnabled; };
+  // should be called with mMutexFilters
+  void rebuildStagesLocked(void);
+  static int getFilterCost(std::shared_ptr<IFilter> pFilter);
+  /* @desc partition the filters into the contiguous stages to minimize the maximum stage cost.
+     @arg bWindowSizeBoundary : true: the window size change is always the boundary
+     @return the number of the filters per stage */
+  static std::vector<int> getStagePartition(const FilterChain& filters, int nStages, bool bWindowSizeBoundary = true);
+
   std::mutex mMutexThreads;
   std::mutex mMutexFilters;
 };
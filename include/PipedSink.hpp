@@ -25,7 +25,7 @@
 #include <string>
 #include <memory>
 
-class PipedSink : public ISink
+class PipedSink : public ISink, public IUnlockable
 {
 protected:
   std::shared_ptr<ISink> mpSink;
@@ -47,6 +47,8 @@ public:
   virtual bool isRunning(void);
   virtual void clearFilters(void);
   virtual void writePrimitive(IAudioBuffer& buf);
+  /* @desc unblock the writer which is waiting for the internal pipe's consumption */
+  virtual void unlock(void);
 
   virtual std::string toString(void){ return std::string("PipedSink(") + (mpSink ? mpSink->toString() : "") + ")"; };
   virtual void dump(void);
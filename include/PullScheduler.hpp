@@ -0,0 +1,69 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __PULL_SCHEDULER_HPP__
+#define __PULL_SCHEDULER_HPP__
+
+#include "ThreadBase.hpp"
+#include <vector>
+#include <map>
+#include <mutex>
+
+/*
+  @desc Period driven scheduler which runs the attached runners on this scheduler's thread.
+        The period is the sink's period e.g. PipeMixer's mixing window. In each period the runners are processed in the dependency order,
+        i.e. the runners which write to the sink adaptor (e.g. Pipe) are processed just before the runner which reads it (e.g. PipeMixer).
+        Then the data flows from the source to the sink within the period without the per-runner thread and the buffering for the thread's jitter.
+        The runner which processes the longer duration than the period is processed only in the periods where its duration elapses.
+        The runner whose data isn't ready yet is skipped in the period. PipeMixer conceals it with zero.
+        The runners are attached by ThreadBase::setPullScheduler() and run(). Note that the runner should not block for long.
+*/
+class PullScheduler : public ThreadBase
+{
+public:
+  static inline const int DEFAULT_PERIOD_USEC = 5000;
+
+protected:
+  int mPeriodUsec;
+  std::recursive_mutex mMutexRunners;
+  // attached order
+  std::vector<ThreadBase*> mRunners;
+  // the processable duration of each runner
+  std::map<ThreadBase*, int64_t> mCreditsUsec;
+
+protected:
+  virtual void process(void);
+  bool isAttachedLocked(ThreadBase* pRunner);
+  void detachLocked(ThreadBase* pRunner);
+  int getPeriodUsecLocked(void);
+  std::vector<ThreadBase*> getEvaluationOrderLocked(void);
+  void processPeriod(int nPeriodUsec);
+
+  // for ThreadBase::run() and ThreadBase::stop()
+  void attach(ThreadBase* pRunner);
+  void detach(ThreadBase* pRunner);
+  friend ThreadBase;
+
+public:
+  /* @arg nPeriodUsec : 0: the shortest period of the attached runners e.g. the sink's period */
+  PullScheduler(int nPeriodUsec = 0);
+  virtual ~PullScheduler();
+
+  void setPeriodUsec(int nPeriodUsec);
+  int getPeriodUsec(void);
+  int getNumberOfRunners(void);
+};
+
+#endif /* __PULL_SCHEDULER_HPP__ */
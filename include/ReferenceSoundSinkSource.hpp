@@ -21,17 +21,21 @@
 #include "Sink.hpp"
 #include <mutex>
 #include <memory>
+#include <atomic>
 
 class ReferenceSoundSinkSource : public InterPipeBridge
 {
 protected:
   std::shared_ptr<ISink> mpSink;
   std::mutex mMutexSink;
+  std::atomic<bool> mbSettingSinkFormat; // the inner sink's notification during setAudioFormatPrimitive() is ignored
 
 protected:
   virtual void readPrimitive(IAudioBuffer& buf);
   virtual void writePrimitive(IAudioBuffer& buf);
   virtual void setAudioFormatPrimitive(AudioFormat format);
+  // the inner sink's format is changed directly. this follows it as getAudioFormat() does.
+  virtual void onInnerAudioFormatChanged(AudioFormat format);
 
 public:
   ReferenceSoundSinkSource( std::shared_ptr<ISink> pSink );
@@ -19,6 +19,7 @@
 
 #include "PipeAndFilterCommon.hpp"
 #include "Buffer.hpp"
+#include "AudioBufferPool.hpp"
 #include "AudioFormat.hpp"
 #include "PlugInManager.hpp"
 #include "Volume.hpp"
@@ -55,10 +56,17 @@ protected:
   int mLatencyUsec;
   int64_t mSinkPosition;
   std::mutex mMutexWrite;
+  AudioBufferPool mBufferPool;
+  // the per channel volumes applied to the last written buffer and the volumes to be applied
+  std::vector<float> mAppliedVolumes;
+  std::vector<float> mTargetVolumes;
 
 protected:
   virtual void writePrimitive(IAudioBuffer& buf) = 0;
   virtual void mutePrimitive(bool bEnableMute, bool bUseZero=false);
+  // account the latency and the position for the buf to be written
+  void updateSinkPosition(IAudioBuffer& buf);
+  bool isVolumeRequired(void);
 
 public:
   virtual void write(IAudioBuffer& buf);
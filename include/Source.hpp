@@ -39,6 +39,8 @@ protected:
 protected:
   virtual void readPrimitive(IAudioBuffer& buf) = 0;
   virtual void setAudioFormatPrimitive(AudioFormat format){mFormat = format;};
+  // account the latency and the position for the buf to be read
+  void updateSourcePosition(IAudioBuffer& buf);
 
 public:
   ISource();
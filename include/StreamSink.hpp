@@ -21,6 +21,7 @@
 #include "AudioFormat.hpp"
 #include "Sink.hpp"
 #include "Stream.hpp"
+#include "PcmSamplingRateConversionPrimitives.hpp"
 #include <string>
 #include <memory>
 
@@ -29,6 +30,8 @@ class StreamSink : public ISink
 protected:
   AudioFormat mFormat;
   std::shared_ptr<IStream> mpStream;
+  // keeps the filter state across the written buffers
+  std::shared_ptr<PcmSamplingRateConverter> mpSamplingRateConverter;
 
 protected:
   virtual void setAudioFormatPrimitive(AudioFormat audioFormat);
@@ -19,6 +19,7 @@
 
 #include "Source.hpp"
 #include "Stream.hpp"
+#include "PcmSamplingRateConversionPrimitives.hpp"
 #include "AudioFormat.hpp"
 #include <memory>
 
@@ -27,6 +28,8 @@ class StreamSource : public ISource
 protected:
   AudioFormat mFormat;
   std::shared_ptr<IStream> mpStream;
+  // keeps the filter state across the read buffers
+  std::shared_ptr<PcmSamplingRateConverter> mpSamplingRateConverter;
 
 protected:
   virtual void readPrimitive(IAudioBuffer& buf);
@@ -22,6 +22,49 @@
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <string>
+#include "ThreadPoolExecutor.hpp"
+
+/*
+  @desc Scheduling policy, CPU affinity and memory locking of the audio thread.
+        The failure (e.g. no privilege for SCHED_FIFO) is reported by apply() and the thread keeps running with the current setting.
+*/
+class ThreadPolicy
+{
+public:
+  enum SCHEDULING
+  {
+    SCHEDULING_DEFAULT, // don't change
+    SCHEDULING_FIFO,    // SCHED_FIFO
+    SCHEDULING_RR       // SCHED_RR
+  };
+
+  SCHEDULING scheduling;
+  int priority;          // clamped to the scheduling's range
+  std::vector<int> cpus; // empty: don't pin
+  bool bLockMemory;      // mlockall() for the process. this is done only once
+
+  ThreadPolicy(SCHEDULING scheduling = SCHEDULING_DEFAULT, int priority = 0, std::vector<int> cpus = std::vector<int>(), bool bLockMemory = false);
+  virtual ~ThreadPolicy(){};
+
+  bool isDefault(void){ return ( scheduling == SCHEDULING_DEFAULT ) && cpus.empty() && !bLockMemory; };
+  /* @desc apply to the current thread
+     @return true: all of the policy is applied. false: some of them couldn't be applied. */
+  bool apply(void);
+
+  static inline const std::string KEY_PREFIX = "thread.policy";
+  /*
+    @desc get the policy from ParameterManager
+          [keyPrefix].scheduling : "default", "fifo" or "rr"
+          [keyPrefix].priority : int
+          [keyPrefix].affinity : comma separated cpu indexes such as "2,3"
+          [keyPrefix].mlock : bool
+  */
+  static ThreadPolicy getFromParameters(std::string keyPrefix = KEY_PREFIX);
+};
+
+class PullScheduler;
 
 class ThreadBase
 {
@@ -30,6 +73,24 @@ protected:
   std::shared_ptr<std::thread> mpThread;
   std::atomic<bool> mbIsRunning;
   bool mIsPreviousRunning;
+  // the dedicated thread's end for stop()
+  std::mutex mMutexThreadFinished;
+  std::condition_variable mThreadFinishedEvent;
+  bool mbThreadFinished;
+  // executor mode
+  std::shared_ptr<ThreadPoolExecutor> mpExecutor;
+  std::atomic<int> mStepState;
+  std::atomic<bool> mbStepRunning;
+  std::mutex mMutexStep;
+  std::condition_variable mStepFinishedEvent;
+  // nullptr: use the default policy. accessed by std::atomic_load() / std::atomic_store() only.
+  std::shared_ptr<ThreadPolicy> mpThreadPolicy;
+  static inline std::mutex mMutexDefaultThreadPolicy;
+  static inline std::shared_ptr<ThreadPolicy> mpDefaultThreadPolicy;
+  // pull scheduler mode
+  std::shared_ptr<PullScheduler> mpPullScheduler;
+  std::atomic<bool> mbPullAttached;
+  friend PullScheduler;
 
 public:
   ThreadBase();
@@ -39,11 +100,69 @@ public:
   virtual void stop(void);
   virtual bool isRunning(void);
 
+  /*
+    @desc run this as the task on the executor instead of the dedicated thread.
+          This is effective only if the derived class implements processStep(). Otherwise the dedicated thread is used as before.
+          Note that this should be called before run().
+    @arg pExecutor : the executor such as ThreadPoolExecutor::getDefaultExecutor(). nullptr: use the dedicated thread.
+  */
+  void setExecutor(std::shared_ptr<ThreadPoolExecutor> pExecutor);
+  std::shared_ptr<ThreadPoolExecutor> getExecutor(void){ return mpExecutor; };
+
+  /*
+    @desc run this by PullScheduler's period instead of the dedicated thread. This has priority over setExecutor().
+          This is effective only if the derived class implements processStep() as well as setExecutor().
+          Note that this should be called before run().
+    @arg pScheduler : nullptr: use the dedicated thread or the executor
+  */
+  void setPullScheduler(std::shared_ptr<PullScheduler> pScheduler);
+  std::shared_ptr<PullScheduler> getPullScheduler(void){ return mpPullScheduler; };
+
+  /* @desc set the thread policy of this instance. This is applied from the next run(). */
+  void setThreadPolicy(ThreadPolicy policy);
+  /* @desc use the default thread policy */
+  void resetThreadPolicy(void);
+  /* @desc get the effective thread policy of this instance */
+  ThreadPolicy getThreadPolicy(void);
+  /* @desc set the default thread policy for the all of the instances and ThreadPoolExecutor's workers which don't have own policy */
+  static void setDefaultThreadPolicy(ThreadPolicy policy);
+  /* @desc use ThreadPolicy::getFromParameters() as the default thread policy (initial state) */
+  static void resetDefaultThreadPolicy(void);
+  static ThreadPolicy getDefaultThreadPolicy(void);
+
 protected:
   virtual void process(void);
   static void _execute(ThreadBase* pThis);
   virtual void unlockToStop(void);
 
+  enum STEP_RESULT
+  {
+    STEP_CONTINUE,  // processed. processStep() will be called again
+    STEP_WAIT,      // not ready. processStep() will be called again after resumeStep()
+    STEP_DONE       // finished as process() returns
+  };
+  static inline const int STOP_RETRY_USEC = 1000; // stop() calls unlockToStop() again in this interval until the thread finishes
+  static inline const int STOP_TIMEOUT_USEC = 1000000; // for ENABLE_PTHREAD_CANCEL
+  static const int STEP_BUDGET = 16; // the steps in a row before giving the worker to the other tasks
+
+  // Should override isStepSupported() and processStep() to support the executor mode
+  virtual bool isStepSupported(void){ return false; };
+  /*
+    @desc process one unit of process() without blocking.
+          Instead of the blocking read, arrange resumeStep() to be called when it's ready and return STEP_WAIT.
+  */
+  virtual STEP_RESULT processStep(void){ return STEP_DONE; };
+  // called on the executor after the last processStep(). release the continuation such as the listener here.
+  virtual void finalizeStep(void){};
+  // the continuation of STEP_WAIT. this is callable from any thread.
+  void resumeStep(void);
+  static void _executeStep(ThreadBase* pThis);
+  void finishStep(void);
+  // for PullScheduler. the duration which processStep() processes. 0: once per the scheduler's period
+  virtual int getPullPeriodUsec(void){ return 0; };
+  // for PullScheduler. the runners which write the data read by this. they're processed before this in the period.
+  virtual std::vector<ThreadBase*> getUpstreamRunners(void){ return std::vector<ThreadBase*>(); };
+
 public:
   class RunnerListener
   {
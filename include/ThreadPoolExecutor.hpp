@@ -0,0 +1,79 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __THREAD_POOL_EXECUTOR_HPP__
+#define __THREAD_POOL_EXECUTOR_HPP__
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+/*
+  @desc Fixed size thread pool with the work stealing.
+        Each worker has own task queue and runs it in FIFO order. The idle worker steals the task from the tail of the other worker's queue.
+        The task submitted from the worker goes to the worker's own queue, otherwise the queues are chosen by round robin.
+        Note that the task shouldn't block for long since it occupies the worker. See ThreadBase::setExecutor() for the continuation.
+*/
+class ThreadPoolExecutor
+{
+public:
+  typedef std::function<void(void)> TASK;
+
+protected:
+  class Worker
+  {
+  public:
+    std::mutex mMutex;
+    std::deque<TASK> mTasks;
+  };
+
+  std::vector<std::shared_ptr<Worker>> mWorkers;
+  std::vector<std::thread> mThreads;
+  std::atomic<int> mPendingTasks;
+  std::atomic<int> mRoundRobin;
+  std::atomic<bool> mbStopping;
+  std::mutex mMutexIdle;
+  std::condition_variable mIdleEvent;
+
+protected:
+  void workerLoop(int nIndex);
+  bool popTask(int nIndex, TASK& task);
+  int getCurrentWorkerIndex(void);
+
+public:
+  /*
+    @desc create the pool
+    @arg nThreads : the number of the worker threads. 0: the number of the cores
+  */
+  ThreadPoolExecutor(int nThreads = 0);
+  virtual ~ThreadPoolExecutor();
+
+  /* @desc run the task on one of the workers */
+  void execute(TASK task);
+  int getNumberOfThreads(void){ return mThreads.size(); };
+  /* @return true if the caller is running on this pool's worker */
+  bool isWorkerThread(void){ return getCurrentWorkerIndex() >= 0; };
+
+  /* @desc the shared pool sized to the core count */
+  static std::shared_ptr<ThreadPoolExecutor> getDefaultExecutor(void);
+};
+
+#endif /* __THREAD_POOL_EXECUTOR_HPP__ */
@@ -29,6 +29,8 @@ public:
   static bool process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, float volume );
   static bool process( AudioBuffer& inBuf, AudioBuffer& outBuf, float volume );
   static bool process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, std::vector<float> channelVolumes );
+  /* @desc apply the linear volume ramp from startVolumes to endVolumes across the buffer */
+  static bool process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, const std::vector<float>& startVolumes, const std::vector<float>& endVolumes );
   static bool process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, CHANNEL_VOLUME volumes );
   static bool process( AudioBuffer& inBuf, AudioBuffer& outBuf, CHANNEL_VOLUME volumes );
 
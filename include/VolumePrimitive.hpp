@@ -19,15 +19,38 @@
 
 #include <stdint.h>
 #include <vector>
+#include <span>
+#include "CpuFeature.hpp"
 
 class VolumePrimitive
 {
 public:
-  static bool volume(int8_t* pRawInBuf, int8_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples = 1);
-  static bool volume(int16_t* pRawInBuf, int16_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples = 1);
-  static bool volume(int32_t* pRawInBuf, int32_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples = 1);
-  static bool volume(float* pRawInBuf, float* pRawOutBuf, std::vector<float> volumes, int nChannelSamples = 1);
-  static bool volume24(int8_t* pRawInBuf, int8_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples = 1);
+  typedef CpuFeature::SIMD SIMD;
+
+  /* @desc apply the per channel volumes (percentage). the volumes are interleaved per channel. */
+  static bool volume(int8_t* pRawInBuf, int8_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples = 1);
+  static bool volume(int16_t* pRawInBuf, int16_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples = 1);
+  static bool volume(int32_t* pRawInBuf, int32_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples = 1);
+  static bool volume(float* pRawInBuf, float* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples = 1);
+  static bool volume24(int8_t* pRawInBuf, int8_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples = 1);
+
+  /*
+    @desc apply the linear volume ramp from startVolumes to endVolumes across the buffer.
+          the frame f uses start + (end - start) * f / frames then the next buffer can start from endVolumes seamlessly.
+  */
+  static bool volume(const int8_t* pRawInBuf, int8_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples);
+  static bool volume(const int16_t* pRawInBuf, int16_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples);
+  static bool volume(const int32_t* pRawInBuf, int32_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples);
+  static bool volume(const float* pRawInBuf, float* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples);
+  static bool volume24(const int8_t* pRawInBuf, int8_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples);
+
+  /* @desc get the kernel set in use. it's chosen once by the detected cpu features */
+  static SIMD getSimd(void);
+  /*
+    @desc override the kernel set such as for the comparison
+    @return false if the running cpu doesn't support it
+  */
+  static bool setSimd(SIMD simd);
 };
 
 #endif /* __VOLUME_PRIMITIVE_HPP__ */
\ No newline at end of file
@@ -0,0 +1,89 @@
+/*
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "AudioBufferPool.hpp"
+#include <algorithm>
+#include <atomic>
+
+AudioBufferPool::AudioBufferPool(int nMaxBuffersPerKey) : mMaxBuffersPerKey(nMaxBuffersPerKey)
+{
+
+}
+
+AudioBufferPool::~AudioBufferPool()
+{
+  clear();
+}
+
+std::shared_ptr<AudioBuffer> AudioBufferPool::acquire(AudioFormat format, int nSamples, bool bClear)
+{
+  std::shared_ptr<AudioBuffer> result;
+  PoolKey key( format.getEncoding(), format.getChannels(), format.getSamplingRate(), nSamples );
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<std::shared_ptr<AudioBuffer>>& buffers = mPool[ key ];
+    for( auto& pBuf : buffers ){
+      // only this pool refers the buffer then nobody uses it
+      if( pBuf.use_count() == 1 ){
+        result = pBuf;
+        break;
+      }
+    }
+    if( result ){
+      // ensure the previous user's write is visible before the reuse
+      std::atomic_thread_fence( std::memory_order_acquire );
+    } else if( buffers.size() < (size_t)mMaxBuffersPerKey ){
+      result = std::make_shared<AudioBuffer>( format, nSamples );
+      buffers.push_back( result );
+      bClear = false; // newly allocated buffer is already zero cleared
+    }
+  }
+
+  if( result ){
+    // the previous user might change the format or the size. then restore them without re-allocation
+    if( !result->getAudioFormat().equal( format ) ){
+      result->setAudioFormat( format, true );
+    }
+    if( result->getNumberOfSamples() != nSamples ){
+      result->resize( nSamples, false );
+    }
+    if( bClear ){
+      ByteBuffer& rawBuf = result->getRawBuffer();
+      std::fill( rawBuf.begin(), rawBuf.end(), 0 );
+    }
+  } else {
+    result = std::make_shared<AudioBuffer>( format, nSamples );
+  }
+
+  return result;
+}
+
+int AudioBufferPool::getPooledBufferCount(void)
+{
+  int result = 0;
+  std::lock_guard<std::mutex> lock(mMutex);
+  for( auto& [key, buffers] : mPool ){
+    result += buffers.size();
+  }
+  return result;
+}
+
+void AudioBufferPool::clear(void)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mPool.clear();
+}
@@ -507,9 +507,32 @@ AudioBase::AudioBase()
 
 AudioBase::~AudioBase()
 {
+  setInnerAudioBase( nullptr );
   mAudioFormatListerners.clear();
 }
 
+void AudioBase::setInnerAudioBase(std::shared_ptr<AudioBase> pInner)
+{
+  std::shared_ptr<AudioBase> pPrevInner = mpInnerAudioBase.lock();
+  if( pPrevInner == pInner ) return;
+  if( pPrevInner && mpInnerAudioFormatListener ){
+    pPrevInner->unregisterAudioFormatListener( mpInnerAudioFormatListener );
+  }
+  mpInnerAudioBase = pInner;
+  if( pInner ){
+    if( !mpInnerAudioFormatListener ){
+      mpInnerAudioFormatListener = std::make_shared<InnerAudioFormatListener>( this );
+    }
+    pInner->registerAudioFormatListener( mpInnerAudioFormatListener );
+  }
+}
+
+void AudioBase::onInnerAudioFormatChanged(AudioFormat format)
+{
+  mPreviousAudioFormat = format;
+  notifyAudioFormatChanged( format );
+}
+
 void AudioBase::registerAudioFormatListener(std::shared_ptr<AudioBase::AudioFormatListener> listener)
 {
   std::weak_ptr<AudioBase::AudioFormatListener> theListener(listener);
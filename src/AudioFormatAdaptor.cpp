@@ -23,6 +23,16 @@
 #include <iostream>
 
 bool AudioFormatAdaptor::convert(AudioBuffer& srcBuf, AudioBuffer& dstBuf)
+{
+  return convertPrimitive( srcBuf, dstBuf, nullptr );
+}
+
+bool AudioFormatAdaptor::convert(AudioBuffer& srcBuf, AudioBuffer& dstBuf, std::shared_ptr<PcmSamplingRateConverter>& pSamplingRateConverter)
+{
+  return convertPrimitive( srcBuf, dstBuf, &pSamplingRateConverter );
+}
+
+bool AudioFormatAdaptor::convertPrimitive(AudioBuffer& srcBuf, AudioBuffer& dstBuf, std::shared_ptr<PcmSamplingRateConverter>* ppSamplingRateConverter)
 {
   AudioBuffer* pSrcBuf = &srcBuf;
   AudioBuffer* pDstBuf = &dstBuf;
@@ -45,7 +55,11 @@ bool AudioFormatAdaptor::convert(AudioBuffer& srcBuf, AudioBuffer& dstBuf)
       std::swap<AudioBuffer*>(pSrcBuf, pDstBuf);
     }
     pDstBuf->setAudioFormat( AudioFormat( dstEncoding, dstSamplingRate, srcFormat.getChannels() ) );
-    samplingRateConversion(*pSrcBuf, *pDstBuf, dstSamplingRate);
+    if( ppSamplingRateConverter ){
+      samplingRateConversion(*pSrcBuf, *pDstBuf, dstSamplingRate, *ppSamplingRateConverter);
+    } else {
+      samplingRateConversion(*pSrcBuf, *pDstBuf, dstSamplingRate);
+    }
     nConverted++;
   }
   if( srcFormat.getChannels() != dstChannel ){
@@ -189,6 +203,28 @@ bool AudioFormatAdaptor::samplingRateConversion(AudioBuffer& srcBuf, AudioBuffer
 }
 
 
+bool AudioFormatAdaptor::samplingRateConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, int dstSamplingRate, std::shared_ptr<PcmSamplingRateConverter>& pSamplingRateConverter)
+{
+  AudioFormat srcFormat = srcBuf.getAudioFormat();
+  AudioFormat::ENCODING encoding = srcFormat.getEncoding();
+  int nChannels = srcFormat.getNumberOfChannels();
+
+  if( !pSamplingRateConverter || !pSamplingRateConverter->isSameConfiguration( encoding, srcFormat.getSamplingRate(), dstSamplingRate, nChannels ) ){
+    pSamplingRateConverter = std::make_shared<PcmSamplingRateConverter>( encoding, srcFormat.getSamplingRate(), dstSamplingRate, nChannels );
+  }
+  if( !pSamplingRateConverter->isAvailable() ){
+    return samplingRateConversion( srcBuf, dstBuf, dstSamplingRate );
+  }
+
+  int nSrcSamples = srcBuf.getNumberOfSamples();
+  dstBuf.setAudioFormat( AudioFormat( encoding, dstSamplingRate, srcFormat.getChannels() ) );
+  dstBuf.resize( pSamplingRateConverter->getMaxOutputSamples( nSrcSamples ) );
+  int nDstSamples = pSamplingRateConverter->convert( srcBuf.getRawBufferPointer(), dstBuf.getRawBufferPointer(), nSrcSamples );
+  dstBuf.resize( nDstSamples );
+
+  return true;
+}
+
 bool AudioFormatAdaptor::channelConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, AudioFormat::CHANNEL dstChannel)
 {
   return ChannelConverter::channelConversion( srcBuf, dstBuf, dstChannel );
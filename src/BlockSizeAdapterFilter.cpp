@@ -0,0 +1,125 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "BlockSizeAdapterFilter.hpp"
+#include <numeric>
+#include <algorithm>
+
+BlockSizeAdapterFilter::BlockSizeAdapterFilter(std::shared_ptr<IFilter> pFilter, int nWindowSizeUsec) : Filter(), mpFilter(pFilter), mWindowSizeUsec(nWindowSizeUsec)
+{
+
+}
+
+BlockSizeAdapterFilter::~BlockSizeAdapterFilter()
+{
+
+}
+
+int BlockSizeAdapterFilter::getAdditionalLatency(int nWindowSize, int nFilterWindowSize)
+{
+  // the output at the n-th window is short by ( n * window ) mod filter's window at most. the maximum of it is the filter's window - gcd.
+  if( nWindowSize <= 0 || nFilterWindowSize <= 0 || !isAdapterRequired( nWindowSize, nFilterWindowSize ) ){
+    return 0;
+  }
+  return nFilterWindowSize - std::gcd( nWindowSize, nFilterWindowSize );
+}
+
+bool BlockSizeAdapterFilter::isAdapterRequired(int nWindowSizeUsec, int nFilterWindowSizeUsec)
+{
+  return nWindowSizeUsec && nFilterWindowSizeUsec && ( nWindowSizeUsec % nFilterWindowSizeUsec );
+}
+
+void BlockSizeAdapterFilter::reset(AudioFormat format, int nSamples)
+{
+  mFormat = format;
+  int nFilterSamples = (int64_t)mpFilter->getRequiredWindowSizeUsec() * format.getSamplingRate() / 1000000;
+  nFilterSamples = std::max( nFilterSamples, 1 );
+  mpFilterInBuf = std::make_shared<AudioBuffer>( format, nFilterSamples );
+  mpFilterOutBuf = std::make_shared<AudioBuffer>( format, nFilterSamples );
+
+  // no size limit : the write never waits since this is the only reader and the writer. the ring grows up to the steady state size.
+  mInFifo.setAudioFormat( format );
+  mInFifo.clearBuffer();
+  mOutFifo.setAudioFormat( format );
+  mOutFifo.clearBuffer();
+
+  // prime the output by the minimum delay then any window can be output without underrun
+  int nDelaySamples = getAdditionalLatency( nSamples, nFilterSamples );
+  if( nDelaySamples ){
+    AudioBuffer zeroBuf( format, nDelaySamples );
+    mOutFifo.write( zeroBuf );
+  }
+}
+
+void BlockSizeAdapterFilter::process(AudioBuffer& inBuf, AudioBuffer& outBuf)
+{
+  if( !mpFilter ){
+    outBuf = inBuf;
+    return;
+  }
+  AudioFormat format = inBuf.getAudioFormat();
+  int nSamples = inBuf.getNumberOfSamples();
+  if( !mpFilterInBuf || !format.equal( mFormat ) ){
+    reset( format, nSamples );
+  }
+
+  mInFifo.write( inBuf );
+  int nFilterBytes = mpFilterInBuf->getRawBufferSize();
+  while( mInFifo.getBufferedBytes() >= nFilterBytes ){
+    mInFifo.read( *mpFilterInBuf );
+    mpFilter->process( *mpFilterInBuf, *mpFilterOutBuf );
+    mOutFifo.write( *mpFilterOutBuf );
+  }
+
+  if( !outBuf.getAudioFormat().equal( format ) ){
+    outBuf.setAudioFormat( format );
+  }
+  if( outBuf.getNumberOfSamples() != nSamples ){
+    outBuf.resize( nSamples );
+  }
+  // the window size change after the priming might be short. then output the zero instead of the blocking.
+  if( mOutFifo.getBufferedBytes() >= outBuf.getRawBufferSize() ){
+    mOutFifo.read( outBuf );
+  } else {
+    ByteBuffer& rawBuffer = outBuf.getRawBuffer();
+    std::fill( rawBuffer.begin(), rawBuffer.end(), 0 );
+  }
+}
+
+std::vector<AudioFormat> BlockSizeAdapterFilter::getSupportedAudioFormats(void)
+{
+  std::shared_ptr<Filter> pFilter = std::dynamic_pointer_cast<Filter>( mpFilter );
+  return pFilter ? pFilter->getSupportedAudioFormats() : Filter::getSupportedAudioFormats();
+}
+
+int BlockSizeAdapterFilter::getLatencyUSec(void)
+{
+  return ( mpFilter ? mpFilter->getLatencyUSec() : 0 ) + getAdditionalLatency( mWindowSizeUsec, mpFilter ? mpFilter->getRequiredWindowSizeUsec() : 0 );
+}
+
+int BlockSizeAdapterFilter::getExpectedProcessingUSec(void)
+{
+  // the filter is called ( window / filter's window ) times per window on average
+  int nFilterWindowSizeUsec = mpFilter ? mpFilter->getRequiredWindowSizeUsec() : 0;
+  if( !nFilterWindowSizeUsec ){
+    return mpFilter ? mpFilter->getExpectedProcessingUSec() : 0;
+  }
+  return (int64_t)mpFilter->getExpectedProcessingUSec() * mWindowSizeUsec / nFilterWindowSizeUsec;
+}
+
+int BlockSizeAdapterFilter::stateResourceConsumption(void)
+{
+  return mpFilter ? mpFilter->stateResourceConsumption() : 0;
+}
@@ -17,6 +17,7 @@
 #include "Buffer.hpp"
 #include <cstring>
 #include <cassert>
+#include <algorithm>
 
 
 AudioSample::AudioSample(AudioFormat format, ByteBuffer buf) : mFormat(format), mBuf(buf)
@@ -236,21 +237,139 @@ bool AudioBuffer::isSameChannelMap(AudioFormat::ChannelMapper& mapper)
 AudioBuffer AudioBuffer::getSelectedChannelData(AudioFormat outAudioFormat, AudioFormat::ChannelMapper& mapper)
 {
   // extract corresponding channel's data & reconstruct the buffer
-  int nSrcSamples = getNumberOfSamples();
-  AudioBuffer dstBuf( outAudioFormat, nSrcSamples );
-  if( !isSameChannelMap(mapper) ){
-    for(int i=0; i<nSrcSamples; i++){
-      AudioSample aSrcSample = getSample(i);
-      AudioSample aDstSample(outAudioFormat);
-      for(const auto& [dstCh, srcCh] : mapper){
-        aDstSample.setData( dstCh, aSrcSample.getData(srcCh) );
-      }
-      dstBuf.setSample(i, aDstSample);
+  AudioBuffer dstBuf( outAudioFormat, 0 );
+  ChannelRemapper remapper( mFormat, outAudioFormat, mapper );
+  remapper.process( *this, dstBuf );
+  return dstBuf;
+}
+
+
+struct Pcm24Sample
+{
+  uint8_t data[3];
+};
+
+template <typename T> static T getZeroSample(void)
+{
+  return T();
+}
+
+template <typename T> static void remapKernel(const uint8_t* pSrc, uint8_t* pDst, const int* pSrcChannels, int nSrcChannels, int nDstChannels, int nSamples)
+{
+  const T* pSrcSample = reinterpret_cast<const T*>( pSrc );
+  T* pDstSample = reinterpret_cast<T*>( pDst );
+  const T zero = getZeroSample<T>();
+
+  for( int i = 0; i < nSamples; i++, pSrcSample += nSrcChannels, pDstSample += nDstChannels ){
+    for( int j = 0; j < nDstChannels; j++ ){
+      int nSrcChannel = pSrcChannels[j];
+      pDstSample[j] = ( nSrcChannel >= 0 ) ? pSrcSample[nSrcChannel] : zero;
     }
+  }
+}
+
+// specialized for the typical stereo output to let the compiler unroll the channel loop
+template <typename T> static void remapKernelStereo(const uint8_t* pSrc, uint8_t* pDst, const int* pSrcChannels, int nSrcChannels, int nDstChannels, int nSamples)
+{
+  const T* pSrcSample = reinterpret_cast<const T*>( pSrc );
+  T* pDstSample = reinterpret_cast<T*>( pDst );
+  const T zero = getZeroSample<T>();
+  const int nSrcL = pSrcChannels[0];
+  const int nSrcR = pSrcChannels[1];
+
+  for( int i = 0; i < nSamples; i++, pSrcSample += nSrcChannels, pDstSample += 2 ){
+    pDstSample[0] = ( nSrcL >= 0 ) ? pSrcSample[nSrcL] : zero;
+    pDstSample[1] = ( nSrcR >= 0 ) ? pSrcSample[nSrcR] : zero;
+  }
+}
+
+ChannelRemapper::REMAP_FUNC ChannelRemapper::getRemapFunc(int nSampleByte, int nDstChannels)
+{
+  bool bStereo = ( nDstChannels == 2 );
+  switch( nSampleByte ){
+    case 1:
+      return bStereo ? remapKernelStereo<uint8_t> : remapKernel<uint8_t>;
+    case 2:
+      return bStereo ? remapKernelStereo<uint16_t> : remapKernel<uint16_t>;
+    case 3:
+      return bStereo ? remapKernelStereo<Pcm24Sample> : remapKernel<Pcm24Sample>;
+    case 4:
+      return bStereo ? remapKernelStereo<uint32_t> : remapKernel<uint32_t>;
+    default:
+      return nullptr;
+  }
+}
+
+ChannelRemapper::ChannelRemapper(AudioFormat srcFormat, AudioFormat dstFormat, AudioFormat::ChannelMapper& mapper) : mSrcFormat(srcFormat), mDstFormat(dstFormat), mMapper(mapper), mIsThrough(false), mpRemap(nullptr)
+{
+  AudioBuffer srcBuf( srcFormat, 0 );
+  mIsThrough = srcBuf.isSameChannelMap( mapper );
+
+  int nSrcChannels = srcFormat.getNumberOfChannels();
+  int nDstChannels = dstFormat.getNumberOfChannels();
+  mSrcChannels.resize( nDstChannels, -1 );
+  for( const auto& [dstCh, srcCh] : mapper ){
+    int nDstChannel = dstFormat.getOffSetInSample( dstCh );
+    int nSrcChannel = srcFormat.getOffSetInSample( srcCh );
+    if( nDstChannel < nDstChannels && nSrcChannel < nSrcChannels ){
+      mSrcChannels[ nDstChannel ] = nSrcChannel;
+    }
+  }
+
+  if( srcFormat.getSampleByte() == dstFormat.getSampleByte() ){
+    mpRemap = getRemapFunc( dstFormat.getSampleByte(), nDstChannels );
+  }
+}
+
+ChannelRemapper::~ChannelRemapper()
+{
+
+}
+
+bool ChannelRemapper::isSameConfiguration(AudioFormat srcFormat, AudioFormat dstFormat)
+{
+  return mSrcFormat.equal( srcFormat ) && mDstFormat.equal( dstFormat );
+}
+
+bool ChannelRemapper::isSameConfiguration(AudioFormat srcFormat, AudioFormat dstFormat, AudioFormat::ChannelMapper& mapper)
+{
+  return isSameConfiguration( srcFormat, dstFormat ) && ( mMapper == mapper );
+}
+
+void ChannelRemapper::process(AudioBuffer& srcBuf, AudioBuffer& dstBuf)
+{
+  if( mIsThrough ){
+    dstBuf = srcBuf;
+    return;
+  }
+
+  int nSamples = srcBuf.getNumberOfSamples();
+  dstBuf.setAudioFormat( mDstFormat );
+  if( dstBuf.getNumberOfSamples() != nSamples ){
+    dstBuf.resize( nSamples, false );
+  }
+
+  const uint8_t* pSrc = srcBuf.getRawBufferPointer();
+  uint8_t* pDst = dstBuf.getRawBufferPointer();
+  int nSrcChannels = mSrcFormat.getNumberOfChannels();
+  int nDstChannels = mDstFormat.getNumberOfChannels();
+
+  if( mpRemap ){
+    mpRemap( pSrc, pDst, mSrcChannels.data(), nSrcChannels, nDstChannels, nSamples );
   } else {
-    dstBuf = *this;
+    // different sample size between the source and the output. copy the available bytes of each channel
+    int nSrcSampleByte = mSrcFormat.getSampleByte();
+    int nDstSampleByte = mDstFormat.getSampleByte();
+    int nCopyByte = std::min( nSrcSampleByte, nDstSampleByte );
+    memset( pDst, 0, dstBuf.getRawBufferSize() );
+    for( int i = 0; i < nSamples; i++, pSrc += nSrcSampleByte * nSrcChannels, pDst += nDstSampleByte * nDstChannels ){
+      for( int j = 0; j < nDstChannels; j++ ){
+        if( mSrcChannels[j] >= 0 ){
+          memcpy( pDst + j * nDstSampleByte, pSrc + mSrcChannels[j] * nSrcSampleByte, nCopyByte );
+        }
+      }
+    }
   }
-  return dstBuf;
 }
 
 CompressAudioBuffer::CompressAudioBuffer(AudioFormat format, int nChunkSize) : mChunkSize(nChunkSize)
@@ -267,6 +386,12 @@ CompressAudioBuffer& CompressAudioBuffer::operator=(CompressAudioBuffer& buf)
   return *this;
 }
 
+void CompressAudioBuffer::resetChunk(void)
+{
+  mBuf.resize( mChunkSize );
+  std::fill( mBuf.begin(), mBuf.end(), 0 );
+}
+
 void CompressAudioBuffer::setAudioFormat( AudioFormat format, bool bForceAndSilent )
 {
   if( !bForceAndSilent ){
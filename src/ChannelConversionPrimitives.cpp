@@ -26,6 +26,22 @@
 
 #if USE_TINY_CC_IMPL
 
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+
+#ifndef USE_CHANNEL_CONVERSION_SIMD
+  #define USE_CHANNEL_CONVERSION_SIMD 1
+#endif /* USE_CHANNEL_CONVERSION_SIMD */
+
+#if USE_CHANNEL_CONVERSION_SIMD && ( defined(__x86_64__) || defined(__i386__) )
+  #define CHANNEL_CONVERSION_X86_SIMD 1
+  #include <immintrin.h>
+#else
+  #define CHANNEL_CONVERSION_X86_SIMD 0
+#endif
+
 std::vector<ChannelConverter::ChannelMapList> ChannelConverter::getChannelConversionMapList(AudioFormat::CHANNEL srcChannel, AudioFormat::CHANNEL dstChannel)
 {
   struct CONVERT_CH_TABLE
@@ -153,6 +169,67 @@ std::vector<ChannelConverter::ChannelMapList> ChannelConverter::getChannelConver
       {AudioFormat::CH::L,  AudioFormat::CH::SBL},
       {AudioFormat::CH::R,  AudioFormat::CH::SBR} }),
 
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_MONO, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::MONO},
+      {AudioFormat::CH::R,    AudioFormat::CH::MONO},
+      {AudioFormat::CH::SW,   AudioFormat::CH::MONO} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_STEREO, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::SW,   AudioFormat::CH::L},
+      {AudioFormat::CH::SW,   AudioFormat::CH::R} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_4CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::SL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SR},
+      {AudioFormat::CH::SW,   AudioFormat::CH::L},
+      {AudioFormat::CH::SW,   AudioFormat::CH::R} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_5CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::SL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SR},
+      {AudioFormat::CH::L,    AudioFormat::CH::C},
+      {AudioFormat::CH::R,    AudioFormat::CH::C} }), // SW ignored
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_5_1CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::SL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SR},
+      {AudioFormat::CH::L,    AudioFormat::CH::C},
+      {AudioFormat::CH::R,    AudioFormat::CH::C},
+      {AudioFormat::CH::SW,   AudioFormat::CH::SW} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_5_0_2CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::SL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SR},
+      {AudioFormat::CH::L,    AudioFormat::CH::C},
+      {AudioFormat::CH::R,    AudioFormat::CH::C},
+      {AudioFormat::CH::L,    AudioFormat::CH::SBL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SBR} }), // SW ignored
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_5_1_2CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::SL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SR},
+      {AudioFormat::CH::L,    AudioFormat::CH::C},
+      {AudioFormat::CH::R,    AudioFormat::CH::C},
+      {AudioFormat::CH::SW,   AudioFormat::CH::SW},
+      {AudioFormat::CH::L,    AudioFormat::CH::SBL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SBR} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_2_1CH, AudioFormat::CHANNEL::CHANNEL_7_1CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::SL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SR},
+      {AudioFormat::CH::L,    AudioFormat::CH::C},
+      {AudioFormat::CH::R,    AudioFormat::CH::C},
+      {AudioFormat::CH::SW,   AudioFormat::CH::SW},
+      {AudioFormat::CH::L,    AudioFormat::CH::SBL},
+      {AudioFormat::CH::R,    AudioFormat::CH::SBR} }),
+
     CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_4CH, AudioFormat::CHANNEL::CHANNEL_MONO, std::vector<ChannelMapList>{
       {AudioFormat::CH::SL, AudioFormat::CH::MONO},
       {AudioFormat::CH::SR, AudioFormat::CH::MONO},
@@ -312,6 +389,66 @@ std::vector<ChannelConverter::ChannelMapList> ChannelConverter::getChannelConver
       {AudioFormat::CH::SR, AudioFormat::CH::SBR},
       {AudioFormat::CH::R,  AudioFormat::CH::SBR},}),
 
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_MONO, std::vector<ChannelMapList>{
+      {AudioFormat::CH::SL,   AudioFormat::CH::MONO},
+      {AudioFormat::CH::SR,   AudioFormat::CH::MONO},
+      {AudioFormat::CH::C,    AudioFormat::CH::MONO},
+      {AudioFormat::CH::SW,   AudioFormat::CH::MONO},
+      {AudioFormat::CH::L,    AudioFormat::CH::MONO},
+      {AudioFormat::CH::R,    AudioFormat::CH::MONO} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_STEREO, std::vector<ChannelMapList>{
+      {AudioFormat::CH::SL,   AudioFormat::CH::L},
+      {AudioFormat::CH::SR,   AudioFormat::CH::R},
+      {AudioFormat::CH::C,    AudioFormat::CH::L},
+      {AudioFormat::CH::C,    AudioFormat::CH::R},
+      {AudioFormat::CH::SW,   AudioFormat::CH::L},
+      {AudioFormat::CH::SW,   AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_2_1CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::SL,   AudioFormat::CH::L},
+      {AudioFormat::CH::SR,   AudioFormat::CH::R},
+      {AudioFormat::CH::C,    AudioFormat::CH::L},
+      {AudioFormat::CH::C,    AudioFormat::CH::R},
+      {AudioFormat::CH::SW,   AudioFormat::CH::SW},
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_4CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::SL,   AudioFormat::CH::SL},
+      {AudioFormat::CH::SR,   AudioFormat::CH::SR},
+      {AudioFormat::CH::C,    AudioFormat::CH::L},
+      {AudioFormat::CH::C,    AudioFormat::CH::R},
+      {AudioFormat::CH::SW,   AudioFormat::CH::L},
+      {AudioFormat::CH::SW,   AudioFormat::CH::R},
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_5CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::SL,   AudioFormat::CH::SL},
+      {AudioFormat::CH::SR,   AudioFormat::CH::SR},
+      {AudioFormat::CH::C,    AudioFormat::CH::C},
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R} }), // SW ignored
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_5_0_2CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::SL,   AudioFormat::CH::SL},
+      {AudioFormat::CH::SR,   AudioFormat::CH::SR},
+      {AudioFormat::CH::C,    AudioFormat::CH::C},
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R} }), // SW ignored
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_5_1_2CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::SL,   AudioFormat::CH::SL},
+      {AudioFormat::CH::SR,   AudioFormat::CH::SR},
+      {AudioFormat::CH::C,    AudioFormat::CH::C},
+      {AudioFormat::CH::SW,   AudioFormat::CH::SW} }),
+    CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_7_1CH, std::vector<ChannelMapList>{
+      {AudioFormat::CH::L,    AudioFormat::CH::L},
+      {AudioFormat::CH::R,    AudioFormat::CH::R},
+      {AudioFormat::CH::SL,   AudioFormat::CH::SL},
+      {AudioFormat::CH::SR,   AudioFormat::CH::SR},
+      {AudioFormat::CH::C,    AudioFormat::CH::C},
+      {AudioFormat::CH::SW,   AudioFormat::CH::SW} }),
+
     CONVERT_CH_TABLE(AudioFormat::CHANNEL::CHANNEL_5_0_2CH, AudioFormat::CHANNEL::CHANNEL_MONO, std::vector<ChannelMapList>{
       {AudioFormat::CH::SBL,  AudioFormat::CH::MONO},
       {AudioFormat::CH::SBR,  AudioFormat::CH::MONO},
@@ -546,22 +683,327 @@ std::vector<ChannelConverter::ChannelMapList> ChannelConverter::getChannelConver
   return pSelectedChMapper ? pSelectedChMapper->chMapList : std::vector<ChannelMapList>{};
 }
 
+float ChannelConverter::getDownmixGain(AudioFormat::CH srcCh, AudioFormat::CH dstCh)
+{
+  // ITU-R BS.775 like levels. the same channel and the LFE feed are 1.0
+  float gain = 1.0f;
+  if( ( srcCh != dstCh ) && ( dstCh != AudioFormat::CH::SW ) ){
+    switch( srcCh ){
+      case AudioFormat::CH::C:
+      case AudioFormat::CH::SL:
+      case AudioFormat::CH::SR:
+      case AudioFormat::CH::SBL:
+      case AudioFormat::CH::SBR:
+        gain = 0.70710678f;
+        break;
+      case AudioFormat::CH::SW:
+        gain = 0.5f;
+        break;
+      default:
+        break;
+    }
+  }
+  return gain;
+}
+
+ChannelConverter::ChannelMatrix ChannelConverter::createChannelMatrix(AudioFormat::CHANNEL srcChannel, AudioFormat::CHANNEL dstChannel)
+{
+  ChannelMatrix matrix;
+
+  std::vector<ChannelConverter::ChannelMapList> chConvMapList = getChannelConversionMapList( srcChannel, dstChannel );
+  int nSrcChannels = AudioFormat::getNumberOfChannels( srcChannel );
+  int nDstChannels = AudioFormat::getNumberOfChannels( dstChannel );
+  if( !chConvMapList.empty() && ( nSrcChannels <= MAX_CHANNELS ) && ( nDstChannels <= MAX_CHANNELS ) ){
+    matrix.nSrcChannels = nSrcChannels;
+    matrix.nDstChannels = nDstChannels;
+    matrix.gains.resize( nSrcChannels * nDstChannels, 0.0f );
+    for( auto& chMap : chConvMapList ){
+      int nSrc = AudioFormat::getOffSetInSample( srcChannel, chMap.srcCh );
+      int nDst = AudioFormat::getOffSetInSample( dstChannel, chMap.dstCh );
+      matrix.gains[ nDst * nSrcChannels + nSrc ] += getDownmixGain( chMap.srcCh, chMap.dstCh );
+    }
+
+    // normalize each output channel to avoid the clipping. the single source output channel is the copy.
+    for( int d = 0; d < nDstChannels; d++ ){
+      float* pGains = matrix.gains.data() + d * nSrcChannels;
+      float sum = 0.0f;
+      int nUsed = 0;
+      for( int s = 0; s < nSrcChannels; s++ ){
+        sum += pGains[s];
+        nUsed += ( pGains[s] != 0.0f ) ? 1 : 0;
+      }
+      if( ( sum > 1.0f ) || ( nUsed == 1 ) ){
+        for( int s = 0; s < nSrcChannels; s++ ){
+          pGains[s] /= sum;
+        }
+      }
+      matrix.bRouting = matrix.bRouting && ( nUsed <= 1 );
+    }
+
+    matrix.columns.resize( nSrcChannels * MAX_CHANNELS, 0.0f );
+    for( int s = 0; s < nSrcChannels; s++ ){
+      for( int d = 0; d < nDstChannels; d++ ){
+        matrix.columns[ s * MAX_CHANNELS + d ] = matrix.getGain( d, s );
+      }
+    }
+
+    if( matrix.bRouting ){
+      for( auto& chMap : chConvMapList ){
+        matrix.mapper.insert_or_assign( chMap.dstCh, chMap.srcCh );
+      }
+    }
+  }
+
+  return matrix;
+}
+
+const ChannelConverter::ChannelMatrix* ChannelConverter::getChannelMatrix(AudioFormat::CHANNEL srcChannel, AudioFormat::CHANNEL dstChannel)
+{
+  static const int nLayouts = AudioFormat::CHANNEL::CHANNEL_UNKNOWN;
+  // all of the matrices are built once then the lookup is just the index
+  static const std::vector<ChannelMatrix> matrices = []{
+    std::vector<ChannelMatrix> result;
+    for( int s = 0; s < nLayouts; s++ ){
+      for( int d = 0; d < nLayouts; d++ ){
+        result.push_back( createChannelMatrix( (AudioFormat::CHANNEL)s, (AudioFormat::CHANNEL)d ) );
+      }
+    }
+    return result;
+  }();
+
+  const ChannelMatrix* pMatrix = nullptr;
+  if( ( srcChannel >= 0 ) && ( srcChannel < nLayouts ) && ( dstChannel >= 0 ) && ( dstChannel < nLayouts ) ){
+    pMatrix = &matrices[ srcChannel * nLayouts + dstChannel ];
+    if( !pMatrix->nDstChannels ){
+      pMatrix = nullptr;
+    }
+  }
+  return pMatrix;
+}
+
+
+/*
+  The kernels apply the matrix to the float frames.
+  An output frame is the sum of the broadcasted source samples multiplied by the source channel's column.
+  The vector kernels store the whole MAX_CHANNELS lanes of a frame (the next frame overwrites the extra lanes)
+  then the last frames which don't have the room for that are done by the scalar kernel.
+*/
+static void channelMixScalar(const float* pSrc, float* pDst, const float* pColumns, int nSrcChannels, int nDstChannels, int nSamples)
+{
+  for( int i = 0; i < nSamples; i++, pSrc += nSrcChannels, pDst += nDstChannels ){
+    for( int d = 0; d < nDstChannels; d++ ){
+      float acc = 0.0f;
+      for( int s = 0; s < nSrcChannels; s++ ){
+        acc = acc + pSrc[s] * pColumns[ s * ChannelConverter::MAX_CHANNELS + d ];
+      }
+      pDst[d] = acc;
+    }
+  }
+}
+
+struct ChannelMixKernels
+{
+  ChannelConverter::SIMD simd;
+  void (*mix)(const float* pSrc, float* pDst, const float* pColumns, int nSrcChannels, int nDstChannels, int nSamples);
+};
+
+static const ChannelMixKernels gScalarKernels = { ChannelConverter::SIMD::SCALAR, channelMixScalar };
+
+#if CHANNEL_CONVERSION_X86_SIMD
+static int getVectorizableSamples(int nDstChannels, int nSamples)
+{
+  // the frame i can store MAX_CHANNELS lanes if i * nDstChannels + MAX_CHANNELS <= nSamples * nDstChannels
+  int nVectorizable = nSamples - ( ChannelConverter::MAX_CHANNELS + nDstChannels - 1 ) / nDstChannels + 1;
+  return std::max( nVectorizable, 0 );
+}
+
+__attribute__((target("sse2")))
+static void channelMixSse2(const float* pSrc, float* pDst, const float* pColumns, int nSrcChannels, int nDstChannels, int nSamples)
+{
+  int nVectorizable = getVectorizableSamples( nDstChannels, nSamples );
+  for( int i = 0; i < nVectorizable; i++, pSrc += nSrcChannels, pDst += nDstChannels ){
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for( int s = 0; s < nSrcChannels; s++ ){
+      __m128 sample = _mm_set1_ps( pSrc[s] );
+      const float* pColumn = pColumns + s * ChannelConverter::MAX_CHANNELS;
+      acc0 = _mm_add_ps( acc0, _mm_mul_ps( sample, _mm_loadu_ps( pColumn ) ) );
+      acc1 = _mm_add_ps( acc1, _mm_mul_ps( sample, _mm_loadu_ps( pColumn + 4 ) ) );
+    }
+    _mm_storeu_ps( pDst, acc0 );
+    _mm_storeu_ps( pDst + 4, acc1 );
+  }
+  channelMixScalar( pSrc, pDst, pColumns, nSrcChannels, nDstChannels, nSamples - nVectorizable );
+}
+
+static const ChannelMixKernels gSse2Kernels = { ChannelConverter::SIMD::SSE2, channelMixSse2 };
+
+__attribute__((target("avx2")))
+static void channelMixAvx2(const float* pSrc, float* pDst, const float* pColumns, int nSrcChannels, int nDstChannels, int nSamples)
+{
+  int nVectorizable = getVectorizableSamples( nDstChannels, nSamples );
+  for( int i = 0; i < nVectorizable; i++, pSrc += nSrcChannels, pDst += nDstChannels ){
+    __m256 acc = _mm256_setzero_ps();
+    for( int s = 0; s < nSrcChannels; s++ ){
+      acc = _mm256_add_ps( acc, _mm256_mul_ps( _mm256_set1_ps( pSrc[s] ), _mm256_loadu_ps( pColumns + s * ChannelConverter::MAX_CHANNELS ) ) );
+    }
+    _mm256_storeu_ps( pDst, acc );
+  }
+  channelMixScalar( pSrc, pDst, pColumns, nSrcChannels, nDstChannels, nSamples - nVectorizable );
+}
+
+static const ChannelMixKernels gAvx2Kernels = { ChannelConverter::SIMD::AVX2, channelMixAvx2 };
+#endif /* CHANNEL_CONVERSION_X86_SIMD */
+
+static const ChannelMixKernels* getKernelsFor(ChannelConverter::SIMD simd)
+{
+  const ChannelMixKernels* pKernels = nullptr;
+  if( CpuFeature::isSimdSupported( simd ) ){
+    switch( simd ){
+      case ChannelConverter::SIMD::SCALAR:
+        pKernels = &gScalarKernels;
+        break;
+#if CHANNEL_CONVERSION_X86_SIMD
+      case ChannelConverter::SIMD::SSE2:
+        pKernels = &gSse2Kernels;
+        break;
+      case ChannelConverter::SIMD::AVX2:
+        pKernels = &gAvx2Kernels;
+        break;
+#endif /* CHANNEL_CONVERSION_X86_SIMD */
+      default:
+        break;
+    }
+  }
+  return pKernels;
+}
+
+static std::atomic<const ChannelMixKernels*>& getKernels(void)
+{
+  // the best kernel set is chosen once by the cpu feature detection
+  static std::atomic<const ChannelMixKernels*> kernels = []{
+    const ChannelMixKernels* pKernels = getKernelsFor( CpuFeature::getSimd() );
+    return pKernels ? pKernels : &gScalarKernels;
+  }();
+  return kernels;
+}
+
+ChannelConverter::SIMD ChannelConverter::getSimd(void)
+{
+  return getKernels().load( std::memory_order_relaxed )->simd;
+}
+
+bool ChannelConverter::setSimd(SIMD simd)
+{
+  const ChannelMixKernels* pKernels = getKernelsFor( simd );
+  if( pKernels ){
+    getKernels().store( pKernels, std::memory_order_relaxed );
+  }
+  return pKernels != nullptr;
+}
+
+
+// the integer pcm is signed. SAMPLE_BYTE is the packed size (3 for 24bit)
+template <typename T, int SAMPLE_BYTE> static inline float loadPcm(const uint8_t* pSrc)
+{
+  if constexpr ( SAMPLE_BYTE == 3 ){
+    return (float)( (int32_t)( ( (uint32_t)pSrc[0] << 8 ) | ( (uint32_t)pSrc[1] << 16 ) | ( (uint32_t)pSrc[2] << 24 ) ) >> 8 );
+  } else {
+    T value;
+    memcpy( &value, pSrc, sizeof(T) );
+    return (float)value;
+  }
+}
+
+template <typename T, int SAMPLE_BYTE> static inline void storePcm(uint8_t* pDst, float value)
+{
+  if constexpr ( SAMPLE_BYTE == 4 ){
+    // the largest float which is less than 2^31
+    value = std::clamp( value, -2147483648.0f, 2147483520.0f );
+  } else {
+    value = std::clamp( value, (float)( -( 1 << ( SAMPLE_BYTE * 8 - 1 ) ) ), (float)( ( 1 << ( SAMPLE_BYTE * 8 - 1 ) ) - 1 ) );
+  }
+  int32_t sample = (int32_t)std::lrintf( value );
+  if constexpr ( SAMPLE_BYTE == 3 ){
+    pDst[0] = (uint8_t)( sample );
+    pDst[1] = (uint8_t)( sample >> 8 );
+    pDst[2] = (uint8_t)( sample >> 16 );
+  } else {
+    T dst = (T)sample;
+    memcpy( pDst, &dst, sizeof(T) );
+  }
+}
+
+template <typename T, int SAMPLE_BYTE> static void mixPcm(const uint8_t* pSrc, uint8_t* pDst, const ChannelConverter::ChannelMatrix& matrix, int nSamples)
+{
+  static constexpr int BLOCK_SAMPLES = 128;
+  float srcBlock[ BLOCK_SAMPLES * ChannelConverter::MAX_CHANNELS ];
+  float dstBlock[ BLOCK_SAMPLES * ChannelConverter::MAX_CHANNELS ];
+  const ChannelMixKernels* pKernels = getKernels().load( std::memory_order_relaxed );
+
+  for( int i = 0; i < nSamples; i += BLOCK_SAMPLES ){
+    int nBlockSamples = std::min( BLOCK_SAMPLES, nSamples - i );
+    int nSrcValues = nBlockSamples * matrix.nSrcChannels;
+    int nDstValues = nBlockSamples * matrix.nDstChannels;
+    for( int j = 0; j < nSrcValues; j++, pSrc += SAMPLE_BYTE ){
+      srcBlock[j] = loadPcm<T, SAMPLE_BYTE>( pSrc );
+    }
+    pKernels->mix( srcBlock, dstBlock, matrix.columns.data(), matrix.nSrcChannels, matrix.nDstChannels, nBlockSamples );
+    for( int j = 0; j < nDstValues; j++, pDst += SAMPLE_BYTE ){
+      storePcm<T, SAMPLE_BYTE>( pDst, dstBlock[j] );
+    }
+  }
+}
+
+bool ChannelConverter::mix(const uint8_t* pSrc, uint8_t* pDst, AudioFormat::ENCODING encoding, const ChannelMatrix& matrix, int nSamples)
+{
+  bool bHandled = true;
+
+  switch( encoding ){
+    case AudioFormat::ENCODING::PCM_8BIT:
+      mixPcm<int8_t, 1>( pSrc, pDst, matrix, nSamples );
+      break;
+    case AudioFormat::ENCODING::PCM_16BIT:
+      mixPcm<int16_t, 2>( pSrc, pDst, matrix, nSamples );
+      break;
+    case AudioFormat::ENCODING::PCM_24BIT_PACKED:
+      mixPcm<int32_t, 3>( pSrc, pDst, matrix, nSamples );
+      break;
+    case AudioFormat::ENCODING::PCM_32BIT:
+      mixPcm<int32_t, 4>( pSrc, pDst, matrix, nSamples );
+      break;
+    case AudioFormat::ENCODING::PCM_FLOAT:
+      getKernels().load( std::memory_order_relaxed )->mix( reinterpret_cast<const float*>( pSrc ), reinterpret_cast<float*>( pDst ), matrix.columns.data(), matrix.nSrcChannels, matrix.nDstChannels, nSamples );
+      break;
+    default:
+      bHandled = false;
+      break;
+  }
+
+  return bHandled;
+}
+
 bool ChannelConverter::channelConversion(AudioBuffer& srcBuf, AudioBuffer& dstBuf, AudioFormat::CHANNEL dstChannel)
 {
   AudioFormat srcFormat = srcBuf.getAudioFormat();
   AudioFormat dstFormat(srcFormat.getEncoding(), srcFormat.getSamplingRate(), dstChannel );
 
-  std::vector<ChannelConverter::ChannelMapList> chConvMapList = getChannelConversionMapList(srcFormat.getChannels(), dstFormat.getChannels());
+  const ChannelMatrix* pMatrix = getChannelMatrix( srcFormat.getChannels(), dstFormat.getChannels() );
 
-  if( !chConvMapList.empty() ){
-    // TODO: Check case of mix e.g. L->C, R->C then L+R -> C
-    // The following getSelectedChannelData expects no mix case.
-    AudioFormat::ChannelMapper mapper;
-    for( auto& chMap : chConvMapList ){
-      mapper.insert_or_assign( chMap.dstCh, chMap.srcCh );
+  if( pMatrix && pMatrix->bRouting ){
+    // no mix. just copy the channels
+    AudioFormat::ChannelMapper mapper = pMatrix->mapper;
+    ChannelRemapper remapper( srcFormat, dstFormat, mapper );
+    remapper.process( srcBuf, dstBuf );
+  } else if( pMatrix ){
+    int nSamples = srcBuf.getNumberOfSamples();
+    dstBuf.setAudioFormat( dstFormat );
+    if( dstBuf.getNumberOfSamples() != nSamples ){
+      dstBuf.resize( nSamples, false );
+    }
+    if( !mix( srcBuf.getRawBufferPointer(), dstBuf.getRawBufferPointer(), srcFormat.getEncoding(), *pMatrix, nSamples ) ){
+      dstBuf = srcBuf;
     }
-    AudioBuffer result = srcBuf.getSelectedChannelData(dstFormat, mapper);
-    dstBuf = result;
   } else {
     dstBuf = srcBuf;
   }
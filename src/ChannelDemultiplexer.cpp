@@ -58,39 +58,37 @@ std::vector<std::shared_ptr<AudioBuffer>> ChannelDemuxer::perChannelDemux(std::s
 {
   std::vector<std::shared_ptr<AudioBuffer>> pOutBufs;
   if( pSrcBuffer ){
-    std::vector<uint8_t*> pRawOutBufs;
-    AudioFormat srcFormat = pSrcBuffer->getAudioFormat();
-    int nSamples = pSrcBuffer->getNumberOfSamples();
+    perChannelDemux( *pSrcBuffer, channels, pOutBufs );
+  }
+  return pOutBufs;
+}
+
+void ChannelDemuxer::perChannelDemux(AudioBuffer& srcBuffer, const std::vector<std::vector<AudioFormat::CH>>& channels, std::vector<std::shared_ptr<AudioBuffer>>& pOutBufs)
+{
+  AudioFormat srcFormat = srcBuffer.getAudioFormat();
+  int nSamples = srcBuffer.getNumberOfSamples();
+  int nSampleBytes = srcFormat.getChannelsSampleByte();
+  int nPerChannelBytes = nSampleBytes / srcFormat.getNumberOfChannels();
+  uint8_t* pSrcBufBase = srcBuffer.getRawBufferPointer();
+
+  pOutBufs.resize( channels.size() );
+  for( size_t j=0; j<channels.size(); j++ ){
     // ensure requested channels buffer
-    int i=0;
-    for( auto& aChannels : channels ){
-      pOutBufs.push_back( std::make_shared<AudioBuffer>(
-        AudioFormat(
-          srcFormat.getEncoding(),
-          srcFormat.getSamplingRate(),
-          AudioFormat::getAudioChannel( aChannels.size() )
-          ), nSamples ) );
-      pRawOutBufs.push_back( pOutBufs[i++]->getRawBufferPointer() );
+    const std::vector<AudioFormat::CH>& aChannels = channels[j];
+    AudioFormat outFormat( srcFormat.getEncoding(), srcFormat.getSamplingRate(), AudioFormat::getAudioChannel( aChannels.size() ) );
+    if( !pOutBufs[j] || !pOutBufs[j]->getAudioFormat().equal( outFormat ) ){
+      pOutBufs[j] = std::make_shared<AudioBuffer>( outFormat, nSamples );
+    } else if( pOutBufs[j]->getNumberOfSamples() != nSamples ){
+      pOutBufs[j]->resize( nSamples, false );
     }
-    int nSampleBytes = srcFormat.getChannelsSampleByte();
-    int nPerChannelBytes = nSampleBytes / srcFormat.getNumberOfChannels();
-    uint8_t* pSrcBufBase = pSrcBuffer->getRawBufferPointer();
+    uint8_t* pOutBuf = pOutBufs[j]->getRawBufferPointer();
     for( int i=0; i<nSamples; i++ ){
-      int j=0;
-      for( auto& aChannels : channels ){
-        int theNumOfChannels = aChannels.size();
-        int k=0;
-        for( auto& aChannel : aChannels ){
-          uint8_t* pSrcBuf = pSrcBufBase + nSampleBytes * i + srcFormat.getOffSetByteInSample(aChannel);
-          uint8_t* pOutBase = pRawOutBufs[j] + nPerChannelBytes*theNumOfChannels*i + nPerChannelBytes * k;
-          for( int l=0; l<nPerChannelBytes; l++ ){
-            *pOutBase++ = *pSrcBuf++;
-          }
-          k++;
+      for( auto& aChannel : aChannels ){
+        uint8_t* pSrcBuf = pSrcBufBase + nSampleBytes * i + srcFormat.getOffSetByteInSample(aChannel);
+        for( int l=0; l<nPerChannelBytes; l++ ){
+          *pOutBuf++ = *pSrcBuf++;
         }
-        j++;
       }
     }
   }
-  return pOutBufs;
 }
\ No newline at end of file
@@ -65,7 +65,16 @@ std::shared_ptr<AudioBuffer> ChannelMuxer::perChannelMux(std::vector<std::shared
 
 std::shared_ptr<AudioBuffer> ChannelMuxer::perChannelMux(std::vector<std::shared_ptr<AudioBuffer>> pSrcBufs, std::vector<std::vector<AudioFormat::CH>> channels, AudioFormat::CHANNEL outChannel)
 {
-  std::shared_ptr<AudioBuffer> pOutBuf;
+  std::shared_ptr<AudioBuffer> pOutBuf = std::make_shared<AudioBuffer>();
+  if( !perChannelMux( pSrcBufs, channels, outChannel, *pOutBuf ) ){
+    pOutBuf.reset();
+  }
+  return pOutBuf;
+}
+
+bool ChannelMuxer::perChannelMux(const std::vector<std::shared_ptr<AudioBuffer>>& pSrcBufs, const std::vector<std::vector<AudioFormat::CH>>& channels, AudioFormat::CHANNEL outChannel, AudioBuffer& outBuf)
+{
+  bool result = false;
   if( pSrcBufs.size() && pSrcBufs.size() == channels.size() ){
     AudioFormat srcFormat = pSrcBufs[0]->getAudioFormat();
     int nSamples = pSrcBufs[0]->getNumberOfSamples();
@@ -76,25 +85,23 @@ std::shared_ptr<AudioBuffer> ChannelMuxer::perChannelMux(std::vector<std::shared
       if( !isSameEncodingSamples ) break;
     }
     if( isSameEncodingSamples ){
-      // src buffer pointer
-      std::vector<uint8_t*> pRawSrcBufs;
-      for( int i=0, c=pSrcBufs.size(); i<c; i++ ){
-        pRawSrcBufs.push_back( pSrcBufs[i]->getRawBufferPointer() );
-      }
-
       // ensure out buffer
       AudioFormat dstFormat( srcFormat.getEncoding(), srcFormat.getSamplingRate(), outChannel );
+      if( !outBuf.getAudioFormat().equal( dstFormat ) ){
+        outBuf.setAudioFormat( dstFormat );
+      }
+      if( outBuf.getNumberOfSamples() != nSamples ){
+        outBuf.resize( nSamples, false );
+      }
       int nOutSampleBytes = dstFormat.getChannelsSampleByte();
-      pOutBuf = std::make_shared<AudioBuffer>( dstFormat, nSamples );
-      uint8_t* pRawOutBufBase = pOutBuf->getRawBufferPointer();
+      uint8_t* pRawOutBufBase = outBuf.getRawBufferPointer();
 
-      for( int i=0; i<nSamples; i++ ){
-        for( int j=0, c=pSrcBufs.size(); j<c; j++ ){
-          AudioFormat theSrcFormat = pSrcBufs[j]->getAudioFormat();
-          int nNumberOfChannels = theSrcFormat.getNumberOfChannels();
-          int theSampleBytes = theSrcFormat.getChannelsSampleByte();
-          int thePerChannelSampleByte = theSrcFormat.getSampleByte();
-          uint8_t* pSrcBuf = pRawSrcBufs[j] + theSampleBytes * i;
+      for( int j=0, c=pSrcBufs.size(); j<c; j++ ){
+        AudioFormat theSrcFormat = pSrcBufs[j]->getAudioFormat();
+        int nNumberOfChannels = theSrcFormat.getNumberOfChannels();
+        int thePerChannelSampleByte = theSrcFormat.getSampleByte();
+        uint8_t* pSrcBuf = pSrcBufs[j]->getRawBufferPointer();
+        for( int i=0; i<nSamples; i++ ){
           uint8_t* pRawOutBufOffset = pRawOutBufBase + nOutSampleBytes * i;
           for( int k=0; k<nNumberOfChannels; k++ ){
             uint8_t* pRawOutBuf = pRawOutBufOffset + dstFormat.getOffSetByteInSample( channels[j][k] );
@@ -104,7 +111,8 @@ std::shared_ptr<AudioBuffer> ChannelMuxer::perChannelMux(std::vector<std::shared
           }
         }
       }
+      result = true;
     }
   }
-  return pOutBuf;
+  return result;
 }
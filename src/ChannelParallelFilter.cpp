@@ -0,0 +1,149 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "ChannelParallelFilter.hpp"
+#include "ChannelDemultiplexer.hpp"
+#include "ChannelMultiplexer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+ChannelParallelFilter::ChannelParallelFilter(AudioFormat audioFormat, std::vector<std::shared_ptr<IFilter>> filters, std::shared_ptr<ThreadPoolExecutor> pExecutor) : Filter(), mAudioFormat(audioFormat), mFilters(filters), mpExecutor(pExecutor)
+{
+  mChannelGroups = getChannelGroups( audioFormat, filters.size() );
+  // the group which has no channel doesn't need the filter
+  mFilters.resize( mChannelGroups.size() );
+  if( !mpExecutor ){
+    mpExecutor = ThreadPoolExecutor::getDefaultExecutor();
+  }
+}
+
+ChannelParallelFilter::~ChannelParallelFilter()
+{
+
+}
+
+std::vector<std::vector<AudioFormat::CH>> ChannelParallelFilter::getChannelGroups(AudioFormat audioFormat, int nGroups)
+{
+  std::vector<std::vector<AudioFormat::CH>> result;
+
+  std::vector<AudioFormat::CH> channels;
+  for( auto& [dstCh, srcCh] : audioFormat.getSameChannelMapper() ){
+    channels.push_back( dstCh );
+  }
+  std::sort( channels.begin(), channels.end(), [&audioFormat](AudioFormat::CH a, AudioFormat::CH b){
+    return audioFormat.getOffSetInSample( a ) < audioFormat.getOffSetInSample( b );
+  } );
+
+  int nChannels = channels.size();
+  nGroups = std::min( nGroups, nChannels );
+  for( int i=0, nBegin=0; i<nGroups; i++ ){
+    int nEnd = nChannels * ( i + 1 ) / nGroups;
+    result.push_back( std::vector<AudioFormat::CH>( channels.begin() + nBegin, channels.begin() + nEnd ) );
+    nBegin = nEnd;
+  }
+
+  return result;
+}
+
+void ChannelParallelFilter::process(AudioBuffer& inBuf, AudioBuffer& outBuf)
+{
+  int nGroups = mChannelGroups.size();
+  if( !nGroups || !inBuf.getAudioFormat().equal( mAudioFormat ) ){
+    outBuf = inBuf;
+    return;
+  }
+
+  ChannelDemuxer::perChannelDemux( inBuf, mChannelGroups, mpGroupInBufs );
+  mpGroupOutBufs.resize( nGroups );
+  for( int i=0; i<nGroups; i++ ){
+    std::shared_ptr<AudioBuffer>& pOutBuf = mpGroupOutBufs[i];
+    if( !pOutBuf || !pOutBuf->getAudioFormat().equal( mpGroupInBufs[i]->getAudioFormat() ) || ( pOutBuf->getNumberOfSamples() != mpGroupInBufs[i]->getNumberOfSamples() ) ){
+      pOutBuf = std::make_shared<AudioBuffer>( mpGroupInBufs[i]->getAudioFormat(), mpGroupInBufs[i]->getNumberOfSamples() );
+    }
+  }
+  std::vector<std::shared_ptr<AudioBuffer>>& inBufs = mpGroupInBufs;
+  std::vector<std::shared_ptr<AudioBuffer>>& outBufs = mpGroupOutBufs;
+
+  // the workers and the caller take the groups until all of them are taken.
+  // the state is shared since the worker might start after this returns. then it doesn't take any group.
+  class GroupJob
+  {
+  public:
+    std::atomic<int> nNextGroup = 0;
+    std::atomic<int> nDoneGroups = 0;
+    std::mutex mutexDone;
+    std::condition_variable doneEvent;
+  };
+  std::shared_ptr<GroupJob> pJob = std::make_shared<GroupJob>();
+  auto processGroups = [this, pJob, nGroups, &inBufs, &outBufs](){
+    for( int i = pJob->nNextGroup++; i < nGroups; i = pJob->nNextGroup++ ){
+      mFilters[i]->process( *inBufs[i], *outBufs[i] );
+      if( ++pJob->nDoneGroups == nGroups ){
+        std::lock_guard<std::mutex> lock(pJob->mutexDone);
+        pJob->doneEvent.notify_all();
+      }
+    }
+  };
+  for( int i=1; i<nGroups; i++ ){
+    mpExecutor->execute( processGroups );
+  }
+  processGroups();
+  {
+    std::unique_lock<std::mutex> lock(pJob->mutexDone);
+    pJob->doneEvent.wait( lock, [&]{ return pJob->nDoneGroups == nGroups; } );
+  }
+
+  // inBuf isn't referred any more then outBuf may be the same buffer
+  ChannelMuxer::perChannelMux( outBufs, mChannelGroups, mAudioFormat.getChannels(), outBuf );
+}
+
+std::vector<AudioFormat> ChannelParallelFilter::getSupportedAudioFormats(void)
+{
+  std::vector<AudioFormat> audioFormats;
+  audioFormats.push_back( mAudioFormat );
+  return audioFormats;
+}
+
+int ChannelParallelFilter::getRequiredWindowSizeUsec(void)
+{
+  return mFilters.empty() ? Filter::getRequiredWindowSizeUsec() : mFilters[0]->getRequiredWindowSizeUsec();
+}
+
+int ChannelParallelFilter::getLatencyUSec(void)
+{
+  return mFilters.empty() ? Filter::getLatencyUSec() : mFilters[0]->getLatencyUSec();
+}
+
+int ChannelParallelFilter::getExpectedProcessingUSec(void)
+{
+  // the groups are processed in parallel
+  int nProcessingUsec = 0;
+  for( auto& pFilter : mFilters ){
+    nProcessingUsec = std::max( nProcessingUsec, pFilter->getExpectedProcessingUSec() );
+  }
+  return nProcessingUsec;
+}
+
+int ChannelParallelFilter::stateResourceConsumption(void)
+{
+  int nProcessingResource = 0;
+  for( auto& pFilter : mFilters ){
+    nProcessingResource += pFilter->stateResourceConsumption();
+  }
+  return nProcessingResource;
+}
@@ -0,0 +1,46 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "CpuFeature.hpp"
+
+bool CpuFeature::isSimdSupported(SIMD simd)
+{
+  bool bSupported = false;
+
+  switch( simd ){
+    case SIMD::SCALAR:
+      bSupported = true;
+      break;
+#if defined(__x86_64__) || defined(__i386__)
+    case SIMD::SSE2:
+      bSupported = __builtin_cpu_supports("sse2");
+      break;
+    case SIMD::AVX2:
+      bSupported = __builtin_cpu_supports("avx2");
+      break;
+#endif /* __x86_64__ || __i386__ */
+    default:
+      break;
+  }
+
+  return bSupported;
+}
+
+CpuFeature::SIMD CpuFeature::getSimd(void)
+{
+  static const SIMD simd = isSimdSupported( SIMD::AVX2 ) ? SIMD::AVX2 : isSimdSupported( SIMD::SSE2 ) ? SIMD::SSE2 : SIMD::SCALAR;
+  return simd;
+}
@@ -17,10 +17,120 @@
 #include "DelayFilter.hpp"
 #include "AudioFormat.hpp"
 #include "Buffer.hpp"
-#include "FifoBuffer.hpp"
 #include <algorithm>
+#include <cstring>
 #include <cassert>
 
+struct Pcm24Sample
+{
+  uint8_t data[3];
+};
+
+// exchange the channel's samples (nStride interval) with the delay line from nPosition
+template <typename T> static void delayChannel(uint8_t* pBuf, uint8_t* pLine, int nDelay, int& nPosition, int nStride, int nSamples)
+{
+  T* pSample = reinterpret_cast<T*>( pBuf );
+  T* pLineSample = reinterpret_cast<T*>( pLine );
+  int nPos = nPosition;
+  while( nSamples > 0 ){
+    int nChunk = std::min( nSamples, nDelay - nPos );
+    for( int i = 0; i < nChunk; i++, pSample += nStride ){
+      T tmp = *pSample;
+      *pSample = pLineSample[ nPos + i ];
+      pLineSample[ nPos + i ] = tmp;
+    }
+    nPos = ( nPos + nChunk ) % nDelay;
+    nSamples -= nChunk;
+  }
+  nPosition = nPos;
+}
+
+DelayLine::DelayLine(AudioFormat format, std::vector<int> delaySamples) : mChannels(format.getNumberOfChannels()), mSampleByte(format.getSampleByte()), mIsUniform(true), mDelaySamples(delaySamples)
+{
+  mDelaySamples.resize( mChannels, 0 );
+  for( auto& nDelay : mDelaySamples ){
+    mIsUniform = mIsUniform && ( nDelay == mDelaySamples[0] );
+  }
+
+  if( mIsUniform ){
+    mDelaySamples.resize( 1 );
+    mLines.push_back( ByteBuffer( mDelaySamples[0] * mSampleByte * mChannels, 0 ) );
+  } else {
+    for( auto& nDelay : mDelaySamples ){
+      mLines.push_back( ByteBuffer( nDelay * mSampleByte, 0 ) );
+    }
+  }
+  mPositions.resize( mDelaySamples.size(), 0 );
+}
+
+DelayLine::~DelayLine()
+{
+
+}
+
+int DelayLine::getDelaySamples(AudioFormat format, int delayUsec)
+{
+  float perSampleDurationUsec = 1000000.0f / format.getSamplingRate();
+  return (int)((float)delayUsec / perSampleDurationUsec + 0.9999f);
+}
+
+void DelayLine::reset(void)
+{
+  for( auto& line : mLines ){
+    std::fill( line.begin(), line.end(), 0 );
+  }
+  std::fill( mPositions.begin(), mPositions.end(), 0 );
+}
+
+void DelayLine::process(const uint8_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  int nFrameByte = mSampleByte * mChannels;
+  if( pSrc != pDst ){
+    memcpy( pDst, pSrc, nSamples * nFrameByte );
+  }
+
+  if( mIsUniform ){
+    // the whole frame is delayed. exchange the chunks with the frame's circular buffer
+    int nDelay = mDelaySamples[0];
+    if( nDelay ){
+      uint8_t* pLine = mLines[0].data();
+      int& nPos = mPositions[0];
+      while( nSamples > 0 ){
+        int nChunk = std::min( nSamples, nDelay - nPos );
+        std::swap_ranges( pDst, pDst + nChunk * nFrameByte, pLine + nPos * nFrameByte );
+        pDst += nChunk * nFrameByte;
+        nPos = ( nPos + nChunk ) % nDelay;
+        nSamples -= nChunk;
+      }
+    }
+  } else {
+    for( int ch = 0; ch < mChannels; ch++ ){
+      int nDelay = mDelaySamples[ch];
+      if( nDelay ){
+        uint8_t* pChannel = pDst + ch * mSampleByte;
+        uint8_t* pLine = mLines[ch].data();
+        switch( mSampleByte ){
+          case 1:
+            delayChannel<uint8_t>( pChannel, pLine, nDelay, mPositions[ch], mChannels, nSamples );
+            break;
+          case 2:
+            delayChannel<uint16_t>( pChannel, pLine, nDelay, mPositions[ch], mChannels, nSamples );
+            break;
+          case 3:
+            delayChannel<Pcm24Sample>( pChannel, pLine, nDelay, mPositions[ch], mChannels, nSamples );
+            break;
+          case 4:
+            delayChannel<uint32_t>( pChannel, pLine, nDelay, mPositions[ch], mChannels, nSamples );
+            break;
+          default:
+            break;
+        }
+      }
+    }
+  }
+}
+
+
 std::vector<AudioFormat> DelayFilter::getSupportedAudioFormats(void)
 {
     std::vector<AudioFormat> audioFormats;
@@ -38,33 +148,27 @@ DelayFilter::DelayFilter(AudioFormat audioFormat, int delayUsec) : mAudioFormat(
 {
   mWindowSize = std::max( DEFAULT_WINDOW_SIZE_USEC, delayUsec );
   if( delayUsec ){
-    int samplingRate = audioFormat.getSamplingRate();
-    float perSampleDurationUsec = 1000000.0f / samplingRate;
-    int nDelaySamples = (int)((float)delayUsec / perSampleDurationUsec + 0.9999f);
-    AudioBuffer delayZeroData(audioFormat, nDelaySamples);
-    ByteBuffer zeroData( audioFormat.getChannelsSampleByte() * nDelaySamples, 0);
-    delayZeroData.setRawBuffer( zeroData );
-    mpDelayBuf = std::make_shared<FifoBuffer>( audioFormat );
-    mpDelayBuf->write(delayZeroData);
+    int nDelaySamples = DelayLine::getDelaySamples( audioFormat, delayUsec );
+    mpDelayLine = std::make_shared<DelayLine>( audioFormat, std::vector<int>( audioFormat.getNumberOfChannels(), nDelaySamples ) );
   } else {
-    mpDelayBuf.reset();
+    mpDelayLine.reset();
   }
 }
 
 DelayFilter::~DelayFilter()
 {
-  if( mpDelayBuf ){
-    mpDelayBuf->unlock();
-    mpDelayBuf.reset();
-  }
+  mpDelayLine.reset();
 }
 
 void DelayFilter::process(AudioBuffer& srcBuf, AudioBuffer& dstBuf)
 {
   if( mAudioFormat.equal( srcBuf.getAudioFormat() ) && mAudioFormat.equal( dstBuf.getAudioFormat() )){
-    if( mpDelayBuf ){
-      mpDelayBuf->write( srcBuf );
-      mpDelayBuf->read( dstBuf );
+    if( mpDelayLine ){
+      int nSamples = srcBuf.getNumberOfSamples();
+      if( dstBuf.getNumberOfSamples() != nSamples ){
+        dstBuf.resize( nSamples, false );
+      }
+      mpDelayLine->process( srcBuf.getRawBufferPointer(), dstBuf.getRawBufferPointer(), nSamples );
     } else {
       dstBuf = srcBuf;
     }
@@ -82,79 +186,18 @@ PerChannelDelayFilter::PerChannelDelayFilter(AudioFormat audioFormat, ChannelDel
     mWindowSize = std::max( mWindowSize, delayUsec );
   }
 
-  // setup per-channel delay to per-chanel FIFO buffer
-  int samplingRate = audioFormat.getSamplingRate();
-  AudioFormat chFormat( audioFormat.getEncoding(), samplingRate, AudioFormat::CHANNEL::CHANNEL_MONO );
-  float perSampleDurationUsec = 1000000.0f / samplingRate;
-
+  // setup per-channel delay to the delay line of the channel's position
+  std::vector<int> delaySamples( audioFormat.getNumberOfChannels(), 0 );
   for(auto& [ch, delayUsec] : channelDelay){
-    // create per-channel fifo buffer
-    std::shared_ptr<FifoBuffer> pFifoBuffer = std::make_shared<FifoBuffer>( chFormat );
-    mDelayBuf[ch] = pFifoBuffer;
-
-    // enqueue delay zero data to fifo buffer
-    int nDelaySamples = (int)((float)delayUsec / perSampleDurationUsec + 0.9999f);
-    AudioBuffer delayZeroData(chFormat, nDelaySamples);
-    ByteBuffer zeroData( chFormat.getChannelsSampleByte() * nDelaySamples, 0);
-    delayZeroData.setRawBuffer( zeroData );
-    pFifoBuffer->write(delayZeroData);
+    int nChannel = audioFormat.getOffSetInSample( ch );
+    if( nChannel >= 0 && nChannel < (int)delaySamples.size() ){
+      delaySamples[ nChannel ] = DelayLine::getDelaySamples( audioFormat, delayUsec );
+    }
   }
+  mpDelayLine = std::make_shared<DelayLine>( audioFormat, delaySamples );
 }
 
 PerChannelDelayFilter::~PerChannelDelayFilter()
 {
-  for(auto& [ch, pFifoBuf] : mDelayBuf){
-    pFifoBuf->unlock();
-  }
-  for(auto& [ch, pFifoBuf] : mDelayBuf){
-    pFifoBuf.reset();
-  }
-  mDelayBuf.clear();
-}
 
-void PerChannelDelayFilter::process(AudioBuffer& srcBuf, AudioBuffer& dstBuf)
-{
-  if( mAudioFormat.equal( srcBuf.getAudioFormat() ) && mAudioFormat.equal( dstBuf.getAudioFormat() )){
-
-    // create temporary buffer
-    AudioFormat tmpFormat( mAudioFormat.getEncoding(), mAudioFormat.getSamplingRate(), AudioFormat::CHANNEL::CHANNEL_MONO );
-    int nSrcSamples = srcBuf.getNumberOfSamples();
-    std::map<AudioFormat::CH, std::shared_ptr<AudioBuffer>> tmpBuffers;
-    for(auto& [ch, delayUsec] : mChannelDelay){
-     tmpBuffers[ch] = std::make_shared<AudioBuffer>( tmpFormat, nSrcSamples );
-    }
-
-    // read per-channel data
-    for(int i=0; i<nSrcSamples; i++){
-      AudioSample aSrcSample = srcBuf.getSample(i);
-      for(auto& [ch, delayUsec] : mChannelDelay){
-        AudioSample tmpSample(tmpFormat);
-        tmpSample.setData( AudioFormat::CH::MONO, aSrcSample.getData(ch) );
-        tmpBuffers[ch]->setSample(i, tmpSample);
-      }
-    }
-
-    // enqueue to per-channel fifo buffer
-    for(auto& [ch, pFifoBuf] : mDelayBuf){
-      pFifoBuf->write( *tmpBuffers[ch] );
-      tmpBuffers[ch] = std::make_shared<AudioBuffer>( tmpFormat, nSrcSamples);
-      pFifoBuf->read( *tmpBuffers[ch] );
-    }
-
-    // dequeue from per-channel fifo buffer & write out to the destinated buffer
-    for(int i=0; i<nSrcSamples; i++){
-      AudioSample aDstSample( mAudioFormat );
-      for(auto& [ch, delayUsec] : mChannelDelay){
-        AudioSample aSrcSample = tmpBuffers[ch]->getSample(i);
-        aDstSample.setData( ch, aSrcSample.getData(AudioFormat::CH::MONO) );
-      }
-      dstBuf.setSample(i, aDstSample);
-    }
-
-    for(auto& [ch, delayUsec] : mChannelDelay){
-      tmpBuffers[ch].reset();
-    }
-    tmpBuffers.clear();
-  }
 }
-
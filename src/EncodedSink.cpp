@@ -21,6 +21,7 @@
 
 EncodedSink::EncodedSink(std::shared_ptr<ISink> pSink, bool bTranscode):ISink(), mpSink(pSink), mbTranscode(bTranscode), mpDecoder(nullptr), mpEncoder(nullptr)
 {
+  setInnerAudioBase( mpSink );
 }
 
 EncodedSink::~EncodedSink()
@@ -34,6 +35,7 @@ std::shared_ptr<ISink> EncodedSink::attachSink(std::shared_ptr<ISink> pSink)
 {
   std::shared_ptr<ISink> pPrevSink = mpSink;
   mpSink = pSink;
+  setInnerAudioBase( mpSink );
   return pPrevSink;
 }
 
@@ -41,6 +43,7 @@ std::shared_ptr<ISink> EncodedSink::detachSink(void)
 {
   std::shared_ptr<ISink> pPrevSink = mpSink;
   mpSink.reset();
+  setInnerAudioBase( nullptr );
   return pPrevSink;
 }
 
@@ -88,15 +91,15 @@ void EncodedSink::writePrimitive(IAudioBuffer& buf)
       ensureTranscoder( srcFormat, dstFormat );
       AudioBuffer* pTmpBuf = dynamic_cast<AudioBuffer*>(&buf);
       int nTmpOutSamples = pTmpBuf ? pTmpBuf->getNumberOfSamples() : 240; // the size is not matter. the codec can use any size
-      AudioBuffer tmpOutBuf( dstFormat, nTmpOutSamples );
+      std::shared_ptr<AudioBuffer> pTmpOutBuf = mBufferPool.acquire( dstFormat, nTmpOutSamples );
       IAudioBuffer* pInBuf = &buf;
-      IAudioBuffer* pOutBuf = &tmpOutBuf;
+      IAudioBuffer* pOutBuf = pTmpOutBuf.get();
       if( !mpDecoder && !mpEncoder ){
         // src & dst are PCM then format conversion
         AudioBuffer* pTmpInBuf = dynamic_cast<AudioBuffer*>(pInBuf);
         AudioBuffer* pTmpOutBuf = dynamic_cast<AudioBuffer*>(pOutBuf);
         if( pTmpInBuf && pTmpOutBuf /* just in case, double check */ ){
-          AudioFormatAdaptor::convert( *dynamic_cast<AudioBuffer*>(pInBuf), *dynamic_cast<AudioBuffer*>(pOutBuf) );
+          AudioFormatAdaptor::convert( *dynamic_cast<AudioBuffer*>(pInBuf), *dynamic_cast<AudioBuffer*>(pOutBuf), mpSamplingRateConverter );
         }
         pOutBuf = pInBuf;
       } else {
@@ -18,8 +18,10 @@
 #include <iterator>
 #include <thread>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 
-FifoBufferBase::FifoBufferBase(AudioFormat format):mFormat(format), mFifoSizeLimit(0), mReadBlocked(false), mUnlockReadBlock(false)
+FifoBufferBase::FifoBufferBase(AudioFormat format):mFormat(format), mFifoSizeLimit(0), mReadBlocked(false), mUnlockGeneration(0), mHasReadReadyListener(false), mHasWriteReadyListener(false)
 {
 
 }
@@ -29,9 +31,17 @@ FifoBufferBase::~FifoBufferBase()
 
 }
 
+void FifoBufferBase::advanceUnlockGeneration(void)
+{
+  std::lock_guard<std::mutex> lock(mReadBlockEventMutex);
+  mUnlockGeneration++;
+  mReadBlockEvent.notify_all();
+}
+
 int FifoBufferBase::getBufferedSamples(void)
 {
-  return mBuf.size() ? ( mBuf.size() / mFormat.getChannelsSampleByte() ) : 0;
+  int nBufferedBytes = getBufferedBytes();
+  return nBufferedBytes ? ( nBufferedBytes / mFormat.getChannelsSampleByte() ) : 0;
 }
 
 int FifoBufferBase::getBufferedBytes(void)
@@ -55,7 +65,7 @@ void FifoBufferBase::setAudioFormatPrimitive( AudioFormat audioFormat )
     if( mFifoSizeLimit ){
       setFifoSizeLimit( nSamples );
     }
-    mBuf.clear();
+    clearBuffer();
   }
 }
 
@@ -64,8 +74,52 @@ void FifoBufferBase::clearBuffer(void)
   mBuf.clear();
 }
 
+void FifoBufferBase::setReadReadyListener(std::function<void(void)> listener)
+{
+  std::lock_guard<std::mutex> lock(mReadyListenerMutex);
+  mReadReadyListener = listener;
+  mHasReadReadyListener = ( listener != nullptr );
+}
 
-FifoBuffer::FifoBuffer(AudioFormat format):FifoBufferBase(format), mWriteBlocked(false), mUnlockWriteBlock(false)
+void FifoBufferBase::setWriteReadyListener(std::function<void(void)> listener)
+{
+  std::lock_guard<std::mutex> lock(mReadyListenerMutex);
+  mWriteReadyListener = listener;
+  mHasWriteReadyListener = ( listener != nullptr );
+}
+
+void FifoBufferBase::notifyReadReady(void)
+{
+  if( mHasReadReadyListener ){
+    std::function<void(void)> listener;
+    {
+      std::lock_guard<std::mutex> lock(mReadyListenerMutex);
+      listener.swap( mReadReadyListener );
+      mHasReadReadyListener = false;
+    }
+    if( listener ){
+      listener();
+    }
+  }
+}
+
+void FifoBufferBase::notifyWriteReady(void)
+{
+  if( mHasWriteReadyListener ){
+    std::function<void(void)> listener;
+    {
+      std::lock_guard<std::mutex> lock(mReadyListenerMutex);
+      listener.swap( mWriteReadyListener );
+      mHasWriteReadyListener = false;
+    }
+    if( listener ){
+      listener();
+    }
+  }
+}
+
+
+FifoBuffer::FifoBuffer(AudioFormat format):FifoBufferBase(format), mWriteBlocked(false)
 {
 
 }
@@ -84,7 +138,8 @@ bool FifoBuffer::read(IAudioBuffer& audioBuf)
     int size = audioBuf.getRawBufferSize();
 
     std::atomic<bool> bReceived = false;
-    while( !bReceived && !mUnlockReadBlock){
+    uint64_t nUnlockGeneration = mUnlockGeneration;
+    while( !bReceived && !isUnlocked( nUnlockGeneration ) ){
       if( mBuf.size() >= size ){
         mBufMutex.lock();
         {
@@ -103,11 +158,12 @@ bool FifoBuffer::read(IAudioBuffer& audioBuf)
           std::lock_guard<std::mutex> lock(mWriteBlockEventMutex);
           mWriteBlockEvent.notify_all();
         }
+        notifyWriteReady();
       } else {
         if( !mReadBlocked && !mWriteBlocked ){
           mReadBlocked = true;
           std::unique_lock<std::mutex> lock(mReadBlockEventMutex);
-          mReadBlockEvent.wait(lock);
+          mReadBlockEvent.wait( lock, [&]{ return isUnlocked( nUnlockGeneration ) || ( mBuf.size() >= (size_t)size ); } );
           mReadBlocked = false;
         }
       }
@@ -126,11 +182,12 @@ bool FifoBuffer::write(IAudioBuffer& audioBuf)
     ByteBuffer& extBuf = audioBuf.getRawBuffer();
     int nSizeExtBuf = extBuf.size();
     std::atomic<bool> bSent = false;
-    while( !bSent && !mUnlockWriteBlock){
+    uint64_t nUnlockGeneration = mUnlockGeneration;
+    while( !bSent && !isUnlocked( nUnlockGeneration ) ){
       if( !mReadBlocked && !mWriteBlocked && mFifoSizeLimit && ( mFifoSizeLimit > mBuf.size() ) && ( (mBuf.size()+nSizeExtBuf) > mFifoSizeLimit ) ){
           mWriteBlocked = true;
           std::unique_lock<std::mutex> lock(mWriteBlockEventMutex);
-          mWriteBlockEvent.wait(lock);
+          mWriteBlockEvent.wait( lock, [&]{ return isUnlocked( nUnlockGeneration ) || FifoBuffer::isWriteReady( nSizeExtBuf ); } );
           mWriteBlocked = false;
       } else {
         mBufMutex.lock();
@@ -153,6 +210,7 @@ bool FifoBuffer::write(IAudioBuffer& audioBuf)
           std::lock_guard<std::mutex> lock(mReadBlockEventMutex);
           mReadBlockEvent.notify_all();
         }
+        notifyReadReady();
       }
     }
   }
@@ -160,13 +218,368 @@ bool FifoBuffer::write(IAudioBuffer& audioBuf)
   return bResult;
 }
 
+bool FifoBuffer::isWriteReady(int nBytes)
+{
+  int nBufferedBytes = mBuf.size();
+  return !( mFifoSizeLimit && ( mFifoSizeLimit > nBufferedBytes ) && ( ( nBufferedBytes + nBytes ) > mFifoSizeLimit ) );
+}
+
 void FifoBuffer::unlock(void)
 {
-  mUnlockReadBlock = true;
-  mUnlockWriteBlock = true;
-  mReadBlockEvent.notify_all();
-  mWriteBlockEvent.notify_all();
-  std::this_thread::sleep_for(std::chrono::microseconds(100));
-  mUnlockReadBlock = false;
-  mUnlockWriteBlock = false;
+  advanceUnlockGeneration();
+  {
+    std::lock_guard<std::mutex> lock(mWriteBlockEventMutex);
+    mWriteBlockEvent.notify_all();
+  }
+  notifyReadReady();
+  notifyWriteReady();
+}
+
+
+RingFifoBuffer::RingFifoBuffer(AudioFormat format):FifoBufferBase(format), mWritePos(0), mReadPos(0), mReadRequestSize(0), mReading(false), mResizing(false), mWriteBlocked(false)
+{
+
+}
+
+RingFifoBuffer::~RingFifoBuffer()
+{
+
+}
+
+int RingFifoBuffer::getBufferedBytes(void)
+{
+  return (int)( mWritePos.load() - mReadPos.load() );
+}
+
+void RingFifoBuffer::clearBuffer(void)
+{
+  // mReadPos is the consumer's then update it in the same way as resizeRing()
+  {
+    std::lock_guard<std::mutex> lock(mRingControlMutex);
+    excludeReader();
+    mReadPos.store( mWritePos.load() );
+    mResizing = false;
+  }
+  notifyWriter();
+  notifyWriteReady();
+}
+
+void RingFifoBuffer::copyToRing(uint64_t nPos, uint8_t* pSrc, int nSize)
+{
+  int nCapacity = mBuf.size();
+  int nOffset = nPos % nCapacity;
+  int nFirst = std::min( nSize, nCapacity - nOffset );
+  uint8_t* pRing = mBuf.data();
+  memcpy( pRing + nOffset, pSrc, nFirst );
+  if( nSize > nFirst ){
+    memcpy( pRing, pSrc + nFirst, nSize - nFirst );
+  }
+}
+
+void RingFifoBuffer::copyFromRing(uint64_t nPos, uint8_t* pDst, int nSize)
+{
+  int nCapacity = mBuf.size();
+  int nOffset = nPos % nCapacity;
+  int nFirst = std::min( nSize, nCapacity - nOffset );
+  uint8_t* pRing = mBuf.data();
+  memcpy( pDst, pRing + nOffset, nFirst );
+  if( nSize > nFirst ){
+    memcpy( pDst + nFirst, pRing, nSize - nFirst );
+  }
+}
+
+void RingFifoBuffer::excludeReader(void)
+{
+  // the reader checks mResizing after setting mReading. this may wait for the reader's current copy only.
+  mResizing = true;
+  while( mReading ){
+    std::this_thread::yield();
+  }
+}
+
+void RingFifoBuffer::resizeRing(int nCapacity)
+{
+  // exclude the consumer and clearBuffer() during the ring replacement. this is the only path which may wait for the consumer except full.
+  std::lock_guard<std::mutex> lock(mRingControlMutex);
+  excludeReader();
+
+  uint64_t nReadPos = mReadPos.load();
+  int nBufferedBytes = (int)( mWritePos.load() - nReadPos );
+  ByteBuffer newRing( nCapacity, 0 );
+  if( nBufferedBytes ){
+    copyFromRing( nReadPos, newRing.data(), nBufferedBytes );
+  }
+  mBuf.swap( newRing );
+  mReadPos.store( 0 );
+  mWritePos.store( nBufferedBytes );
+
+  mResizing = false;
+}
+
+void RingFifoBuffer::notifyReader(void)
+{
+  if( mReadBlocked ){
+    std::lock_guard<std::mutex> lock(mReadBlockEventMutex);
+    mReadBlockEvent.notify_all();
+  }
+}
+
+void RingFifoBuffer::notifyWriter(void)
+{
+  if( mWriteBlocked ){
+    std::lock_guard<std::mutex> lock(mWriteBlockEventMutex);
+    mWriteBlockEvent.notify_all();
+  }
+}
+
+bool RingFifoBuffer::read(IAudioBuffer& audioBuf)
+{
+  bool bResult = audioBuf.getAudioFormat().equal( mFormat );
+  assert( bResult == true );
+
+  if( bResult ){
+    int size = audioBuf.getRawBufferSize();
+    bool bReceived = !size;
+
+    uint64_t nUnlockGeneration = mUnlockGeneration;
+    while( !bReceived && !isUnlocked( nUnlockGeneration ) ){
+      mReading = true;
+      if( !mResizing ){
+        uint64_t nReadPos = mReadPos.load( std::memory_order_relaxed );
+        if( ( mWritePos.load( std::memory_order_acquire ) - nReadPos ) >= (uint64_t)size ){
+          copyFromRing( nReadPos, audioBuf.getRawBufferPointer(), size );
+          mReadPos.store( nReadPos + size );
+          bReceived = true;
+        }
+      }
+      mReading = false;
+
+      if( bReceived ){
+        notifyWriter();
+        notifyWriteReady();
+      } else {
+        // let the producer know how much is required since the ring might need to be extended for this request
+        mReadRequestSize = size;
+        notifyWriter();
+        std::unique_lock<std::mutex> lock(mReadBlockEventMutex);
+        mReadBlocked = true;
+        mReadBlockEvent.wait( lock, [&]{ return isUnlocked( nUnlockGeneration ) || ( !mResizing && getBufferedBytes() >= size ); } );
+        mReadBlocked = false;
+      }
+    }
+    mReadRequestSize = 0;
+  }
+
+  return bResult;
+}
+
+bool RingFifoBuffer::write(IAudioBuffer& audioBuf)
+{
+  bool bResult = audioBuf.getAudioFormat().equal( mFormat );
+  assert( bResult == true );
+
+  if( bResult ){
+    ByteBuffer& extBuf = audioBuf.getRawBuffer();
+    int nSizeExtBuf = extBuf.size();
+    bool bSent = !nSizeExtBuf;
+
+    uint64_t nUnlockGeneration = mUnlockGeneration;
+    while( !bSent && !isUnlocked( nUnlockGeneration ) ){
+      // the ring must hold this write and the pending read request at once. Otherwise both sides will wait each other.
+      int nRequiredCapacity = std::max( mFifoSizeLimit, nSizeExtBuf + mReadRequestSize );
+      int nCapacity = mBuf.size();
+      if( nCapacity < nRequiredCapacity ){
+        resizeRing( std::max( nRequiredCapacity, nCapacity * 2 ) );
+        nCapacity = mBuf.size();
+      }
+
+      uint64_t nWritePos = mWritePos.load( std::memory_order_relaxed );
+      if( ( nCapacity - (int)( nWritePos - mReadPos.load( std::memory_order_acquire ) ) ) >= nSizeExtBuf ){
+        copyToRing( nWritePos, extBuf.data(), nSizeExtBuf );
+        mWritePos.store( nWritePos + nSizeExtBuf );
+        bSent = true;
+        notifyReader();
+        notifyReadReady();
+      } else if( !mFifoSizeLimit || getBufferedBytes() >= mFifoSizeLimit ){
+        // the size limit is the soft limit as FifoBuffer : the writer waits only while the buffered data is under the limit.
+        // Otherwise extend the ring instead of waiting for the consumer which may not read any more (e.g. during the stop).
+        resizeRing( std::max( nCapacity * 2, nCapacity + nSizeExtBuf ) );
+      } else {
+        std::unique_lock<std::mutex> lock(mWriteBlockEventMutex);
+        mWriteBlocked = true;
+        mWriteBlockEvent.wait( lock, [&]{ return isUnlocked( nUnlockGeneration ) || ( (int)mBuf.size() - getBufferedBytes() ) >= nSizeExtBuf || ( nSizeExtBuf + mReadRequestSize ) > (int)mBuf.size() || getBufferedBytes() >= mFifoSizeLimit; } );
+        mWriteBlocked = false;
+      }
+    }
+  }
+
+  return bResult;
+}
+
+bool RingFifoBuffer::isWriteReady(int nBytes)
+{
+  // same as write() : the writer waits only if the ring is full and the buffered data is under the limit. Otherwise the ring is extended.
+  int nBufferedBytes = getBufferedBytes();
+  int nCapacity = std::max( (int)mBuf.size(), std::max( mFifoSizeLimit, nBytes + mReadRequestSize ) );
+  return !mFifoSizeLimit || ( nBufferedBytes >= mFifoSizeLimit ) || ( ( nCapacity - nBufferedBytes ) >= nBytes );
+}
+
+void RingFifoBuffer::unlock(void)
+{
+  advanceUnlockGeneration();
+  {
+    std::lock_guard<std::mutex> lock(mWriteBlockEventMutex);
+    mWriteBlockEvent.notify_all();
+  }
+  notifyReadReady();
+  notifyWriteReady();
+}
+
+
+HandoffFifoBuffer::HandoffFifoBuffer(AudioFormat format, int nSlots):FifoBufferBase(format), mSlots( std::max( nSlots, 2 ) ), mWriteSlot(0), mWrittenBytes(0), mReadSlot(0), mReadBytes(0), mReadOffset(0), mWriteBlocked(false)
+{
+
+}
+
+HandoffFifoBuffer::~HandoffFifoBuffer()
+{
+
+}
+
+int HandoffFifoBuffer::getBufferedBytes(void)
+{
+  return (int)( mWrittenBytes.load() - mReadBytes.load() );
+}
+
+void HandoffFifoBuffer::clearBuffer(void)
+{
+  mReadOffset = 0;
+  mReadBytes.store( mWrittenBytes.load() );
+  mReadSlot.store( mWriteSlot.load() );
+  notifyWriter();
+}
+
+void HandoffFifoBuffer::notifyReader(void)
+{
+  if( mReadBlocked ){
+    std::lock_guard<std::mutex> lock(mReadBlockEventMutex);
+    mReadBlockEvent.notify_all();
+  }
+}
+
+void HandoffFifoBuffer::notifyWriter(void)
+{
+  if( mWriteBlocked ){
+    std::lock_guard<std::mutex> lock(mWriteBlockEventMutex);
+    mWriteBlockEvent.notify_all();
+  }
+}
+
+void HandoffFifoBuffer::releaseReadSlot(uint64_t nReadSlot)
+{
+  mReadOffset = 0;
+  mReadSlot.store( nReadSlot + 1 );
+  notifyWriter();
+  notifyWriteReady();
+}
+
+bool HandoffFifoBuffer::read(IAudioBuffer& audioBuf, bool bHandoff)
+{
+  bool bResult = audioBuf.getAudioFormat().equal( mFormat );
+  assert( bResult == true );
+
+  if( bResult ){
+    ByteBuffer& extBuf = audioBuf.getRawBuffer();
+    int size = extBuf.size();
+    int nReceived = 0;
+    int nSlots = mSlots.size();
+
+    uint64_t nUnlockGeneration = mUnlockGeneration;
+    while( ( nReceived < size ) && !isUnlocked( nUnlockGeneration ) ){
+      uint64_t nReadSlot = mReadSlot.load( std::memory_order_relaxed );
+      if( nReadSlot != mWriteSlot.load( std::memory_order_acquire ) ){
+        ByteBuffer& slot = mSlots[ nReadSlot % nSlots ];
+        if( bHandoff && !nReceived && !mReadOffset && ( (int)slot.size() == size ) ){
+          // take the written memory and give back the audioBuf's memory for the next write
+          extBuf.swap( slot );
+          nReceived = size;
+          mReadBytes.fetch_add( size );
+          releaseReadSlot( nReadSlot );
+        } else {
+          int nCopySize = std::min( (int)slot.size() - mReadOffset, size - nReceived );
+          memcpy( extBuf.data() + nReceived, slot.data() + mReadOffset, nCopySize );
+          nReceived += nCopySize;
+          mReadOffset += nCopySize;
+          mReadBytes.fetch_add( nCopySize );
+          if( mReadOffset >= (int)slot.size() ){
+            releaseReadSlot( nReadSlot );
+          }
+        }
+      } else {
+        std::unique_lock<std::mutex> lock(mReadBlockEventMutex);
+        mReadBlocked = true;
+        mReadBlockEvent.wait( lock, [&]{ return isUnlocked( nUnlockGeneration ) || ( mReadSlot.load() != mWriteSlot.load() ); } );
+        mReadBlocked = false;
+      }
+    }
+  }
+
+  return bResult;
+}
+
+bool HandoffFifoBuffer::write(IAudioBuffer& audioBuf, bool bHandoff)
+{
+  bool bResult = audioBuf.getAudioFormat().equal( mFormat );
+  assert( bResult == true );
+
+  if( bResult ){
+    ByteBuffer& extBuf = audioBuf.getRawBuffer();
+    int nSizeExtBuf = extBuf.size();
+    bool bSent = !nSizeExtBuf;
+    uint64_t nSlots = mSlots.size();
+
+    uint64_t nUnlockGeneration = mUnlockGeneration;
+    while( !bSent && !isUnlocked( nUnlockGeneration ) ){
+      uint64_t nWriteSlot = mWriteSlot.load( std::memory_order_relaxed );
+      if( ( nWriteSlot - mReadSlot.load( std::memory_order_acquire ) ) < nSlots ){
+        // the free slot holds the memory which was given back by the consumer
+        ByteBuffer& slot = mSlots[ nWriteSlot % nSlots ];
+        if( bHandoff ){
+          slot.swap( extBuf );
+          extBuf.resize( nSizeExtBuf );
+        } else {
+          slot.resize( nSizeExtBuf );
+          memcpy( slot.data(), extBuf.data(), nSizeExtBuf );
+        }
+        mWrittenBytes.fetch_add( nSizeExtBuf );
+        mWriteSlot.store( nWriteSlot + 1 );
+        bSent = true;
+        notifyReader();
+        notifyReadReady();
+      } else {
+        std::unique_lock<std::mutex> lock(mWriteBlockEventMutex);
+        mWriteBlocked = true;
+        mWriteBlockEvent.wait( lock, [&]{ return isUnlocked( nUnlockGeneration ) || ( ( mWriteSlot.load() - mReadSlot.load() ) < nSlots ); } );
+        mWriteBlocked = false;
+      }
+    }
+  }
+
+  return bResult;
+}
+
+bool HandoffFifoBuffer::isWriteReady(int nBytes)
+{
+  return ( mWriteSlot.load() - mReadSlot.load() ) < mSlots.size();
+}
+
+void HandoffFifoBuffer::unlock(void)
+{
+  advanceUnlockGeneration();
+  {
+    std::lock_guard<std::mutex> lock(mWriteBlockEventMutex);
+    mWriteBlockEvent.notify_all();
+  }
+  notifyReadReady();
+  notifyWriteReady();
 }
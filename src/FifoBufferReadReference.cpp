@@ -38,7 +38,8 @@ bool FifoBufferReadReference::readReference(IAudioBuffer& audioBuf)
     size = size ? size : ( mBuf.size() ? (mBuf.size() / 3) : 256 );
 
     std::atomic<bool> bReceived = false;
-    while( !bReceived && !mUnlockReadBlock ){
+    uint64_t nUnlockGeneration = mUnlockGeneration;
+    while( !bReceived && !isUnlocked( nUnlockGeneration ) ){
       if( mBuf.size() >= size ){
         mBufMutex.lock();
         {
@@ -56,7 +57,7 @@ bool FifoBufferReadReference::readReference(IAudioBuffer& audioBuf)
         if( !mReadBlocked ){
           mReadBlocked = true;
           std::unique_lock<std::mutex> lock(mReadBlockEventMutex);
-          mReadBlockEvent.wait(lock);
+          mReadBlockEvent.wait( lock, [&]{ return isUnlocked( nUnlockGeneration ) || ( mBuf.size() >= (size_t)size ); } );
           mReadBlocked = false;
         }
       }
@@ -113,8 +114,5 @@ bool FifoBufferReadReference::write(IAudioBuffer& audioBuf)
 
 void FifoBufferReadReference::unlock(void)
 {
-  mUnlockReadBlock = true;
-  mReadBlockEvent.notify_all();
-  std::this_thread::sleep_for(std::chrono::microseconds(100));
-  mUnlockReadBlock = false;
+  advanceUnlockGeneration();
 }
\ No newline at end of file
@@ -0,0 +1,421 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "GraphPipe.hpp"
+#include "Mixer.hpp"
+#include <iostream>
+#include <algorithm>
+#include <span>
+#include <cstring>
+
+GraphPipe::GraphPipe():Pipe()
+{
+  mMutexFilters.lock();
+  mEdges.push_back( Edge( nullptr, nullptr ) );
+  publishGraphLocked();
+  mMutexFilters.unlock();
+}
+
+GraphPipe::~GraphPipe()
+{
+  // the processing context uses this class's buffers
+  stop();
+}
+
+bool GraphPipe::isNodeIncludedLocked(std::shared_ptr<IFilter> pFilter)
+{
+  return std::find( mNodes.begin(), mNodes.end(), pFilter ) != mNodes.end();
+}
+
+bool GraphPipe::isConnectedLocked(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo)
+{
+  return std::find( mEdges.begin(), mEdges.end(), Edge( pFrom, pTo ) ) != mEdges.end();
+}
+
+bool GraphPipe::isReachableLocked(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo)
+{
+  std::vector<std::shared_ptr<IFilter>> pending = { pFrom };
+  std::vector<std::shared_ptr<IFilter>> visited;
+  while( !pending.empty() ){
+    std::shared_ptr<IFilter> pFilter = pending.back();
+    pending.pop_back();
+    if( pFilter == pTo ){
+      return true;
+    }
+    if( std::find( visited.begin(), visited.end(), pFilter ) == visited.end() ){
+      visited.push_back( pFilter );
+      for( auto& [pEdgeFrom, pEdgeTo] : mEdges ){
+        if( pEdgeFrom == pFilter && pEdgeTo ){
+          pending.push_back( pEdgeTo );
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void GraphPipe::addNodeLocked(std::shared_ptr<IFilter> pFilter)
+{
+  if( pFilter && !isNodeIncludedLocked( pFilter ) ){
+    mNodes.push_back( pFilter );
+  }
+}
+
+void GraphPipe::publishGraphLocked(void)
+{
+  std::shared_ptr<const Schedule> pSchedule = createScheduleLocked();
+  // publish the schedule first then the processing context which sees the new filter chain always finds its schedule
+  mpRetiredSchedule = std::atomic_exchange_explicit( &mpSchedule, pSchedule, std::memory_order_acq_rel );
+  publishFiltersLocked( pSchedule->pFilters );
+}
+
+std::shared_ptr<const GraphPipe::Schedule> GraphPipe::createScheduleLocked(void)
+{
+  std::shared_ptr<Schedule> pSchedule = std::make_shared<Schedule>();
+  const int SOURCE = -1, SINK = -2;
+  int nNodes = mNodes.size();
+  auto getIndex = [&](std::shared_ptr<IFilter> pFilter, int nNullIndex){
+    return pFilter ? (int)( std::find( mNodes.begin(), mNodes.end(), pFilter ) - mNodes.begin() ) : nNullIndex;
+  };
+  std::vector<std::pair<int, int>> edges;
+  for( auto& [pFrom, pTo] : mEdges ){
+    edges.push_back( { getIndex( pFrom, SOURCE ), getIndex( pTo, SINK ) } );
+  }
+
+  // only the nodes on the path from the source to the sink are processed
+  std::vector<bool> fromSource( nNodes, false ), toSink( nNodes, false );
+  for( bool bUpdated = true; bUpdated; ){
+    bUpdated = false;
+    for( auto& [nFrom, nTo] : edges ){
+      if( nTo >= 0 && !fromSource[nTo] && ( nFrom == SOURCE || ( nFrom >= 0 && fromSource[nFrom] ) ) ){
+        fromSource[nTo] = bUpdated = true;
+      }
+      if( nFrom >= 0 && !toSink[nFrom] && ( nTo == SINK || ( nTo >= 0 && toSink[nTo] ) ) ){
+        toSink[nFrom] = bUpdated = true;
+      }
+    }
+  }
+  std::vector<bool> live( nNodes );
+  for( int i=0; i<nNodes; i++ ){
+    live[i] = fromSource[i] && toSink[i];
+  }
+  std::erase_if( edges, [&](const std::pair<int, int>& edge){
+    return ( edge.first >= 0 && !live[edge.first] ) || ( edge.second >= 0 && !live[edge.second] );
+  } );
+
+  // the topological order. the earlier added node is processed first if the order is not determined by the graph.
+  std::vector<int> order;
+  std::vector<int> nPendingInputs( nNodes, 0 );
+  for( auto& [nFrom, nTo] : edges ){
+    if( nFrom >= 0 && nTo >= 0 ) nPendingInputs[nTo]++;
+  }
+  std::vector<bool> scheduled( nNodes, false );
+  for( bool bUpdated = true; bUpdated; ){
+    bUpdated = false;
+    for( int i=0; i<nNodes && !bUpdated; i++ ){
+      if( live[i] && !scheduled[i] && !nPendingInputs[i] ){
+        scheduled[i] = bUpdated = true;
+        order.push_back( i );
+        for( auto& [nFrom, nTo] : edges ){
+          if( nFrom == i && nTo >= 0 ) nPendingInputs[nTo]--;
+        }
+      }
+    }
+  }
+
+  // assign the buffers. the buffer is reused after the last reader of it.
+  int nSteps = order.size();
+  std::vector<int> stepIndex( nNodes, -1 );
+  for( int i=0; i<nSteps; i++ ){
+    stepIndex[ order[i] ] = i;
+  }
+  auto getLastUse = [&](int nProducer){
+    int nLastUse = -1;
+    for( auto& [nFrom, nTo] : edges ){
+      if( nFrom == nProducer ) nLastUse = std::max( nLastUse, ( nTo == SINK ) ? nSteps : stepIndex[nTo] );
+    }
+    return nLastUse;
+  };
+  std::vector<int> producerSlots( nNodes, -1 );
+  auto getSlot = [&](int nProducer){ return ( nProducer == SOURCE ) ? SOURCE_SLOT : producerSlots[nProducer]; };
+  std::vector<int> freeSlots;
+  int nSlots = SOURCE_SLOT + 1;
+  auto allocateSlot = [&](void){
+    int nSlot = nSlots;
+    if( freeSlots.empty() ){
+      nSlots++;
+    } else {
+      nSlot = freeSlots.back();
+      freeSlots.pop_back();
+    }
+    return nSlot;
+  };
+
+  for( int i=0; i<nSteps; i++ ){
+    Step step;
+    step.pFilter = mNodes[ order[i] ];
+    std::vector<int> lastUsedSlots;
+    for( auto& [nFrom, nTo] : edges ){
+      if( nTo == order[i] ){
+        step.inSlots.push_back( getSlot( nFrom ) );
+        if( getLastUse( nFrom ) == i ){
+          lastUsedSlots.push_back( getSlot( nFrom ) );
+        }
+      }
+    }
+    bool bMixSlotAllocated = false;
+    if( step.inSlots.size() == 1 ){
+      step.inSlot = step.inSlots[0];
+    } else if( !lastUsedSlots.empty() ){
+      // mix into the input which isn't read any more
+      step.inSlot = lastUsedSlots[0];
+    } else {
+      step.inSlot = allocateSlot();
+      bMixSlotAllocated = true;
+    }
+    // the output shouldn't be same as the input
+    step.outSlot = allocateSlot();
+    producerSlots[ order[i] ] = step.outSlot;
+    freeSlots.insert( freeSlots.end(), lastUsedSlots.begin(), lastUsedSlots.end() );
+    if( bMixSlotAllocated ){
+      freeSlots.push_back( step.inSlot );
+    }
+    pSchedule->steps.push_back( step );
+  }
+
+  for( auto& [nFrom, nTo] : edges ){
+    if( nTo == SINK ){
+      pSchedule->sinkInSlots.push_back( getSlot( nFrom ) );
+    }
+  }
+  // all of the sink's inputs aren't read any more then the first one is used for the mix
+  pSchedule->sinkSlot = pSchedule->sinkInSlots.empty() ? allocateSlot() : pSchedule->sinkInSlots[0];
+  pSchedule->nSlots = nSlots;
+
+  // the flat chain for Pipe's window size, format and latency. the nodes which aren't processed are included as well.
+  std::shared_ptr<FilterChain> pFilters = std::make_shared<FilterChain>();
+  for( auto& step : pSchedule->steps ){
+    pFilters->push_back( step.pFilter );
+  }
+  for( int i=0; i<nNodes; i++ ){
+    if( stepIndex[i] < 0 ){
+      pFilters->push_back( mNodes[i] );
+    }
+  }
+  pSchedule->pFilters = pFilters;
+
+  return pSchedule;
+}
+
+void GraphPipe::addFilterToHead(std::shared_ptr<IFilter> pFilter)
+{
+  mMutexFilters.lock();
+  if( pFilter && !isNodeIncludedLocked( pFilter ) ){
+    addNodeLocked( pFilter );
+    for( auto& edge : mEdges ){
+      if( !edge.first ) edge.first = pFilter;
+    }
+    mEdges.push_back( Edge( nullptr, pFilter ) );
+    publishGraphLocked();
+  }
+  mMutexFilters.unlock();
+}
+
+void GraphPipe::addFilterToTail(std::shared_ptr<IFilter> pFilter)
+{
+  mMutexFilters.lock();
+  if( pFilter && !isNodeIncludedLocked( pFilter ) ){
+    addNodeLocked( pFilter );
+    for( auto& edge : mEdges ){
+      if( !edge.second ) edge.second = pFilter;
+    }
+    mEdges.push_back( Edge( pFilter, nullptr ) );
+    publishGraphLocked();
+  }
+  mMutexFilters.unlock();
+}
+
+bool GraphPipe::addFilterAfterFilter(std::shared_ptr<IFilter> pFilter, std::shared_ptr<IFilter> pPosition)
+{
+  bool result = false;
+
+  mMutexFilters.lock();
+  if( pFilter && pPosition && isNodeIncludedLocked( pPosition ) && !isNodeIncludedLocked( pFilter ) ){
+    addNodeLocked( pFilter );
+    for( auto& edge : mEdges ){
+      if( edge.first == pPosition ) edge.first = pFilter;
+    }
+    mEdges.push_back( Edge( pPosition, pFilter ) );
+    publishGraphLocked();
+    result = true;
+  }
+  mMutexFilters.unlock();
+
+  return result;
+}
+
+bool GraphPipe::removeFilter(std::shared_ptr<IFilter> pFilter)
+{
+  bool result = false;
+
+  mMutexFilters.lock();
+  if( pFilter && isNodeIncludedLocked( pFilter ) ){
+    std::vector<std::shared_ptr<IFilter>> inputs, outputs;
+    for( auto& [pFrom, pTo] : mEdges ){
+      if( pTo == pFilter ) inputs.push_back( pFrom );
+      if( pFrom == pFilter ) outputs.push_back( pTo );
+    }
+    std::erase_if( mEdges, [&](const Edge& edge){ return edge.first == pFilter || edge.second == pFilter; } );
+    for( auto& pFrom : inputs ){
+      for( auto& pTo : outputs ){
+        if( !isConnectedLocked( pFrom, pTo ) ){
+          mEdges.push_back( Edge( pFrom, pTo ) );
+        }
+      }
+    }
+    std::erase( mNodes, pFilter );
+    publishGraphLocked();
+    result = true;
+  }
+  mMutexFilters.unlock();
+
+  return result;
+}
+
+void GraphPipe::clearFilters(void)
+{
+  mMutexFilters.lock();
+  mNodes.clear();
+  mEdges.clear();
+  mEdges.push_back( Edge( nullptr, nullptr ) );
+  publishGraphLocked();
+  mMutexFilters.unlock();
+}
+
+bool GraphPipe::connect(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo)
+{
+  bool result = false;
+
+  mMutexFilters.lock();
+  bool bCycle = pFrom && pTo && isReachableLocked( pTo, pFrom );
+  if( !bCycle && !isConnectedLocked( pFrom, pTo ) ){
+    addNodeLocked( pFrom );
+    addNodeLocked( pTo );
+    mEdges.push_back( Edge( pFrom, pTo ) );
+    publishGraphLocked();
+    result = true;
+  }
+  mMutexFilters.unlock();
+
+  return result;
+}
+
+bool GraphPipe::disconnect(std::shared_ptr<IFilter> pFrom, std::shared_ptr<IFilter> pTo)
+{
+  bool result = false;
+
+  mMutexFilters.lock();
+  if( std::erase( mEdges, Edge( pFrom, pTo ) ) ){
+    publishGraphLocked();
+    result = true;
+  }
+  mMutexFilters.unlock();
+
+  return result;
+}
+
+std::vector<GraphPipe::Edge> GraphPipe::getConnections(void)
+{
+  mMutexFilters.lock();
+  std::vector<Edge> result = mEdges;
+  mMutexFilters.unlock();
+
+  return result;
+}
+
+int GraphPipe::getNumberOfBuffers(void)
+{
+  return std::atomic_load_explicit( &mpSchedule, std::memory_order_acquire )->nSlots;
+}
+
+void GraphPipe::dump(void)
+{
+  std::cout << "Source:" << (mpSource ? mpSource->toString() : "") << std::endl;
+  std::cout << "Sink:" << (mpSink ? mpSink->toString() : "") << std::endl;
+
+  std::cout << "Connections:" << std::endl;
+  for( auto& [pFrom, pTo] : getConnections() ){
+    std::cout << ( pFrom ? pFrom->toString() : "Source" ) << " -> " << ( pTo ? pTo->toString() : "Sink" ) << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+std::shared_ptr<const GraphPipe::Schedule> GraphPipe::getProcessingSchedule(const FilterChain& filters)
+{
+  std::shared_ptr<const Schedule> pSchedule = mpProcessingSchedule;
+  if( !pSchedule || ( pSchedule->pFilters.get() != &filters ) ){
+    // the schedule is published before the filter chain then this is same as or newer than the filters
+    pSchedule = std::atomic_load_explicit( &mpSchedule, std::memory_order_acquire );
+    mpProcessingSchedule = pSchedule;
+  }
+  return pSchedule;
+}
+
+void GraphPipe::mixSlots(const std::vector<int>& inSlots, int nOutSlot)
+{
+  // the capacity is kept then this doesn't allocate in the steady state
+  mMixInputs.clear();
+  for( auto& nSlot : inSlots ){
+    mMixInputs.push_back( mSlotBuffers[nSlot]->getRawBufferPointer() );
+  }
+  std::shared_ptr<AudioBuffer> pOutBuf = mSlotBuffers[nOutSlot];
+  Mixer::process( std::span<const uint8_t* const>( mMixInputs ), pOutBuf->getAudioFormat(), pOutBuf->getRawBufferPointer(), pOutBuf->getNumberOfSamples() );
+}
+
+std::shared_ptr<AudioBuffer> GraphPipe::processFilters(const FilterChain& filters, std::shared_ptr<AudioBuffer>& pInBuf, std::shared_ptr<AudioBuffer>& pOutBuf)
+{
+  std::shared_ptr<const Schedule> pSchedule = getProcessingSchedule( filters );
+
+  // the buffers are kept unless the window or the format is changed
+  AudioFormat format = pInBuf->getAudioFormat();
+  int nSamples = pInBuf->getNumberOfSamples();
+  mSlotBuffers.resize( pSchedule->nSlots );
+  for( int i=SOURCE_SLOT+1; i<pSchedule->nSlots; i++ ){
+    if( !mSlotBuffers[i] || !mSlotBuffers[i]->getAudioFormat().equal( format ) || ( mSlotBuffers[i]->getNumberOfSamples() != nSamples ) ){
+      mSlotBuffers[i] = mBufferPool.acquire( format, nSamples, true );
+    }
+  }
+  mSlotBuffers[SOURCE_SLOT] = pInBuf;
+
+  for( auto& step : pSchedule->steps ){
+    if( step.inSlots.size() > 1 ){
+      mixSlots( step.inSlots, step.inSlot );
+    }
+    step.pFilter->process( *mSlotBuffers[step.inSlot], *mSlotBuffers[step.outSlot] );
+  }
+
+  if( pSchedule->sinkInSlots.empty() ){
+    std::shared_ptr<AudioBuffer> pSilence = mSlotBuffers[pSchedule->sinkSlot];
+    std::memset( pSilence->getRawBufferPointer(), 0, pSilence->getRawBufferSize() );
+  } else if( pSchedule->sinkInSlots.size() > 1 ){
+    mixSlots( pSchedule->sinkInSlots, pSchedule->sinkSlot );
+  }
+
+  std::shared_ptr<AudioBuffer> pSinkOut = mSlotBuffers[pSchedule->sinkSlot];
+  mSlotBuffers[SOURCE_SLOT].reset();
+
+  return pSinkOut;
+}
@@ -16,18 +16,26 @@
 
 #include "InterPipeBridge.hpp"
 
-InterPipeBridge::InterPipeBridge(AudioFormat format) : ISource(), ISink(), mFifoBuffer(format), mRequiredResource(0)
+InterPipeBridge::InterPipeBridge(AudioFormat format) : ISource(), ISink(), mFifoBuffer(format), mHandoffFifoBuffer(format), mHandoffEnabled(false), mRequiredResource(0)
 {
 
 }
 
 void InterPipeBridge::readPrimitive(IAudioBuffer& buf)
 {
-  mFifoBuffer.read(buf);
+  if( mHandoffEnabled ){
+    mHandoffFifoBuffer.read(buf);
+  } else {
+    mFifoBuffer.read(buf);
+  }
 }
 
 void InterPipeBridge::writePrimitive(IAudioBuffer& buf)
 {
+  if( mHandoffEnabled ){
+    mHandoffFifoBuffer.write(buf);
+    return;
+  }
   AudioBuffer* pBuf = dynamic_cast<AudioBuffer*>(&buf);
   if( pBuf ){
     int nSamples = pBuf->getNumberOfSamples();
@@ -38,9 +46,85 @@ void InterPipeBridge::writePrimitive(IAudioBuffer& buf)
   mFifoBuffer.write(buf);
 }
 
+bool InterPipeBridge::writeHandoff(IAudioBuffer& buf)
+{
+  bool bResult = false;
+
+  // the mute and the volume need to process the buf then the usual write() is required for them
+  if( mHandoffEnabled && !ISink::getMuteEnabled() && !ISink::isVolumeRequired() ){
+    std::lock_guard<std::mutex> lock(mMutexWrite);
+    updateSinkPosition( buf );
+    bResult = mHandoffFifoBuffer.write( buf, true );
+  }
+
+  return bResult;
+}
+
+bool InterPipeBridge::readHandoff(IAudioBuffer& buf)
+{
+  bool bResult = false;
+
+  if( mHandoffEnabled && !ISource::getMuteEnabled() ){
+    std::lock_guard<std::mutex> lock(mMutexRead);
+    updateSourcePosition( buf );
+    bResult = mHandoffFifoBuffer.read( buf, true );
+  }
+
+  return bResult;
+}
+
+bool InterPipeBridge::isReadReady(int nBytes)
+{
+  // the muted read doesn't wait for the data
+  if( ISource::getMuteEnabled() ){
+    return true;
+  }
+  return mHandoffEnabled ? mHandoffFifoBuffer.isReadReady( nBytes ) : mFifoBuffer.isReadReady( nBytes );
+}
+
+bool InterPipeBridge::isWriteReady(int nBytes)
+{
+  return mHandoffEnabled ? mHandoffFifoBuffer.isWriteReady( nBytes ) : mFifoBuffer.isWriteReady( nBytes );
+}
+
+void InterPipeBridge::setReadReadyListener(std::function<void(void)> listener)
+{
+  if( mHandoffEnabled ){
+    mHandoffFifoBuffer.setReadReadyListener( listener );
+  } else {
+    mFifoBuffer.setReadReadyListener( listener );
+  }
+}
+
+void InterPipeBridge::setWriteReadyListener(std::function<void(void)> listener)
+{
+  if( mHandoffEnabled ){
+    mHandoffFifoBuffer.setWriteReadyListener( listener );
+  } else {
+    mFifoBuffer.setWriteReadyListener( listener );
+  }
+}
+
+void InterPipeBridge::setHandoffEnabled(bool bEnabled)
+{
+  if( bEnabled != mHandoffEnabled ){
+    unlock();
+    mFifoBuffer.clearBuffer();
+    mHandoffFifoBuffer.clearBuffer();
+    mHandoffEnabled = bEnabled;
+  }
+}
+
+void InterPipeBridge::unlock(void)
+{
+  mFifoBuffer.unlock();
+  mHandoffFifoBuffer.unlock();
+}
+
 void InterPipeBridge::setAudioFormatPrimitive(AudioFormat audioFormat)
 {
   mFifoBuffer.setAudioFormat( audioFormat );
+  mHandoffFifoBuffer.setAudioFormat( audioFormat );
 }
 
 AudioFormat InterPipeBridge::getAudioFormat(void)
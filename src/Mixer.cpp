@@ -25,98 +25,74 @@
 
 #if USE_TINY_MIXER_IMPL
 
-bool Mixer::process( std::vector<std::shared_ptr<AudioBuffer>> pInBuffers, std::shared_ptr<AudioBuffer> pOutBuffer )
+bool Mixer::process( const std::vector<std::shared_ptr<AudioBuffer>>& pInBuffers, std::shared_ptr<AudioBuffer> pOutBuffer )
 {
   bool result = false;
   if( !pInBuffers.empty() && pOutBuffer ){
     // normalize buffer format (allocate)
     AudioFormat dstFormat = pOutBuffer->getAudioFormat();
-    std::vector<std::shared_ptr<AudioBuffer>> normalizedInBuffers;
-    normalizedInBuffers.reserve( pInBuffers.size() );
-    std::vector<std::shared_ptr<AudioBuffer>> allocatedBufferPointers;
-    allocatedBufferPointers.reserve( pInBuffers.size() );
+    std::vector<const uint8_t*>& rawInBuffers = mRawInBuffers;
+    std::vector<std::shared_ptr<AudioBuffer>>& allocatedBufferPointers = mConvertedBuffers;
+    rawInBuffers.clear();
     int nSamples = pOutBuffer->getNumberOfSamples();
     // format convert if different format
-    for(std::shared_ptr<AudioBuffer> pBuffer : pInBuffers){
+    for(const std::shared_ptr<AudioBuffer>& pBuffer : pInBuffers){
       if( dstFormat.equal( pBuffer->getAudioFormat() ) ){
-        normalizedInBuffers.push_back( pBuffer );
+        rawInBuffers.push_back( pBuffer->getRawBufferPointer() );
       } else {
-        std::shared_ptr<AudioBuffer> pTmpBuffer = std::make_shared<AudioBuffer>( dstFormat, nSamples);
-        if( AudioFormatAdaptor::convert(*pBuffer, *pTmpBuffer ) ){
-          normalizedInBuffers.push_back( pTmpBuffer );
+        std::shared_ptr<AudioBuffer> pTmpBuffer = mBufferPool.acquire( dstFormat, nSamples );
+        if( !AudioFormatAdaptor::convert(*pBuffer, *pTmpBuffer ) ){
+          // the input which can't be converted is mixed as the silence instead of dropping it
+          pTmpBuffer = mBufferPool.acquire( dstFormat, nSamples, true );
         }
+        rawInBuffers.push_back( pTmpBuffer->getRawBufferPointer() );
         allocatedBufferPointers.push_back( pTmpBuffer );
       }
     }
-    // do mix
-    if( normalizedInBuffers.size() >= 2 ){
-      result = doMix( normalizedInBuffers, pOutBuffer );
-    } else {
-      // only 1 source then just copy it. (no mix)
-      result = true;
-      *pOutBuffer = *normalizedInBuffers[0];
-    }
+    // do mix. only 1 source is also handled as the saturated copy
+    result = process( rawInBuffers, dstFormat, pOutBuffer->getRawBufferPointer(), nSamples );
+    // return the converted buffers to the pool. the capacities are kept for the next call.
     allocatedBufferPointers.clear();
+    rawInBuffers.clear();
   }
 
   return result;
 }
 
-
-bool Mixer::doMix( std::vector<std::shared_ptr<AudioBuffer>> pInBuffers, std::shared_ptr<AudioBuffer> pOutBuffer )
+// the pointers are converted one by one instead of accessing the byte pointer array as the typed pointer array (strict aliasing)
+template <typename T>
+static std::span<const T* const> getTypedInBuffers( std::span<const uint8_t* const> pRawInBuffers )
 {
-  bool result = false;
-  std::shared_ptr<AudioBuffer> pFinalOutBuffer = pOutBuffer;
-  if( !pInBuffers.empty() && pOutBuffer ){
-    AudioFormat format = pOutBuffer->getAudioFormat();
-    int nSamples = pOutBuffer->getNumberOfSamples();
-    // loop a+b=c
-    std::shared_ptr<AudioBuffer> tmpIn1Buffer = std::make_shared<AudioBuffer>( format, nSamples );
-    *tmpIn1Buffer = *pInBuffers[0];
-    std::shared_ptr<AudioBuffer> pInBuffer1 = tmpIn1Buffer;
-    std::shared_ptr<AudioBuffer> tmpOutBuffer = std::make_shared<AudioBuffer>( format, nSamples );
-    std::shared_ptr<AudioBuffer> pOutBuffer = tmpOutBuffer;
-    for(int i=1; i<pInBuffers.size(); i++){
-      std::shared_ptr<AudioBuffer> pInBuffer2 = pInBuffers[i];
-      result = doMixPrimitive( pInBuffer1, pInBuffer2, pOutBuffer );
-      if( (i+1) == pInBuffers.size() ){
-        // end then copy to the final buffer
-        *pFinalOutBuffer = result ? *pOutBuffer : *pInBuffer1;
-      }
-      if( result ){
-        std::swap(pInBuffer1, pOutBuffer);
-      }
-    }
+  static thread_local std::vector<const T*> typedInBuffers;
+  typedInBuffers.resize( pRawInBuffers.size() );
+  for(size_t i=0; i<pRawInBuffers.size(); i++){
+    typedInBuffers[i] = reinterpret_cast<const T*>( pRawInBuffers[i] );
   }
-  return result;
+  return typedInBuffers;
 }
 
-bool Mixer::doMixPrimitive( std::shared_ptr<AudioBuffer> pInBuffer1, std::shared_ptr<AudioBuffer> pInBuffer2, std::shared_ptr<AudioBuffer> pOutBuffer )
+bool Mixer::process( std::span<const uint8_t* const> pRawInBuffers, AudioFormat format, uint8_t* pRawOutBuffer, int nSamples )
 {
   bool bHandled = false;
 
-  if( pInBuffer1 && pInBuffer2 && pOutBuffer ){
-    AudioFormat format = pOutBuffer->getAudioFormat();
-    int nChannelSamples = pOutBuffer->getNumberOfSamples() * format.getNumberOfChannels();
-    int8_t* pRawInBuf1 = reinterpret_cast<int8_t*>( pInBuffer1->getRawBufferPointer() );
-    int8_t* pRawInBuf2 = reinterpret_cast<int8_t*>( pInBuffer2->getRawBufferPointer() );
-    int8_t* pRawOutBuf = reinterpret_cast<int8_t*>( pOutBuffer->getRawBufferPointer() );
+  if( !pRawInBuffers.empty() && pRawOutBuffer ){
+    int nChannelSamples = nSamples * format.getNumberOfChannels();
 
     switch( format.getEncoding() ){
       case AudioFormat::ENCODING::PCM_8BIT:
-        bHandled = MixerPrimitive::mix( pRawInBuf1, pRawInBuf2, pRawOutBuf, nChannelSamples);
+        bHandled = MixerPrimitive::mix( getTypedInBuffers<int8_t>( pRawInBuffers ), reinterpret_cast<int8_t*>(pRawOutBuffer), nChannelSamples );
         break;
       case AudioFormat::ENCODING::PCM_16BIT:
-        bHandled = MixerPrimitive::mix( reinterpret_cast<int16_t*>(pRawInBuf1), reinterpret_cast<int16_t*>(pRawInBuf2), reinterpret_cast<int16_t*>(pRawOutBuf), nChannelSamples);
+        bHandled = MixerPrimitive::mix( getTypedInBuffers<int16_t>( pRawInBuffers ), reinterpret_cast<int16_t*>(pRawOutBuffer), nChannelSamples );
         break;
       case AudioFormat::ENCODING::PCM_32BIT:
-        bHandled = MixerPrimitive::mix( reinterpret_cast<int32_t*>(pRawInBuf1), reinterpret_cast<int32_t*>(pRawInBuf2), reinterpret_cast<int32_t*>(pRawOutBuf), nChannelSamples);
+        bHandled = MixerPrimitive::mix( getTypedInBuffers<int32_t>( pRawInBuffers ), reinterpret_cast<int32_t*>(pRawOutBuffer), nChannelSamples );
         break;
       case AudioFormat::ENCODING::PCM_FLOAT:
-        bHandled = MixerPrimitive::mix( reinterpret_cast<float*>(pRawInBuf1), reinterpret_cast<float*>(pRawInBuf2), reinterpret_cast<float*>(pRawOutBuf), nChannelSamples);
+        bHandled = MixerPrimitive::mix( getTypedInBuffers<float>( pRawInBuffers ), reinterpret_cast<float*>(pRawOutBuffer), nChannelSamples );
         break;
       case AudioFormat::ENCODING::PCM_24BIT_PACKED:
-        bHandled = MixerPrimitive::mix24( pRawInBuf1, pRawInBuf2, pRawOutBuf, nChannelSamples);
+        bHandled = MixerPrimitive::mix24( getTypedInBuffers<int8_t>( pRawInBuffers ), reinterpret_cast<int8_t*>(pRawOutBuffer), nChannelSamples );
         break;
       case AudioFormat::ENCODING::PCM_UNKNOWN:
       default:
@@ -23,68 +23,690 @@
 #if USE_TINY_MIXER_PRIMITIVE_IMPL
 
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <atomic>
 
-bool MixerPrimitive::mix( int8_t* pRawInBuf1, int8_t* pRawInBuf2, int8_t* pRawOutBuf, int nChannelSamples)
+#ifndef USE_MIXER_PRIMITIVE_SIMD
+  #define USE_MIXER_PRIMITIVE_SIMD 1
+#endif /* USE_MIXER_PRIMITIVE_SIMD */
+
+#if USE_MIXER_PRIMITIVE_SIMD && ( defined(__x86_64__) || defined(__i386__) )
+  #define MIXER_PRIMITIVE_X86_SIMD 1
+  #include <immintrin.h>
+#else
+  #define MIXER_PRIMITIVE_X86_SIMD 0
+#endif
+
+static constexpr int32_t INT24_MIN = -8388608;
+static constexpr int32_t INT24_MAX = 8388607;
+
+struct MixerKernels
+{
+  MixerPrimitive::SIMD simd;
+  void (*mix8)(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples);
+  void (*mix16)(const int16_t* pIn1, const int16_t* pIn2, int16_t* pOut, int nChannelSamples);
+  void (*mix32)(const int32_t* pIn1, const int32_t* pIn2, int32_t* pOut, int nChannelSamples);
+  void (*mixFloat)(const float* pIn1, const float* pIn2, float* pOut, int nChannelSamples);
+  void (*mix24)(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples);
+  // N-way mix for the channel sample range [nBegin, nEnd)
+  void (*mixN8)(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd);
+  void (*mixN16)(const int16_t* const* ppIn, int nIn, int16_t* pOut, int nBegin, int nEnd);
+  void (*mixN32)(const int32_t* const* ppIn, int nIn, int32_t* pOut, int nBegin, int nEnd);
+  void (*mixNFloat)(const float* const* ppIn, int nIn, float* pOut, int nBegin, int nEnd);
+  void (*mixN24)(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd);
+};
+
+
+// --- scalar (fallback and the tail of the vector kernels)
+static void mix8Scalar(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples)
 {
   for(int i=0; i<nChannelSamples; i++){
-    int16_t mixed = (*pRawInBuf1) + (*pRawInBuf2);
-    *pRawOutBuf = std::max<int16_t>(INT8_MIN, std::min<int16_t>(mixed, INT8_MAX));
-    pRawInBuf1++;
-    pRawInBuf2++;
-    pRawOutBuf++;
+    int16_t mixed = pIn1[i] + pIn2[i];
+    pOut[i] = std::max<int16_t>(INT8_MIN, std::min<int16_t>(mixed, INT8_MAX));
   }
-  return true;
 }
 
-bool MixerPrimitive::mix( int16_t* pRawInBuf1, int16_t* pRawInBuf2, int16_t* pRawOutBuf, int nChannelSamples)
+static void mix16Scalar(const int16_t* pIn1, const int16_t* pIn2, int16_t* pOut, int nChannelSamples)
 {
   for(int i=0; i<nChannelSamples; i++){
-    int32_t mixed = (*pRawInBuf1) + (*pRawInBuf2);
-    *pRawOutBuf = std::max<int32_t>(INT16_MIN, std::min<int32_t>(mixed, INT16_MAX));
-    pRawInBuf1++;
-    pRawInBuf2++;
-    pRawOutBuf++;
+    int32_t mixed = pIn1[i] + pIn2[i];
+    pOut[i] = std::max<int32_t>(INT16_MIN, std::min<int32_t>(mixed, INT16_MAX));
   }
-  return true;
 }
 
-bool MixerPrimitive::mix( int32_t* pRawInBuf1, int32_t* pRawInBuf2, int32_t* pRawOutBuf, int nChannelSamples)
+static void mix32Scalar(const int32_t* pIn1, const int32_t* pIn2, int32_t* pOut, int nChannelSamples)
 {
   for(int i=0; i<nChannelSamples; i++){
-    int64_t mixed = (*pRawInBuf1) + (*pRawInBuf2);
-    *pRawOutBuf = std::max<int64_t>(INT32_MIN, std::min<int64_t>(mixed, INT32_MAX));
-    pRawInBuf1++;
-    pRawInBuf2++;
-    pRawOutBuf++;
+    int64_t mixed = (int64_t)pIn1[i] + (int64_t)pIn2[i];
+    pOut[i] = std::max<int64_t>(INT32_MIN, std::min<int64_t>(mixed, INT32_MAX));
   }
-  return true;
 }
 
-bool MixerPrimitive::mix( float* pRawInBuf1, float* pRawInBuf2, float* pRawOutBuf, int nChannelSamples)
+static void mixFloatScalar(const float* pIn1, const float* pIn2, float* pOut, int nChannelSamples)
 {
   for(int i=0; i<nChannelSamples; i++){
-    float mixed = (*pRawInBuf1) + (*pRawInBuf2);
-    *pRawOutBuf = std::max<float>(-1.0f, std::min<float>(mixed, 1.0f));
-    pRawInBuf1++;
-    pRawInBuf2++;
-    pRawOutBuf++;
+    float mixed = pIn1[i] + pIn2[i];
+    pOut[i] = std::max<float>(-1.0f, std::min<float>(mixed, 1.0f));
   }
-  return true;
 }
 
-bool MixerPrimitive::mix24( int8_t* pRawInBuf1, int8_t* pRawInBuf2, int8_t* pRawOutBuf, int nChannelSamples)
+static inline int32_t load24(const int8_t* pIn)
+{
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(pIn);
+  uint32_t value = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+  return ((int32_t)(value << 8)) >> 8; // sign extension
+}
+
+static inline void store24(int8_t* pOut, int32_t value)
+{
+  pOut[0] = value & 0xFF;
+  pOut[1] = (value >> 8) & 0xFF;
+  pOut[2] = (value >> 16) & 0xFF;
+}
+
+static void mix24Scalar(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples)
 {
   for(int i=0; i<nChannelSamples; i++){
-    int32_t mixed = (int32_t)(*pRawInBuf1) + (int32_t)(*(pRawInBuf1+1) << 8) + (int32_t)(*(pRawInBuf1+2) << 16) + (int32_t)(*pRawInBuf2) + (int32_t)(*(pRawInBuf2+1) << 8)+ (int32_t)(*(pRawInBuf2+2) << 16);
-    mixed = std::max<int32_t>(-8388608, std::min<int32_t>(mixed, 8388607));
-    *pRawOutBuf++ = mixed & 0xFF;
-    *pRawOutBuf++ = (mixed & 0xFF00) >> 8;
-    *pRawOutBuf++ = (mixed & 0xFF0000) >> 16;
-    pRawInBuf1 = pRawInBuf1 + 3;
-    pRawInBuf2 = pRawInBuf2 + 3;
+    int32_t mixed = load24( pIn1 ) + load24( pIn2 );
+    store24( pOut, std::max<int32_t>(INT24_MIN, std::min<int32_t>(mixed, INT24_MAX)) );
+    pIn1 += 3;
+    pIn2 += 3;
+    pOut += 3;
+  }
+}
+
+// accumulate a cache resident block of all the inputs by the wider type then saturate once
+static constexpr int MIX_BLOCK_SIZE = 256;
+// the 8bit and 24bit vector kernels accumulate by 16bit and 32bit lanes which can't overflow up to this inputs
+static constexpr int MIX_N_NARROW_ACC_MAX_INPUTS = 256;
+
+template <typename T, typename ACC>
+static inline void mixNScalar(const T* const* ppIn, int nIn, T* pOut, int nBegin, int nEnd, ACC min, ACC max)
+{
+  ACC acc[MIX_BLOCK_SIZE];
+  for(int nOffset = nBegin; nOffset < nEnd; nOffset += MIX_BLOCK_SIZE){
+    int nSize = std::min( MIX_BLOCK_SIZE, nEnd - nOffset );
+    const T* pIn = ppIn[0] + nOffset;
+    for(int i=0; i<nSize; i++){
+      acc[i] = pIn[i];
+    }
+    for(int j=1; j<nIn; j++){
+      pIn = ppIn[j] + nOffset;
+      for(int i=0; i<nSize; i++){
+        acc[i] += pIn[i];
+      }
+    }
+    T* pDst = pOut + nOffset;
+    for(int i=0; i<nSize; i++){
+      pDst[i] = std::max<ACC>( min, std::min<ACC>( acc[i], max ) );
+    }
+  }
+}
+
+static void mixN8Scalar(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd)
+{
+  mixNScalar<int8_t, int32_t>( ppIn, nIn, pOut, nBegin, nEnd, INT8_MIN, INT8_MAX );
+}
+
+static void mixN16Scalar(const int16_t* const* ppIn, int nIn, int16_t* pOut, int nBegin, int nEnd)
+{
+  mixNScalar<int16_t, int32_t>( ppIn, nIn, pOut, nBegin, nEnd, INT16_MIN, INT16_MAX );
+}
+
+static void mixN32Scalar(const int32_t* const* ppIn, int nIn, int32_t* pOut, int nBegin, int nEnd)
+{
+  mixNScalar<int32_t, int64_t>( ppIn, nIn, pOut, nBegin, nEnd, INT32_MIN, INT32_MAX );
+}
+
+static void mixNFloatScalar(const float* const* ppIn, int nIn, float* pOut, int nBegin, int nEnd)
+{
+  mixNScalar<float, float>( ppIn, nIn, pOut, nBegin, nEnd, -1.0f, 1.0f );
+}
+
+static void mixN24Scalar(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd)
+{
+  int64_t acc[MIX_BLOCK_SIZE];
+  for(int nOffset = nBegin; nOffset < nEnd; nOffset += MIX_BLOCK_SIZE){
+    int nSize = std::min( MIX_BLOCK_SIZE, nEnd - nOffset );
+    const int8_t* pIn = ppIn[0] + nOffset*3;
+    for(int i=0; i<nSize; i++){
+      acc[i] = load24( pIn + i*3 );
+    }
+    for(int j=1; j<nIn; j++){
+      pIn = ppIn[j] + nOffset*3;
+      for(int i=0; i<nSize; i++){
+        acc[i] += load24( pIn + i*3 );
+      }
+    }
+    int8_t* pDst = pOut + nOffset*3;
+    for(int i=0; i<nSize; i++){
+      store24( pDst + i*3, (int32_t)std::max<int64_t>( INT24_MIN, std::min<int64_t>( acc[i], INT24_MAX ) ) );
+    }
+  }
+}
+
+static const MixerKernels gScalarKernels = { MixerPrimitive::SIMD::SCALAR, mix8Scalar, mix16Scalar, mix32Scalar, mixFloatScalar, mix24Scalar, mixN8Scalar, mixN16Scalar, mixN32Scalar, mixNFloatScalar, mixN24Scalar };
+
+
+#if MIXER_PRIMITIVE_X86_SIMD
+// --- SSE2
+__attribute__((target("sse2")))
+static void mix8Sse2(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples)
+{
+  int i = 0;
+  for(; i+16<=nChannelSamples; i+=16){
+    __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn1+i) );
+    __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn2+i) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i), _mm_adds_epi8( a, b ) );
+  }
+  mix8Scalar( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("sse2")))
+static void mix16Sse2(const int16_t* pIn1, const int16_t* pIn2, int16_t* pOut, int nChannelSamples)
+{
+  int i = 0;
+  for(; i+8<=nChannelSamples; i+=8){
+    __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn1+i) );
+    __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn2+i) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i), _mm_adds_epi16( a, b ) );
+  }
+  mix16Scalar( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("sse2")))
+static void mix32Sse2(const int32_t* pIn1, const int32_t* pIn2, int32_t* pOut, int nChannelSamples)
+{
+  // there is no saturating 32bit add then detect the overflow : the sign of the sum differs from the both inputs
+  const __m128i max = _mm_set1_epi32( INT32_MAX );
+  int i = 0;
+  for(; i+4<=nChannelSamples; i+=4){
+    __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn1+i) );
+    __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn2+i) );
+    __m128i sum = _mm_add_epi32( a, b );
+    __m128i overflow = _mm_srai_epi32( _mm_and_si128( _mm_xor_si128( a, sum ), _mm_xor_si128( b, sum ) ), 31 );
+    __m128i saturated = _mm_xor_si128( _mm_srai_epi32( a, 31 ), max );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i), _mm_or_si128( _mm_and_si128( overflow, saturated ), _mm_andnot_si128( overflow, sum ) ) );
+  }
+  mix32Scalar( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("sse2")))
+static void mixFloatSse2(const float* pIn1, const float* pIn2, float* pOut, int nChannelSamples)
+{
+  const __m128 max = _mm_set1_ps( 1.0f );
+  const __m128 min = _mm_set1_ps( -1.0f );
+  int i = 0;
+  for(; i+4<=nChannelSamples; i+=4){
+    __m128 sum = _mm_add_ps( _mm_loadu_ps( pIn1+i ), _mm_loadu_ps( pIn2+i ) );
+    _mm_storeu_ps( pOut+i, _mm_max_ps( _mm_min_ps( sum, max ), min ) );
+  }
+  mixFloatScalar( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("sse2")))
+static void mix24Sse2(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples)
+{
+  // SSE2 doesn't have the byte shuffle then gather 4 samples as the 32bit words and sign-extend them in the vector
+  const __m128i max = _mm_set1_epi32( INT24_MAX );
+  const __m128i min = _mm_set1_epi32( INT24_MIN );
+  int32_t words1[4], words2[4], mixed[4];
+  int i = 0;
+  // the last 32bit word load reads 1 byte more than the 4 samples
+  for(; i+5<=nChannelSamples; i+=4){
+    for(int j=0; j<4; j++){
+      memcpy( &words1[j], pIn1 + (i+j)*3, sizeof(int32_t) );
+      memcpy( &words2[j], pIn2 + (i+j)*3, sizeof(int32_t) );
+    }
+    __m128i a = _mm_srai_epi32( _mm_slli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(words1) ), 8 ), 8 );
+    __m128i b = _mm_srai_epi32( _mm_slli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(words2) ), 8 ), 8 );
+    __m128i sum = _mm_add_epi32( a, b );
+    __m128i over = _mm_cmpgt_epi32( sum, max );
+    sum = _mm_or_si128( _mm_and_si128( over, max ), _mm_andnot_si128( over, sum ) );
+    __m128i under = _mm_cmplt_epi32( sum, min );
+    sum = _mm_or_si128( _mm_and_si128( under, min ), _mm_andnot_si128( under, sum ) );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(mixed), sum );
+    for(int j=0; j<4; j++){
+      store24( pOut + (i+j)*3, mixed[j] );
+    }
+  }
+  mix24Scalar( pIn1+i*3, pIn2+i*3, pOut+i*3, nChannelSamples-i );
+}
+
+__attribute__((target("sse2")))
+static void mixN16Sse2(const int16_t* const* ppIn, int nIn, int16_t* pOut, int nBegin, int nEnd)
+{
+  int i = nBegin;
+  for(; i+8<=nEnd; i+=8){
+    __m128i accLow = _mm_setzero_si128();
+    __m128i accHigh = _mm_setzero_si128();
+    for(int j=0; j<nIn; j++){
+      __m128i in = _mm_loadu_si128( reinterpret_cast<const __m128i*>(ppIn[j]+i) );
+      accLow = _mm_add_epi32( accLow, _mm_srai_epi32( _mm_unpacklo_epi16( in, in ), 16 ) );
+      accHigh = _mm_add_epi32( accHigh, _mm_srai_epi32( _mm_unpackhi_epi16( in, in ), 16 ) );
+    }
+    // packs saturates the 32bit sums to 16bit
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i), _mm_packs_epi32( accLow, accHigh ) );
+  }
+  mixN16Scalar( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("sse2")))
+static void mixNFloatSse2(const float* const* ppIn, int nIn, float* pOut, int nBegin, int nEnd)
+{
+  const __m128 max = _mm_set1_ps( 1.0f );
+  const __m128 min = _mm_set1_ps( -1.0f );
+  int i = nBegin;
+  for(; i+4<=nEnd; i+=4){
+    __m128 acc = _mm_loadu_ps( ppIn[0]+i );
+    for(int j=1; j<nIn; j++){
+      acc = _mm_add_ps( acc, _mm_loadu_ps( ppIn[j]+i ) );
+    }
+    _mm_storeu_ps( pOut+i, _mm_max_ps( _mm_min_ps( acc, max ), min ) );
+  }
+  mixNFloatScalar( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("sse2")))
+static void mixN8Sse2(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd)
+{
+  int i = nBegin;
+  if( nIn <= MIX_N_NARROW_ACC_MAX_INPUTS ){
+    for(; i+16<=nEnd; i+=16){
+      __m128i accLow = _mm_setzero_si128();
+      __m128i accHigh = _mm_setzero_si128();
+      for(int j=0; j<nIn; j++){
+        __m128i in = _mm_loadu_si128( reinterpret_cast<const __m128i*>(ppIn[j]+i) );
+        accLow = _mm_add_epi16( accLow, _mm_srai_epi16( _mm_unpacklo_epi8( in, in ), 8 ) );
+        accHigh = _mm_add_epi16( accHigh, _mm_srai_epi16( _mm_unpackhi_epi8( in, in ), 8 ) );
+      }
+      // packs saturates the 16bit sums to 8bit
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i), _mm_packs_epi16( accLow, accHigh ) );
+    }
+  }
+  mixN8Scalar( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("sse2")))
+static void mixN32Sse2(const int32_t* const* ppIn, int nIn, int32_t* pOut, int nBegin, int nEnd)
+{
+  // SSE2 doesn't have the 64bit compare then accumulate by double. it's exact for the 32bit integer sums.
+  const __m128d max = _mm_set1_pd( INT32_MAX );
+  const __m128d min = _mm_set1_pd( INT32_MIN );
+  int i = nBegin;
+  for(; i+4<=nEnd; i+=4){
+    __m128d accLow = _mm_setzero_pd();
+    __m128d accHigh = _mm_setzero_pd();
+    for(int j=0; j<nIn; j++){
+      __m128i in = _mm_loadu_si128( reinterpret_cast<const __m128i*>(ppIn[j]+i) );
+      accLow = _mm_add_pd( accLow, _mm_cvtepi32_pd( in ) );
+      accHigh = _mm_add_pd( accHigh, _mm_cvtepi32_pd( _mm_srli_si128( in, 8 ) ) );
+    }
+    accLow = _mm_max_pd( _mm_min_pd( accLow, max ), min );
+    accHigh = _mm_max_pd( _mm_min_pd( accHigh, max ), min );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i), _mm_unpacklo_epi64( _mm_cvtpd_epi32( accLow ), _mm_cvtpd_epi32( accHigh ) ) );
+  }
+  mixN32Scalar( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("sse2")))
+static void mixN24Sse2(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd)
+{
+  // gather 4 samples as the 32bit words in the same way as mix24Sse2
+  const __m128i max = _mm_set1_epi32( INT24_MAX );
+  const __m128i min = _mm_set1_epi32( INT24_MIN );
+  int32_t words[4], mixed[4];
+  int i = nBegin;
+  if( nIn <= MIX_N_NARROW_ACC_MAX_INPUTS ){
+    // the last 32bit word load reads 1 byte more than the 4 samples
+    for(; i+5<=nEnd; i+=4){
+      __m128i acc = _mm_setzero_si128();
+      for(int j=0; j<nIn; j++){
+        for(int k=0; k<4; k++){
+          memcpy( &words[k], ppIn[j] + (i+k)*3, sizeof(int32_t) );
+        }
+        acc = _mm_add_epi32( acc, _mm_srai_epi32( _mm_slli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(words) ), 8 ), 8 ) );
+      }
+      __m128i over = _mm_cmpgt_epi32( acc, max );
+      acc = _mm_or_si128( _mm_and_si128( over, max ), _mm_andnot_si128( over, acc ) );
+      __m128i under = _mm_cmplt_epi32( acc, min );
+      acc = _mm_or_si128( _mm_and_si128( under, min ), _mm_andnot_si128( under, acc ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(mixed), acc );
+      for(int k=0; k<4; k++){
+        store24( pOut + (i+k)*3, mixed[k] );
+      }
+    }
+  }
+  mixN24Scalar( ppIn, nIn, pOut, i, nEnd );
+}
+
+static const MixerKernels gSse2Kernels = { MixerPrimitive::SIMD::SSE2, mix8Sse2, mix16Sse2, mix32Sse2, mixFloatSse2, mix24Sse2, mixN8Sse2, mixN16Sse2, mixN32Sse2, mixNFloatSse2, mixN24Sse2 };
+
+
+// --- AVX2
+__attribute__((target("avx2")))
+static void mix8Avx2(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples)
+{
+  int i = 0;
+  for(; i+32<=nChannelSamples; i+=32){
+    __m256i a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pIn1+i) );
+    __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pIn2+i) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut+i), _mm256_adds_epi8( a, b ) );
+  }
+  mix8Sse2( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("avx2")))
+static void mix16Avx2(const int16_t* pIn1, const int16_t* pIn2, int16_t* pOut, int nChannelSamples)
+{
+  int i = 0;
+  for(; i+16<=nChannelSamples; i+=16){
+    __m256i a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pIn1+i) );
+    __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pIn2+i) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut+i), _mm256_adds_epi16( a, b ) );
+  }
+  mix16Sse2( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("avx2")))
+static void mix32Avx2(const int32_t* pIn1, const int32_t* pIn2, int32_t* pOut, int nChannelSamples)
+{
+  const __m256i max = _mm256_set1_epi32( INT32_MAX );
+  int i = 0;
+  for(; i+8<=nChannelSamples; i+=8){
+    __m256i a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pIn1+i) );
+    __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pIn2+i) );
+    __m256i sum = _mm256_add_epi32( a, b );
+    __m256i overflow = _mm256_and_si256( _mm256_xor_si256( a, sum ), _mm256_xor_si256( b, sum ) );
+    __m256i saturated = _mm256_xor_si256( _mm256_srai_epi32( a, 31 ), max );
+    // blendv picks by the sign bit of each byte then spread the overflow bit over the lane
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut+i), _mm256_blendv_epi8( sum, saturated, _mm256_srai_epi32( overflow, 31 ) ) );
   }
+  mix32Sse2( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("avx2")))
+static void mixFloatAvx2(const float* pIn1, const float* pIn2, float* pOut, int nChannelSamples)
+{
+  const __m256 max = _mm256_set1_ps( 1.0f );
+  const __m256 min = _mm256_set1_ps( -1.0f );
+  int i = 0;
+  for(; i+8<=nChannelSamples; i+=8){
+    __m256 sum = _mm256_add_ps( _mm256_loadu_ps( pIn1+i ), _mm256_loadu_ps( pIn2+i ) );
+    _mm256_storeu_ps( pOut+i, _mm256_max_ps( _mm256_min_ps( sum, max ), min ) );
+  }
+  mixFloatSse2( pIn1+i, pIn2+i, pOut+i, nChannelSamples-i );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load24Avx2(const int8_t* pIn, __m256i unpackMask)
+{
+  // 8 samples = 24 bytes. each 128bit lane takes 4 samples (12 bytes) and places them on the upper 24bit of the 32bit lanes
+  __m128i low = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn) );
+  __m128i high = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn+12) );
+  __m256i packed = _mm256_inserti128_si256( _mm256_castsi128_si256( low ), high, 1 );
+  return _mm256_srai_epi32( _mm256_shuffle_epi8( packed, unpackMask ), 8 );
+}
+
+__attribute__((target("avx2")))
+static inline void store12(int8_t* pOut, __m128i packed)
+{
+  _mm_storel_epi64( reinterpret_cast<__m128i*>(pOut), packed );
+  int32_t last = _mm_cvtsi128_si32( _mm_srli_si128( packed, 8 ) );
+  memcpy( pOut+8, &last, sizeof(int32_t) );
+}
+
+__attribute__((target("avx2")))
+static void mix24Avx2(const int8_t* pIn1, const int8_t* pIn2, int8_t* pOut, int nChannelSamples)
+{
+  const __m256i unpackMask = _mm256_setr_epi8(
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+  const __m256i packMask = _mm256_setr_epi8(
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+  const __m256i max = _mm256_set1_epi32( INT24_MAX );
+  const __m256i min = _mm256_set1_epi32( INT24_MIN );
+  int i = 0;
+  // the upper lane load reads 4 bytes more than the 8 samples. the store writes the 8 samples exactly.
+  for(; i+10<=nChannelSamples; i+=8){
+    __m256i sum = _mm256_add_epi32( load24Avx2( pIn1+i*3, unpackMask ), load24Avx2( pIn2+i*3, unpackMask ) );
+    sum = _mm256_shuffle_epi8( _mm256_max_epi32( _mm256_min_epi32( sum, max ), min ), packMask );
+    store12( pOut+i*3, _mm256_castsi256_si128( sum ) );
+    store12( pOut+i*3+12, _mm256_extracti128_si256( sum, 1 ) );
+  }
+  mix24Sse2( pIn1+i*3, pIn2+i*3, pOut+i*3, nChannelSamples-i );
+}
+
+__attribute__((target("avx2")))
+static void mixN16Avx2(const int16_t* const* ppIn, int nIn, int16_t* pOut, int nBegin, int nEnd)
+{
+  int i = nBegin;
+  for(; i+16<=nEnd; i+=16){
+    __m256i accLow = _mm256_setzero_si256();
+    __m256i accHigh = _mm256_setzero_si256();
+    for(int j=0; j<nIn; j++){
+      __m256i in = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(ppIn[j]+i) );
+      accLow = _mm256_add_epi32( accLow, _mm256_cvtepi16_epi32( _mm256_castsi256_si128( in ) ) );
+      accHigh = _mm256_add_epi32( accHigh, _mm256_cvtepi16_epi32( _mm256_extracti128_si256( in, 1 ) ) );
+    }
+    // packs works per 128bit lane then restore the sample order
+    __m256i packed = _mm256_permute4x64_epi64( _mm256_packs_epi32( accLow, accHigh ), 0xD8 );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut+i), packed );
+  }
+  mixN16Sse2( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("avx2")))
+static void mixNFloatAvx2(const float* const* ppIn, int nIn, float* pOut, int nBegin, int nEnd)
+{
+  const __m256 max = _mm256_set1_ps( 1.0f );
+  const __m256 min = _mm256_set1_ps( -1.0f );
+  int i = nBegin;
+  for(; i+8<=nEnd; i+=8){
+    __m256 acc = _mm256_loadu_ps( ppIn[0]+i );
+    for(int j=1; j<nIn; j++){
+      acc = _mm256_add_ps( acc, _mm256_loadu_ps( ppIn[j]+i ) );
+    }
+    _mm256_storeu_ps( pOut+i, _mm256_max_ps( _mm256_min_ps( acc, max ), min ) );
+  }
+  mixNFloatSse2( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("avx2")))
+static void mixN8Avx2(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd)
+{
+  int i = nBegin;
+  if( nIn <= MIX_N_NARROW_ACC_MAX_INPUTS ){
+    for(; i+32<=nEnd; i+=32){
+      __m256i accLow = _mm256_setzero_si256();
+      __m256i accHigh = _mm256_setzero_si256();
+      for(int j=0; j<nIn; j++){
+        __m256i in = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(ppIn[j]+i) );
+        accLow = _mm256_add_epi16( accLow, _mm256_cvtepi8_epi16( _mm256_castsi256_si128( in ) ) );
+        accHigh = _mm256_add_epi16( accHigh, _mm256_cvtepi8_epi16( _mm256_extracti128_si256( in, 1 ) ) );
+      }
+      // packs works per 128bit lane then restore the sample order
+      __m256i packed = _mm256_permute4x64_epi64( _mm256_packs_epi16( accLow, accHigh ), 0xD8 );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut+i), packed );
+    }
+  }
+  mixN8Sse2( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("avx2")))
+static void mixN32Avx2(const int32_t* const* ppIn, int nIn, int32_t* pOut, int nBegin, int nEnd)
+{
+  const __m256d max = _mm256_set1_pd( INT32_MAX );
+  const __m256d min = _mm256_set1_pd( INT32_MIN );
+  int i = nBegin;
+  for(; i+8<=nEnd; i+=8){
+    __m256d accLow = _mm256_setzero_pd();
+    __m256d accHigh = _mm256_setzero_pd();
+    for(int j=0; j<nIn; j++){
+      __m256i in = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(ppIn[j]+i) );
+      accLow = _mm256_add_pd( accLow, _mm256_cvtepi32_pd( _mm256_castsi256_si128( in ) ) );
+      accHigh = _mm256_add_pd( accHigh, _mm256_cvtepi32_pd( _mm256_extracti128_si256( in, 1 ) ) );
+    }
+    __m128i low = _mm256_cvtpd_epi32( _mm256_max_pd( _mm256_min_pd( accLow, max ), min ) );
+    __m128i high = _mm256_cvtpd_epi32( _mm256_max_pd( _mm256_min_pd( accHigh, max ), min ) );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut+i), _mm256_inserti128_si256( _mm256_castsi128_si256( low ), high, 1 ) );
+  }
+  mixN32Sse2( ppIn, nIn, pOut, i, nEnd );
+}
+
+__attribute__((target("avx2")))
+static void mixN24Avx2(const int8_t* const* ppIn, int nIn, int8_t* pOut, int nBegin, int nEnd)
+{
+  const __m256i unpackMask = _mm256_setr_epi8(
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11 );
+  const __m256i packMask = _mm256_setr_epi8(
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+    0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+  const __m256i max = _mm256_set1_epi32( INT24_MAX );
+  const __m256i min = _mm256_set1_epi32( INT24_MIN );
+  int i = nBegin;
+  if( nIn <= MIX_N_NARROW_ACC_MAX_INPUTS ){
+    // the upper lane load reads 4 bytes more than the 8 samples. the store writes the 8 samples exactly.
+    for(; i+10<=nEnd; i+=8){
+      __m256i acc = _mm256_setzero_si256();
+      for(int j=0; j<nIn; j++){
+        acc = _mm256_add_epi32( acc, load24Avx2( ppIn[j]+i*3, unpackMask ) );
+      }
+      acc = _mm256_shuffle_epi8( _mm256_max_epi32( _mm256_min_epi32( acc, max ), min ), packMask );
+      store12( pOut+i*3, _mm256_castsi256_si128( acc ) );
+      store12( pOut+i*3+12, _mm256_extracti128_si256( acc, 1 ) );
+    }
+  }
+  mixN24Sse2( ppIn, nIn, pOut, i, nEnd );
+}
+
+static const MixerKernels gAvx2Kernels = { MixerPrimitive::SIMD::AVX2, mix8Avx2, mix16Avx2, mix32Avx2, mixFloatAvx2, mix24Avx2, mixN8Avx2, mixN16Avx2, mixN32Avx2, mixNFloatAvx2, mixN24Avx2 };
+#endif /* MIXER_PRIMITIVE_X86_SIMD */
+
+
+static const MixerKernels* getKernelsFor(MixerPrimitive::SIMD simd)
+{
+  const MixerKernels* pKernels = nullptr;
+  if( CpuFeature::isSimdSupported( simd ) ){
+    switch( simd ){
+      case MixerPrimitive::SIMD::SCALAR:
+        pKernels = &gScalarKernels;
+        break;
+#if MIXER_PRIMITIVE_X86_SIMD
+      case MixerPrimitive::SIMD::SSE2:
+        pKernels = &gSse2Kernels;
+        break;
+      case MixerPrimitive::SIMD::AVX2:
+        pKernels = &gAvx2Kernels;
+        break;
+#endif /* MIXER_PRIMITIVE_X86_SIMD */
+      default:
+        break;
+    }
+  }
+  return pKernels;
+}
+
+static std::atomic<const MixerKernels*>& getKernels(void)
+{
+  // the best kernel set is chosen once by the cpu feature detection
+  static std::atomic<const MixerKernels*> kernels = []{
+    const MixerKernels* pKernels = getKernelsFor( CpuFeature::getSimd() );
+    return pKernels ? pKernels : &gScalarKernels;
+  }();
+  return kernels;
+}
+
+MixerPrimitive::SIMD MixerPrimitive::getSimd(void)
+{
+  return getKernels().load( std::memory_order_relaxed )->simd;
+}
+
+bool MixerPrimitive::isSimdSupported(SIMD simd)
+{
+  return getKernelsFor( simd ) != nullptr;
+}
+
+bool MixerPrimitive::setSimd(SIMD simd)
+{
+  const MixerKernels* pKernels = getKernelsFor( simd );
+  if( pKernels ){
+    getKernels().store( pKernels, std::memory_order_relaxed );
+  }
+  return pKernels != nullptr;
+}
+
+bool MixerPrimitive::mix( int8_t* pRawInBuf1, int8_t* pRawInBuf2, int8_t* pRawOutBuf, int nChannelSamples)
+{
+  getKernels().load( std::memory_order_relaxed )->mix8( pRawInBuf1, pRawInBuf2, pRawOutBuf, nChannelSamples );
+  return true;
+}
+
+bool MixerPrimitive::mix( int16_t* pRawInBuf1, int16_t* pRawInBuf2, int16_t* pRawOutBuf, int nChannelSamples)
+{
+  getKernels().load( std::memory_order_relaxed )->mix16( pRawInBuf1, pRawInBuf2, pRawOutBuf, nChannelSamples );
+  return true;
+}
+
+bool MixerPrimitive::mix( int32_t* pRawInBuf1, int32_t* pRawInBuf2, int32_t* pRawOutBuf, int nChannelSamples)
+{
+  getKernels().load( std::memory_order_relaxed )->mix32( pRawInBuf1, pRawInBuf2, pRawOutBuf, nChannelSamples );
+  return true;
+}
+
+bool MixerPrimitive::mix( float* pRawInBuf1, float* pRawInBuf2, float* pRawOutBuf, int nChannelSamples)
+{
+  getKernels().load( std::memory_order_relaxed )->mixFloat( pRawInBuf1, pRawInBuf2, pRawOutBuf, nChannelSamples );
+  return true;
+}
+
+bool MixerPrimitive::mix24( int8_t* pRawInBuf1, int8_t* pRawInBuf2, int8_t* pRawOutBuf, int nChannelSamples)
+{
+  getKernels().load( std::memory_order_relaxed )->mix24( pRawInBuf1, pRawInBuf2, pRawOutBuf, nChannelSamples );
   return true;
 }
 
+bool MixerPrimitive::mix( std::span<const int8_t* const> pRawInBufs, int8_t* pRawOutBuf, int nChannelSamples)
+{
+  if( !pRawInBufs.empty() ){
+    getKernels().load( std::memory_order_relaxed )->mixN8( pRawInBufs.data(), pRawInBufs.size(), pRawOutBuf, 0, nChannelSamples );
+  }
+  return !pRawInBufs.empty();
+}
+
+bool MixerPrimitive::mix( std::span<const int16_t* const> pRawInBufs, int16_t* pRawOutBuf, int nChannelSamples)
+{
+  if( !pRawInBufs.empty() ){
+    getKernels().load( std::memory_order_relaxed )->mixN16( pRawInBufs.data(), pRawInBufs.size(), pRawOutBuf, 0, nChannelSamples );
+  }
+  return !pRawInBufs.empty();
+}
+
+bool MixerPrimitive::mix( std::span<const int32_t* const> pRawInBufs, int32_t* pRawOutBuf, int nChannelSamples)
+{
+  if( !pRawInBufs.empty() ){
+    getKernels().load( std::memory_order_relaxed )->mixN32( pRawInBufs.data(), pRawInBufs.size(), pRawOutBuf, 0, nChannelSamples );
+  }
+  return !pRawInBufs.empty();
+}
+
+bool MixerPrimitive::mix( std::span<const float* const> pRawInBufs, float* pRawOutBuf, int nChannelSamples)
+{
+  if( !pRawInBufs.empty() ){
+    getKernels().load( std::memory_order_relaxed )->mixNFloat( pRawInBufs.data(), pRawInBufs.size(), pRawOutBuf, 0, nChannelSamples );
+  }
+  return !pRawInBufs.empty();
+}
+
+bool MixerPrimitive::mix24( std::span<const int8_t* const> pRawInBufs, int8_t* pRawOutBuf, int nChannelSamples)
+{
+  if( !pRawInBufs.empty() ){
+    getKernels().load( std::memory_order_relaxed )->mixN24( pRawInBufs.data(), pRawInBufs.size(), pRawOutBuf, 0, nChannelSamples );
+  }
+  return !pRawInBufs.empty();
+}
+
 #endif /* USE_TINY_MIXER_PRIMITIVE_IMPL */
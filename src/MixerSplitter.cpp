@@ -29,76 +29,193 @@ bool MixerSplitter::isPipeRunningOrNotRegistered(std::shared_ptr<ISink> srcSink)
   return ( (pPipe && pPipe->isRunning()) || !pPipe );
 }
 
-/*
-  @desc return true if add/removeSink, allocate/releaseSinkAdaptor, map/unmap/conditionalMap, source(=SinkAdaptor)'s format changed.
-  TODO: improve the format change by using AudioFormat's format change listener
-*/
-bool MixerSplitter::isSituationChanged(void)
-{
-  bool bIsChanged = mbOnChanged;
-  mbOnChanged = false;
-  if( bIsChanged ) return bIsChanged;
-  for( auto& pSource : mpSources ){
-    if( !mpSourceAudioFormats.contains( pSource ) || !mpSourceAudioFormats[pSource]->equal( pSource->getAudioFormat() )){
-      bIsChanged = true;
-      mpSourceAudioFormats.insert_or_assign( pSource, pSource->getAudioFormat().getCopiedNewSharedInstance() );
-      break;
-    }
+void MixerSplitter::SourceChangeListener::onRunnerStatusChanged(bool bRunning)
+{
+  std::shared_ptr<ISink> pSource = mpSource.lock();
+  if( pSource ){
+    mpMixerSplitter->postSourceChanged( pSource );
   }
-  return bIsChanged;
 }
 
+void MixerSplitter::SourceChangeListener::onFormatChanged(AudioFormat format)
+{
+  std::shared_ptr<ISink> pSource = mpSource.lock();
+  if( pSource ){
+    mpMixerSplitter->postSourceChanged( pSource );
+  }
+}
 
-void MixerSplitter::process(void)
+void MixerSplitter::SinkChangeListener::onFormatChanged(AudioFormat format)
 {
-  while( mbIsRunning && !mpSinks.empty() && !mpSources.empty() ){
-    if( isSituationChanged() ){
-      mMutexSourceSink.lock();
-      std::map<std::shared_ptr<ISink>, std::vector<std::shared_ptr<ISink>>> mapper;
-      for(auto& pConditionMapper : mSourceSinkMapper){
-        if( !mapper.contains( pConditionMapper->sink ) ){
-          std::vector<std::shared_ptr<ISink>> emptyArray;
-          mapper.insert_or_assign( pConditionMapper->sink, emptyArray );
-        }
-        std::shared_ptr<IPipe> pPipe = mpSourcePipes[ pConditionMapper->source ].lock();
-        if( ( (pPipe && pPipe->isRunning()) || !pPipe ) && pConditionMapper->condition->canHandle( pConditionMapper->source->getAudioFormat() ) ){
-          mapper[ pConditionMapper->sink ].push_back( pConditionMapper->source );
-        }
+  std::shared_ptr<ISink> pSink = mpSink.lock();
+  if( pSink ){
+    mpMixerSplitter->postSinkChanged( pSink );
+  }
+}
+
+void MixerSplitter::postSinkChanged(std::shared_ptr<ISink> pSink)
+{
+  std::lock_guard<std::mutex> lock(mMutexEvent);
+  mChangedSinks.insert( pSink );
+  mEvent.notify_all();
+}
+
+void MixerSplitter::postSourceChanged(std::shared_ptr<ISink> pSource)
+{
+  std::lock_guard<std::mutex> lock(mMutexEvent);
+  mChangedSources.insert( pSource );
+  mEvent.notify_all();
+}
+
+void MixerSplitter::postAllChanged(void)
+{
+  std::lock_guard<std::mutex> lock(mMutexEvent);
+  mbAllChanged = true;
+  mEvent.notify_all();
+}
+
+// for unmap, releaseSinkAdaptor. should be called before removing the mapper
+void MixerSplitter::postMappedSinksChangedLocked(std::shared_ptr<ISink> pSource)
+{
+  for( auto& aMapper : mSourceSinkMapper ){
+    if( aMapper->source == pSource ){
+      postSinkChanged( aMapper->sink );
+    }
+  }
+}
+
+bool MixerSplitter::takeChangedSinks(std::set<std::shared_ptr<ISink>>& outSinks, bool bWait)
+{
+  std::set<std::shared_ptr<ISink>> changedSources;
+  bool bAllChanged = false;
+  {
+    std::unique_lock<std::mutex> lock(mMutexEvent);
+    if( bWait ){
+      mEvent.wait( lock, [&]{ return !mbIsRunning || mbAllChanged || !mChangedSinks.empty() || !mChangedSources.empty(); } );
+    }
+    outSinks.swap( mChangedSinks );
+    mChangedSinks.clear();
+    changedSources.swap( mChangedSources );
+    bAllChanged = mbAllChanged;
+    mbAllChanged = false;
+  }
+
+  mMutexSourceSink.lock();
+  if( bAllChanged ){
+    outSinks.insert( mpSinks.begin(), mpSinks.end() );
+  }
+  for( auto& pSource : changedSources ){
+    for( auto& aMapper : mSourceSinkMapper ){
+      if( aMapper->source == pSource ){
+        outSinks.insert( aMapper->sink );
       }
+    }
+  }
+  mMutexSourceSink.unlock();
 
-      for( auto& [pSink, pSources] : mapper ){
-        // TODO: Improve only 1 stream mix(=no mix) case by bypassing PipeMixer (=Direct write to Sink) by wrapper class of InterPipeBridge
-        // ensure PipeMixer
-        if( !mpMixers.contains(pSink) ){
-          mpMixers.insert_or_assign( pSink, std::make_shared<PipeMixer>( pSink->getAudioFormat(), pSink ) );
-        }
-        // setup PipeMixer
-        std::shared_ptr<PipeMixer> pPipeMixer = mpMixers[pSink];
-        pPipeMixer->attachSink( pSink );
-        std::vector<std::shared_ptr<ISink>> sources = pPipeMixer->getSinkAdaptors();
-        for( auto& pSinkAdaptor : pSources ){
-          pPipeMixer->attachSinkAdaptor( std::dynamic_pointer_cast<InterPipeBridge>(pSinkAdaptor), mpSourcePipes[ pSinkAdaptor ].lock() );
-          std::erase( sources, pSinkAdaptor );
-        }
-        // remove unused sink adaptors(=Source for the mixer) from pPipeMixer
-        for( auto& pSinkAdaptor : sources ){
-          pPipeMixer->releaseSinkAdaptor( pSinkAdaptor );
-        }
+  return !outSinks.empty();
+}
 
-        pPipeMixer->run();
+void MixerSplitter::updateMixers(std::set<std::shared_ptr<ISink>>& sinks)
+{
+  mMutexSourceSink.lock();
+  for( auto& pSink : sinks ){
+    updateMixerLocked( pSink );
+  }
+  mMutexSourceSink.unlock();
+}
+
+/*
+  @desc update the sink's PipeMixer only. The sink adaptors which are mapped to the sink, whose pipe is running and whose format is acceptable by the condition are mixed.
+*/
+void MixerSplitter::updateMixerLocked(std::shared_ptr<ISink> pSink)
+{
+  if( !isSinkAvailableLocked( pSink ) ) return;
+
+  bool bMapped = false;
+  std::vector<std::shared_ptr<ISink>> pSources;
+  for( auto& pConditionMapper : mSourceSinkMapper ){
+    if( pConditionMapper->sink == pSink ){
+      bMapped = true;
+      AudioFormat srcFormat = pConditionMapper->source->getAudioFormat();
+      // the compressed sink's input is passed through without the mix then the PCM source can't be the input
+      bool bAcceptable = pSink->getAudioFormat().isEncodingPcm() || srcFormat.isEncodingCompressed();
+      if( bAcceptable && isPipeRunningOrNotRegistered( pConditionMapper->source ) && pConditionMapper->condition->canHandle( srcFormat ) ){
+        pSources.push_back( pConditionMapper->source );
       }
-      mMutexSourceSink.unlock();
-    } else {
-      std::this_thread::sleep_for(std::chrono::microseconds(1000));
     }
   }
+  if( !bMapped && !mpMixers.contains( pSink ) ) return;
+
+  // TODO: Improve only 1 stream mix(=no mix) case by bypassing PipeMixer (=Direct write to Sink) by wrapper class of InterPipeBridge
+  // ensure PipeMixer
+  if( !mpMixers.contains(pSink) ){
+    std::shared_ptr<PipeMixer> pPipeMixer = std::make_shared<PipeMixer>( pSink->getAudioFormat(), pSink );
+    pPipeMixer->setPullScheduler( mpPullScheduler );
+    mpMixers.insert_or_assign( pSink, pPipeMixer );
+  }
+  // setup PipeMixer
+  std::shared_ptr<PipeMixer> pPipeMixer = mpMixers[pSink];
+  pPipeMixer->attachSink( pSink );
+  std::vector<std::shared_ptr<ISink>> sources = pPipeMixer->getSinkAdaptors();
+  for( auto& pSinkAdaptor : pSources ){
+    pPipeMixer->attachSinkAdaptor( std::dynamic_pointer_cast<InterPipeBridge>(pSinkAdaptor), mpSourcePipes[ pSinkAdaptor ].lock() );
+    std::erase( sources, pSinkAdaptor );
+  }
+  // remove unused sink adaptors(=Source for the mixer) from pPipeMixer
+  for( auto& pSinkAdaptor : sources ){
+    pPipeMixer->releaseSinkAdaptor( pSinkAdaptor );
+  }
+
+  pPipeMixer->run();
+}
+
+void MixerSplitter::stopMixers(void)
+{
+  mMutexSourceSink.lock();
   for( auto& [pSink, pPipeMixer] : mpMixers ){
     pPipeMixer->stop();
   }
+  mMutexSourceSink.unlock();
+  // the stopped mixers need to be run at the next run()
+  postAllChanged();
+}
+
+void MixerSplitter::process(void)
+{
+  while( mbIsRunning && !mpSinks.empty() && !mpSources.empty() ){
+    std::set<std::shared_ptr<ISink>> sinks;
+    if( takeChangedSinks( sinks, true ) ){
+      updateMixers( sinks );
+    }
+  }
+  stopMixers();
+}
+
+ThreadBase::STEP_RESULT MixerSplitter::processStep(void)
+{
+  if( mpSinks.empty() || mpSources.empty() ){
+    return STEP_DONE;
+  }
+  std::set<std::shared_ptr<ISink>> sinks;
+  if( takeChangedSinks( sinks, false ) ){
+    updateMixers( sinks );
+  }
+  return STEP_CONTINUE;
+}
+
+void MixerSplitter::finalizeStep(void)
+{
+  stopMixers();
 }
 
 void MixerSplitter::unlockToStop(void)
 {
+  {
+    // wake up the waiting for the change
+    std::lock_guard<std::mutex> lock(mMutexEvent);
+    mEvent.notify_all();
+  }
   for( auto& pSink : mpSources ){
     std::shared_ptr<IUnlockable> pLocakable = std::dynamic_pointer_cast<IUnlockable>(pSink);
     if( pLocakable ){
@@ -113,7 +230,7 @@ void MixerSplitter::unlockToStop(void)
   }
 }
 
-MixerSplitter::MixerSplitter():ThreadBase(),mbOnChanged(false)
+MixerSplitter::MixerSplitter():ThreadBase(),mbAllChanged(true)
 {
 
 }
@@ -121,9 +238,20 @@ MixerSplitter::MixerSplitter():ThreadBase(),mbOnChanged(false)
 MixerSplitter::~MixerSplitter()
 {
   stop();
+  for( auto& [pSource, pListener] : mpSourceListeners ){
+    std::shared_ptr<IPipe> pPipe = mpSourcePipes[ pSource ].lock();
+    if( pPipe ){
+      pPipe->unregisterRunnerStatusListener( pListener );
+    }
+    pSource->unregisterAudioFormatListener( pListener );
+  }
+  mpSourceListeners.clear();
+  for( auto& [pSink, pListener] : mpSinkListeners ){
+    pSink->unregisterAudioFormatListener( pListener );
+  }
+  mpSinkListeners.clear();
   mSourceSinkMapper.clear();
   mpSources.clear();
-  mpSourceAudioFormats.clear();
   mpSourcePipes.clear();
   mpSinks.clear();
   mpMixers.clear();
@@ -136,10 +264,12 @@ std::vector<std::shared_ptr<ISink>> MixerSplitter::getAllOfSinks(void)
 
 void MixerSplitter::attachSink(std::shared_ptr<ISink> pSink)
 {
+  std::shared_ptr<SinkChangeListener> pListener = std::make_shared<SinkChangeListener>( this, pSink );
+  pSink->registerAudioFormatListener( pListener );
   mMutexSourceSink.lock();
   mpSinks.push_back( pSink );
+  mpSinkListeners.insert_or_assign( pSink, pListener );
   mMutexSourceSink.unlock();
-  mbOnChanged = true;
 }
 
 bool MixerSplitter::detachSink(std::shared_ptr<ISink> pSink)
@@ -155,6 +285,10 @@ bool MixerSplitter::detachSink(std::shared_ptr<ISink> pSink)
       mpMixers[pSink]->stop();
       mpMixers.erase(pSink);
     }
+    if( mpSinkListeners.contains( pSink ) ){
+      pSink->unregisterAudioFormatListener( mpSinkListeners[ pSink ] );
+      mpSinkListeners.erase( pSink );
+    }
     int nCurrentSize = mpSinks.size();
     std::erase( mpSinks, pSink );
     result = (mpSinks.size() == nCurrentSize);
@@ -168,7 +302,11 @@ bool MixerSplitter::detachSink(std::shared_ptr<ISink> pSink)
     }
   }
   mMutexSourceSink.unlock();
-  mbOnChanged = true;
+  {
+    // let the waiting process() know the sink's removal
+    std::lock_guard<std::mutex> lock(mMutexEvent);
+    mEvent.notify_all();
+  }
 
   return result;
 }
@@ -181,12 +319,17 @@ std::vector<std::shared_ptr<ISink>> MixerSplitter::getAllOfSinkAdaptors(void)
 std::shared_ptr<ISink> MixerSplitter::allocateSinkAdaptor(AudioFormat format, std::shared_ptr<IPipe> pPipe)
 {
   std::shared_ptr<InterPipeBridge> pInterPipeBridge = std::make_shared<InterPipeBridge>( format );
+  std::shared_ptr<ISink> pSinkAdaptor = pInterPipeBridge;
+  std::shared_ptr<SourceChangeListener> pListener = std::make_shared<SourceChangeListener>( this, pSinkAdaptor );
+  pSinkAdaptor->registerAudioFormatListener( pListener );
+  if( pPipe ){
+    pPipe->registerRunnerStatusListener( pListener );
+  }
   mMutexSourceSink.lock();
   mpSources.push_back( pInterPipeBridge );
   mpSourcePipes.insert_or_assign( pInterPipeBridge, pPipe );
-  mpSourceAudioFormats.insert_or_assign( pInterPipeBridge, format.getCopiedNewSharedInstance() );
+  mpSourceListeners.insert_or_assign( pInterPipeBridge, pListener );
   mMutexSourceSink.unlock();
-  mbOnChanged = true;
   return pInterPipeBridge;
 }
 
@@ -199,15 +342,22 @@ bool MixerSplitter::releaseSinkAdaptor(std::shared_ptr<ISink> pSink)
     if( pLockable ){
       pLockable->unlock();
     }
+    if( mpSourceListeners.contains( pSink ) ){
+      std::shared_ptr<IPipe> pPipe = mpSourcePipes[ pSink ].lock();
+      if( pPipe ){
+        pPipe->unregisterRunnerStatusListener( mpSourceListeners[ pSink ] );
+      }
+      pSink->unregisterAudioFormatListener( mpSourceListeners[ pSink ] );
+      mpSourceListeners.erase( pSink );
+    }
     int nCurrentSize = mpSources.size();
     std::erase( mpSources, pSink );
     mpSourcePipes.erase( pSink );
-    mpSourceAudioFormats.erase( pSink );
     result = (mpSources.size() == nCurrentSize);
+    postMappedSinksChangedLocked( pSink );
     removeMapperLocked(pSink);
   }
   mMutexSourceSink.unlock();
-  mbOnChanged = true;
 
   return result;
 }
@@ -261,15 +411,15 @@ bool MixerSplitter::conditionalMap(std::shared_ptr<ISink> srcSink, std::shared_p
     mSourceSinkMapper.push_back( std::make_shared<SourceSinkConditionMapper>(srcSink, dstSink, condition) );
   }
   mMutexSourceSink.unlock();
-  mbOnChanged = true;
+  if( result ){
+    postSinkChanged( dstSink );
+  }
   return result;
 }
 
 bool MixerSplitter::map(std::shared_ptr<ISink> srcSink, std::shared_ptr<ISink> dstSink)
 {
-  bool result = conditionalMap( srcSink, dstSink, std::make_shared<MapAnyCondition>() );
-  mbOnChanged = true;
-  return result;
+  return conditionalMap( srcSink, dstSink, std::make_shared<MapAnyCondition>() );
 }
 
 bool MixerSplitter::removeMapperLocked(std::shared_ptr<ISink> srcSink)
@@ -294,9 +444,9 @@ bool MixerSplitter::unmap(std::shared_ptr<ISink> srcSink)
 {
   bool result = false;
   mMutexSourceSink.lock();
+  postMappedSinksChangedLocked( srcSink );
   result = removeMapperLocked( srcSink );
   mMutexSourceSink.unlock();
-  mbOnChanged = true;
   return result;
 }
 
@@ -36,6 +36,8 @@ void MultipleSink::attachSink(std::shared_ptr<ISink> pSink, AudioFormat::Channel
     mSinkMutex.lock();
     mpSinks.push_back( pSink );
     mChannelMaps.insert_or_assign( pSink, map );
+    mpChannelRemappers.erase( pSink );
+    mpSinkBuffers.erase( pSink );
     pSink->setAudioFormat( mFormat );
     mSinkMutex.unlock();
   }
@@ -49,6 +51,8 @@ bool MultipleSink::detachSink(std::shared_ptr<ISink> pSink)
   if( mChannelMaps.contains( pSink ) ){
     std::erase( mpSinks, pSink );
     mChannelMaps.erase( pSink );
+    mpChannelRemappers.erase( pSink );
+    mpSinkBuffers.erase( pSink );
     if( mpDelayFilters.contains(pSink) ){
       mpDelayFilters.erase( pSink );
     }
@@ -84,6 +88,8 @@ void MultipleSink::clearSinks(void)
   mSinkMutex.lock();
   mpSinks.clear();
   mChannelMaps.clear();
+  mpChannelRemappers.clear();
+  mpSinkBuffers.clear();
   mSinkMutex.unlock();
 }
 
@@ -104,6 +110,27 @@ void MultipleSink::ensureDelayFiltersLocked(bool bForceRecreate)
   }
 }
 
+std::shared_ptr<ChannelRemapper> MultipleSink::getChannelRemapperLocked(std::shared_ptr<ISink> pSink, AudioFormat srcFormat, AudioFormat sinkFormat)
+{
+  std::shared_ptr<ChannelRemapper> pRemapper = mpChannelRemappers.contains( pSink ) ? mpChannelRemappers[ pSink ] : nullptr;
+  if( !pRemapper || !pRemapper->isSameConfiguration( srcFormat, sinkFormat ) ){
+    pRemapper = std::make_shared<ChannelRemapper>( srcFormat, sinkFormat, mChannelMaps[ pSink ] );
+    mpChannelRemappers.insert_or_assign( pSink, pRemapper );
+  }
+  return pRemapper;
+}
+
+std::shared_ptr<AudioBuffer> MultipleSink::getSinkBufferLocked(std::shared_ptr<ISink> pSink, AudioFormat sinkFormat)
+{
+  // the remapper resizes it only when the number of samples differs
+  std::shared_ptr<AudioBuffer> pSinkBuf = mpSinkBuffers.contains( pSink ) ? mpSinkBuffers[ pSink ] : nullptr;
+  if( !pSinkBuf || !pSinkBuf->getAudioFormat().equal( sinkFormat ) ){
+    pSinkBuf = std::make_shared<AudioBuffer>( sinkFormat, 0 );
+    mpSinkBuffers.insert_or_assign( pSink, pSinkBuf );
+  }
+  return pSinkBuf;
+}
+
 
 void MultipleSink::writePrimitive(IAudioBuffer& buf)
 {
@@ -113,18 +140,16 @@ void MultipleSink::writePrimitive(IAudioBuffer& buf)
 //    std::cout << "MultipleSink::writePrimitive to " << pSink->toString() << std::endl;
     AudioFormat sinkFormat = pSink->getAudioFormat();
     if( pBuf && sinkFormat.isEncodingPcm() ){
-      AudioFormat::ChannelMapper mapper = mChannelMaps[ pSink ];
+      AudioFormat::ChannelMapper& mapper = mChannelMaps[ pSink ];
       if( sinkFormat.getNumberOfChannels() >= mapper.size() ){
-        AudioBuffer selectedChannelData = pBuf->getSelectedChannelData( sinkFormat, mapper );
+        AudioBuffer& selectedChannelData = *getSinkBufferLocked( pSink, sinkFormat );
+        getChannelRemapperLocked( pSink, pBuf->getAudioFormat(), sinkFormat )->process( *pBuf, selectedChannelData );
         ensureDelayFiltersLocked();
         if( mpDelayFilters.contains( pSink ) ){
-          AudioBuffer delayedOut( sinkFormat, pBuf->getNumberOfSamples() );
-          std::shared_ptr<DelayFilter> pDelayFilter = mpDelayFilters[ pSink ];
-          pDelayFilter->process( selectedChannelData, delayedOut );
-          pSink->write( delayedOut );
-        } else {
-          pSink->write( selectedChannelData );
+          // the delay line works in place
+          mpDelayFilters[ pSink ]->process( selectedChannelData, selectedChannelData );
         }
+        pSink->write( selectedChannelData );
       }
     } else {
       pSink->write( buf );
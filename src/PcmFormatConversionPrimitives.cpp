@@ -17,18 +17,71 @@
 #include "PcmFormatConversionPrimitives.hpp"
 #include <algorithm>
 #include <cstdint>
-#include <functional>
-#include <iostream>
+#include <cstring>
+#include <atomic>
+
+#ifndef USE_PCM_FORMAT_CONVERSION_SIMD
+  #define USE_PCM_FORMAT_CONVERSION_SIMD 1
+#endif /* USE_PCM_FORMAT_CONVERSION_SIMD */
+
+#if USE_PCM_FORMAT_CONVERSION_SIMD && ( defined(__x86_64__) || defined(__i386__) )
+  #define PCM_FORMAT_CONVERSION_X86_SIMD 1
+  #include <immintrin.h>
+#else
+  #define PCM_FORMAT_CONVERSION_X86_SIMD 0
+#endif
+
+// 2^31 : the scale between the 32bit pcm and the float
+static constexpr float PCM32_FULL_SCALE = 2147483648.0f;
+// the largest float which is less than 2^31
+static constexpr float INT32_MAX_FLOAT = 2147483520.0f;
+
+typedef void (*CONVERT_FUNC)(uint8_t* pSrc, uint8_t* pDst, int nSamples);
+
+struct PcmConvertKernels
+{
+  PcmFormatConvert::SIMD simd;
+  CONVERT_FUNC pcm8ToPcm16, pcm8ToPcm24, pcm8ToPcm32, pcm8ToFloat;
+  CONVERT_FUNC pcm16ToPcm8, pcm16ToPcm24, pcm16ToPcm32, pcm16ToFloat;
+  CONVERT_FUNC pcm24ToPcm8, pcm24ToPcm16, pcm24ToPcm32, pcm24ToFloat;
+  CONVERT_FUNC pcm32ToPcm8, pcm32ToPcm16, pcm32ToPcm24, pcm32ToFloat;
+  CONVERT_FUNC floatToPcm8, floatToPcm16, floatToPcm24, floatToPcm32;
+};
+
+
+// --- scalar (fallback and the tail of the vector kernels)
+static inline uint32_t load24(uint8_t* pSrc)
+{
+  return ((uint32_t)pSrc[0] << 8) | ((uint32_t)pSrc[1] << 16) | ((uint32_t)pSrc[2] << 24);
+}
+
+static inline void store24(uint8_t* pDst, uint32_t sample)
+{
+  pDst[0] = (uint8_t)( sample >> 8 );
+  pDst[1] = (uint8_t)( sample >> 16 );
+  pDst[2] = (uint8_t)( sample >> 24 );
+}
+
+static inline float pcm32ToFloat(uint32_t sample)
+{
+  return (float)(int32_t)sample / PCM32_FULL_SCALE;
+}
+
+static inline uint32_t floatToPcm32(float sample)
+{
+  return (uint32_t)(int32_t)( std::max<float>( (float)INT32_MIN, std::min<float>( sample * (float)INT32_MAX, INT32_MAX_FLOAT ) ) );
+}
 
 // from Pcm8
-void PcmFormatConvert::convertPcm8ToPcm16(uint8_t* pSrc, uint16_t* pDst, int nSamples)
+static void convertPcm8ToPcm16Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint16_t* pDst16 = reinterpret_cast<uint16_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint16_t)(*pSrc++) << 8;
+    *pDst16++ = (uint16_t)(*pSrc++) << 8;
   }
 }
 
-void PcmFormatConvert::convertPcm8ToPcm24(uint8_t* pSrc, uint8_t* pDst, int nSamples)
+static void convertPcm8ToPcm24Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
   for(int i=0; i<nSamples; i++){
     *pDst++ = 0;
@@ -37,154 +90,623 @@ void PcmFormatConvert::convertPcm8ToPcm24(uint8_t* pSrc, uint8_t* pDst, int nSam
   }
 }
 
-void PcmFormatConvert::convertPcm8ToPcm32(uint8_t* pSrc, uint32_t* pDst, int nSamples)
+static void convertPcm8ToPcm32Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint32_t* pDst32 = reinterpret_cast<uint32_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint32_t)(*pSrc++) << 24;
+    *pDst32++ = (uint32_t)(*pSrc++) << 24;
   }
 }
 
-void PcmFormatConvert::convertPcm8ToFloat(uint8_t* pSrc, float* pDst, int nSamples)
+static void convertPcm8ToFloatScalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  float* pDstF = reinterpret_cast<float*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = ((float)(*pSrc++) - (float)(1<<7) + 1.0f)/(float)(1<<7);
+    *pDstF++ = ((float)(*pSrc++) - (float)(1<<7) + 1.0f)/(float)(1<<7);
   }
 }
 
 // from Pcm16
-void PcmFormatConvert::convertPcm16ToPcm8(uint16_t* pSrc, uint8_t* pDst, int nSamples)
+static void convertPcm16ToPcm8Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint16_t* pSrc16 = reinterpret_cast<uint16_t*>(pSrc);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint8_t)((*pSrc++) >> 8);
+    *pDst++ = (uint8_t)((*pSrc16++) >> 8);
   }
 }
 
-void PcmFormatConvert::convertPcm16ToPcm24(uint16_t* pSrc, uint8_t* pDst, int nSamples)
+static void convertPcm16ToPcm24Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint16_t* pSrc16 = reinterpret_cast<uint16_t*>(pSrc);
   for(int i=0; i<nSamples; i++){
     *pDst++ = 0;
-    *pDst++ = (uint8_t)(*pSrc & 0x00FF);
-    *pDst++ = (uint8_t)(((*pSrc++) & 0xFF00) >> 8);
+    *pDst++ = (uint8_t)(*pSrc16 & 0x00FF);
+    *pDst++ = (uint8_t)(((*pSrc16++) & 0xFF00) >> 8);
   }
 }
 
-void PcmFormatConvert::convertPcm16ToPcm32(uint16_t* pSrc, uint32_t* pDst, int nSamples)
+static void convertPcm16ToPcm32Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint16_t* pSrc16 = reinterpret_cast<uint16_t*>(pSrc);
+  uint32_t* pDst32 = reinterpret_cast<uint32_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint32_t)(*pSrc++) << 16;
+    *pDst32++ = (uint32_t)(*pSrc16++) << 16;
   }
 }
 
-void PcmFormatConvert::convertPcm16ToFloat(uint16_t* pSrc, float* pDst, int nSamples)
+static void convertPcm16ToFloatScalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint16_t* pSrc16 = reinterpret_cast<uint16_t*>(pSrc);
+  float* pDstF = reinterpret_cast<float*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = ((float)(*pSrc++) - (float)(1<<15) + 1.0f)/(float)(1<<15);
+    *pDstF++ = ((float)(*pSrc16++) - (float)(1<<15) + 1.0f)/(float)(1<<15);
   }
 }
 
 // from pcm24
-void PcmFormatConvert::convertPcm24ToPcm8(uint8_t* pSrc, uint8_t* pDst, int nSamples)
+static void convertPcm24ToPcm8Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
   for(int i=0; i<nSamples; i++){
-    pSrc++;
-    pSrc++;
-    *pDst++ = (uint8_t)(*pSrc++);
+    *pDst++ = pSrc[2];
+    pSrc += 3;
   }
 }
 
-void PcmFormatConvert::convertPcm24ToPcm16(uint8_t* pSrc, uint16_t* pDst, int nSamples)
+static void convertPcm24ToPcm16Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint16_t* pDst16 = reinterpret_cast<uint16_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-    pSrc++;
-    *pDst = (uint16_t)(*pSrc++);
-    *pDst++ = *pDst + ((uint16_t)(*pSrc++) << 8);
+    *pDst16++ = (uint16_t)pSrc[1] | ((uint16_t)pSrc[2] << 8);
+    pSrc += 3;
   }
 }
 
-void PcmFormatConvert::convertPcm24ToPcm32(uint8_t* pSrc, uint32_t* pDst, int nSamples)
+static void convertPcm24ToPcm32Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint32_t* pDst32 = reinterpret_cast<uint32_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst = (uint32_t)(*pSrc++) << 8;
-    *pDst = *pDst + ((uint32_t)(*pSrc++) << 16);
-    *pDst++ = *pDst + ((uint32_t)(*pSrc++) << 24);
+    *pDst32++ = load24( pSrc );
+    pSrc += 3;
   }
 }
 
-void PcmFormatConvert::convertPcm24ToFloat(uint8_t* pSrc, float* pDst, int nSamples)
+static void convertPcm24ToFloatScalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  float* pDstF = reinterpret_cast<float*>(pDst);
   for(int i=0; i<nSamples; i++){
-    uint32_t tmp = 0;
-    convertPcm24ToPcm32(pSrc, &tmp);
-    *pDst++ = ((float)tmp - (float)(1<<31) + 1.0f)/(float)(1<<31);
+    *pDstF++ = pcm32ToFloat( load24( pSrc ) );
+    pSrc += 3;
   }
 }
 
-
 // from pcm32
-void PcmFormatConvert::convertPcm32ToPcm8(uint32_t* pSrc, uint8_t* pDst, int nSamples)
+static void convertPcm32ToPcm8Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint32_t* pSrc32 = reinterpret_cast<uint32_t*>(pSrc);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint8_t)((*pSrc++) >> 24);
+    *pDst++ = (uint8_t)((*pSrc32++) >> 24);
   }
 }
 
-void PcmFormatConvert::convertPcm32ToPcm16(uint32_t* pSrc, uint16_t* pDst, int nSamples)
+static void convertPcm32ToPcm16Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint32_t* pSrc32 = reinterpret_cast<uint32_t*>(pSrc);
+  uint16_t* pDst16 = reinterpret_cast<uint16_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint16_t)((*pSrc++) >> 16);
+    *pDst16++ = (uint16_t)((*pSrc32++) >> 16);
   }
 }
 
-void PcmFormatConvert::convertPcm32ToPcm24(uint32_t* pSrc, uint8_t* pDst, int nSamples)
+static void convertPcm32ToPcm24Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint32_t* pSrc32 = reinterpret_cast<uint32_t*>(pSrc);
   for(int i=0; i<nSamples; i++){
-    uint32_t tmp = *pSrc++;
-
-    *pDst++ = (uint8_t)((tmp & 0x0000FF00) >> 8);
-    *pDst++ = (uint8_t)((tmp & 0x00FF0000) >> 16);
-    *pDst++ = (uint8_t)((tmp & 0xFF000000) >> 24);
+    store24( pDst, *pSrc32++ );
+    pDst += 3;
   }
 }
 
-void PcmFormatConvert::convertPcm32ToFloat(uint32_t* pSrc, float* pDst, int nSamples)
+static void convertPcm32ToFloatScalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  uint32_t* pSrc32 = reinterpret_cast<uint32_t*>(pSrc);
+  float* pDstF = reinterpret_cast<float*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = ((float)(*pSrc++) - (float)(1<<31) + 1.0f)/(float)(1<<31);
+    *pDstF++ = pcm32ToFloat( *pSrc32++ );
   }
 }
 
-
 // from float32
-void PcmFormatConvert::convertFloatToPcm8(float* pSrc, uint8_t* pDst, int nSamples)
+static void convertFloatToPcm8Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  float* pSrcF = reinterpret_cast<float*>(pSrc);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint8_t)( ((*pSrc++)+1.0f) * (1<<7) - 1 );
+    *pDst++ = (uint8_t)(int32_t)( ((*pSrcF++)+1.0f) * (1<<7) - 1 );
   }
 }
 
-void PcmFormatConvert::convertFloatToPcm16(float* pSrc, uint16_t* pDst, int nSamples)
+static void convertFloatToPcm16Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  float* pSrcF = reinterpret_cast<float*>(pSrc);
+  uint16_t* pDst16 = reinterpret_cast<uint16_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-    *pDst++ = (uint16_t)( ((*pSrc++)+1.0f) * (1<<15) - 1 );
+    *pDst16++ = (uint16_t)(int32_t)( ((*pSrcF++)+1.0f) * (1<<15) - 1 );
   }
 }
 
-void PcmFormatConvert::convertFloatToPcm24(float* pSrc, uint8_t* pDst, int nSamples)
+static void convertFloatToPcm24Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  float* pSrcF = reinterpret_cast<float*>(pSrc);
   for(int i=0; i<nSamples; i++){
-    uint32_t tmp = 0;
-    convertFloatToPcm32(pSrc, &tmp);
-
-    *pDst++ = (uint8_t)((tmp & 0x0000FF00) >> 8);
-    *pDst++ = (uint8_t)((tmp & 0x00FF0000) >> 16);
-    *pDst++ = (uint8_t)((tmp & 0xFF000000) >> 24);
+    store24( pDst, floatToPcm32( *pSrcF++ ) );
+    pDst += 3;
   }
 }
 
-void PcmFormatConvert::convertFloatToPcm32(float* pSrc, uint32_t* pDst, int nSamples)
+static void convertFloatToPcm32Scalar(uint8_t* pSrc, uint8_t* pDst, int nSamples)
 {
+  float* pSrcF = reinterpret_cast<float*>(pSrc);
+  uint32_t* pDst32 = reinterpret_cast<uint32_t*>(pDst);
   for(int i=0; i<nSamples; i++){
-//    *pDst++ = (uint32_t)( ((*pSrc++)+1.0f) * (1<<31) - 1 );
-    *pDst++ = (uint32_t)(int32_t)( std::max<float>((float)INT32_MIN, std::min<float>( (float)((*pSrc++) * (float)INT32_MAX), (float)INT32_MAX ) ) );
+    *pDst32++ = floatToPcm32( *pSrcF++ );
+  }
+}
+
+static const PcmConvertKernels gScalarKernels = {
+  PcmFormatConvert::SIMD::SCALAR,
+  convertPcm8ToPcm16Scalar, convertPcm8ToPcm24Scalar, convertPcm8ToPcm32Scalar, convertPcm8ToFloatScalar,
+  convertPcm16ToPcm8Scalar, convertPcm16ToPcm24Scalar, convertPcm16ToPcm32Scalar, convertPcm16ToFloatScalar,
+  convertPcm24ToPcm8Scalar, convertPcm24ToPcm16Scalar, convertPcm24ToPcm32Scalar, convertPcm24ToFloatScalar,
+  convertPcm32ToPcm8Scalar, convertPcm32ToPcm16Scalar, convertPcm32ToPcm24Scalar, convertPcm32ToFloatScalar,
+  convertFloatToPcm8Scalar, convertFloatToPcm16Scalar, convertFloatToPcm24Scalar, convertFloatToPcm32Scalar
+};
+
+
+#if PCM_FORMAT_CONVERSION_X86_SIMD
+/*
+  The vector kernels are composed by a loader and a storer over 32bit lanes.
+  The integer pairs go through the 32bit pcm (the sample is on the upper bits) then any pair is the combination of them.
+  The float pairs except the 24/32bit use the lanes for the float directly.
+*/
+
+// --- SSE2 : 4 samples per vector
+__attribute__((target("sse2")))
+static inline __m128i loadPcm32FromPcm8Sse2(const uint8_t* pSrc)
+{
+  int32_t packed;
+  memcpy( &packed, pSrc, sizeof(int32_t) );
+  __m128i in = _mm_unpacklo_epi8( _mm_setzero_si128(), _mm_cvtsi32_si128( packed ) );
+  return _mm_unpacklo_epi16( _mm_setzero_si128(), in );
+}
+
+__attribute__((target("sse2")))
+static inline __m128i loadPcm32FromPcm16Sse2(const uint8_t* pSrc)
+{
+  return _mm_unpacklo_epi16( _mm_setzero_si128(), _mm_loadl_epi64( reinterpret_cast<const __m128i*>(pSrc) ) );
+}
+
+__attribute__((target("sse2")))
+static inline __m128i loadPcm32Sse2(const uint8_t* pSrc)
+{
+  return _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) );
+}
+
+__attribute__((target("sse2")))
+static inline __m128i loadPcm32FromFloatSse2(const uint8_t* pSrc)
+{
+  __m128 in = _mm_mul_ps( _mm_loadu_ps( reinterpret_cast<const float*>(pSrc) ), _mm_set1_ps( (float)INT32_MAX ) );
+  return _mm_cvttps_epi32( _mm_max_ps( _mm_min_ps( in, _mm_set1_ps( INT32_MAX_FLOAT ) ), _mm_set1_ps( (float)INT32_MIN ) ) );
+}
+
+__attribute__((target("sse2")))
+static inline __m128i loadFloatFromPcm8Sse2(const uint8_t* pSrc)
+{
+  int32_t packed;
+  memcpy( &packed, pSrc, sizeof(int32_t) );
+  __m128i in = _mm_unpacklo_epi8( _mm_cvtsi32_si128( packed ), _mm_setzero_si128() );
+  __m128 out = _mm_cvtepi32_ps( _mm_unpacklo_epi16( in, _mm_setzero_si128() ) );
+  out = _mm_add_ps( _mm_sub_ps( out, _mm_set1_ps( (float)(1<<7) ) ), _mm_set1_ps( 1.0f ) );
+  return _mm_castps_si128( _mm_mul_ps( out, _mm_set1_ps( 1.0f/(float)(1<<7) ) ) );
+}
+
+__attribute__((target("sse2")))
+static inline __m128i loadFloatFromPcm16Sse2(const uint8_t* pSrc)
+{
+  __m128i in = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(pSrc) );
+  __m128 out = _mm_cvtepi32_ps( _mm_unpacklo_epi16( in, _mm_setzero_si128() ) );
+  out = _mm_add_ps( _mm_sub_ps( out, _mm_set1_ps( (float)(1<<15) ) ), _mm_set1_ps( 1.0f ) );
+  return _mm_castps_si128( _mm_mul_ps( out, _mm_set1_ps( 1.0f/(float)(1<<15) ) ) );
+}
+
+__attribute__((target("sse2")))
+static inline void storePcm32ToPcm8Sse2(uint8_t* pDst, __m128i in)
+{
+  // the arithmetic shift keeps the values in the signed range then packs doesn't saturate
+  in = _mm_srai_epi32( in, 24 );
+  in = _mm_packs_epi32( in, in );
+  int32_t packed = _mm_cvtsi128_si32( _mm_packs_epi16( in, in ) );
+  memcpy( pDst, &packed, sizeof(int32_t) );
+}
+
+__attribute__((target("sse2")))
+static inline void storePcm32ToPcm16Sse2(uint8_t* pDst, __m128i in)
+{
+  in = _mm_srai_epi32( in, 16 );
+  _mm_storel_epi64( reinterpret_cast<__m128i*>(pDst), _mm_packs_epi32( in, in ) );
+}
+
+__attribute__((target("sse2")))
+static inline void storePcm32Sse2(uint8_t* pDst, __m128i in)
+{
+  _mm_storeu_si128( reinterpret_cast<__m128i*>(pDst), in );
+}
+
+__attribute__((target("sse2")))
+static inline void storeFloatFromPcm32Sse2(uint8_t* pDst, __m128i in)
+{
+  _mm_storeu_ps( reinterpret_cast<float*>(pDst), _mm_mul_ps( _mm_cvtepi32_ps( in ), _mm_set1_ps( 1.0f/PCM32_FULL_SCALE ) ) );
+}
+
+__attribute__((target("sse2")))
+static inline void storePcm8FromFloatSse2(uint8_t* pDst, __m128i in)
+{
+  __m128 out = _mm_sub_ps( _mm_mul_ps( _mm_add_ps( _mm_castsi128_ps( in ), _mm_set1_ps( 1.0f ) ), _mm_set1_ps( (float)(1<<7) ) ), _mm_set1_ps( 1.0f ) );
+  // take the lowest byte as the scalar cast does
+  storePcm32ToPcm8Sse2( pDst, _mm_slli_epi32( _mm_cvttps_epi32( out ), 24 ) );
+}
+
+__attribute__((target("sse2")))
+static inline void storePcm16FromFloatSse2(uint8_t* pDst, __m128i in)
+{
+  __m128 out = _mm_sub_ps( _mm_mul_ps( _mm_add_ps( _mm_castsi128_ps( in ), _mm_set1_ps( 1.0f ) ), _mm_set1_ps( (float)(1<<15) ) ), _mm_set1_ps( 1.0f ) );
+  storePcm32ToPcm16Sse2( pDst, _mm_slli_epi32( _mm_cvttps_epi32( out ), 16 ) );
+}
+
+template <int SRC_BYTES, int DST_BYTES, __m128i (*LOAD)(const uint8_t*), void (*STORE)(uint8_t*, __m128i), CONVERT_FUNC SCALAR>
+__attribute__((target("sse2")))
+static void convertSse2(uint8_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  int i = 0;
+  for(; i+4<=nSamples; i+=4){
+    STORE( pDst+i*DST_BYTES, LOAD( pSrc+i*SRC_BYTES ) );
   }
+  SCALAR( pSrc+i*SRC_BYTES, pDst+i*DST_BYTES, nSamples-i );
+}
+
+// the 24bit pack/unpack requires the byte shuffle then it's done by the scalar kernel on SSE2
+static const PcmConvertKernels gSse2Kernels = {
+  PcmFormatConvert::SIMD::SSE2,
+  convertSse2<1, 2, loadPcm32FromPcm8Sse2, storePcm32ToPcm16Sse2, convertPcm8ToPcm16Scalar>,
+  convertPcm8ToPcm24Scalar,
+  convertSse2<1, 4, loadPcm32FromPcm8Sse2, storePcm32Sse2, convertPcm8ToPcm32Scalar>,
+  convertSse2<1, 4, loadFloatFromPcm8Sse2, storePcm32Sse2, convertPcm8ToFloatScalar>,
+
+  convertSse2<2, 1, loadPcm32FromPcm16Sse2, storePcm32ToPcm8Sse2, convertPcm16ToPcm8Scalar>,
+  convertPcm16ToPcm24Scalar,
+  convertSse2<2, 4, loadPcm32FromPcm16Sse2, storePcm32Sse2, convertPcm16ToPcm32Scalar>,
+  convertSse2<2, 4, loadFloatFromPcm16Sse2, storePcm32Sse2, convertPcm16ToFloatScalar>,
+
+  convertPcm24ToPcm8Scalar, convertPcm24ToPcm16Scalar, convertPcm24ToPcm32Scalar, convertPcm24ToFloatScalar,
+
+  convertSse2<4, 1, loadPcm32Sse2, storePcm32ToPcm8Sse2, convertPcm32ToPcm8Scalar>,
+  convertSse2<4, 2, loadPcm32Sse2, storePcm32ToPcm16Sse2, convertPcm32ToPcm16Scalar>,
+  convertPcm32ToPcm24Scalar,
+  convertSse2<4, 4, loadPcm32Sse2, storeFloatFromPcm32Sse2, convertPcm32ToFloatScalar>,
+
+  convertSse2<4, 1, loadPcm32Sse2, storePcm8FromFloatSse2, convertFloatToPcm8Scalar>,
+  convertSse2<4, 2, loadPcm32Sse2, storePcm16FromFloatSse2, convertFloatToPcm16Scalar>,
+  convertFloatToPcm24Scalar,
+  convertSse2<4, 4, loadPcm32FromFloatSse2, storePcm32Sse2, convertFloatToPcm32Scalar>
+};
+
+
+// --- AVX2 : 8 samples per vector
+__attribute__((target("avx2")))
+static inline __m256i loadPcm32FromPcm8Avx2(const uint8_t* pSrc)
+{
+  return _mm256_slli_epi32( _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i*>(pSrc) ) ), 24 );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i loadPcm32FromPcm16Avx2(const uint8_t* pSrc)
+{
+  return _mm256_slli_epi32( _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) ) ), 16 );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i loadPcm32FromPcm24Avx2(const uint8_t* pSrc)
+{
+  // 8 samples = 24 bytes. the upper lane is loaded from the byte 8 then its samples start at the byte 4 of the lane.
+  const __m256i unpackMask = _mm256_setr_epi8(
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+    -1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15 );
+  __m128i low = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) );
+  __m128i high = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc+8) );
+  return _mm256_shuffle_epi8( _mm256_inserti128_si256( _mm256_castsi128_si256( low ), high, 1 ), unpackMask );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i loadPcm32Avx2(const uint8_t* pSrc)
+{
+  return _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pSrc) );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i loadPcm32FromFloatAvx2(const uint8_t* pSrc)
+{
+  __m256 in = _mm256_mul_ps( _mm256_loadu_ps( reinterpret_cast<const float*>(pSrc) ), _mm256_set1_ps( (float)INT32_MAX ) );
+  return _mm256_cvttps_epi32( _mm256_max_ps( _mm256_min_ps( in, _mm256_set1_ps( INT32_MAX_FLOAT ) ), _mm256_set1_ps( (float)INT32_MIN ) ) );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i loadFloatFromPcm8Avx2(const uint8_t* pSrc)
+{
+  __m256 out = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i*>(pSrc) ) ) );
+  out = _mm256_add_ps( _mm256_sub_ps( out, _mm256_set1_ps( (float)(1<<7) ) ), _mm256_set1_ps( 1.0f ) );
+  return _mm256_castps_si256( _mm256_mul_ps( out, _mm256_set1_ps( 1.0f/(float)(1<<7) ) ) );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i loadFloatFromPcm16Avx2(const uint8_t* pSrc)
+{
+  __m256 out = _mm256_cvtepi32_ps( _mm256_cvtepu16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) ) ) );
+  out = _mm256_add_ps( _mm256_sub_ps( out, _mm256_set1_ps( (float)(1<<15) ) ), _mm256_set1_ps( 1.0f ) );
+  return _mm256_castps_si256( _mm256_mul_ps( out, _mm256_set1_ps( 1.0f/(float)(1<<15) ) ) );
+}
+
+__attribute__((target("avx2")))
+static inline __m128i packToPcm16Avx2(__m256i in)
+{
+  // packs works per 128bit lane then gather the lower halves
+  return _mm256_castsi256_si128( _mm256_permute4x64_epi64( _mm256_packs_epi32( in, in ), 0x08 ) );
+}
+
+__attribute__((target("avx2")))
+static inline void storePcm32ToPcm8Avx2(uint8_t* pDst, __m256i in)
+{
+  __m128i out = packToPcm16Avx2( _mm256_srai_epi32( in, 24 ) );
+  _mm_storel_epi64( reinterpret_cast<__m128i*>(pDst), _mm_packs_epi16( out, out ) );
+}
+
+__attribute__((target("avx2")))
+static inline void storePcm32ToPcm16Avx2(uint8_t* pDst, __m256i in)
+{
+  _mm_storeu_si128( reinterpret_cast<__m128i*>(pDst), packToPcm16Avx2( _mm256_srai_epi32( in, 16 ) ) );
+}
+
+__attribute__((target("avx2")))
+static inline void storePcm32ToPcm24Avx2(uint8_t* pDst, __m256i in)
+{
+  // take the upper 24bit of each 32bit lane then gather the 24 bytes to the lower side
+  const __m256i packMask = _mm256_setr_epi8(
+    1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1,
+    1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1 );
+  __m256i out = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( in, packMask ), _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 ) );
+  _mm_storeu_si128( reinterpret_cast<__m128i*>(pDst), _mm256_castsi256_si128( out ) );
+  _mm_storel_epi64( reinterpret_cast<__m128i*>(pDst+16), _mm256_extracti128_si256( out, 1 ) );
+}
+
+__attribute__((target("avx2")))
+static inline void storePcm32Avx2(uint8_t* pDst, __m256i in)
+{
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>(pDst), in );
+}
+
+__attribute__((target("avx2")))
+static inline void storeFloatFromPcm32Avx2(uint8_t* pDst, __m256i in)
+{
+  _mm256_storeu_ps( reinterpret_cast<float*>(pDst), _mm256_mul_ps( _mm256_cvtepi32_ps( in ), _mm256_set1_ps( 1.0f/PCM32_FULL_SCALE ) ) );
+}
+
+__attribute__((target("avx2")))
+static inline void storePcm8FromFloatAvx2(uint8_t* pDst, __m256i in)
+{
+  __m256 out = _mm256_sub_ps( _mm256_mul_ps( _mm256_add_ps( _mm256_castsi256_ps( in ), _mm256_set1_ps( 1.0f ) ), _mm256_set1_ps( (float)(1<<7) ) ), _mm256_set1_ps( 1.0f ) );
+  // take the lowest byte as the scalar cast does
+  storePcm32ToPcm8Avx2( pDst, _mm256_slli_epi32( _mm256_cvttps_epi32( out ), 24 ) );
+}
+
+__attribute__((target("avx2")))
+static inline void storePcm16FromFloatAvx2(uint8_t* pDst, __m256i in)
+{
+  __m256 out = _mm256_sub_ps( _mm256_mul_ps( _mm256_add_ps( _mm256_castsi256_ps( in ), _mm256_set1_ps( 1.0f ) ), _mm256_set1_ps( (float)(1<<15) ) ), _mm256_set1_ps( 1.0f ) );
+  storePcm32ToPcm16Avx2( pDst, _mm256_slli_epi32( _mm256_cvttps_epi32( out ), 16 ) );
+}
+
+template <int SRC_BYTES, int DST_BYTES, __m256i (*LOAD)(const uint8_t*), void (*STORE)(uint8_t*, __m256i), CONVERT_FUNC SCALAR>
+__attribute__((target("avx2")))
+static void convertAvx2(uint8_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  int i = 0;
+  for(; i+8<=nSamples; i+=8){
+    STORE( pDst+i*DST_BYTES, LOAD( pSrc+i*SRC_BYTES ) );
+  }
+  SCALAR( pSrc+i*SRC_BYTES, pDst+i*DST_BYTES, nSamples-i );
+}
+
+static const PcmConvertKernels gAvx2Kernels = {
+  PcmFormatConvert::SIMD::AVX2,
+  convertAvx2<1, 2, loadPcm32FromPcm8Avx2, storePcm32ToPcm16Avx2, convertPcm8ToPcm16Scalar>,
+  convertAvx2<1, 3, loadPcm32FromPcm8Avx2, storePcm32ToPcm24Avx2, convertPcm8ToPcm24Scalar>,
+  convertAvx2<1, 4, loadPcm32FromPcm8Avx2, storePcm32Avx2, convertPcm8ToPcm32Scalar>,
+  convertAvx2<1, 4, loadFloatFromPcm8Avx2, storePcm32Avx2, convertPcm8ToFloatScalar>,
+
+  convertAvx2<2, 1, loadPcm32FromPcm16Avx2, storePcm32ToPcm8Avx2, convertPcm16ToPcm8Scalar>,
+  convertAvx2<2, 3, loadPcm32FromPcm16Avx2, storePcm32ToPcm24Avx2, convertPcm16ToPcm24Scalar>,
+  convertAvx2<2, 4, loadPcm32FromPcm16Avx2, storePcm32Avx2, convertPcm16ToPcm32Scalar>,
+  convertAvx2<2, 4, loadFloatFromPcm16Avx2, storePcm32Avx2, convertPcm16ToFloatScalar>,
+
+  convertAvx2<3, 1, loadPcm32FromPcm24Avx2, storePcm32ToPcm8Avx2, convertPcm24ToPcm8Scalar>,
+  convertAvx2<3, 2, loadPcm32FromPcm24Avx2, storePcm32ToPcm16Avx2, convertPcm24ToPcm16Scalar>,
+  convertAvx2<3, 4, loadPcm32FromPcm24Avx2, storePcm32Avx2, convertPcm24ToPcm32Scalar>,
+  convertAvx2<3, 4, loadPcm32FromPcm24Avx2, storeFloatFromPcm32Avx2, convertPcm24ToFloatScalar>,
+
+  convertAvx2<4, 1, loadPcm32Avx2, storePcm32ToPcm8Avx2, convertPcm32ToPcm8Scalar>,
+  convertAvx2<4, 2, loadPcm32Avx2, storePcm32ToPcm16Avx2, convertPcm32ToPcm16Scalar>,
+  convertAvx2<4, 3, loadPcm32Avx2, storePcm32ToPcm24Avx2, convertPcm32ToPcm24Scalar>,
+  convertAvx2<4, 4, loadPcm32Avx2, storeFloatFromPcm32Avx2, convertPcm32ToFloatScalar>,
+
+  convertAvx2<4, 1, loadPcm32Avx2, storePcm8FromFloatAvx2, convertFloatToPcm8Scalar>,
+  convertAvx2<4, 2, loadPcm32Avx2, storePcm16FromFloatAvx2, convertFloatToPcm16Scalar>,
+  convertAvx2<4, 3, loadPcm32FromFloatAvx2, storePcm32ToPcm24Avx2, convertFloatToPcm24Scalar>,
+  convertAvx2<4, 4, loadPcm32FromFloatAvx2, storePcm32Avx2, convertFloatToPcm32Scalar>
+};
+#endif /* PCM_FORMAT_CONVERSION_X86_SIMD */
+
+
+static const PcmConvertKernels* getKernelsFor(PcmFormatConvert::SIMD simd)
+{
+  const PcmConvertKernels* pKernels = nullptr;
+  if( CpuFeature::isSimdSupported( simd ) ){
+    switch( simd ){
+      case PcmFormatConvert::SIMD::SCALAR:
+        pKernels = &gScalarKernels;
+        break;
+#if PCM_FORMAT_CONVERSION_X86_SIMD
+      case PcmFormatConvert::SIMD::SSE2:
+        pKernels = &gSse2Kernels;
+        break;
+      case PcmFormatConvert::SIMD::AVX2:
+        pKernels = &gAvx2Kernels;
+        break;
+#endif /* PCM_FORMAT_CONVERSION_X86_SIMD */
+      default:
+        break;
+    }
+  }
+  return pKernels;
+}
+
+static std::atomic<const PcmConvertKernels*>& getKernels(void)
+{
+  // the best kernel set is chosen once by the cpu feature detection
+  static std::atomic<const PcmConvertKernels*> kernels = []{
+    const PcmConvertKernels* pKernels = getKernelsFor( CpuFeature::getSimd() );
+    return pKernels ? pKernels : &gScalarKernels;
+  }();
+  return kernels;
+}
+
+static inline const PcmConvertKernels* kernels(void)
+{
+  return getKernels().load( std::memory_order_relaxed );
+}
+
+PcmFormatConvert::SIMD PcmFormatConvert::getSimd(void)
+{
+  return kernels()->simd;
+}
+
+bool PcmFormatConvert::setSimd(SIMD simd)
+{
+  const PcmConvertKernels* pKernels = getKernelsFor( simd );
+  if( pKernels ){
+    getKernels().store( pKernels, std::memory_order_relaxed );
+  }
+  return pKernels != nullptr;
+}
+
+
+// from Pcm8
+void PcmFormatConvert::convertPcm8ToPcm16(uint8_t* pSrc, uint16_t* pDst, int nSamples)
+{
+  kernels()->pcm8ToPcm16( pSrc, reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+void PcmFormatConvert::convertPcm8ToPcm24(uint8_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->pcm8ToPcm24( pSrc, pDst, nSamples );
+}
+
+void PcmFormatConvert::convertPcm8ToPcm32(uint8_t* pSrc, uint32_t* pDst, int nSamples)
+{
+  kernels()->pcm8ToPcm32( pSrc, reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+void PcmFormatConvert::convertPcm8ToFloat(uint8_t* pSrc, float* pDst, int nSamples)
+{
+  kernels()->pcm8ToFloat( pSrc, reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+// from Pcm16
+void PcmFormatConvert::convertPcm16ToPcm8(uint16_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->pcm16ToPcm8( reinterpret_cast<uint8_t*>(pSrc), pDst, nSamples );
+}
+
+void PcmFormatConvert::convertPcm16ToPcm24(uint16_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->pcm16ToPcm24( reinterpret_cast<uint8_t*>(pSrc), pDst, nSamples );
+}
+
+void PcmFormatConvert::convertPcm16ToPcm32(uint16_t* pSrc, uint32_t* pDst, int nSamples)
+{
+  kernels()->pcm16ToPcm32( reinterpret_cast<uint8_t*>(pSrc), reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+void PcmFormatConvert::convertPcm16ToFloat(uint16_t* pSrc, float* pDst, int nSamples)
+{
+  kernels()->pcm16ToFloat( reinterpret_cast<uint8_t*>(pSrc), reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+// from pcm24
+void PcmFormatConvert::convertPcm24ToPcm8(uint8_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->pcm24ToPcm8( pSrc, pDst, nSamples );
+}
+
+void PcmFormatConvert::convertPcm24ToPcm16(uint8_t* pSrc, uint16_t* pDst, int nSamples)
+{
+  kernels()->pcm24ToPcm16( pSrc, reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+void PcmFormatConvert::convertPcm24ToPcm32(uint8_t* pSrc, uint32_t* pDst, int nSamples)
+{
+  kernels()->pcm24ToPcm32( pSrc, reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+void PcmFormatConvert::convertPcm24ToFloat(uint8_t* pSrc, float* pDst, int nSamples)
+{
+  kernels()->pcm24ToFloat( pSrc, reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+// from pcm32
+void PcmFormatConvert::convertPcm32ToPcm8(uint32_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->pcm32ToPcm8( reinterpret_cast<uint8_t*>(pSrc), pDst, nSamples );
+}
+
+void PcmFormatConvert::convertPcm32ToPcm16(uint32_t* pSrc, uint16_t* pDst, int nSamples)
+{
+  kernels()->pcm32ToPcm16( reinterpret_cast<uint8_t*>(pSrc), reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+void PcmFormatConvert::convertPcm32ToPcm24(uint32_t* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->pcm32ToPcm24( reinterpret_cast<uint8_t*>(pSrc), pDst, nSamples );
+}
+
+void PcmFormatConvert::convertPcm32ToFloat(uint32_t* pSrc, float* pDst, int nSamples)
+{
+  kernels()->pcm32ToFloat( reinterpret_cast<uint8_t*>(pSrc), reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+// from float32
+void PcmFormatConvert::convertFloatToPcm8(float* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->floatToPcm8( reinterpret_cast<uint8_t*>(pSrc), pDst, nSamples );
+}
+
+void PcmFormatConvert::convertFloatToPcm16(float* pSrc, uint16_t* pDst, int nSamples)
+{
+  kernels()->floatToPcm16( reinterpret_cast<uint8_t*>(pSrc), reinterpret_cast<uint8_t*>(pDst), nSamples );
+}
+
+void PcmFormatConvert::convertFloatToPcm24(float* pSrc, uint8_t* pDst, int nSamples)
+{
+  kernels()->floatToPcm24( reinterpret_cast<uint8_t*>(pSrc), pDst, nSamples );
+}
+
+void PcmFormatConvert::convertFloatToPcm32(float* pSrc, uint32_t* pDst, int nSamples)
+{
+  kernels()->floatToPcm32( reinterpret_cast<uint8_t*>(pSrc), reinterpret_cast<uint8_t*>(pDst), nSamples );
 }
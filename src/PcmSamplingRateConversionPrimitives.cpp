@@ -15,10 +15,20 @@
 */
 
 #include "PcmSamplingRateConversionPrimitives.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include "CpuFeature.hpp"
 
 // TODO: rewrite with template
 // DO NOT USE THIS TINY SRC in the production device
 // SHOULD REPLACE WITH HIGH QUALITY SRC
+// Note that this is used only by the stateless AudioFormatAdaptor::samplingRateConversion().
+// The streams should keep PcmSamplingRateConverter (see the below) instead.
 
 #ifndef USE_TINY_SRC_IMPL
   #define USE_TINY_SRC_IMPL 1
@@ -141,3 +151,284 @@ bool PcmSamplingRateConvert::convert(float* pSrc, float* pDst, int32_t srcRate,
 }
 
 #endif /* USE_TINY_SRC_IMPL */
+
+
+#ifndef USE_SAMPLING_RATE_CONVERSION_SIMD
+  #define USE_SAMPLING_RATE_CONVERSION_SIMD 1
+#endif /* USE_SAMPLING_RATE_CONVERSION_SIMD */
+
+#if USE_SAMPLING_RATE_CONVERSION_SIMD && ( defined(__x86_64__) || defined(__i386__) )
+  #define SAMPLING_RATE_CONVERSION_X86_SIMD 1
+  #include <immintrin.h>
+#else
+  #define SAMPLING_RATE_CONVERSION_X86_SIMD 0
+#endif
+
+// the kaiser window's beta (about -80dB stopband) and the cutoff relative to the lower nyquist frequency
+static constexpr double KAISER_BETA = 8.6;
+static constexpr double CUTOFF_RATIO = 0.92;
+
+static float dotProductScalar(const float* pCoefficients, const float* pSamples, int nTaps)
+{
+  float result = 0.0f;
+  for(int i=0; i<nTaps; i++){
+    result += pCoefficients[i] * pSamples[i];
+  }
+  return result;
+}
+
+#if SAMPLING_RATE_CONVERSION_X86_SIMD
+__attribute__((target("sse2")))
+static float dotProductSse2(const float* pCoefficients, const float* pSamples, int nTaps)
+{
+  __m128 acc = _mm_setzero_ps();
+  int i = 0;
+  for(; i+4<=nTaps; i+=4){
+    acc = _mm_add_ps( acc, _mm_mul_ps( _mm_loadu_ps( pCoefficients+i ), _mm_loadu_ps( pSamples+i ) ) );
+  }
+  acc = _mm_add_ps( acc, _mm_movehl_ps( acc, acc ) );
+  acc = _mm_add_ss( acc, _mm_shuffle_ps( acc, acc, 1 ) );
+  return _mm_cvtss_f32( acc ) + dotProductScalar( pCoefficients+i, pSamples+i, nTaps-i );
+}
+
+__attribute__((target("avx2")))
+static float dotProductAvx2(const float* pCoefficients, const float* pSamples, int nTaps)
+{
+  __m256 acc = _mm256_setzero_ps();
+  int i = 0;
+  for(; i+8<=nTaps; i+=8){
+    acc = _mm256_add_ps( acc, _mm256_mul_ps( _mm256_loadu_ps( pCoefficients+i ), _mm256_loadu_ps( pSamples+i ) ) );
+  }
+  __m128 sum = _mm_add_ps( _mm256_castps256_ps128( acc ), _mm256_extractf128_ps( acc, 1 ) );
+  sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+  sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+  return _mm_cvtss_f32( sum ) + dotProductScalar( pCoefficients+i, pSamples+i, nTaps-i );
+}
+#endif /* SAMPLING_RATE_CONVERSION_X86_SIMD */
+
+// the zeroth order modified bessel function of the first kind for the kaiser window
+static double besselI0(double x)
+{
+  double result = 1.0;
+  double term = 1.0;
+  for(int k=1; k<50 && term > result * 1.0e-12; k++){
+    term *= ( x / (2.0 * k) ) * ( x / (2.0 * k) );
+    result += term;
+  }
+  return result;
+}
+
+std::shared_ptr<const std::vector<float>> PcmSamplingRateConverter::getCoefficients(int nInterpolation, int nDecimation, int nTaps, int srcRate, int dstRate)
+{
+  static std::mutex mutex;
+  static std::map<std::tuple<int, int, int>, std::shared_ptr<const std::vector<float>>> tables;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto key = std::make_tuple( nInterpolation, nDecimation, nTaps );
+  if( tables.contains( key ) ){
+    return tables[ key ];
+  }
+
+  // the prototype low pass filter runs at srcRate * nInterpolation
+  int nLength = nInterpolation * nTaps;
+  double cutoff = 0.5 * CUTOFF_RATIO * std::min( srcRate, dstRate ) / ( (double)srcRate * nInterpolation );
+  double center = ( nLength - 1 ) / 2.0;
+  double windowNormalize = besselI0( KAISER_BETA );
+  std::shared_ptr<std::vector<float>> pCoefficients = std::make_shared<std::vector<float>>( nLength );
+  for(int phase=0; phase<nInterpolation; phase++){
+    std::vector<double> phaseCoefficients( nTaps );
+    double sum = 0.0;
+    for(int tap=0; tap<nTaps; tap++){
+      double x = phase + tap * nInterpolation - center;
+      double sinc = ( x == 0.0 ) ? 1.0 : std::sin( 2.0 * M_PI * cutoff * x ) / ( 2.0 * M_PI * cutoff * x );
+      double r = x / ( center + 0.5 );
+      double window = besselI0( KAISER_BETA * std::sqrt( std::max( 0.0, 1.0 - r * r ) ) ) / windowNormalize;
+      phaseCoefficients[tap] = sinc * window;
+      sum += phaseCoefficients[tap];
+    }
+    // each phase has the unity DC gain
+    for(int tap=0; tap<nTaps; tap++){
+      (*pCoefficients)[ phase * nTaps + ( nTaps - 1 - tap ) ] = (float)( phaseCoefficients[tap] / sum );
+    }
+  }
+  tables[ key ] = pCoefficients;
+
+  return pCoefficients;
+}
+
+PcmSamplingRateConverter::PcmSamplingRateConverter(AudioFormat::ENCODING encoding, int srcRate, int dstRate, int nChannels) : mEncoding(encoding), mSrcRate(srcRate), mDstRate(dstRate), mChannels(nChannels), mInterpolation(0), mDecimation(0), mTaps(0), mpCoefficients(nullptr), mDotProduct(dotProductScalar), mPhase(0), mNextIndex(0)
+{
+  if( srcRate > 0 && dstRate > 0 && nChannels > 0 && AudioFormat::isEncodingPcm( encoding ) ){
+    int gcd = std::gcd( srcRate, dstRate );
+    mInterpolation = dstRate / gcd;
+    mDecimation = srcRate / gcd;
+    if( mInterpolation <= MAX_PHASES ){
+      int nTaps = TAPS_PER_PHASE * ( ( mDecimation + mInterpolation - 1 ) / mInterpolation );
+      mTaps = std::min( nTaps, MAX_TAPS_PER_PHASE );
+      mpCoefficients = getCoefficients( mInterpolation, mDecimation, mTaps, srcRate, dstRate );
+    }
+  }
+
+#if SAMPLING_RATE_CONVERSION_X86_SIMD
+  switch( CpuFeature::getSimd() ){
+    case CpuFeature::SIMD::AVX2:
+      mDotProduct = dotProductAvx2;
+      break;
+    case CpuFeature::SIMD::SSE2:
+      mDotProduct = dotProductSse2;
+      break;
+    default:
+      break;
+  }
+#endif /* SAMPLING_RATE_CONVERSION_X86_SIMD */
+
+  reset();
+}
+
+PcmSamplingRateConverter::~PcmSamplingRateConverter()
+{
+}
+
+bool PcmSamplingRateConverter::isAvailable(void)
+{
+  return mpCoefficients != nullptr;
+}
+
+bool PcmSamplingRateConverter::isSameConfiguration(AudioFormat::ENCODING encoding, int srcRate, int dstRate, int nChannels)
+{
+  return ( mEncoding == encoding ) && ( mSrcRate == srcRate ) && ( mDstRate == dstRate ) && ( mChannels == nChannels );
+}
+
+void PcmSamplingRateConverter::reset(void)
+{
+  mHistory.assign( mChannels * std::max( mTaps - 1, 0 ), 0.0f );
+  mPhase = 0;
+  mNextIndex = std::max( mTaps - 1, 0 );
+}
+
+int PcmSamplingRateConverter::getMaxOutputSamples(int nSrcSamples)
+{
+  return mDecimation ? (int)( ( (int64_t)nSrcSamples * mInterpolation + mDecimation - 1 ) / mDecimation ) + 1 : 0;
+}
+
+template <typename T>
+static inline void deinterleave(const uint8_t* pSrc, float* pWork, int nChannels, int nSamples, int nStride, float scale)
+{
+  const T* pSrcT = reinterpret_cast<const T*>( pSrc );
+  for(int i=0; i<nSamples; i++){
+    for(int ch=0; ch<nChannels; ch++){
+      pWork[ ch * nStride + i ] = (float)( *pSrcT++ ) * scale;
+    }
+  }
+}
+
+template <typename T>
+static inline void interleave(const float* pOutput, uint8_t* pDst, int nChannelSamples, float scale, float min, float max)
+{
+  T* pDstT = reinterpret_cast<T*>( pDst );
+  for(int i=0; i<nChannelSamples; i++){
+    pDstT[i] = (T)std::lrint( std::max( min, std::min( pOutput[i] * scale, max ) ) );
+  }
+}
+
+void PcmSamplingRateConverter::loadInput(const uint8_t* pSrc, int nSrcSamples, int nStride)
+{
+  float* pWork = mWork.data() + mTaps - 1;
+  switch( mEncoding ){
+    case AudioFormat::ENCODING::PCM_8BIT:
+      deinterleave<int8_t>( pSrc, pWork, mChannels, nSrcSamples, nStride, 1.0f / 128.0f );
+      break;
+    case AudioFormat::ENCODING::PCM_16BIT:
+      deinterleave<int16_t>( pSrc, pWork, mChannels, nSrcSamples, nStride, 1.0f / 32768.0f );
+      break;
+    case AudioFormat::ENCODING::PCM_32BIT:
+      deinterleave<int32_t>( pSrc, pWork, mChannels, nSrcSamples, nStride, 1.0f / 2147483648.0f );
+      break;
+    case AudioFormat::ENCODING::PCM_FLOAT:
+      deinterleave<float>( pSrc, pWork, mChannels, nSrcSamples, nStride, 1.0f );
+      break;
+    case AudioFormat::ENCODING::PCM_24BIT_PACKED:
+      for(int i=0; i<nSrcSamples; i++){
+        for(int ch=0; ch<mChannels; ch++){
+          int32_t sample = (int32_t)( ( (uint32_t)pSrc[0] << 8 ) | ( (uint32_t)pSrc[1] << 16 ) | ( (uint32_t)pSrc[2] << 24 ) ) >> 8;
+          pWork[ ch * nStride + i ] = (float)sample / 8388608.0f;
+          pSrc += 3;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void PcmSamplingRateConverter::storeOutput(uint8_t* pDst, int nDstSamples)
+{
+  int nChannelSamples = nDstSamples * mChannels;
+  switch( mEncoding ){
+    case AudioFormat::ENCODING::PCM_8BIT:
+      interleave<int8_t>( mOutput.data(), pDst, nChannelSamples, 128.0f, INT8_MIN, INT8_MAX );
+      break;
+    case AudioFormat::ENCODING::PCM_16BIT:
+      interleave<int16_t>( mOutput.data(), pDst, nChannelSamples, 32768.0f, INT16_MIN, INT16_MAX );
+      break;
+    case AudioFormat::ENCODING::PCM_32BIT:
+      // the largest float which is less than 2^31
+      interleave<int32_t>( mOutput.data(), pDst, nChannelSamples, 2147483648.0f, (float)INT32_MIN, 2147483520.0f );
+      break;
+    case AudioFormat::ENCODING::PCM_FLOAT:
+      memcpy( pDst, mOutput.data(), nChannelSamples * sizeof(float) );
+      break;
+    case AudioFormat::ENCODING::PCM_24BIT_PACKED:
+      for(int i=0; i<nChannelSamples; i++){
+        int32_t sample = (int32_t)std::lrint( std::max( -8388608.0f, std::min( mOutput[i] * 8388608.0f, 8388607.0f ) ) );
+        *pDst++ = sample & 0xFF;
+        *pDst++ = ( sample >> 8 ) & 0xFF;
+        *pDst++ = ( sample >> 16 ) & 0xFF;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+int PcmSamplingRateConverter::convert(const uint8_t* pSrc, uint8_t* pDst, int nSrcSamples)
+{
+  if( !isAvailable() || !pSrc || !pDst || nSrcSamples <= 0 ) return 0;
+
+  // the work buffer is [channel][history + input] then each output sample is a dot product with the consecutive samples
+  int nHistory = mTaps - 1;
+  int nStride = nHistory + nSrcSamples;
+  if( mWork.size() < (size_t)( nStride * mChannels ) ){
+    mWork.resize( nStride * mChannels );
+  }
+  for(int ch=0; ch<mChannels; ch++){
+    memcpy( mWork.data() + ch * nStride, mHistory.data() + ch * nHistory, nHistory * sizeof(float) );
+  }
+  loadInput( pSrc, nSrcSamples, nStride );
+
+  int nMaxDstSamples = getMaxOutputSamples( nSrcSamples );
+  if( mOutput.size() < (size_t)( nMaxDstSamples * mChannels ) ){
+    mOutput.resize( nMaxDstSamples * mChannels );
+  }
+  const float* pCoefficients = mpCoefficients->data();
+  float* pOutput = mOutput.data();
+  int nDstSamples = 0;
+  for( ; mNextIndex < nStride && nDstSamples < nMaxDstSamples; nDstSamples++ ){
+    const float* pPhaseCoefficients = pCoefficients + mPhase * mTaps;
+    const float* pSamples = mWork.data() + mNextIndex - nHistory;
+    for(int ch=0; ch<mChannels; ch++){
+      *pOutput++ = mDotProduct( pPhaseCoefficients, pSamples + ch * nStride, mTaps );
+    }
+    mPhase += mDecimation;
+    mNextIndex += mPhase / mInterpolation;
+    mPhase = mPhase % mInterpolation;
+  }
+  mNextIndex -= nSrcSamples;
+
+  for(int ch=0; ch<mChannels; ch++){
+    memcpy( mHistory.data() + ch * nHistory, mWork.data() + ch * nStride + nSrcSamples, nHistory * sizeof(float) );
+  }
+  storeOutput( pDst, nDstSamples );
+
+  return nDstSamples;
+}
@@ -25,29 +25,71 @@
 #include <stdexcept>
 #include <utility>
 #include <algorithm>
+#include <thread>
 
-Pipe::Pipe():IPipe(), mpSink(nullptr), mpSource(nullptr), mFlushRequest(false)
+Pipe::Pipe():IPipe(), mpFilters(std::make_shared<const FilterChain>()), mFiltersGeneration(0), mpSink(nullptr), mpSource(nullptr), mpHandoffSink(nullptr), mpReadyNotifierSink(nullptr), mpHandoffSource(nullptr), mpReadyNotifierSource(nullptr), mFlushRequest(false), mStepFiltersGeneration(0), mIoPipeliningEnabled(false), mReadAheadFifo(AudioFormat(), IO_PIPELINING_DEPTH), mWriteBehindFifo(AudioFormat(), IO_PIPELINING_DEPTH), mIoSamples(0), mReadAheadStopRequest(false), mReadAheadDone(true), mIoWaiters(0), mBlockSizeAdapterEnabled(false), mFormatGeneration(1), mNegotiatedFormatGeneration(0), mNegotiatedPcm(false), mNegotiatedCompressed(false)
 {
-
+  mpFormatChangeListener = std::make_shared<FormatChangeListener>( this );
+  mpReadAheadThread = std::make_shared<ReadAheadThread>( this );
+  mpWriteBehindThread = std::make_shared<WriteBehindThread>( this );
 }
 
 Pipe::~Pipe()
 {
   clearFilters();
   stop();
+  if( mpSource ){
+    mpSource->unregisterAudioFormatListener( mpFormatChangeListener );
+  }
+  if( mpSink ){
+    mpSink->unregisterAudioFormatListener( mpFormatChangeListener );
+  }
+}
+
+std::shared_ptr<const Pipe::FilterChain> Pipe::getFilters(void)
+{
+  return std::atomic_load_explicit( &mpFilters, std::memory_order_acquire );
+}
+
+void Pipe::publishFiltersLocked(std::shared_ptr<const FilterChain> pFilters)
+{
+  mpRetiredFilters = std::atomic_exchange_explicit( &mpFilters, pFilters, std::memory_order_acq_rel );
+  // the filters' supported formats might be different
+  invalidateNegotiatedFormat();
+  mFiltersGeneration.fetch_add( 1, std::memory_order_release );
+}
+
+bool Pipe::negotiateFormat(void)
+{
+  // the notification during this invalidates the result again
+  uint64_t nFormatGeneration = mFormatGeneration.load( std::memory_order_acquire );
+  std::shared_ptr<ISource> pSource = mpSource;
+  std::shared_ptr<ISink> pSink = mpSink;
+  AudioFormat sourceFormat = pSource ? pSource->getAudioFormat() : AudioFormat();
+  AudioFormat sinkFormat = pSink ? pSink->getAudioFormat() : AudioFormat();
+  mNegotiatedPcm = pSource && pSink && sourceFormat.isEncodingPcm() && sinkFormat.isEncodingPcm();
+  mNegotiatedCompressed = pSource && pSink && sourceFormat.isEncodingCompressed() && sinkFormat.isEncodingCompressed();
+  mNegotiatedFormat = mNegotiatedPcm ? getFilterAudioFormat( sinkFormat ) : sinkFormat;
+  mNegotiatedFormatGeneration = nFormatGeneration;
+
+  return mNegotiatedPcm;
 }
 
 void Pipe::addFilterToHead(std::shared_ptr<IFilter> pFilter)
 {
   mMutexFilters.lock();
-  mFilters.insert(mFilters.begin(), pFilter);
+  std::shared_ptr<FilterChain> pFilters = std::make_shared<FilterChain>( *getFilters() );
+  pFilters->insert(pFilters->begin(), pFilter);
+  publishFiltersLocked( pFilters );
   mMutexFilters.unlock();
 }
 
 void Pipe::addFilterToTail(std::shared_ptr<IFilter> pFilter)
 {
   mMutexFilters.lock();
-  mFilters.push_back(pFilter);
+  std::shared_ptr<FilterChain> pFilters = std::make_shared<FilterChain>( *getFilters() );
+  pFilters->push_back(pFilter);
+  publishFiltersLocked( pFilters );
   mMutexFilters.unlock();
 }
 
@@ -57,9 +99,11 @@ bool Pipe::addFilterAfterFilter(std::shared_ptr<IFilter> pFilter, std::shared_pt
 
   if( pPosition ){
     mMutexFilters.lock();
-    auto it = std::find( mFilters.begin(), mFilters.end(), pPosition );
-    if( it != mFilters.end() ){
-      mFilters.insert( it+1, pFilter );
+    std::shared_ptr<FilterChain> pFilters = std::make_shared<FilterChain>( *getFilters() );
+    auto it = std::find( pFilters->begin(), pFilters->end(), pPosition );
+    if( it != pFilters->end() ){
+      pFilters->insert( it+1, pFilter );
+      publishFiltersLocked( pFilters );
       result = true;
     }
     mMutexFilters.unlock();
@@ -72,26 +116,28 @@ bool Pipe::removeFilter(std::shared_ptr<IFilter> pFilter)
 {
   bool result = false;
 
-  if( isFilterIncluded(pFilter) ){
-    mMutexFilters.lock();
-    std::erase( mFilters, pFilter );
+  mMutexFilters.lock();
+  std::shared_ptr<FilterChain> pFilters = std::make_shared<FilterChain>( *getFilters() );
+  if( std::erase( *pFilters, pFilter ) ){
+    publishFiltersLocked( pFilters );
     result = true;
-    mMutexFilters.unlock();
   }
+  mMutexFilters.unlock();
 
   return result;
 }
 
 bool Pipe::isFilterIncluded(std::shared_ptr<IFilter> pFilter)
 {
-  auto it = std::find( mFilters.begin(), mFilters.end(), pFilter );
-  return ( it != mFilters.end() ) ? true : false;
+  std::shared_ptr<const FilterChain> pFilters = getFilters();
+  auto it = std::find( pFilters->begin(), pFilters->end(), pFilter );
+  return ( it != pFilters->end() ) ? true : false;
 }
 
 void Pipe::clearFilters(void)
 {
   mMutexFilters.lock();
-  mFilters.clear();
+  publishFiltersLocked( std::make_shared<const FilterChain>() );
   mMutexFilters.unlock();
 }
 
@@ -100,15 +146,32 @@ std::shared_ptr<ISink> Pipe::attachSink(std::shared_ptr<ISink> pISink)
   std::shared_ptr<ISink> pPrevISink = mpSink;
   mMutexSink.lock();
   mpSink = pISink;
+  mpHandoffSink = dynamic_cast<IBufferHandoff*>( pISink.get() );
+  mpReadyNotifierSink = dynamic_cast<IReadyNotifier*>( pISink.get() );
   mMutexSink.unlock();
+  if( pPrevISink ){
+    pPrevISink->unregisterAudioFormatListener( mpFormatChangeListener );
+  }
+  if( pISink ){
+    pISink->registerAudioFormatListener( mpFormatChangeListener );
+  }
+  invalidateNegotiatedFormat();
 
   return pPrevISink;
 }
 
 std::shared_ptr<ISink> Pipe::detachSink(void)
 {
+  mMutexSink.lock();
   std::shared_ptr<ISink> pPrevISink = mpSink;
   mpSink = nullptr;
+  mpHandoffSink = nullptr;
+  mpReadyNotifierSink = nullptr;
+  mMutexSink.unlock();
+  if( pPrevISink ){
+    pPrevISink->unregisterAudioFormatListener( mpFormatChangeListener );
+  }
+  invalidateNegotiatedFormat();
 
   return pPrevISink;
 }
@@ -123,14 +186,31 @@ std::shared_ptr<ISource> Pipe::attachSource(std::shared_ptr<ISource> pISource)
   std::shared_ptr<ISource> pPrevISource = mpSource;
   mMutexSource.lock();
   mpSource = pISource;
+  mpHandoffSource = dynamic_cast<IBufferHandoff*>( pISource.get() );
+  mpReadyNotifierSource = dynamic_cast<IReadyNotifier*>( pISource.get() );
   mMutexSource.unlock();
+  if( pPrevISource ){
+    pPrevISource->unregisterAudioFormatListener( mpFormatChangeListener );
+  }
+  if( pISource ){
+    pISource->registerAudioFormatListener( mpFormatChangeListener );
+  }
+  invalidateNegotiatedFormat();
   return pPrevISource;
 }
 
 std::shared_ptr<ISource> Pipe::detachSource(void)
 {
+  mMutexSource.lock();
   std::shared_ptr<ISource> pPrevISource = mpSource;
   mpSource = nullptr;
+  mpHandoffSource = nullptr;
+  mpReadyNotifierSource = nullptr;
+  mMutexSource.unlock();
+  if( pPrevISource ){
+    pPrevISource->unregisterAudioFormatListener( mpFormatChangeListener );
+  }
+  invalidateNegotiatedFormat();
 
   return pPrevISource;
 }
@@ -146,7 +226,7 @@ void Pipe::dump(void)
   std::cout << "Sink:" << (mpSink ? mpSink->toString() : "") << std::endl;
 
   std::cout << "Filters:" << std::endl;
-  for( auto& pFilter : mFilters ) {
+  for( auto& pFilter : *getFilters() ) {
     std::cout << pFilter->toString() << std::endl;
   }
   std::cout << std::endl;
@@ -154,6 +234,14 @@ void Pipe::dump(void)
 
 void Pipe::unlockToStop(void)
 {
+  mReadAheadFifo.unlock();
+  mWriteBehindFifo.unlock();
+  {
+    // wake up the wait for the read-ahead window
+    std::lock_guard<std::mutex> lock(mMutexIo);
+    mIoEvent.notify_all();
+  }
+
   std::shared_ptr<IUnlockable> pSource = std::dynamic_pointer_cast<IUnlockable>(mpSource);
   if( pSource ) pSource->unlock();
 
@@ -161,6 +249,13 @@ void Pipe::unlockToStop(void)
     std::shared_ptr<IUnlockable> pSink = std::dynamic_pointer_cast<IUnlockable>(mpSink);
     if( pSink ) pSink->unlock();
   }
+
+  // the filter might block as well e.g. FilterInjector
+  std::shared_ptr<const FilterChain> pFilters = getFilters();
+  for( auto& pFilter : *pFilters ){
+    std::shared_ptr<IUnlockable> pUnlockableFilter = std::dynamic_pointer_cast<IUnlockable>(pFilter);
+    if( pUnlockableFilter ) pUnlockableFilter->unlock();
+  }
 }
 
 void Pipe::stopAndFlush(void)
@@ -177,63 +272,352 @@ void Pipe::stopAndFlush(void)
 void Pipe::process(void)
 {
   while(mbIsRunning && mpSource && mpSink && !mFlushRequest){
-    if( mpSource->getAudioFormat().isEncodingPcm() && mpSink->getAudioFormat().isEncodingPcm() ){
-      // TODO: Should check not only filter format but also source/sink formats.
-      float windowSizeUsec = getCommonWindowSizeUsec();
-      AudioFormat usingAudioFormat = getFilterAudioFormat( mpSink->getAudioFormat() );
+    if( isFormatNegotiationRequired() ){
+      negotiateFormat();
+    }
+    if( mNegotiatedPcm ){
+      uint64_t nFiltersGeneration = mFiltersGeneration.load( std::memory_order_acquire );
+      std::shared_ptr<const FilterChain> pFilters = getProcessingFilters();
+      int windowSizeUsec = getCommonWindowSizeUsec( *pFilters );
+      AudioFormat usingAudioFormat = mNegotiatedFormat;
       float usingSamplingRate = usingAudioFormat.getSamplingRate();
       float perSampleDurationUsec = 1000000.0f / usingSamplingRate;
       int samples = windowSizeUsec / perSampleDurationUsec;
 
-      std::shared_ptr<AudioBuffer> pInBuf = std::make_shared<AudioBuffer>( usingAudioFormat, samples );
-      std::shared_ptr<AudioBuffer> pOutBuf= std::make_shared<AudioBuffer>( usingAudioFormat, samples );
+      std::shared_ptr<AudioBuffer> pInBuf = mBufferPool.acquire( usingAudioFormat, samples, true );
+      std::shared_ptr<AudioBuffer> pOutBuf= mBufferPool.acquire( usingAudioFormat, samples, true );
       std::shared_ptr<AudioBuffer> pSinkOut = pInBuf;
 
-      int nFilterSize = mFilters.size();
-      while( mbIsRunning && ( nFilterSize == mFilters.size() && (mpSource->getAudioFormat().isEncodingPcm() && mpSink->getAudioFormat().isEncodingPcm())) && !mFlushRequest) {
+      bool bIoPipelining = mIoPipeliningEnabled;
+      if( bIoPipelining ){
+        processIoPipelining( pFilters, nFiltersGeneration, windowSizeUsec, pInBuf, pOutBuf );
+      }
+
+      while( !bIoPipelining && mbIsRunning && !mFlushRequest ) {
+        // the format is negotiated again only if it's invalidated
+        if( isFormatNegotiationRequired() && ( !negotiateFormat() || !usingAudioFormat.equal( mNegotiatedFormat ) ) ){
+          break;
+        }
+        // pick up the updated filter chain at the window boundary. the buffers are kept if the window and the format are same.
+        uint64_t nCurrentGeneration = mFiltersGeneration.load( std::memory_order_acquire );
+        if( nCurrentGeneration != nFiltersGeneration ){
+          nFiltersGeneration = nCurrentGeneration;
+          pFilters = getProcessingFilters();
+          if( getCommonWindowSizeUsec( *pFilters ) != windowSizeUsec ){
+            break;
+          }
+        }
+
         // TODO: implement wait during muting and implement unlock for the mute wait
         mMutexSource.lock();
-        mpSource->read( *pInBuf );
+        // take the written memory as is if the source supports the buffer handoff
+        if( !mpHandoffSource || !mpHandoffSource->readHandoff( *pInBuf ) ){
+          mpSource->read( *pInBuf );
+        }
         mMutexSource.unlock();
 
-        mMutexFilters.lock();
-        for( auto& pFilter : mFilters ) {
-          pFilter->process( *pInBuf, *pOutBuf );
-          pSinkOut = pOutBuf;
-          std::swap( pInBuf, pOutBuf );
-        }
-        mMutexFilters.unlock();
+        pSinkOut = processFilters( *pFilters, pInBuf, pOutBuf );
 
         // TODO : May change as directly write to the following buffer from the last filter to avoid the copy.
         mMutexSink.lock();
-        mpSink->write( *pSinkOut );
+        // pass the buffer's memory instead of the copy. pSinkOut is overwritten by the next read or the filters.
+        if( !mpHandoffSink || !mpHandoffSink->writeHandoff( *pSinkOut ) ){
+          mpSink->write( *pSinkOut );
+        }
         mMutexSink.unlock();
       }
 
       pInBuf.reset();
       pOutBuf.reset();
       pSinkOut.reset();
-    } else {
-      while( mbIsRunning && (mpSource->getAudioFormat().isEncodingCompressed() && mpSink->getAudioFormat().isEncodingCompressed()) && !mFlushRequest) {
-        CompressAudioBuffer buf;
-        mMutexSource.lock();
-        mpSource->read( buf );
-        mMutexSource.unlock();
-        mMutexSink.lock();
-        mpSink->write( buf );
-        mMutexSink.unlock();
+    } else if( mNegotiatedCompressed ) {
+      while( mbIsRunning && !mFlushRequest && ( !isFormatNegotiationRequired() || ( !negotiateFormat() && mNegotiatedCompressed ) ) ) {
+        passThroughCompressed();
+      }
+    }
+  }
+}
+
+void Pipe::notifyIoEvent(void)
+{
+  if( mIoWaiters ){
+    std::lock_guard<std::mutex> lock(mMutexIo);
+    mIoEvent.notify_all();
+  }
+}
+
+bool Pipe::waitIoFifo(HandoffFifoBuffer& fifo, int nBytes, std::function<bool(void)> bEnd)
+{
+  if( fifo.getBufferedBytes() < nBytes ){
+    std::unique_lock<std::mutex> lock(mMutexIo);
+    mIoWaiters++;
+    mIoEvent.wait( lock, [&]{ return ( fifo.getBufferedBytes() >= nBytes ) || bEnd(); } );
+    mIoWaiters--;
+  }
+  return fifo.getBufferedBytes() >= nBytes;
+}
+
+void Pipe::ReadAheadThread::process(void)
+{
+  // read the window n+1
+  std::shared_ptr<AudioBuffer> pBuf = mpPipe->mBufferPool.acquire( mpPipe->mIoFormat, mpPipe->mIoSamples, true );
+  while( mbIsRunning && !mpPipe->mReadAheadStopRequest ){
+    mpPipe->mMutexSource.lock();
+    std::shared_ptr<ISource> pSource = mpPipe->mpSource;
+    if( pSource ){
+      IBufferHandoff* pHandoffSource = mpPipe->mpHandoffSource;
+      if( !pHandoffSource || !pHandoffSource->readHandoff( *pBuf ) ){
+        pSource->read( *pBuf );
+      }
+    }
+    mpPipe->mMutexSource.unlock();
+    if( !pSource ){
+      break;
+    }
+    if( mbIsRunning ){
+      mpPipe->mReadAheadFifo.write( *pBuf, true );
+      mpPipe->notifyIoEvent();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mpPipe->mMutexIo);
+    mpPipe->mReadAheadDone = true;
+    mpPipe->mIoEvent.notify_all();
+  }
+}
+
+void Pipe::ReadAheadThread::unlockToStop(void)
+{
+  mpPipe->mReadAheadFifo.unlock();
+  std::shared_ptr<IUnlockable> pSource = std::dynamic_pointer_cast<IUnlockable>( mpPipe->getSourceRef() );
+  if( pSource ) pSource->unlock();
+}
+
+void Pipe::WriteBehindThread::process(void)
+{
+  // write the window n-1
+  std::shared_ptr<AudioBuffer> pBuf = mpPipe->mBufferPool.acquire( mpPipe->mIoFormat, mpPipe->mIoSamples, true );
+  int nBytes = pBuf->getRawBufferSize();
+  // the remaining windows are written after stop() unless the pipe is stopping
+  while( mpPipe->waitIoFifo( mpPipe->mWriteBehindFifo, nBytes, [&]{ return !mbIsRunning; } ) && mpPipe->mbIsRunning ){
+    mpPipe->mWriteBehindFifo.read( *pBuf, true );
+    mpPipe->mMutexSink.lock();
+    std::shared_ptr<ISink> pSink = mpPipe->mpSink;
+    if( pSink ){
+      IBufferHandoff* pHandoffSink = mpPipe->mpHandoffSink;
+      if( !pHandoffSink || !pHandoffSink->writeHandoff( *pBuf ) ){
+        pSink->write( *pBuf );
       }
     }
+    mpPipe->mMutexSink.unlock();
+    // the space for the processing thread's write
+    mpPipe->notifyIoEvent();
   }
 }
 
+void Pipe::WriteBehindThread::unlockToStop(void)
+{
+  std::lock_guard<std::mutex> lock(mpPipe->mMutexIo);
+  mpPipe->mIoEvent.notify_all();
+}
+
+void Pipe::processIoPipelining(std::shared_ptr<const FilterChain> pFilters, uint64_t nFiltersGeneration, int windowSizeUsec, std::shared_ptr<AudioBuffer> pInBuf, std::shared_ptr<AudioBuffer> pOutBuf)
+{
+  AudioFormat usingAudioFormat = pInBuf->getAudioFormat();
+  int nBytes = pInBuf->getRawBufferSize();
+  mIoFormat = usingAudioFormat;
+  mIoSamples = pInBuf->getNumberOfSamples();
+  mReadAheadFifo.setAudioFormat( usingAudioFormat );
+  mWriteBehindFifo.setAudioFormat( usingAudioFormat );
+  mReadAheadFifo.clearBuffer();
+  mWriteBehindFifo.clearBuffer();
+  mReadAheadStopRequest = false;
+  mReadAheadDone = false;
+
+  // the I/O threads follow the pipe's thread policy
+  mpReadAheadThread->setThreadPolicy( getThreadPolicy() );
+  mpWriteBehindThread->setThreadPolicy( getThreadPolicy() );
+  mpReadAheadThread->run();
+  mpWriteBehindThread->run();
+
+  auto processWindow = [&](void){
+    mReadAheadFifo.read( *pInBuf, true );
+    std::shared_ptr<AudioBuffer> pSinkOut = processFilters( *pFilters, pInBuf, pOutBuf );
+    mWriteBehindFifo.write( *pSinkOut, true );
+    notifyIoEvent();
+  };
+  auto isStopping = [&](void){ return !mbIsRunning || mFlushRequest; };
+
+  // process the window n
+  while( !isStopping() ) {
+    if( isFormatNegotiationRequired() && ( !negotiateFormat() || !usingAudioFormat.equal( mNegotiatedFormat ) ) ){
+      break;
+    }
+    uint64_t nCurrentGeneration = mFiltersGeneration.load( std::memory_order_acquire );
+    if( nCurrentGeneration != nFiltersGeneration ){
+      std::shared_ptr<const FilterChain> pNewFilters = getProcessingFilters();
+      if( getCommonWindowSizeUsec( *pNewFilters ) != windowSizeUsec ){
+        // the read-ahead windows are processed by the current filters
+        break;
+      }
+      nFiltersGeneration = nCurrentGeneration;
+      pFilters = pNewFilters;
+    }
+    if( !waitIoFifo( mReadAheadFifo, nBytes, [&]{ return isStopping() || mReadAheadDone; } ) ){
+      break;
+    }
+    processWindow();
+  }
+
+  // the windows which are already read are processed and written instead of dropping them unless stopping
+  mReadAheadStopRequest = true;
+  while( !isStopping() && waitIoFifo( mReadAheadFifo, nBytes, [&]{ return isStopping() || mReadAheadDone; } ) ){
+    processWindow();
+  }
+  mpReadAheadThread->stop();
+  mpWriteBehindThread->stop();
+}
+
+void Pipe::passThroughCompressed(void)
+{
+  // the frame buffer is reused instead of the allocation per frame
+  mCompressedBuf.resetChunk();
+  mMutexSource.lock();
+  if( !mpHandoffSource || !mpHandoffSource->readHandoff( mCompressedBuf ) ){
+    mpSource->read( mCompressedBuf );
+  }
+  mMutexSource.unlock();
+  mMutexSink.lock();
+  if( !mpHandoffSink || !mpHandoffSink->writeHandoff( mCompressedBuf ) ){
+    mpSink->write( mCompressedBuf );
+  }
+  mMutexSink.unlock();
+}
+
+std::shared_ptr<AudioBuffer> Pipe::processFilters(const FilterChain& filters, std::shared_ptr<AudioBuffer>& pInBuf, std::shared_ptr<AudioBuffer>& pOutBuf)
+{
+  std::shared_ptr<AudioBuffer> pSinkOut = pInBuf;
+  for( auto& pFilter : filters ) {
+    pFilter->process( *pInBuf, *pOutBuf );
+    pSinkOut = pOutBuf;
+    std::swap( pInBuf, pOutBuf );
+  }
+  return pSinkOut;
+}
+
+bool Pipe::isStepReadReady(int nBytes)
+{
+  IReadyNotifier* pNotifier = mpReadyNotifierSource;
+  bool bReady = !pNotifier || pNotifier->isReadReady( nBytes );
+  if( !bReady ){
+    pNotifier->setReadReadyListener( [this](){ resumeStep(); } );
+    // check again since the write might be done before setting the listener
+    bReady = pNotifier->isReadReady( nBytes );
+  }
+  return bReady;
+}
+
+bool Pipe::isStepWriteReady(int nBytes)
+{
+  IReadyNotifier* pNotifier = mpReadyNotifierSink;
+  bool bReady = !pNotifier || pNotifier->isWriteReady( nBytes );
+  if( !bReady ){
+    pNotifier->setWriteReadyListener( [this](){ resumeStep(); } );
+    bReady = pNotifier->isWriteReady( nBytes );
+  }
+  return bReady;
+}
+
+ThreadBase::STEP_RESULT Pipe::processStep(void)
+{
+  if( !mpSource || !mpSink || mFlushRequest ){
+    return STEP_DONE;
+  }
+
+  if( isFormatNegotiationRequired() ){
+    negotiateFormat();
+  }
+  if( !mNegotiatedPcm ){
+    // the compressed buffer's size is unknown until the read then this is same as process()
+    passThroughCompressed();
+    return STEP_CONTINUE;
+  }
+
+  // write the previous window first
+  if( mpStepPendingOut ){
+    if( !isStepWriteReady( mpStepPendingOut->getRawBufferSize() ) ){
+      return STEP_WAIT;
+    }
+    mMutexSink.lock();
+    if( !mpHandoffSink || !mpHandoffSink->writeHandoff( *mpStepPendingOut ) ){
+      mpSink->write( *mpStepPendingOut );
+    }
+    mMutexSink.unlock();
+    mpStepPendingOut.reset();
+  }
+
+  // pick up the updated filter chain at the window boundary as process()
+  uint64_t nCurrentGeneration = mFiltersGeneration.load( std::memory_order_acquire );
+  if( !mpStepFilters || ( nCurrentGeneration != mStepFiltersGeneration ) ){
+    mStepFiltersGeneration = nCurrentGeneration;
+    mpStepFilters = getProcessingFilters();
+  }
+  int windowSizeUsec = getCommonWindowSizeUsec( *mpStepFilters );
+  AudioFormat usingAudioFormat = mNegotiatedFormat;
+  float perSampleDurationUsec = 1000000.0f / usingAudioFormat.getSamplingRate();
+  int samples = windowSizeUsec / perSampleDurationUsec;
+  if( !mpStepInBuf || !mpStepInBuf->getAudioFormat().equal( usingAudioFormat ) || ( mpStepInBuf->getNumberOfSamples() != samples ) ){
+    mpStepInBuf = mBufferPool.acquire( usingAudioFormat, samples, true );
+    mpStepOutBuf = mBufferPool.acquire( usingAudioFormat, samples, true );
+  }
+
+  // the continuation instead of the blocking read
+  if( !isStepReadReady( mpStepInBuf->getRawBufferSize() ) ){
+    return STEP_WAIT;
+  }
+  mMutexSource.lock();
+  if( !mpHandoffSource || !mpHandoffSource->readHandoff( *mpStepInBuf ) ){
+    mpSource->read( *mpStepInBuf );
+  }
+  mMutexSource.unlock();
+
+  std::shared_ptr<AudioBuffer> pSinkOut = processFilters( *mpStepFilters, mpStepInBuf, mpStepOutBuf );
+
+  if( !isStepWriteReady( pSinkOut->getRawBufferSize() ) ){
+    mpStepPendingOut = pSinkOut;
+    return STEP_WAIT;
+  }
+  mMutexSink.lock();
+  if( !mpHandoffSink || !mpHandoffSink->writeHandoff( *pSinkOut ) ){
+    mpSink->write( *pSinkOut );
+  }
+  mMutexSink.unlock();
+
+  return STEP_CONTINUE;
+}
+
+void Pipe::finalizeStep(void)
+{
+  IReadyNotifier* pSource = mpReadyNotifierSource;
+  if( pSource ){
+    pSource->setReadReadyListener( nullptr );
+  }
+  IReadyNotifier* pSink = mpReadyNotifierSink;
+  if( pSink ){
+    pSink->setWriteReadyListener( nullptr );
+  }
+  mpStepInBuf.reset();
+  mpStepOutBuf.reset();
+  mpStepPendingOut.reset();
+  mpStepFilters.reset();
+}
+
 AudioFormat Pipe::getFilterAudioFormat(AudioFormat theUsingFormat)
 {
   // TODO : Prepare different format choice example. Note that this is override-able.
 
   bool bPossibleToUseTheFormat = true;
-  mMutexFilters.lock();
-  for( auto& pFilter : mFilters ) {
+  for( auto& pFilter : *getFilters() ) {
     std::vector<AudioFormat> formats = pFilter->getSupportedAudioFormats();
     bool bCompatible = false;
     for( auto& aFormat : formats ){
@@ -242,7 +626,6 @@ AudioFormat Pipe::getFilterAudioFormat(AudioFormat theUsingFormat)
     bPossibleToUseTheFormat &= bCompatible;
     if( !bPossibleToUseTheFormat ) break;
   }
-  mMutexFilters.unlock();
 
   if( !bPossibleToUseTheFormat ){
     throw std::invalid_argument("There is no common audio format in the registered filters");
@@ -252,15 +635,59 @@ AudioFormat Pipe::getFilterAudioFormat(AudioFormat theUsingFormat)
 }
 
 int Pipe::getCommonWindowSizeUsec(void)
+{
+  return mBlockSizeAdapterEnabled ? getMinimumWindowSizeUsec( *getFilters() ) : getCommonWindowSizeUsec( *getFilters() );
+}
+
+int Pipe::getMinimumWindowSizeUsec(const FilterChain& filters)
+{
+  int result = 0;
+
+  for( auto& pFilter : filters ) {
+    int windowSizeUsec = pFilter->getRequiredWindowSizeUsec();
+    result = ( windowSizeUsec && ( !result || windowSizeUsec < result ) ) ? windowSizeUsec : result;
+  }
+
+  return result ? result : getCommonWindowSizeUsec( filters );
+}
+
+std::shared_ptr<const Pipe::FilterChain> Pipe::getProcessingFilters(void)
+{
+  std::shared_ptr<const FilterChain> pFilters = getFilters();
+  if( !mBlockSizeAdapterEnabled ){
+    mBlockSizeAdapters.clear();
+    return pFilters;
+  }
+
+  int nWindowSizeUsec = getMinimumWindowSizeUsec( *pFilters );
+  std::shared_ptr<FilterChain> pProcessingFilters = std::make_shared<FilterChain>();
+  std::map<std::shared_ptr<IFilter>, std::shared_ptr<BlockSizeAdapterFilter>> adapters;
+  for( auto& pFilter : *pFilters ){
+    if( BlockSizeAdapterFilter::isAdapterRequired( nWindowSizeUsec, pFilter->getRequiredWindowSizeUsec() ) ){
+      // keep the adapter's buffered data unless the pipe's window is changed
+      std::shared_ptr<BlockSizeAdapterFilter> pAdapter = mBlockSizeAdapters.contains( pFilter ) ? mBlockSizeAdapters[ pFilter ] : nullptr;
+      if( !pAdapter || ( pAdapter->getRequiredWindowSizeUsec() != nWindowSizeUsec ) ){
+        pAdapter = std::make_shared<BlockSizeAdapterFilter>( pFilter, nWindowSizeUsec );
+      }
+      adapters.insert_or_assign( pFilter, pAdapter );
+      pProcessingFilters->push_back( pAdapter );
+    } else {
+      pProcessingFilters->push_back( pFilter );
+    }
+  }
+  mBlockSizeAdapters = adapters;
+
+  return pProcessingFilters;
+}
+
+int Pipe::getCommonWindowSizeUsec(const FilterChain& filters)
 {
   int result = 1;
 
-  mMutexFilters.lock();
-  for( auto& pFilter : mFilters ) {
+  for( auto& pFilter : filters ) {
     int windowSizeUsec = pFilter->getRequiredWindowSizeUsec();
     result = windowSizeUsec ? std::lcm(result, windowSizeUsec) : result;
   }
-  mMutexFilters.unlock();
 
   return result;
 }
@@ -273,23 +700,31 @@ int Pipe::getWindowSizeUsec(void)
 int Pipe::getLatencyUSec(void)
 {
   int nProcessingTimeUsec = 0;
-  mMutexFilters.lock();
-  for( auto& pFilter : mFilters ) {
+  std::shared_ptr<const FilterChain> pFilters = getFilters();
+  for( auto& pFilter : *pFilters ) {
     nProcessingTimeUsec += pFilter->getExpectedProcessingUSec();
   }
-  mMutexFilters.unlock();
 
-  return getCommonWindowSizeUsec() + nProcessingTimeUsec;
+  int nWindowSizeUsec = mBlockSizeAdapterEnabled ? getMinimumWindowSizeUsec( *pFilters ) : getCommonWindowSizeUsec( *pFilters );
+  // the read-ahead and the write-behind hold a window respectively
+  int nIoPipeliningUsec = mIoPipeliningEnabled ? ( nWindowSizeUsec * IO_PIPELINING_DEPTH ) : 0;
+  // the adapters delay the filters whose window doesn't fit
+  int nBlockSizeAdapterUsec = 0;
+  if( mBlockSizeAdapterEnabled ){
+    for( auto& pFilter : *pFilters ) {
+      nBlockSizeAdapterUsec += BlockSizeAdapterFilter::getAdditionalLatency( nWindowSizeUsec, pFilter->getRequiredWindowSizeUsec() );
+    }
+  }
+
+  return nWindowSizeUsec + nProcessingTimeUsec + nIoPipeliningUsec + nBlockSizeAdapterUsec;
 }
 
 int Pipe::stateResourceConsumption(void)
 {
   int nProcessingResource = 0;
-  mMutexFilters.lock();
-  for( auto& pFilter : mFilters ) {
+  for( auto& pFilter : *getFilters() ) {
     nProcessingResource += pFilter->stateResourceConsumption();
   }
-  mMutexFilters.unlock();
   nProcessingResource += ( mpSink ? mpSink->stateResourceConsumption() : 0 );
   nProcessingResource += ( mpSource ? mpSource->stateResourceConsumption() : 0 );
 
@@ -19,8 +19,10 @@
 #include "Mixer.hpp"
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <span>
 
-PipeMixer::PipeMixer(AudioFormat format, std::shared_ptr<ISink> pSink) : ThreadBase(), mFormat(format), mpSink(pSink)
+PipeMixer::PipeMixer(AudioFormat format, std::shared_ptr<ISink> pSink) : ThreadBase(), mFormat(format), mpSink(pSink), mDeadlineMixEnabled(false), mConcealment(CONCEAL_ZERO), mDeadlineWakeup(false)
 {
 
 }
@@ -70,8 +72,10 @@ bool PipeMixer::isPipeRunningOrNotRegistered(std::shared_ptr<InterPipeBridge> sr
 void PipeMixer::process(void)
 {
   while( mbIsRunning && mpSink && !mpInterPipeBridges.empty() ){
-    if( mpSink->getAudioFormat().isEncodingPcm() ){
-      int nSamples = 256;
+    if( mpSink->getAudioFormat().isEncodingPcm() && mDeadlineMixEnabled ){
+      processDeadline();
+    } else if( mpSink->getAudioFormat().isEncodingPcm() ){
+      int nSamples = MIX_WINDOW_SAMPLES;
       AudioFormat outFormat = mpSink->getAudioFormat();
       std::shared_ptr<AudioBuffer> pOutBuf = std::make_shared<AudioBuffer>( outFormat, nSamples );
       std::vector<std::shared_ptr<AudioBuffer>> buffers;
@@ -91,13 +95,13 @@ void PipeMixer::process(void)
             }
           }
           if( bZeroData ) {
-            ByteBuffer zeroBuffer( buffers[i]->getRawBufferSize(), 0 );
-            buffers[i]->setRawBuffer(zeroBuffer);
+            ByteBuffer& rawBuffer = buffers[i]->getRawBuffer();
+            std::fill( rawBuffer.begin(), rawBuffer.end(), 0 );
           }
         }
         mMutexPipe.unlock();
         if( mbIsRunning ){
-          Mixer::process( buffers, pOutBuf );
+          mixBuffers( buffers, pOutBuf );
         }
         if( mbIsRunning && mpSink ){
           mpSink->write( *pOutBuf );
@@ -106,18 +110,247 @@ void PipeMixer::process(void)
 
       buffers.clear();
     } else {
-      CompressAudioBuffer buf;
-      mMutexPipe.lock();
-      for(auto& pSource : mpInterPipeBridges){
-        if( isPipeRunningOrNotRegistered( pSource ) ){
-          pSource->read( buf );
-          break;
+      passThroughCompressed();
+    }
+  }
+}
+
+void PipeMixer::processDeadline(void)
+{
+  AudioFormat outFormat = mpSink->getAudioFormat();
+  int nSamples = getMixWindowSamples( outFormat );
+  std::chrono::microseconds period( (int64_t)nSamples * 1000000 / outFormat.getSamplingRate() );
+
+  // the buffers are allocated here only. the concealment and the mix don't allocate.
+  std::shared_ptr<AudioBuffer> pOutBuf = std::make_shared<AudioBuffer>( outFormat, nSamples );
+  std::vector<std::shared_ptr<AudioBuffer>> buffers;
+  int nCurrentPipeSize = mpInterPipeBridges.size();
+  for(int i=0; i<nCurrentPipeSize; i++){
+    buffers.push_back( std::make_shared<AudioBuffer>( outFormat, nSamples ) );
+  }
+  mConsecutiveUnderruns.assign( nCurrentPipeSize, 0 );
+  mMixInputs.reserve( nCurrentPipeSize );
+  int nBytes = pOutBuf->getRawBufferSize();
+
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + period;
+  while( mbIsRunning && mpSink && ( nCurrentPipeSize == (int)mpInterPipeBridges.size() ) && outFormat.equal( mpSink->getAudioFormat() ) ){
+    waitInputsUntil( deadline, nBytes );
+    if( !mbIsRunning ){
+      break;
+    }
+    mMutexPipe.lock();
+    readOrConcealInputsLocked( buffers, nBytes );
+    mMutexPipe.unlock();
+    mixBuffers( buffers, pOutBuf );
+    mpSink->write( *pOutBuf );
+
+    // the late input gets the period from the earlier of the deadline and the mix. resync if the mix is late more than the period.
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    deadline = std::min( deadline, now ) + period;
+    if( deadline < now ){
+      deadline = now + period;
+    }
+  }
+
+  mMutexPipe.lock();
+  for( auto& pSource : mpInterPipeBridges ){
+    pSource->setReadReadyListener( nullptr );
+  }
+  mMutexPipe.unlock();
+}
+
+bool PipeMixer::waitInputsUntil(std::chrono::steady_clock::time_point deadline, int nBytes)
+{
+  std::unique_lock<std::mutex> lock( mDeadlineMutex );
+  while( mbIsRunning ){
+    mDeadlineWakeup = false;
+    bool bAllReady = true;
+    mMutexPipe.lock();
+    for( auto& pSource : mpInterPipeBridges ){
+      if( isPipeRunningOrNotRegistered( pSource ) && pSource->getAudioFormat().isEncodingPcm() && !pSource->isReadReady( nBytes ) ){
+        pSource->setReadReadyListener( [this](){ wakeUpDeadlineWait(); } );
+        // check again since the write might be done before setting the listener
+        bAllReady = bAllReady && pSource->isReadReady( nBytes );
+      }
+    }
+    mMutexPipe.unlock();
+    if( bAllReady ){
+      return true;
+    }
+    if( !mDeadlineEvent.wait_until( lock, deadline, [&]{ return mDeadlineWakeup || !mbIsRunning; } ) ){
+      return false;
+    }
+  }
+  return false;
+}
+
+void PipeMixer::wakeUpDeadlineWait(void)
+{
+  std::lock_guard<std::mutex> lock( mDeadlineMutex );
+  mDeadlineWakeup = true;
+  mDeadlineEvent.notify_all();
+}
+
+void PipeMixer::readOrConcealInputsLocked(std::vector<std::shared_ptr<AudioBuffer>>& buffers, int nBytes)
+{
+  mConsecutiveUnderruns.resize( mpInterPipeBridges.size(), 0 );
+  for(size_t i=0; i<mpInterPipeBridges.size(); i++){
+    std::shared_ptr<InterPipeBridge> pSource = mpInterPipeBridges[i];
+    bool bActive = isPipeRunningOrNotRegistered( pSource ) && pSource->getAudioFormat().isEncodingPcm();
+    if( bActive && pSource->isReadReady( nBytes ) ){
+      if( !pSource->readHandoff( *buffers[i] ) ){
+        pSource->read( *buffers[i] );
+      }
+      mConsecutiveUnderruns[i] = 0;
+    } else {
+      if( bActive ){
+        mUnderrunCounts[pSource]++;
+        mConsecutiveUnderruns[i]++;
+      }
+      // the buffer still has the previous window then it's repeated as is
+      if( !bActive || ( mConcealment == CONCEAL_ZERO ) || ( mConsecutiveUnderruns[i] > 1 ) ){
+        ByteBuffer& rawBuffer = buffers[i]->getRawBuffer();
+        std::fill( rawBuffer.begin(), rawBuffer.end(), 0 );
+      }
+    }
+  }
+}
+
+void PipeMixer::mixBuffers(std::vector<std::shared_ptr<AudioBuffer>>& buffers, std::shared_ptr<AudioBuffer> pOutBuf)
+{
+  // the inputs are read in the output format then this mixes the raw buffers without the intermediate allocation
+  mMixInputs.clear();
+  for( auto& pBuf : buffers ){
+    mMixInputs.push_back( pBuf->getRawBufferPointer() );
+  }
+  Mixer::process( std::span<const uint8_t* const>( mMixInputs ), pOutBuf->getAudioFormat(), pOutBuf->getRawBufferPointer(), pOutBuf->getNumberOfSamples() );
+}
+
+int PipeMixer::getMixWindowSamples(AudioFormat format)
+{
+  int nSamples = MIX_WINDOW_SAMPLES;
+  std::shared_ptr<ISink> pSink = mpSink;
+  if( mDeadlineMixEnabled && pSink ){
+    int nLatencyUsec = pSink->getLatencyUSec();
+    if( nLatencyUsec > 0 ){
+      nLatencyUsec = std::clamp( nLatencyUsec, MIN_MIX_WINDOW_USEC, MAX_MIX_WINDOW_USEC );
+      // rounded since the sink's latency might be the written window's duration which is truncated
+      nSamples = ( (int64_t)nLatencyUsec * format.getSamplingRate() + 500000 ) / 1000000;
+    }
+  }
+  return nSamples;
+}
+
+int PipeMixer::getUnderrunCount(std::shared_ptr<ISink> pSinkAdaptor)
+{
+  int result = -1;
+  std::shared_ptr<InterPipeBridge> pInterPipeBridge = std::dynamic_pointer_cast<InterPipeBridge>( pSinkAdaptor );
+  mMutexPipe.lock();
+  if( pInterPipeBridge && mUnderrunCounts.contains( pInterPipeBridge ) ){
+    result = mUnderrunCounts[ pInterPipeBridge ];
+  }
+  mMutexPipe.unlock();
+  return result;
+}
+
+void PipeMixer::passThroughCompressed(void)
+{
+  // the compressed frame isn't mixed. the first running pipe's frame is passed through the reused buffer.
+  mCompressedBuf.resetChunk();
+  mMutexPipe.lock();
+  for(auto& pSource : mpInterPipeBridges){
+    if( isPipeRunningOrNotRegistered( pSource ) ){
+      if( !pSource->readHandoff( mCompressedBuf ) ){
+        pSource->read( mCompressedBuf );
+      }
+      break;
+    }
+  }
+  IBufferHandoff* pHandoffSink = dynamic_cast<IBufferHandoff*>( mpSink.get() );
+  if( !pHandoffSink || !pHandoffSink->writeHandoff( mCompressedBuf ) ){
+    mpSink->write( mCompressedBuf );
+  }
+  mMutexPipe.unlock();
+}
+
+ThreadBase::STEP_RESULT PipeMixer::processStep(void)
+{
+  if( !mpSink || mpInterPipeBridges.empty() ){
+    return STEP_DONE;
+  }
+
+  if( !mpSink->getAudioFormat().isEncodingPcm() ){
+    // the compressed buffer's size is unknown until the read then this is same as process()
+    passThroughCompressed();
+    return STEP_CONTINUE;
+  }
+
+  AudioFormat outFormat = mpSink->getAudioFormat();
+  int nSamples = getMixWindowSamples( outFormat );
+  mMutexPipe.lock();
+  if( !mpStepOutBuf || !mpStepOutBuf->getAudioFormat().equal( outFormat ) || ( mpStepOutBuf->getNumberOfSamples() != nSamples ) || ( mStepBuffers.size() != mpInterPipeBridges.size() ) ){
+    mpStepOutBuf = std::make_shared<AudioBuffer>( outFormat, nSamples );
+    mStepBuffers.clear();
+    for(size_t i=0; i<mpInterPipeBridges.size(); i++){
+      mStepBuffers.push_back( std::make_shared<AudioBuffer>( outFormat, nSamples ) );
+    }
+  }
+  int nBytes = mpStepOutBuf->getRawBufferSize();
+  bool bConceal = ( mpPullScheduler != nullptr );
+
+  if( !bConceal ){
+    // the continuation instead of the blocking read. the all inputs should be ready before reading any of them.
+    for( auto& pSource : mpInterPipeBridges ){
+      if( isPipeRunningOrNotRegistered( pSource ) && pSource->getAudioFormat().isEncodingPcm() && !pSource->isReadReady( nBytes ) ){
+        pSource->setReadReadyListener( [this](){ resumeStep(); } );
+        if( !pSource->isReadReady( nBytes ) ){
+          mMutexPipe.unlock();
+          return STEP_WAIT;
         }
+        pSource->setReadReadyListener( nullptr );
       }
-      mpSink->write( buf );
-      mMutexPipe.unlock();
     }
   }
+
+  // the all running inputs are ready here unless the pull scheduler mode
+  readOrConcealInputsLocked( mStepBuffers, nBytes );
+  mMutexPipe.unlock();
+
+  mixBuffers( mStepBuffers, mpStepOutBuf );
+  mpSink->write( *mpStepOutBuf );
+
+  return STEP_CONTINUE;
+}
+
+void PipeMixer::finalizeStep(void)
+{
+  mMutexPipe.lock();
+  for( auto& pSource : mpInterPipeBridges ){
+    pSource->setReadReadyListener( nullptr );
+  }
+  mStepBuffers.clear();
+  mpStepOutBuf.reset();
+  mMutexPipe.unlock();
+}
+
+int PipeMixer::getPullPeriodUsec(void)
+{
+  AudioFormat format = mpSink ? mpSink->getAudioFormat() : mFormat;
+  return (int64_t)getMixWindowSamples( format ) * 1000000 / format.getSamplingRate();
+}
+
+std::vector<ThreadBase*> PipeMixer::getUpstreamRunners(void)
+{
+  std::vector<ThreadBase*> result;
+  mMutexPipe.lock();
+  for( auto& [pInterPipeBridge, pWeakPipe] : mpPipes ){
+    std::shared_ptr<IPipe> pPipe = pWeakPipe.lock();
+    if( pPipe ){
+      result.push_back( pPipe.get() );
+    }
+  }
+  mMutexPipe.unlock();
+  return result;
 }
 
 void PipeMixer::unlockToStop(void)
@@ -125,6 +358,7 @@ void PipeMixer::unlockToStop(void)
   for( auto& pPipeBridge : mpInterPipeBridges ){
     pPipeBridge->unlock();
   }
+  wakeUpDeadlineWait();
 }
 
 std::shared_ptr<ISink> PipeMixer::getSinkFromPipe(std::shared_ptr<IPipe> pArgPipe)
@@ -149,6 +383,7 @@ void PipeMixer::attachSinkAdaptor(std::shared_ptr<InterPipeBridge> pSource, std:
   if( pSource && !mpPipes.contains( pSource ) /* std::find(mpInterPipeBridges.begin(), mpInterPipeBridges.end(), pSource) == mpInterPipeBridges.end()*/ ){
     mpInterPipeBridges.push_back( pSource );
     mpPipes.insert_or_assign( pSource, pPipe );
+    mUnderrunCounts.insert_or_assign( pSource, 0 );
   }
   mMutexPipe.unlock();
 }
@@ -173,6 +408,7 @@ void PipeMixer::releaseSinkAdaptor(std::shared_ptr<ISink> pSink)
     mMutexPipe.lock();
     std::erase( mpInterPipeBridges, pInterPipeBridge );
     mpPipes.erase( pInterPipeBridge );
+    mUnderrunCounts.erase( pInterPipeBridge );
     mMutexPipe.unlock();
   }
 }
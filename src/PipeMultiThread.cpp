@@ -21,7 +21,7 @@
 #include <iostream>
 #include <algorithm>
 
-PipeMultiThread::PipeMultiThread() : mpSink(nullptr), mpSource(nullptr), mSinkAttached(false), mSourceAttached(false)
+PipeMultiThread::PipeMultiThread() : mpSink(nullptr), mpSource(nullptr), mSinkAttached(false), mSourceAttached(false), mNumberOfStages(0), mBlockSizeAdapterEnabled(false)
 {
 
 }
@@ -55,6 +55,8 @@ void PipeMultiThread::createAndConnectPipesToHead(std::shared_ptr<IPipe> pCurren
     AudioFormat theUsingFormat = pCurrentPipe->getFilterAudioFormat();
 
     std::shared_ptr<InterPipeBridge> pInterBridge = std::make_shared<InterPipeBridge>( theUsingFormat );
+    // the both sides are Pipe then the window buffer is passed without copy
+    pInterBridge->setHandoffEnabled( true );
     mInterPipeBridges.insert( mInterPipeBridges.begin(), pInterBridge );
 
     std::shared_ptr<ISource> pSource = pCurrentPipe->attachSource( pInterBridge );
@@ -71,6 +73,8 @@ void PipeMultiThread::createAndConnectPipesToTail(std::shared_ptr<IPipe> pCurren
     AudioFormat theUsingFormat = pCurrentPipe->getFilterAudioFormat();
 
     std::shared_ptr<InterPipeBridge> pInterBridge = std::make_shared<InterPipeBridge>(theUsingFormat);
+    // the both sides are Pipe then the window buffer is passed without copy
+    pInterBridge->setHandoffEnabled( true );
     mInterPipeBridges.push_back( pInterBridge  );
 
     std::shared_ptr<ISink> pSink = pCurrentPipe->attachSink( pInterBridge );
@@ -84,6 +88,12 @@ void PipeMultiThread::addFilterToHead(std::shared_ptr<IFilter> pFilter)
 {
   if( pFilter ){
     mMutexFilters.lock();
+    mFilters.insert( mFilters.begin(), pFilter );
+    if( isStagePartitioned() ){
+      rebuildStagesLocked();
+      mMutexFilters.unlock();
+      return;
+    }
     std::shared_ptr<IPipe> pPipe = getHeadPipe();
     if( pPipe ){
       int theFilterWindowSize = pFilter->getRequiredWindowSizeUsec();
@@ -103,6 +113,12 @@ void PipeMultiThread::addFilterToTail(std::shared_ptr<IFilter> pFilter)
 {
   if( pFilter ){
     mMutexFilters.lock();
+    mFilters.push_back( pFilter );
+    if( isStagePartitioned() ){
+      rebuildStagesLocked();
+      mMutexFilters.unlock();
+      return;
+    }
     std::shared_ptr<IPipe> pPipe = getTailPipe();
     if( pPipe ){
       int theFilterWindowSize = pFilter->getRequiredWindowSizeUsec();
@@ -156,15 +172,25 @@ bool PipeMultiThread::addFilterAfterFilter(std::shared_ptr<IFilter> pFilter, std
 
   if( pFilter && pPosition ){
     mMutexFilters.lock();
-    std::shared_ptr<IPipe> pPipe = findPipe( pFilter );
-    if( pPipe ){
-      int theFilterWindowSize = pFilter->getRequiredWindowSizeUsec();
-      int thePipeWindowSize = pPipe->getWindowSizeUsec();
-
-      if( theFilterWindowSize != thePipeWindowSize ) {
-        // TODO : Create different pipe and interconnect
-      } else {
-        result = pPipe->addFilterAfterFilter( pFilter, pPosition );
+    auto it = std::find( mFilters.begin(), mFilters.end(), pPosition );
+    if( isStagePartitioned() && ( it != mFilters.end() ) ){
+      mFilters.insert( it + 1, pFilter );
+      rebuildStagesLocked();
+      result = true;
+    } else {
+      std::shared_ptr<IPipe> pPipe = findPipe( pFilter );
+      if( pPipe ){
+        int theFilterWindowSize = pFilter->getRequiredWindowSizeUsec();
+        int thePipeWindowSize = pPipe->getWindowSizeUsec();
+
+        if( theFilterWindowSize != thePipeWindowSize ) {
+          // TODO : Create different pipe and interconnect
+        } else {
+          result = pPipe->addFilterAfterFilter( pFilter, pPosition );
+        }
+      }
+      if( result && ( it != mFilters.end() ) ){
+        mFilters.insert( it + 1, pFilter );
       }
     }
     mMutexFilters.unlock();
@@ -177,13 +203,23 @@ bool PipeMultiThread::removeFilter(std::shared_ptr<IFilter> pFilter)
 {
   bool result = false;
 
-  for( auto& pPipe : mPipes ){
-    if( pPipe->isFilterIncluded( pFilter ) ){
-      pPipe->removeFilter( pFilter );
-      result = true;
-      break;
+  mMutexFilters.lock();
+  if( isStagePartitioned() ){
+    result = std::erase( mFilters, pFilter );
+    if( result ){
+      rebuildStagesLocked();
+    }
+  } else {
+    for( auto& pPipe : mPipes ){
+      if( pPipe->isFilterIncluded( pFilter ) ){
+        pPipe->removeFilter( pFilter );
+        std::erase( mFilters, pFilter );
+        result = true;
+        break;
+      }
     }
   }
+  mMutexFilters.unlock();
 
   return result;
 }
@@ -331,6 +367,7 @@ void PipeMultiThread::clearFilters(void)
 {
   mPipes.clear();
   mInterPipeBridges.clear();
+  mFilters.clear();
 }
 
 AudioFormat PipeMultiThread::getFilterAudioFormat(AudioFormat theUsingFormat)
@@ -392,3 +429,118 @@ int PipeMultiThread::stateResourceConsumption(void)
 
   return nProcessingResource;
 }
+
+void PipeMultiThread::setNumberOfStages(int nStages)
+{
+  mMutexFilters.lock();
+  if( nStages != mNumberOfStages ){
+    mNumberOfStages = nStages;
+    rebuildStagesLocked();
+  }
+  mMutexFilters.unlock();
+}
+
+void PipeMultiThread::setBlockSizeAdapterEnabled(bool bEnabled)
+{
+  mMutexFilters.lock();
+  if( bEnabled != mBlockSizeAdapterEnabled ){
+    mBlockSizeAdapterEnabled = bEnabled;
+    rebuildStagesLocked();
+  }
+  mMutexFilters.unlock();
+}
+
+std::vector<int> PipeMultiThread::getStageResourceConsumption(void)
+{
+  std::vector<int> result;
+
+  mMutexFilters.lock();
+  for( auto& pPipe : mPipes ){
+    int nCost = 0;
+    for( auto& pFilter : mFilters ){
+      nCost += pPipe->isFilterIncluded( pFilter ) ? pFilter->stateResourceConsumption() : 0;
+    }
+    result.push_back( nCost );
+  }
+  mMutexFilters.unlock();
+
+  return result;
+}
+
+int PipeMultiThread::getFilterCost(std::shared_ptr<IFilter> pFilter)
+{
+  // the filter which doesn't declare the cost is counted as the minimum
+  return std::max( pFilter->stateResourceConsumption(), 1 );
+}
+
+std::vector<int> PipeMultiThread::getStagePartition(const FilterChain& filters, int nStages, bool bWindowSizeBoundary)
+{
+  // greedy : close the stage when the cost exceeds the limit or the window size is changed
+  auto partition = [&filters, bWindowSizeBoundary](int64_t nLimit){
+    std::vector<int> stageSizes;
+    int64_t nStageCost = 0;
+    for( int i=0, c=filters.size(); i<c; i++ ){
+      int nCost = getFilterCost( filters[i] );
+      bool bBoundary = bWindowSizeBoundary && i && ( filters[i]->getRequiredWindowSizeUsec() != filters[i-1]->getRequiredWindowSizeUsec() );
+      if( stageSizes.empty() || bBoundary || ( ( nStageCost + nCost ) > nLimit ) ){
+        stageSizes.push_back( 0 );
+        nStageCost = 0;
+      }
+      stageSizes.back()++;
+      nStageCost += nCost;
+    }
+    return stageSizes;
+  };
+
+  // binary search the minimum limit of the stage cost which fits in nStages
+  int64_t nMin = 0;
+  int64_t nMax = 0;
+  for( auto& pFilter : filters ){
+    nMin = std::max( nMin, (int64_t)getFilterCost( pFilter ) );
+    nMax += getFilterCost( pFilter );
+  }
+  while( nMin < nMax ){
+    int64_t nLimit = ( nMin + nMax ) / 2;
+    if( (int)partition( nLimit ).size() <= std::max( nStages, 1 ) ){
+      nMax = nLimit;
+    } else {
+      nMin = nLimit + 1;
+    }
+  }
+
+  return partition( nMax );
+}
+
+void PipeMultiThread::rebuildStagesLocked(void)
+{
+  bool bRunning = isRunning();
+  if( bRunning ){
+    stop();
+  }
+
+  mPipes.clear();
+  mInterPipeBridges.clear();
+  mSourceAttached = false;
+  mSinkAttached = false;
+
+  int nIndex = 0;
+  for( auto nStageSize : getStagePartition( mFilters, mNumberOfStages, !mBlockSizeAdapterEnabled ) ){
+    std::shared_ptr<IPipe> pPipe = getTailPipe();
+    if( pPipe ){
+      createAndConnectPipesToTail( pPipe );
+    }
+    pPipe = getTailPipe( true );
+    std::shared_ptr<Pipe> pStagePipe = std::dynamic_pointer_cast<Pipe>( pPipe );
+    if( pStagePipe ){
+      pStagePipe->setBlockSizeAdapterEnabled( mBlockSizeAdapterEnabled );
+    }
+    for( int i=0; i<nStageSize; i++ ){
+      pPipe->addFilterToTail( mFilters[nIndex++] );
+    }
+  }
+  ensureSourceSink();
+
+  if( bRunning ){
+    run();
+  }
+}
@@ -23,6 +23,7 @@ PipedSink::PipedSink( std::shared_ptr<ISink> pSink ) : ISink(), mpSink(pSink)
   mpInterPipeBridge = std::make_shared<InterPipeBridge>();
   mpPipe = std::make_shared<PipeMultiThread>();
   mpPipe->attachSource ( mpInterPipeBridge );
+  setInnerAudioBase( mpSink );
 }
 
 PipedSink::~PipedSink()
@@ -42,6 +43,7 @@ std::shared_ptr<ISink> PipedSink::attachSink(std::shared_ptr<ISink> pSink)
 
   std::shared_ptr<ISink> prevSink = mpSink;
   mpSink = pSink;
+  setInnerAudioBase( mpSink );
 
   if( mpPipe ){
     std::shared_ptr<ISink> prevPipeSink = mpPipe->attachSink( pSink );
@@ -62,6 +64,7 @@ std::shared_ptr<ISink> PipedSink::detachSink(void)
   }
   std::shared_ptr<ISink> prevSink = mpSink;
   mpSink = nullptr;
+  setInnerAudioBase( nullptr );
 
   if( mpPipe ){
     std::shared_ptr<ISink> prevPipeSink = mpPipe->detachSink();
@@ -78,6 +81,13 @@ void PipedSink::writePrimitive(IAudioBuffer& buf)
   }
 }
 
+void PipedSink::unlock(void)
+{
+  if( mpInterPipeBridge ){
+    mpInterPipeBridge->unlock();
+  }
+}
+
 void PipedSink::dump(void)
 {
   if( mpSink ){
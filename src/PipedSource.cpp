@@ -42,6 +42,7 @@ std::shared_ptr<ISource> PipedSource::attachSource(std::shared_ptr<ISource> pSou
 
   std::shared_ptr<ISource> prevSource = mpSource;
   mpSource = pSource;
+  setInnerAudioBase( mpSource );
 
   if( mpPipe ){
     std::shared_ptr<ISource> prevPipeSource = mpPipe->attachSource( pSource );
@@ -62,6 +63,7 @@ std::shared_ptr<ISource> PipedSource::detachSource(void)
   }
   std::shared_ptr<ISource> prevSource = mpSource;
   mpSource = nullptr;
+  setInnerAudioBase( nullptr );
 
   if( mpPipe ){
     std::shared_ptr<ISource> prevPipeSource = mpPipe->detachSource();
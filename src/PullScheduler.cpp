@@ -0,0 +1,167 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "PullScheduler.hpp"
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <set>
+
+PullScheduler::PullScheduler(int nPeriodUsec):ThreadBase(), mPeriodUsec(nPeriodUsec)
+{
+
+}
+
+PullScheduler::~PullScheduler()
+{
+  stop();
+  std::vector<ThreadBase*> runners;
+  mMutexRunners.lock();
+  runners = mRunners;
+  mMutexRunners.unlock();
+  for( auto& pRunner : runners ){
+    pRunner->stop();
+  }
+}
+
+void PullScheduler::setPeriodUsec(int nPeriodUsec)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutexRunners);
+  mPeriodUsec = nPeriodUsec;
+}
+
+int PullScheduler::getPeriodUsec(void)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutexRunners);
+  return getPeriodUsecLocked();
+}
+
+int PullScheduler::getNumberOfRunners(void)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutexRunners);
+  return mRunners.size();
+}
+
+int PullScheduler::getPeriodUsecLocked(void)
+{
+  int nPeriodUsec = mPeriodUsec;
+  if( nPeriodUsec <= 0 ){
+    for( auto& pRunner : mRunners ){
+      int nRunnerPeriodUsec = pRunner->getPullPeriodUsec();
+      if( nRunnerPeriodUsec > 0 && ( nPeriodUsec <= 0 || nRunnerPeriodUsec < nPeriodUsec ) ){
+        nPeriodUsec = nRunnerPeriodUsec;
+      }
+    }
+  }
+  return ( nPeriodUsec > 0 ) ? nPeriodUsec : DEFAULT_PERIOD_USEC;
+}
+
+void PullScheduler::attach(ThreadBase* pRunner)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutexRunners);
+  if( pRunner && !isAttachedLocked( pRunner ) ){
+    mRunners.push_back( pRunner );
+    mCreditsUsec[ pRunner ] = 0;
+  }
+}
+
+void PullScheduler::detach(ThreadBase* pRunner)
+{
+  // this waits for the current period since the period holds the lock
+  std::lock_guard<std::recursive_mutex> lock(mMutexRunners);
+  detachLocked( pRunner );
+}
+
+bool PullScheduler::isAttachedLocked(ThreadBase* pRunner)
+{
+  return std::find( mRunners.begin(), mRunners.end(), pRunner ) != mRunners.end();
+}
+
+void PullScheduler::detachLocked(ThreadBase* pRunner)
+{
+  auto it = std::find( mRunners.begin(), mRunners.end(), pRunner );
+  if( it != mRunners.end() ){
+    mRunners.erase( it );
+    mCreditsUsec.erase( pRunner );
+    pRunner->finalizeStep();
+    pRunner->mbPullAttached = false;
+  }
+}
+
+std::vector<ThreadBase*> PullScheduler::getEvaluationOrderLocked(void)
+{
+  // depth first on the upstreams. then the upstream runner comes before the downstream runner.
+  std::vector<ThreadBase*> order;
+  std::set<ThreadBase*> visited;
+  std::function<void(ThreadBase*)> visit = [&](ThreadBase* pRunner){
+    if( visited.contains( pRunner ) ) return;
+    visited.insert( pRunner );
+    for( auto& pUpstream : pRunner->getUpstreamRunners() ){
+      if( isAttachedLocked( pUpstream ) ){
+        visit( pUpstream );
+      }
+    }
+    order.push_back( pRunner );
+  };
+  for( auto& pRunner : mRunners ){
+    visit( pRunner );
+  }
+  return order;
+}
+
+void PullScheduler::processPeriod(int nPeriodUsec)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutexRunners);
+  for( auto& pRunner : getEvaluationOrderLocked() ){
+    // the runner might be detached by the previous runner's step e.g. MixerSplitter
+    if( !isAttachedLocked( pRunner ) ) continue;
+    int nRunnerPeriodUsec = pRunner->getPullPeriodUsec();
+    if( nRunnerPeriodUsec <= 0 ){
+      nRunnerPeriodUsec = nPeriodUsec;
+    }
+    mCreditsUsec[ pRunner ] += nPeriodUsec;
+    while( mbIsRunning && isAttachedLocked( pRunner ) && mCreditsUsec[ pRunner ] >= nRunnerPeriodUsec ){
+      ThreadBase::STEP_RESULT result = pRunner->mbIsRunning ? pRunner->processStep() : ThreadBase::STEP_DONE;
+      if( result == ThreadBase::STEP_DONE ){
+        pRunner->mbIsRunning = false;
+        detachLocked( pRunner );
+        pRunner->notifyRunnerStatusChanged();
+      } else if( result == ThreadBase::STEP_WAIT ){
+        // not ready. try again in the next period without accumulating the missed duration.
+        mCreditsUsec[ pRunner ] = std::min( mCreditsUsec[ pRunner ], (int64_t)nRunnerPeriodUsec );
+        break;
+      } else {
+        mCreditsUsec[ pRunner ] -= nRunnerPeriodUsec;
+      }
+    }
+  }
+}
+
+void PullScheduler::process(void)
+{
+  auto nextTime = std::chrono::steady_clock::now();
+  while( mbIsRunning ){
+    int nPeriodUsec = getPeriodUsec();
+    processPeriod( nPeriodUsec );
+
+    nextTime += std::chrono::microseconds( nPeriodUsec );
+    auto now = std::chrono::steady_clock::now();
+    if( nextTime + std::chrono::microseconds( nPeriodUsec ) < now ){
+      // overrun. restart from now instead of the burst to catch up.
+      nextTime = now;
+    }
+    std::this_thread::sleep_until( nextTime );
+  }
+}
@@ -17,9 +17,10 @@
 #include "ReferenceSoundSinkSource.hpp"
 #include <algorithm>
 
-ReferenceSoundSinkSource::ReferenceSoundSinkSource( std::shared_ptr<ISink> pSink ) : InterPipeBridge( pSink ? pSink->getAudioFormat() : AudioFormat() ), mpSink( pSink )
+ReferenceSoundSinkSource::ReferenceSoundSinkSource( std::shared_ptr<ISink> pSink ) : InterPipeBridge( pSink ? pSink->getAudioFormat() : AudioFormat() ), mpSink( pSink ), mbSettingSinkFormat( false )
 {
   setRequiredResourceConsumption(0);
+  ISink::setInnerAudioBase( mpSink );
 }
 
 ReferenceSoundSinkSource::~ReferenceSoundSinkSource()
@@ -53,6 +54,7 @@ std::shared_ptr<ISink> ReferenceSoundSinkSource::attachSink(std::shared_ptr<ISin
   std::shared_ptr<ISink> pPrevSink = mpSink;
   mpSink = pSink;
   mMutexSink.unlock();
+  ISink::setInnerAudioBase( pSink );
   return pPrevSink;
 }
 
@@ -63,6 +65,7 @@ std::shared_ptr<ISink> ReferenceSoundSinkSource::detachSink(void)
   mpSink = nullptr;
   clearBuffer();
   mMutexSink.unlock();
+  ISink::setInnerAudioBase( nullptr );
   return pPrevSink;
 }
 
@@ -77,7 +80,9 @@ void ReferenceSoundSinkSource::setAudioFormatPrimitive(AudioFormat audioFormat)
   bool result = false;
   mMutexSink.lock();
   if( mpSink ){
+    mbSettingSinkFormat = true;
     result = mpSink->setAudioFormat( audioFormat );
+    mbSettingSinkFormat = false;
   }
   mMutexSink.unlock();
   if( result ){
@@ -104,6 +109,13 @@ AudioFormat ReferenceSoundSinkSource::getAudioFormat(void)
   return result;
 }
 
+void ReferenceSoundSinkSource::onInnerAudioFormatChanged(AudioFormat format)
+{
+  if( !mbSettingSinkFormat ){
+    getAudioFormat();
+  }
+}
+
 int ReferenceSoundSinkSource::stateResourceConsumption(void)
 {
   int result = InterPipeBridge::stateResourceConsumption();
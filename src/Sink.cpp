@@ -64,42 +64,72 @@ void ISink::mutePrimitive(bool bEnableMute, bool bUseZero)
 {
 }
 
-void ISink::write(IAudioBuffer& buf)
+void ISink::updateSinkPosition(IAudioBuffer& buf)
 {
-  std::lock_guard<std::mutex> lock(mMutexWrite);
-  int nSamples = 0;
-  AudioFormat format;
   AudioBuffer* pBuf = dynamic_cast<AudioBuffer*>(&buf);
   if( pBuf ){
     // AudioBuffer instance
-    nSamples = pBuf->getNumberOfSamples();
-    format = pBuf->getAudioFormat();
+    int nSamples = pBuf->getNumberOfSamples();
     if( nSamples ){
-      mLatencyUsec = 1000000 * nSamples / format.getSamplingRate();
+      mLatencyUsec = 1000000 * nSamples / pBuf->getAudioFormat().getSamplingRate();
     }
     mSinkPosition += (mLatencyUsec ? mLatencyUsec : buf.getRawBufferSize());
   } else {
     // CompressedAudioBuffer instance
     mSinkPosition += buf.getRawBufferSize();
   }
+}
+
+bool ISink::isVolumeRequired(void)
+{
+  // the ramp back to 100% is also required after the volume was applied
+  return (!mIsPerChannelVolume && (100.0f != mVolume)) || (mIsPerChannelVolume && Volume::isVolumeRequired(mPerChannelVolumes)) || (!mAppliedVolumes.empty() && Volume::isVolumeRequired(mAppliedVolumes));
+}
+
+void ISink::write(IAudioBuffer& buf)
+{
+  std::lock_guard<std::mutex> lock(mMutexWrite);
+  updateSinkPosition( buf );
+  AudioBuffer* pBuf = dynamic_cast<AudioBuffer*>(&buf);
+  int nSamples = pBuf ? pBuf->getNumberOfSamples() : 0;
+  AudioFormat format = pBuf ? pBuf->getAudioFormat() : AudioFormat();
+  int nChannels = format.getNumberOfChannels();
+  if( pBuf ){
+    if( mIsPerChannelVolume ){
+      mTargetVolumes = mPerChannelVolumes;
+    } else {
+      mTargetVolumes.assign( nChannels, mVolume );
+    }
+    if( mAppliedVolumes.size() != (size_t)nChannels ){
+      // nothing is output yet or the channel layout is changed then start at the target without the ramp
+      mAppliedVolumes = mTargetVolumes;
+    }
+  }
   if( !getMuteEnabled() ){
-    if( (!mIsPerChannelVolume && (100.0f == mVolume)) || (mIsPerChannelVolume && !Volume::isVolumeRequired(mPerChannelVolumes) ) || !pBuf ){
+    if( !isVolumeRequired() || !pBuf ){
       writePrimitive( buf );
     } else {
       // pBuf is already checked in the above
-      AudioBuffer volumedBuf( format, nSamples );
-      if( (!mIsPerChannelVolume && Volume::process( pBuf, &volumedBuf, mVolume )) || (mIsPerChannelVolume && Volume::process( pBuf, &volumedBuf, mPerChannelVolumes )) ){
-        writePrimitive( volumedBuf );
+      std::shared_ptr<AudioBuffer> pVolumedBuf = mBufferPool.acquire( format, nSamples );
+      // ramp from the previously applied volumes to avoid the zipper noise on the volume change
+      const std::vector<float>& startVolumes = ( mAppliedVolumes.size() == mTargetVolumes.size() ) ? mAppliedVolumes : mTargetVolumes;
+      if( Volume::process( pBuf, pVolumedBuf.get(), startVolumes, mTargetVolumes ) ){
+        mAppliedVolumes = mTargetVolumes;
+        writePrimitive( *pVolumedBuf );
       } else {
         writePrimitive( buf );
       }
     }
-  } else if ( getUseZeroEnabledInMute() ) {
-    // mute enabled && zero out enabled
-    AudioBuffer zeroBuffer( format, nSamples );
-    ByteBuffer rawZeroBuffer( zeroBuffer.getRawBufferSize(), 0 );
-    zeroBuffer.setRawBuffer( rawZeroBuffer );
-    writePrimitive( zeroBuffer );
+  } else {
+    if( pBuf ){
+      // the output is silent then the unmute ramps up from zero
+      mAppliedVolumes.assign( nChannels, 0.0f );
+    }
+    if ( getUseZeroEnabledInMute() ) {
+      // mute enabled && zero out enabled
+      std::shared_ptr<AudioBuffer> pZeroBuffer = mBufferPool.acquire( format, nSamples, true );
+      writePrimitive( *pZeroBuffer );
+    }
   }
 }
 
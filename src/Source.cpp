@@ -16,6 +16,7 @@
 
 #include "Source.hpp"
 #include <iostream>
+#include <algorithm>
 
 ISource::ISource():ISourceSinkCommon(), mLatencyUsec(0), mSourcePosition(0)
 {
@@ -27,10 +28,8 @@ ISource::~ISource()
 
 }
 
-void ISource::read(IAudioBuffer& buf)
+void ISource::updateSourcePosition(IAudioBuffer& buf)
 {
-  std::lock_guard<std::mutex> lock(mMutexRead);
-  // TODO: Handle volume as same as ISink
   AudioBuffer* pBuf = dynamic_cast<AudioBuffer*>(&buf);
   if( pBuf ){
     int nSamples = pBuf->getNumberOfSamples();
@@ -42,12 +41,19 @@ void ISource::read(IAudioBuffer& buf)
   } else {
     mSourcePosition += buf.getRawBufferSize();
   }
+}
+
+void ISource::read(IAudioBuffer& buf)
+{
+  std::lock_guard<std::mutex> lock(mMutexRead);
+  // TODO: Handle volume as same as ISink
+  updateSourcePosition( buf );
   if( !getMuteEnabled() ){
     readPrimitive(buf);
   } else if ( getUseZeroEnabledInMute() ) {
     // mute enabled && use zero enabled
-    ByteBuffer rawZeroBuffer( buf.getRawBufferSize(), 0 );
-    buf.setRawBuffer( rawZeroBuffer );
+    ByteBuffer& rawBuffer = buf.getRawBuffer();
+    std::fill( rawBuffer.begin(), rawBuffer.end(), 0 );
   }
 }
 
@@ -55,7 +55,7 @@ void StreamSink::writePrimitive(IAudioBuffer& buf)
     AudioBuffer* pBuf = dynamic_cast<AudioBuffer*>(&buf);
     if( pBuf && !mFormat.equal( pBuf->getAudioFormat() ) ){
       AudioBuffer dstAudioBuffer( mFormat, pBuf->getNumberOfSamples() );
-      AudioFormatAdaptor::convert( *pBuf, dstAudioBuffer );
+      AudioFormatAdaptor::convert( *pBuf, dstAudioBuffer, mpSamplingRateConverter );
       *pBuf = dstAudioBuffer;
     }
  
@@ -54,7 +54,7 @@ void StreamSource::readPrimitive(IAudioBuffer& buf)
       AudioBuffer* pBuf = dynamic_cast<AudioBuffer*>(&buf);
       if( pBuf ){
         AudioBuffer dstAudioBuffer( mFormat, pBuf->getNumberOfSamples() );
-        AudioFormatAdaptor::convert( *pBuf, dstAudioBuffer );
+        AudioFormatAdaptor::convert( *pBuf, dstAudioBuffer, mpSamplingRateConverter );
         *pBuf = dstAudioBuffer;
       }
     }
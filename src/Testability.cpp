@@ -66,7 +66,7 @@ void ICapture::unlock(void)
 
 SinkTestBase::SinkTestBase(std::shared_ptr<ISink> pSink) : ISink(), mpSink(pSink)
 {
-
+  setInnerAudioBase( mpSink );
 }
 
 SinkTestBase::~SinkTestBase()
@@ -193,7 +193,7 @@ void SinkInjector::setAudioFormatPrimitive(AudioFormat audioFormat)
 
 SourceTestBase::SourceTestBase(std::shared_ptr<ISource> pSource) : ISource(), mpSource( pSource )
 {
-
+  setInnerAudioBase( mpSource );
 }
 
 SourceTestBase::~SourceTestBase()
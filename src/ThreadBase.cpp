@@ -15,19 +15,30 @@
 */
 
 #include "ThreadBase.hpp"
+#include "PullScheduler.hpp"
+#include "ParameterManager.hpp"
+#include "StringTokenizer.hpp"
 #include <iostream>
 #include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <stdexcept>
 
+// the last resort for the thread which doesn't finish by unlockToStop()
 #ifndef ENABLE_PTHREAD_CANCEL
-#define ENABLE_PTHREAD_CANCEL 1
+#define ENABLE_PTHREAD_CANCEL 0
 #endif /* ENABLE_PTHREAD_CANCEL */
 
-#if ENABLE_PTHREAD_CANCEL
-#include <pthread.h>
-#include <future>
-#endif /* ENABLE_PTHREAD_CANCEL */
+enum STEP_STATE
+{
+  STEP_STATE_IDLE,        // waiting for resumeStep()
+  STEP_STATE_SCHEDULED,   // the task is queued or running
+  STEP_STATE_NOTIFIED,    // resumeStep() is called during the task
+  STEP_STATE_FINISHED
+};
 
-ThreadBase::ThreadBase():mpThread(nullptr), mbIsRunning(false), mIsPreviousRunning(false)
+ThreadBase::ThreadBase():mpThread(nullptr), mbIsRunning(false), mIsPreviousRunning(false), mbThreadFinished(true), mStepState(STEP_STATE_FINISHED), mbStepRunning(false), mbPullAttached(false)
 {
 
 }
@@ -42,9 +53,33 @@ void ThreadBase::run(void)
   if( !mbIsRunning && mpThread ){
     stop();
   }
+  if( mpPullScheduler && isStepSupported() ){
+    mMutexThread.lock();
+    if( !mbIsRunning && !mbPullAttached && !mbStepRunning && !mpThread ){
+      mbIsRunning = true;
+      mbPullAttached = true;
+      mpPullScheduler->attach( this );
+    }
+    mMutexThread.unlock();
+    notifyRunnerStatusChanged();
+    return;
+  }
+  if( mpExecutor && isStepSupported() ){
+    mMutexThread.lock();
+    if( !mbIsRunning && !mbStepRunning && !mpThread ){
+      mbIsRunning = true;
+      mbStepRunning = true;
+      mStepState = STEP_STATE_IDLE;
+      resumeStep();
+    }
+    mMutexThread.unlock();
+    notifyRunnerStatusChanged();
+    return;
+  }
   mMutexThread.lock();
   if( !mbIsRunning && !mpThread ){
     mbIsRunning = true;
+    mbThreadFinished = false;
     mpThread = std::make_shared<std::thread>(_execute, this);
   }
   mMutexThread.unlock();
@@ -58,31 +93,55 @@ void ThreadBase::unlockToStop(void)
 
 void ThreadBase::stop(void)
 {
+  if( mbPullAttached ){
+    mbIsRunning = false;
+    // this waits for the scheduler's current period
+    mpPullScheduler->detach( this );
+  }
+  if( mbStepRunning ){
+    mbIsRunning = false;
+    // wait for finishStep() in the same way as the dedicated thread. the waiting step is resumed again in the retry interval.
+    std::unique_lock<std::mutex> lock(mMutexStep);
+    while( mbStepRunning ){
+      lock.unlock();
+      unlockToStop();
+      // let the waiting step know the stop
+      resumeStep();
+      lock.lock();
+      if( mStepFinishedEvent.wait_for( lock, std::chrono::microseconds(STOP_RETRY_USEC), [&]{ return !mbStepRunning; } ) ){
+        break;
+      }
+    }
+  }
   if( mpThread ){
     mbIsRunning = false;
     mMutexThread.lock();
-    while( mpThread ){
-      unlockToStop();
-      std::this_thread::sleep_for(std::chrono::microseconds(100));
-      if( mpThread->joinable() ){
+    if( mpThread ){
+      // wait for the thread's end instead of polling. unlockToStop() is retried since the thread might block again after the previous one.
+      [[maybe_unused]] auto startTime = std::chrono::steady_clock::now();
+      std::unique_lock<std::mutex> lock(mMutexThreadFinished);
+      while( !mbThreadFinished ){
+        lock.unlock();
+        unlockToStop();
+        lock.lock();
+        if( mThreadFinishedEvent.wait_for( lock, std::chrono::microseconds(STOP_RETRY_USEC), [&]{ return mbThreadFinished; } ) ){
+          break;
+        }
 #if ENABLE_PTHREAD_CANCEL
-        auto stopper = std::async( std::launch::async, &std::thread::join, mpThread );
-        bool bJoined = true;
-        if( std::future_status::timeout == stopper.wait_for( std::chrono::microseconds(1000000) ) ){
+        if( ( std::chrono::steady_clock::now() - startTime ) > std::chrono::microseconds(STOP_TIMEOUT_USEC) ){
           pthread_cancel(mpThread->native_handle());
-          std::cout << "ThreadBase::stop():" << mpThread->get_id() << ":join() timed out. try to stop with pthread_cancel" << std::endl;
-          bJoined = false;
-        }
-        if( bJoined ){
-          mpThread = nullptr;
+          std::cout << "ThreadBase::stop():" << mpThread->get_id() << ":the thread didn't finish. try to stop with pthread_cancel" << std::endl;
+          break;
         }
-#else
-        mpThread->join();
-        mpThread = nullptr;
 #endif /* ENABLE_PTHREAD_CANCEL */
       }
-    mMutexThread.unlock();
+      lock.unlock();
+      if( mpThread->joinable() ){
+        mpThread->join();
+      }
+      mpThread = nullptr;
     }
+    mMutexThread.unlock();
   }
   notifyRunnerStatusChanged();
 }
@@ -98,10 +157,73 @@ void ThreadBase::process(void)
 
 void ThreadBase::_execute(ThreadBase* pThis)
 {
+  pThis->getThreadPolicy().apply();
   pThis->process();
   pThis->mbIsRunning = false;
+  {
+    std::lock_guard<std::mutex> lock(pThis->mMutexThreadFinished);
+    pThis->mbThreadFinished = true;
+  }
+  pThis->mThreadFinishedEvent.notify_all();
+}
+
+void ThreadBase::setExecutor(std::shared_ptr<ThreadPoolExecutor> pExecutor)
+{
+  mMutexThread.lock();
+  mpExecutor = pExecutor;
+  mMutexThread.unlock();
+}
+
+void ThreadBase::resumeStep(void)
+{
+  int state = mStepState.load();
+  while( true ){
+    if( state == STEP_STATE_IDLE ){
+      if( mStepState.compare_exchange_weak( state, STEP_STATE_SCHEDULED ) ){
+        mpExecutor->execute( [this](){ _executeStep(this); } );
+        return;
+      }
+    } else if( state == STEP_STATE_SCHEDULED ){
+      // the running task will call processStep() again
+      if( mStepState.compare_exchange_weak( state, STEP_STATE_NOTIFIED ) ){
+        return;
+      }
+    } else {
+      return;
+    }
+  }
 }
 
+void ThreadBase::_executeStep(ThreadBase* pThis)
+{
+  for( int i=0; i<STEP_BUDGET; i++ ){
+    // the notification until here is covered by this processStep()
+    pThis->mStepState = STEP_STATE_SCHEDULED;
+    STEP_RESULT result = pThis->mbIsRunning ? pThis->processStep() : STEP_DONE;
+    if( result == STEP_DONE ){
+      pThis->finishStep();
+      return;
+    } else if( result == STEP_WAIT ){
+      int state = STEP_STATE_SCHEDULED;
+      if( pThis->mStepState.compare_exchange_strong( state, STEP_STATE_IDLE ) ){
+        return;
+      }
+      // resumeStep() was called during processStep() then continue
+    }
+  }
+  // requeue to give the worker to the others
+  pThis->mpExecutor->execute( [pThis](){ _executeStep(pThis); } );
+}
+
+void ThreadBase::finishStep(void)
+{
+  mbIsRunning = false;
+  finalizeStep();
+  mStepState = STEP_STATE_FINISHED;
+  std::lock_guard<std::mutex> lock(mMutexStep);
+  mbStepRunning = false;
+  mStepFinishedEvent.notify_all();
+}
 
 void ThreadBase::notifyRunnerStatusChanged(void)
 {
@@ -138,3 +260,121 @@ void ThreadBase::unregisterRunnerStatusListener(ThreadBase::RunnerListener* theL
     mRunnerListerners.erase(pos);
   }
 }
+
+void ThreadBase::setPullScheduler(std::shared_ptr<PullScheduler> pScheduler)
+{
+  mMutexThread.lock();
+  mpPullScheduler = pScheduler;
+  mMutexThread.unlock();
+}
+
+void ThreadBase::setThreadPolicy(ThreadPolicy policy)
+{
+  std::atomic_store( &mpThreadPolicy, std::make_shared<ThreadPolicy>( policy ) );
+}
+
+void ThreadBase::resetThreadPolicy(void)
+{
+  std::atomic_store( &mpThreadPolicy, std::shared_ptr<ThreadPolicy>() );
+}
+
+ThreadPolicy ThreadBase::getThreadPolicy(void)
+{
+  // not by mMutexThread since the starting thread reads this while stop() holds it
+  std::shared_ptr<ThreadPolicy> pPolicy = std::atomic_load( &mpThreadPolicy );
+  return pPolicy ? *pPolicy : getDefaultThreadPolicy();
+}
+
+void ThreadBase::setDefaultThreadPolicy(ThreadPolicy policy)
+{
+  std::lock_guard<std::mutex> lock(mMutexDefaultThreadPolicy);
+  mpDefaultThreadPolicy = std::make_shared<ThreadPolicy>( policy );
+}
+
+void ThreadBase::resetDefaultThreadPolicy(void)
+{
+  std::lock_guard<std::mutex> lock(mMutexDefaultThreadPolicy);
+  mpDefaultThreadPolicy.reset();
+}
+
+ThreadPolicy ThreadBase::getDefaultThreadPolicy(void)
+{
+  std::lock_guard<std::mutex> lock(mMutexDefaultThreadPolicy);
+  return mpDefaultThreadPolicy ? *mpDefaultThreadPolicy : ThreadPolicy::getFromParameters();
+}
+
+
+ThreadPolicy::ThreadPolicy(SCHEDULING scheduling, int priority, std::vector<int> cpus, bool bLockMemory):scheduling(scheduling), priority(priority), cpus(cpus), bLockMemory(bLockMemory)
+{
+
+}
+
+bool ThreadPolicy::apply(void)
+{
+  bool bResult = true;
+
+  if( scheduling != SCHEDULING_DEFAULT ){
+    int policy = ( scheduling == SCHEDULING_FIFO ) ? SCHED_FIFO : SCHED_RR;
+    struct sched_param param;
+    param.sched_priority = std::clamp( priority, sched_get_priority_min( policy ), sched_get_priority_max( policy ) );
+    bResult = !pthread_setschedparam( pthread_self(), policy, &param ) && bResult;
+  }
+
+  if( !cpus.empty() ){
+#if __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO( &cpuSet );
+    for( auto& aCpu : cpus ){
+      if( ( aCpu >= 0 ) && ( aCpu < CPU_SETSIZE ) ){
+        CPU_SET( aCpu, &cpuSet );
+      }
+    }
+    bResult = !pthread_setaffinity_np( pthread_self(), sizeof(cpu_set_t), &cpuSet ) && bResult;
+#else
+    // the thread affinity isn't supported
+    bResult = false;
+#endif /* __linux__ */
+  }
+
+  if( bLockMemory ){
+    static std::atomic<bool> bMemoryLocked = false;
+    if( !bMemoryLocked ){
+      bMemoryLocked = !mlockall( MCL_CURRENT | MCL_FUTURE );
+      bResult = bMemoryLocked && bResult;
+    }
+  }
+
+  if( !bResult ){
+    // report once. the thread keeps running with the current setting.
+    static std::atomic<bool> bReported = false;
+    if( !bReported.exchange( true ) ){
+      std::cout << "ThreadPolicy::apply(): some of the policy couldn't be applied (no privilege?). fallback to the current setting" << std::endl;
+    }
+  }
+
+  return bResult;
+}
+
+ThreadPolicy ThreadPolicy::getFromParameters(std::string keyPrefix)
+{
+  ThreadPolicy policy;
+
+  std::shared_ptr<ParameterManager> pParams = ParameterManager::getManager().lock();
+  if( pParams ){
+    std::string scheduling = pParams->getParameter( keyPrefix + ".scheduling", "default" );
+    policy.scheduling = ( scheduling == "fifo" ) ? SCHEDULING_FIFO : ( scheduling == "rr" ) ? SCHEDULING_RR : SCHEDULING_DEFAULT;
+    policy.priority = pParams->getParameterInt( keyPrefix + ".priority", 0 );
+    StringTokenizer tok( pParams->getParameter( keyPrefix + ".affinity", "" ), "," );
+    while( tok.hasNext() ){
+      std::string cpu = tok.getNext();
+      try {
+        policy.cpus.push_back( std::stoi( cpu ) );
+      } catch (const std::invalid_argument& e) {
+      } catch (const std::out_of_range& e) {
+      }
+    }
+    policy.bLockMemory = pParams->getParameterBool( keyPrefix + ".mlock", false );
+  }
+
+  return policy;
+}
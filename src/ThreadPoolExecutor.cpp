@@ -0,0 +1,124 @@
+/* 
+  Copyright (C) 2021 hidenorly
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "ThreadPoolExecutor.hpp"
+#include "ThreadBase.hpp"
+#include <algorithm>
+#include <chrono>
+
+// the pool and the index of the worker which is running on the current thread
+static thread_local ThreadPoolExecutor* gpCurrentExecutor = nullptr;
+static thread_local int gCurrentWorkerIndex = -1;
+
+ThreadPoolExecutor::ThreadPoolExecutor(int nThreads):mPendingTasks(0), mRoundRobin(0), mbStopping(false)
+{
+  if( nThreads <= 0 ){
+    nThreads = std::max( (int)std::thread::hardware_concurrency(), 1 );
+  }
+  for( int i=0; i<nThreads; i++ ){
+    mWorkers.push_back( std::make_shared<Worker>() );
+  }
+  for( int i=0; i<nThreads; i++ ){
+    mThreads.push_back( std::thread( &ThreadPoolExecutor::workerLoop, this, i ) );
+  }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutexIdle);
+    mbStopping = true;
+    mIdleEvent.notify_all();
+  }
+  for( auto& aThread : mThreads ){
+    if( aThread.joinable() ){
+      aThread.join();
+    }
+  }
+}
+
+int ThreadPoolExecutor::getCurrentWorkerIndex(void)
+{
+  return ( gpCurrentExecutor == this ) ? gCurrentWorkerIndex : -1;
+}
+
+void ThreadPoolExecutor::execute(TASK task)
+{
+  int nIndex = getCurrentWorkerIndex();
+  if( nIndex < 0 ){
+    nIndex = (unsigned int)mRoundRobin.fetch_add( 1 ) % mWorkers.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock( mWorkers[nIndex]->mMutex );
+    mWorkers[nIndex]->mTasks.push_back( task );
+  }
+  mPendingTasks.fetch_add( 1 );
+  std::lock_guard<std::mutex> lock(mMutexIdle);
+  mIdleEvent.notify_one();
+}
+
+bool ThreadPoolExecutor::popTask(int nIndex, TASK& task)
+{
+  // own queue first
+  {
+    std::lock_guard<std::mutex> lock( mWorkers[nIndex]->mMutex );
+    if( !mWorkers[nIndex]->mTasks.empty() ){
+      task = std::move( mWorkers[nIndex]->mTasks.front() );
+      mWorkers[nIndex]->mTasks.pop_front();
+      return true;
+    }
+  }
+  // steal from the others
+  int nWorkers = mWorkers.size();
+  for( int i=1; i<nWorkers; i++ ){
+    std::shared_ptr<Worker> pVictim = mWorkers[ (nIndex + i) % nWorkers ];
+    std::lock_guard<std::mutex> lock( pVictim->mMutex );
+    if( !pVictim->mTasks.empty() ){
+      task = std::move( pVictim->mTasks.back() );
+      pVictim->mTasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPoolExecutor::workerLoop(int nIndex)
+{
+  gpCurrentExecutor = this;
+  gCurrentWorkerIndex = nIndex;
+  ThreadBase::getDefaultThreadPolicy().apply();
+
+  while( !mbStopping ){
+    TASK task;
+    if( popTask( nIndex, task ) ){
+      mPendingTasks.fetch_sub( 1 );
+      task();
+    } else {
+      std::unique_lock<std::mutex> lock(mMutexIdle);
+      // execute() counts the task up before notifying under mMutexIdle then the untimed wait can't miss it
+      mIdleEvent.wait( lock, [&]{ return mbStopping || mPendingTasks > 0; } );
+    }
+  }
+
+  gpCurrentExecutor = nullptr;
+  gCurrentWorkerIndex = -1;
+}
+
+std::shared_ptr<ThreadPoolExecutor> ThreadPoolExecutor::getDefaultExecutor(void)
+{
+  static std::shared_ptr<ThreadPoolExecutor> pExecutor = std::make_shared<ThreadPoolExecutor>();
+  return pExecutor;
+}
@@ -21,6 +21,11 @@
 #include <cassert>
 
 bool Volume::process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, std::vector<float> channelVolumes )
+{
+  return process( pInBuf, pOutBuf, channelVolumes, channelVolumes );
+}
+
+bool Volume::process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, const std::vector<float>& startVolumes, const std::vector<float>& endVolumes )
 {
   bool bHandled = false;
 
@@ -32,7 +37,7 @@ bool Volume::process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, std::vector<flo
     AudioFormat srcFormat = pInBuf->getAudioFormat();
     AudioFormat dstFormat = pOutBuf->getAudioFormat();
     if( srcFormat.equal(dstFormat) ){
-      if( isVolumeRequired( channelVolumes ) ){
+      if( isVolumeRequired( startVolumes ) || isVolumeRequired( endVolumes ) ){
         int nChannelSamples = nSamples * dstFormat.getNumberOfChannels();
 
         int8_t* pRawInBuf = reinterpret_cast<int8_t*>( pInBuf->getRawBufferPointer() );
@@ -40,19 +45,19 @@ bool Volume::process( AudioBuffer* pInBuf, AudioBuffer* pOutBuf, std::vector<flo
 
         switch( dstFormat.getEncoding() ){
           case AudioFormat::ENCODING::PCM_8BIT:
-            bHandled = VolumePrimitive::volume( pRawInBuf, pRawOutBuf, channelVolumes, nChannelSamples );
+            bHandled = VolumePrimitive::volume( pRawInBuf, pRawOutBuf, startVolumes, endVolumes, nChannelSamples );
             break;
           case AudioFormat::ENCODING::PCM_16BIT:
-            bHandled = VolumePrimitive::volume( reinterpret_cast<int16_t*>(pRawInBuf), reinterpret_cast<int16_t*>(pRawOutBuf), channelVolumes, nChannelSamples );
+            bHandled = VolumePrimitive::volume( reinterpret_cast<int16_t*>(pRawInBuf), reinterpret_cast<int16_t*>(pRawOutBuf), startVolumes, endVolumes, nChannelSamples );
             break;
           case AudioFormat::ENCODING::PCM_32BIT:
-            bHandled = VolumePrimitive::volume( reinterpret_cast<int32_t*>(pRawInBuf), reinterpret_cast<int32_t*>(pRawOutBuf), channelVolumes, nChannelSamples );
+            bHandled = VolumePrimitive::volume( reinterpret_cast<int32_t*>(pRawInBuf), reinterpret_cast<int32_t*>(pRawOutBuf), startVolumes, endVolumes, nChannelSamples );
             break;
           case AudioFormat::ENCODING::PCM_FLOAT:
-            bHandled = VolumePrimitive::volume( reinterpret_cast<float*>(pRawInBuf), reinterpret_cast<float*>(pRawOutBuf), channelVolumes, nChannelSamples );
+            bHandled = VolumePrimitive::volume( reinterpret_cast<float*>(pRawInBuf), reinterpret_cast<float*>(pRawOutBuf), startVolumes, endVolumes, nChannelSamples );
             break;
           case AudioFormat::ENCODING::PCM_24BIT_PACKED:
-            bHandled = VolumePrimitive::volume24( pRawInBuf, pRawOutBuf, channelVolumes, nChannelSamples );
+            bHandled = VolumePrimitive::volume24( pRawInBuf, pRawOutBuf, startVolumes, endVolumes, nChannelSamples );
             break;
           case AudioFormat::ENCODING::PCM_UNKNOWN:
           default:
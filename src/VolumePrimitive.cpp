@@ -1,4 +1,4 @@
-/*
+/* 
   Copyright (C) 2021 hidenorly
 
    Licensed under the Apache License, Version 2.0 (the "License");
@@ -23,61 +23,435 @@
 #if USE_TINY_VOLUME_PRIMITIVE_IMPL
 
 #include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <atomic>
 
-bool VolumePrimitive::volume(int8_t* pRawInBuf, int8_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples)
+#ifndef USE_VOLUME_PRIMITIVE_SIMD
+  #define USE_VOLUME_PRIMITIVE_SIMD 1
+#endif /* USE_VOLUME_PRIMITIVE_SIMD */
+
+#if USE_VOLUME_PRIMITIVE_SIMD && ( defined(__x86_64__) || defined(__i386__) )
+  #define VOLUME_PRIMITIVE_X86_SIMD 1
+  #include <immintrin.h>
+#else
+  #define VOLUME_PRIMITIVE_X86_SIMD 0
+#endif
+
+// the largest float which is less than 2^31
+static constexpr float INT32_MAX_FLOAT = 2147483520.0f;
+
+// the interleaved gains for GAIN_PATTERN_FRAMES frames. the pattern size is the multiple of the vector width.
+static constexpr int GAIN_PATTERN_FRAMES = 8;
+static constexpr int MAX_CHANNELS = 32;
+
+struct GainPattern
 {
-  int nChannels = volumes.size();
-  for(int i=0; i<nChannelSamples; i++){
-    int16_t volumed = ((float)(*pRawInBuf++) * volumes[i % nChannels] / 100.0f);
-    *pRawOutBuf++ = (int8_t)(std::max<int16_t>(INT8_MIN, std::min<int16_t>(volumed, INT8_MAX)));
+  alignas(32) float gains[GAIN_PATTERN_FRAMES * MAX_CHANNELS];
+  // added to gains for the next GAIN_PATTERN_FRAMES frames
+  alignas(32) float deltas[GAIN_PATTERN_FRAMES * MAX_CHANNELS];
+  int nSize;
+
+  void next(void){
+    for(int i=0; i<nSize; i++){
+      gains[i] += deltas[i];
+    }
   }
-  return true;
+};
+
+static bool prepareGainPattern(GainPattern& pattern, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples)
+{
+  int nChannels = startVolumes.size();
+  bool bResult = nChannels && ( nChannels <= MAX_CHANNELS ) && ( endVolumes.size() == startVolumes.size() );
+
+  if( bResult ){
+    int nFrames = std::max( 1, nChannelSamples / nChannels );
+    pattern.nSize = nChannels * GAIN_PATTERN_FRAMES;
+    for(int ch=0; ch<nChannels; ch++){
+      float startGain = startVolumes[ch] / 100.0f;
+      float slope = ( endVolumes[ch] - startVolumes[ch] ) / 100.0f / nFrames;
+      for(int frame=0; frame<GAIN_PATTERN_FRAMES; frame++){
+        pattern.gains[ frame * nChannels + ch ] = startGain + slope * frame;
+        pattern.deltas[ frame * nChannels + ch ] = slope * GAIN_PATTERN_FRAMES;
+      }
+    }
+  }
+
+  return bResult;
 }
 
-bool VolumePrimitive::volume(int16_t* pRawInBuf, int16_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples)
+struct VolumeKernels
 {
-  int nChannels = volumes.size();
+  VolumePrimitive::SIMD simd;
+  void (*volume8)(const int8_t* pIn, int8_t* pOut, GainPattern& pattern, int nChannelSamples);
+  void (*volume16)(const int16_t* pIn, int16_t* pOut, GainPattern& pattern, int nChannelSamples);
+  void (*volume32)(const int32_t* pIn, int32_t* pOut, GainPattern& pattern, int nChannelSamples);
+  void (*volumeFloat)(const float* pIn, float* pOut, GainPattern& pattern, int nChannelSamples);
+  void (*volume24)(const int8_t* pIn, int8_t* pOut, GainPattern& pattern, int nChannelSamples);
+};
 
-  for(int i=0; i<nChannelSamples; i++){
-    int32_t volumed = ((float)(*pRawInBuf++) * volumes[i % nChannels] / 100.0f);
-    *pRawOutBuf++ = (int16_t)(std::max<int32_t>(INT16_MIN, std::min<int32_t>(volumed, INT16_MAX)));
+
+// --- scalar (fallback and the tail of the vector kernels)
+template <typename T>
+static inline T applyGain(T in, float gain, float min, float max)
+{
+  return (T)std::max<float>( min, std::min<float>( (float)in * gain, max ) );
+}
+
+template <typename T>
+static inline void volumeScalar(const T* pIn, T* pOut, GainPattern& pattern, int nChannelSamples, float min, float max)
+{
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    for(int j=0, n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<T>( pIn[i+j], pattern.gains[j], min, max );
+    }
+    pattern.next();
   }
-  return true;
 }
 
-bool VolumePrimitive::volume(int32_t* pRawInBuf, int32_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples)
+static void volume8Scalar(const int8_t* pIn, int8_t* pOut, GainPattern& pattern, int nChannelSamples)
 {
-  int nChannels = volumes.size();
-  for(int i=0; i<nChannelSamples; i++){
-    float volumed = ((float)(*pRawInBuf++) * volumes[i % nChannels] / 100.0f);
-    *pRawOutBuf++ = (int32_t)(std::max<float>((float)INT32_MIN, std::min<float>(volumed, (float)INT32_MAX)));
+  volumeScalar<int8_t>( pIn, pOut, pattern, nChannelSamples, INT8_MIN, INT8_MAX );
+}
+
+static void volume16Scalar(const int16_t* pIn, int16_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  volumeScalar<int16_t>( pIn, pOut, pattern, nChannelSamples, INT16_MIN, INT16_MAX );
+}
+
+static void volume32Scalar(const int32_t* pIn, int32_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  volumeScalar<int32_t>( pIn, pOut, pattern, nChannelSamples, (float)INT32_MIN, INT32_MAX_FLOAT );
+}
+
+static void volumeFloatScalar(const float* pIn, float* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  volumeScalar<float>( pIn, pOut, pattern, nChannelSamples, -1.0f, 1.0f );
+}
+
+static void volume24Scalar(const int8_t* pIn, int8_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const uint8_t* pSrc = reinterpret_cast<const uint8_t*>(pIn);
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    for(int j=0, n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      const uint8_t* pSample = pSrc + (i+j)*3;
+      int32_t sample = ((int32_t)( ( (uint32_t)pSample[0] | ((uint32_t)pSample[1] << 8) | ((uint32_t)pSample[2] << 16) ) << 8 )) >> 8;
+      int32_t volumed = applyGain<int32_t>( sample, pattern.gains[j], -8388608.0f, 8388607.0f );
+      int8_t* pDst = pOut + (i+j)*3;
+      pDst[0] = volumed & 0xFF;
+      pDst[1] = (volumed >> 8) & 0xFF;
+      pDst[2] = (volumed >> 16) & 0xFF;
+    }
+    pattern.next();
   }
-  return true;
 }
 
-bool VolumePrimitive::volume(float* pRawInBuf, float* pRawOutBuf, std::vector<float> volumes, int nChannelSamples)
+static const VolumeKernels gScalarKernels = { VolumePrimitive::SIMD::SCALAR, volume8Scalar, volume16Scalar, volume32Scalar, volumeFloatScalar, volume24Scalar };
+
+
+#if VOLUME_PRIMITIVE_X86_SIMD
+// --- SSE2 : 4 channel samples per vector
+__attribute__((target("sse2")))
+static inline __m128 applyGainSse2(__m128 in, const float* pGains, __m128 min, __m128 max)
 {
-  int nChannels = volumes.size();
-  for(int i=0; i<nChannelSamples; i++){
-    float volumed = ((float)(*pRawInBuf++) * volumes[i % nChannels] / 100.0f);
-    *pRawOutBuf++ = std::max<float>(-1.0f, std::min<float>(volumed, 1.0f));
+  return _mm_max_ps( _mm_min_ps( _mm_mul_ps( in, _mm_load_ps( pGains ) ), max ), min );
+}
+
+__attribute__((target("sse2")))
+static void volume8Sse2(const int8_t* pIn, int8_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const __m128 min = _mm_set1_ps( INT8_MIN );
+  const __m128 max = _mm_set1_ps( INT8_MAX );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+4<=n; j+=4){
+      int32_t packed;
+      memcpy( &packed, pIn+i+j, sizeof(int32_t) );
+      __m128i in = _mm_cvtsi32_si128( packed );
+      in = _mm_unpacklo_epi8( in, in );
+      in = _mm_srai_epi32( _mm_unpacklo_epi16( in, in ), 24 );
+      __m128i out = _mm_cvttps_epi32( applyGainSse2( _mm_cvtepi32_ps( in ), pattern.gains + j, min, max ) );
+      out = _mm_packs_epi16( _mm_packs_epi32( out, out ), out );
+      packed = _mm_cvtsi128_si32( out );
+      memcpy( pOut+i+j, &packed, sizeof(int32_t) );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<int8_t>( pIn[i+j], pattern.gains[j], INT8_MIN, INT8_MAX );
+    }
+    pattern.next();
+  }
+}
+
+__attribute__((target("sse2")))
+static void volume16Sse2(const int16_t* pIn, int16_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const __m128 min = _mm_set1_ps( INT16_MIN );
+  const __m128 max = _mm_set1_ps( INT16_MAX );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+4<=n; j+=4){
+      __m128i in = _mm_loadl_epi64( reinterpret_cast<const __m128i*>(pIn+i+j) );
+      in = _mm_srai_epi32( _mm_unpacklo_epi16( in, in ), 16 );
+      __m128i out = _mm_cvttps_epi32( applyGainSse2( _mm_cvtepi32_ps( in ), pattern.gains + j, min, max ) );
+      _mm_storel_epi64( reinterpret_cast<__m128i*>(pOut+i+j), _mm_packs_epi32( out, out ) );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<int16_t>( pIn[i+j], pattern.gains[j], INT16_MIN, INT16_MAX );
+    }
+    pattern.next();
   }
-  return true;
 }
 
-bool VolumePrimitive::volume24(int8_t* pRawInBuf, int8_t* pRawOutBuf, std::vector<float> volumes, int nChannelSamples)
+__attribute__((target("sse2")))
+static void volume32Sse2(const int32_t* pIn, int32_t* pOut, GainPattern& pattern, int nChannelSamples)
 {
-  int nChannels = volumes.size();
-  for(int i=0; i<nChannelSamples; i++){
-    float volumed =  ((float)((int32_t)(*pRawInBuf) + (int32_t)(*(pRawInBuf+1) << 8) + (int32_t)(*(pRawInBuf+2) << 16)) * volumes[i % nChannels] / 100.0f);
-    int32_t tmp = (int32_t)(std::max<float>(-8388608.0f, std::min<float>(volumed, 8388607.0f)));
-    *pRawOutBuf++ = tmp & 0xFF;
-    *pRawOutBuf++ = (tmp & 0xFF00) >> 8;
-    *pRawOutBuf++ = (tmp & 0xFF0000) >> 16;
-    pRawInBuf = pRawInBuf + 3;
+  const __m128 min = _mm_set1_ps( (float)INT32_MIN );
+  const __m128 max = _mm_set1_ps( INT32_MAX_FLOAT );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+4<=n; j+=4){
+      __m128i in = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn+i+j) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i+j), _mm_cvttps_epi32( applyGainSse2( _mm_cvtepi32_ps( in ), pattern.gains + j, min, max ) ) );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<int32_t>( pIn[i+j], pattern.gains[j], (float)INT32_MIN, INT32_MAX_FLOAT );
+    }
+    pattern.next();
   }
-  return true;
 }
 
-#endif /* USE_TINY_VOLUME_PRIMITIVE_IMPL */
\ No newline at end of file
+__attribute__((target("sse2")))
+static void volumeFloatSse2(const float* pIn, float* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const __m128 min = _mm_set1_ps( -1.0f );
+  const __m128 max = _mm_set1_ps( 1.0f );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+4<=n; j+=4){
+      _mm_storeu_ps( pOut+i+j, applyGainSse2( _mm_loadu_ps( pIn+i+j ), pattern.gains + j, min, max ) );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<float>( pIn[i+j], pattern.gains[j], -1.0f, 1.0f );
+    }
+    pattern.next();
+  }
+}
+
+static const VolumeKernels gSse2Kernels = { VolumePrimitive::SIMD::SSE2, volume8Sse2, volume16Sse2, volume32Sse2, volumeFloatSse2, volume24Scalar };
+
+
+// --- AVX2 : 8 channel samples per vector
+__attribute__((target("avx2")))
+static inline __m256 applyGainAvx2(__m256 in, const float* pGains, __m256 min, __m256 max)
+{
+  return _mm256_max_ps( _mm256_min_ps( _mm256_mul_ps( in, _mm256_load_ps( pGains ) ), max ), min );
+}
+
+__attribute__((target("avx2")))
+static inline __m128i packToInt16Avx2(__m256i in)
+{
+  // packs works per 128bit lane then gather the lower halves
+  return _mm256_castsi256_si128( _mm256_permute4x64_epi64( _mm256_packs_epi32( in, in ), 0x08 ) );
+}
+
+__attribute__((target("avx2")))
+static void volume8Avx2(const int8_t* pIn, int8_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const __m256 min = _mm256_set1_ps( INT8_MIN );
+  const __m256 max = _mm256_set1_ps( INT8_MAX );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+8<=n; j+=8){
+      __m256i in = _mm256_cvtepi8_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i*>(pIn+i+j) ) );
+      __m128i out = packToInt16Avx2( _mm256_cvttps_epi32( applyGainAvx2( _mm256_cvtepi32_ps( in ), pattern.gains + j, min, max ) ) );
+      _mm_storel_epi64( reinterpret_cast<__m128i*>(pOut+i+j), _mm_packs_epi16( out, out ) );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<int8_t>( pIn[i+j], pattern.gains[j], INT8_MIN, INT8_MAX );
+    }
+    pattern.next();
+  }
+}
+
+__attribute__((target("avx2")))
+static void volume16Avx2(const int16_t* pIn, int16_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const __m256 min = _mm256_set1_ps( INT16_MIN );
+  const __m256 max = _mm256_set1_ps( INT16_MAX );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+8<=n; j+=8){
+      __m256i in = _mm256_cvtepi16_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn+i+j) ) );
+      __m128i out = packToInt16Avx2( _mm256_cvttps_epi32( applyGainAvx2( _mm256_cvtepi32_ps( in ), pattern.gains + j, min, max ) ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut+i+j), out );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<int16_t>( pIn[i+j], pattern.gains[j], INT16_MIN, INT16_MAX );
+    }
+    pattern.next();
+  }
+}
+
+__attribute__((target("avx2")))
+static void volume32Avx2(const int32_t* pIn, int32_t* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const __m256 min = _mm256_set1_ps( (float)INT32_MIN );
+  const __m256 max = _mm256_set1_ps( INT32_MAX_FLOAT );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+8<=n; j+=8){
+      __m256i in = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pIn+i+j) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>(pOut+i+j), _mm256_cvttps_epi32( applyGainAvx2( _mm256_cvtepi32_ps( in ), pattern.gains + j, min, max ) ) );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<int32_t>( pIn[i+j], pattern.gains[j], (float)INT32_MIN, INT32_MAX_FLOAT );
+    }
+    pattern.next();
+  }
+}
+
+__attribute__((target("avx2")))
+static void volumeFloatAvx2(const float* pIn, float* pOut, GainPattern& pattern, int nChannelSamples)
+{
+  const __m256 min = _mm256_set1_ps( -1.0f );
+  const __m256 max = _mm256_set1_ps( 1.0f );
+  for(int i=0; i<nChannelSamples; i+=pattern.nSize){
+    int j = 0;
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j+8<=n; j+=8){
+      _mm256_storeu_ps( pOut+i+j, applyGainAvx2( _mm256_loadu_ps( pIn+i+j ), pattern.gains + j, min, max ) );
+    }
+    for(int n=std::min( pattern.nSize, nChannelSamples-i ); j<n; j++){
+      pOut[i+j] = applyGain<float>( pIn[i+j], pattern.gains[j], -1.0f, 1.0f );
+    }
+    pattern.next();
+  }
+}
+
+static const VolumeKernels gAvx2Kernels = { VolumePrimitive::SIMD::AVX2, volume8Avx2, volume16Avx2, volume32Avx2, volumeFloatAvx2, volume24Scalar };
+#endif /* VOLUME_PRIMITIVE_X86_SIMD */
+
+
+static const VolumeKernels* getKernelsFor(VolumePrimitive::SIMD simd)
+{
+  const VolumeKernels* pKernels = nullptr;
+  if( CpuFeature::isSimdSupported( simd ) ){
+    switch( simd ){
+      case VolumePrimitive::SIMD::SCALAR:
+        pKernels = &gScalarKernels;
+        break;
+#if VOLUME_PRIMITIVE_X86_SIMD
+      case VolumePrimitive::SIMD::SSE2:
+        pKernels = &gSse2Kernels;
+        break;
+      case VolumePrimitive::SIMD::AVX2:
+        pKernels = &gAvx2Kernels;
+        break;
+#endif /* VOLUME_PRIMITIVE_X86_SIMD */
+      default:
+        break;
+    }
+  }
+  return pKernels;
+}
+
+static std::atomic<const VolumeKernels*>& getKernels(void)
+{
+  // the best kernel set is chosen once by the cpu feature detection
+  static std::atomic<const VolumeKernels*> kernels = []{
+    const VolumeKernels* pKernels = getKernelsFor( CpuFeature::getSimd() );
+    return pKernels ? pKernels : &gScalarKernels;
+  }();
+  return kernels;
+}
+
+VolumePrimitive::SIMD VolumePrimitive::getSimd(void)
+{
+  return getKernels().load( std::memory_order_relaxed )->simd;
+}
+
+bool VolumePrimitive::setSimd(SIMD simd)
+{
+  const VolumeKernels* pKernels = getKernelsFor( simd );
+  if( pKernels ){
+    getKernels().store( pKernels, std::memory_order_relaxed );
+  }
+  return pKernels != nullptr;
+}
+
+
+bool VolumePrimitive::volume(const int8_t* pRawInBuf, int8_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples)
+{
+  GainPattern pattern;
+  bool bResult = prepareGainPattern( pattern, startVolumes, endVolumes, nChannelSamples );
+  if( bResult ){
+    getKernels().load( std::memory_order_relaxed )->volume8( pRawInBuf, pRawOutBuf, pattern, nChannelSamples );
+  }
+  return bResult;
+}
+
+bool VolumePrimitive::volume(const int16_t* pRawInBuf, int16_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples)
+{
+  GainPattern pattern;
+  bool bResult = prepareGainPattern( pattern, startVolumes, endVolumes, nChannelSamples );
+  if( bResult ){
+    getKernels().load( std::memory_order_relaxed )->volume16( pRawInBuf, pRawOutBuf, pattern, nChannelSamples );
+  }
+  return bResult;
+}
+
+bool VolumePrimitive::volume(const int32_t* pRawInBuf, int32_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples)
+{
+  GainPattern pattern;
+  bool bResult = prepareGainPattern( pattern, startVolumes, endVolumes, nChannelSamples );
+  if( bResult ){
+    getKernels().load( std::memory_order_relaxed )->volume32( pRawInBuf, pRawOutBuf, pattern, nChannelSamples );
+  }
+  return bResult;
+}
+
+bool VolumePrimitive::volume(const float* pRawInBuf, float* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples)
+{
+  GainPattern pattern;
+  bool bResult = prepareGainPattern( pattern, startVolumes, endVolumes, nChannelSamples );
+  if( bResult ){
+    getKernels().load( std::memory_order_relaxed )->volumeFloat( pRawInBuf, pRawOutBuf, pattern, nChannelSamples );
+  }
+  return bResult;
+}
+
+bool VolumePrimitive::volume24(const int8_t* pRawInBuf, int8_t* pRawOutBuf, std::span<const float> startVolumes, std::span<const float> endVolumes, int nChannelSamples)
+{
+  GainPattern pattern;
+  bool bResult = prepareGainPattern( pattern, startVolumes, endVolumes, nChannelSamples );
+  if( bResult ){
+    getKernels().load( std::memory_order_relaxed )->volume24( pRawInBuf, pRawOutBuf, pattern, nChannelSamples );
+  }
+  return bResult;
+}
+
+bool VolumePrimitive::volume(int8_t* pRawInBuf, int8_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples)
+{
+  return volume( pRawInBuf, pRawOutBuf, volumes, volumes, nChannelSamples );
+}
+
+bool VolumePrimitive::volume(int16_t* pRawInBuf, int16_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples)
+{
+  return volume( pRawInBuf, pRawOutBuf, volumes, volumes, nChannelSamples );
+}
+
+bool VolumePrimitive::volume(int32_t* pRawInBuf, int32_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples)
+{
+  return volume( pRawInBuf, pRawOutBuf, volumes, volumes, nChannelSamples );
+}
+
+bool VolumePrimitive::volume(float* pRawInBuf, float* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples)
+{
+  return volume( pRawInBuf, pRawOutBuf, volumes, volumes, nChannelSamples );
+}
+
+bool VolumePrimitive::volume24(int8_t* pRawInBuf, int8_t* pRawOutBuf, const std::vector<float>& volumes, int nChannelSamples)
+{
+  return volume24( pRawInBuf, pRawOutBuf, volumes, volumes, nChannelSamples );
+}
+
+#endif /* USE_TINY_VOLUME_PRIMITIVE_IMPL */
@@ -29,8 +29,16 @@
 #include "AudioFormatAdaptor.hpp"
 #include "FilterExample.hpp"
 #include "FifoBuffer.hpp"
+#include "AudioBufferPool.hpp"
+#include "MixerPrimitive.hpp"
+#include "VolumePrimitive.hpp"
+#include "PcmFormatConversionPrimitives.hpp"
+#include "PcmSamplingRateConversionPrimitives.hpp"
+#include "ChannelConversionPrimitives.hpp"
 #include "InterPipeBridge.hpp"
 #include "PipeMultiThread.hpp"
+#include "ThreadPoolExecutor.hpp"
+#include "PullScheduler.hpp"
 #include "MultipleSink.hpp"
 #include "Stream.hpp"
 #include "StreamSink.hpp"
@@ -60,12 +68,16 @@
 #include "ReferenceSoundSinkSource.hpp"
 #include "ChannelDemultiplexer.hpp"
 #include "ChannelMultiplexer.hpp"
+#include "ChannelParallelFilter.hpp"
+#include "BlockSizeAdapterFilter.hpp"
+#include "GraphPipe.hpp"
 
 #include <iostream>
 #include <filesystem>
 #include <chrono>
 #include <memory>
 #include <cmath>
+#include <set>
 
 class TestSink : public Sink
 {
@@ -100,6 +100,167 @@ TEST_F(TestCase_PipeAndFilter, testAttachSourceSinkToPipe)
   pPipe->clearFilters();
 }
 
+class FilterCounter : public Filter
+{
+public:
+  std::atomic<int> mCount;
+  FilterCounter() : mCount(0){};
+  virtual ~FilterCounter(){};
+  virtual void process(AudioBuffer& inBuf, AudioBuffer& outBuf){ mCount++; outBuf = inBuf; };
+};
+
+TEST_F(TestCase_PipeAndFilter, testPipeFilterHotSwap)
+{
+  // Signal flow : Source -> Pipe(->FilterCounter->) -> Sink while the filters are added and removed
+  std::unique_ptr<IPipe> pPipe = std::make_unique<Pipe>();
+  pPipe->attachSource( std::make_shared<Source>() );
+  pPipe->attachSink( std::make_shared<Sink>() );
+  pPipe->run();
+
+  std::shared_ptr<FilterCounter> pCounter = std::make_shared<FilterCounter>();
+  pPipe->addFilterToTail( pCounter );
+  for(int i=0; i<1000 && !pCounter->mCount; i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  EXPECT_GT( pCounter->mCount, 0 );
+
+  // the running pipe picks up the every update
+  for(int i=0; i<100; i++){
+    std::shared_ptr<IFilter> pFilter = std::make_shared<Filter>();
+    pPipe->addFilterToHead( pFilter );
+    EXPECT_TRUE( pPipe->addFilterAfterFilter( std::make_shared<Filter>(), pFilter ) );
+    EXPECT_TRUE( pPipe->removeFilter( pFilter ) );
+    EXPECT_FALSE( pPipe->removeFilter( pFilter ) );
+  }
+  EXPECT_TRUE( pPipe->isFilterIncluded( pCounter ) );
+
+  // the removed filter isn't used after the window boundary
+  EXPECT_TRUE( pPipe->removeFilter( pCounter ) );
+  std::this_thread::sleep_for(std::chrono::microseconds(20000));
+  int nCount = pCounter->mCount;
+  std::this_thread::sleep_for(std::chrono::microseconds(20000));
+  EXPECT_EQ( nCount, pCounter->mCount );
+  EXPECT_TRUE( pPipe->isRunning() );
+
+  pPipe->stop();
+  pPipe->clearFilters();
+}
+
+TEST_F(TestCase_PipeAndFilter, testPipeIoPipelining)
+{
+  // Signal flow : SlowSource -> Pipe(->SlowFilter->) -> SlowSink. Each of them takes 2msec per window.
+  class SlowSource : public Source
+  {
+  protected:
+    virtual void readPrimitive(IAudioBuffer& buf){ std::this_thread::sleep_for(std::chrono::microseconds(2000)); Source::readPrimitive( buf ); };
+  };
+  class SlowSink : public Sink
+  {
+  protected:
+    virtual void writePrimitive(IAudioBuffer& buf){ std::this_thread::sleep_for(std::chrono::microseconds(2000)); Sink::writePrimitive( buf ); };
+  };
+  class SlowFilter : public FilterCounter
+  {
+  public:
+    virtual void process(AudioBuffer& inBuf, AudioBuffer& outBuf){ std::this_thread::sleep_for(std::chrono::microseconds(2000)); FilterCounter::process( inBuf, outBuf ); };
+  };
+
+  int nCounts[2] = {0};
+  for( int i=0; i<2; i++ ){
+    bool bIoPipelining = ( i == 1 );
+    std::shared_ptr<Pipe> pPipe = std::make_shared<Pipe>();
+    std::shared_ptr<SlowFilter> pFilter = std::make_shared<SlowFilter>();
+    pPipe->attachSource( std::make_shared<SlowSource>() );
+    pPipe->attachSink( std::make_shared<SlowSink>() );
+    pPipe->addFilterToTail( pFilter );
+    int nLatency = pPipe->getLatencyUSec();
+    pPipe->setIoPipeliningEnabled( bIoPipelining );
+    EXPECT_EQ( bIoPipelining, pPipe->getIoPipeliningEnabled() );
+    // the read-ahead and the write-behind add the windows
+    EXPECT_EQ( nLatency + ( bIoPipelining ? pPipe->getWindowSizeUsec() * Pipe::IO_PIPELINING_DEPTH : 0 ), pPipe->getLatencyUSec() );
+
+    pPipe->run();
+    std::this_thread::sleep_for(std::chrono::microseconds(200000));
+    nCounts[i] = pFilter->mCount;
+    pPipe->stop();
+    EXPECT_FALSE( pPipe->isRunning() );
+    pPipe->clearFilters();
+  }
+  std::cout << "serial:" << nCounts[0] << " windows, pipelined:" << nCounts[1] << " windows" << std::endl;
+  EXPECT_GT( nCounts[0], 0 );
+  EXPECT_GT( nCounts[1], nCounts[0] );
+}
+
+TEST_F(TestCase_PipeAndFilter, testPipeIoPipeliningWindowChange)
+{
+  // Signal flow : SequenceSource -> Pipe(->FilterCounter->(Filter10ms)->) -> SequenceCheckSink with the I/O pipelining
+  // the read-ahead windows should be processed by the previous filters when the window size is changed
+  class SequenceSource : public Source
+  {
+  protected:
+    int16_t mValue;
+    virtual void readPrimitive(IAudioBuffer& buf){
+      int16_t* pData = reinterpret_cast<int16_t*>( buf.getRawBufferPointer() );
+      int nSamples = buf.getRawBufferSize() / sizeof(int16_t);
+      for( int i=0; i<nSamples; i++ ){
+        pData[i] = mValue++;
+      }
+    };
+  public:
+    SequenceSource():Source(), mValue(0){};
+  };
+  class SequenceCheckSink : public Sink
+  {
+  protected:
+    int16_t mExpected;
+    virtual void writePrimitive(IAudioBuffer& buf){
+      int16_t* pData = reinterpret_cast<int16_t*>( buf.getRawBufferPointer() );
+      int nSamples = buf.getRawBufferSize() / sizeof(int16_t);
+      for( int i=0; i<nSamples; i++ ){
+        if( pData[i] != mExpected ){
+          mDiscontinuities++;
+        }
+        mExpected = pData[i] + 1;
+      }
+      mSamples += nSamples;
+    };
+  public:
+    std::atomic<int> mDiscontinuities;
+    std::atomic<int> mSamples;
+    SequenceCheckSink():Sink(), mExpected(0), mDiscontinuities(0), mSamples(0){};
+  };
+  class Filter10ms : public FilterCounter
+  {
+  public:
+    virtual int getRequiredWindowSizeUsec(void){ return 10000; };
+  };
+
+  std::shared_ptr<Pipe> pPipe = std::make_shared<Pipe>();
+  std::shared_ptr<SequenceCheckSink> pSink = std::make_shared<SequenceCheckSink>();
+  pPipe->attachSource( std::make_shared<SequenceSource>() );
+  pPipe->attachSink( pSink );
+  pPipe->addFilterToTail( std::make_shared<FilterCounter>() );
+  pPipe->setIoPipeliningEnabled( true );
+  pPipe->run();
+
+  std::shared_ptr<Filter10ms> pFilter10ms = std::make_shared<Filter10ms>();
+  for( int i=0; i<4; i++ ){
+    std::this_thread::sleep_for(std::chrono::microseconds(10000));
+    if( i % 2 ){
+      pPipe->removeFilter( pFilter10ms );
+    } else {
+      pPipe->addFilterToTail( pFilter10ms );
+    }
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(10000));
+  pPipe->stop();
+  EXPECT_FALSE( pPipe->isRunning() );
+
+  EXPECT_GT( pSink->mSamples, 0 );
+  EXPECT_EQ( 0, pSink->mDiscontinuities );
+  pPipe->clearFilters();
+}
+
 TEST_F(TestCase_PipeAndFilter, testInterPipeBridge)
 {
   // Signal flow
@@ -163,6 +324,62 @@ TEST_F(TestCase_PipeAndFilter, testInterPipeBridge)
   pPipe2->clearFilters();
 }
 
+TEST_F(TestCase_PipeAndFilter, testPipeExecutor)
+{
+  // Signal flow : Source -> Pipe1(->FilterCounter->) -> <InterPipeBridge> -> Pipe2(->FilterCounter->) -> Sink
+  // the both pipes run on the single worker. Then the blocking read of Pipe2 must be the continuation.
+  std::shared_ptr<ThreadPoolExecutor> pExecutor = std::make_shared<ThreadPoolExecutor>(1);
+  EXPECT_EQ( 1, pExecutor->getNumberOfThreads() );
+
+  std::shared_ptr<InterPipeBridge> interPipe = std::make_shared<InterPipeBridge>( AudioFormat() );
+  std::shared_ptr<FilterCounter> pCounter1 = std::make_shared<FilterCounter>();
+  std::shared_ptr<FilterCounter> pCounter2 = std::make_shared<FilterCounter>();
+
+  std::unique_ptr<IPipe> pPipe1 = std::make_unique<Pipe>();
+  pPipe1->attachSource( std::make_shared<Source>() );
+  pPipe1->attachSink( interPipe );
+  pPipe1->addFilterToTail( pCounter1 );
+  pPipe1->setExecutor( pExecutor );
+
+  std::unique_ptr<IPipe> pPipe2 = std::make_unique<Pipe>();
+  pPipe2->attachSource( interPipe );
+  pPipe2->attachSink( std::make_shared<Sink>() );
+  pPipe2->addFilterToTail( pCounter2 );
+  pPipe2->setExecutor( pExecutor );
+
+  // Pipe2 waits for the data without occupying the worker
+  pPipe2->run();
+  EXPECT_TRUE( pPipe2->isRunning() );
+  std::this_thread::sleep_for(std::chrono::microseconds(10000));
+  EXPECT_EQ( 0, pCounter2->mCount );
+
+  pPipe1->run();
+  EXPECT_TRUE( pPipe1->isRunning() );
+  for(int i=0; i<1000 && pCounter2->mCount < 10; i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  EXPECT_GE( pCounter1->mCount, 10 );
+  EXPECT_GE( pCounter2->mCount, 10 );
+
+  pPipe1->stop();
+  EXPECT_FALSE( pPipe1->isRunning() );
+  pPipe2->stop();
+  EXPECT_FALSE( pPipe2->isRunning() );
+
+  // restart on the executor
+  int nCount = pCounter1->mCount;
+  pPipe1->run();
+  for(int i=0; i<1000 && pCounter1->mCount == nCount; i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  EXPECT_GT( pCounter1->mCount, nCount );
+  pPipe1->stop();
+  EXPECT_FALSE( pPipe1->isRunning() );
+
+  pPipe1->clearFilters();
+  pPipe2->clearFilters();
+}
+
 TEST_F(TestCase_PipeAndFilter, testPipeMultiThread)
 {
   // Signal flow
@@ -209,6 +426,337 @@ TEST_F(TestCase_PipeAndFilter, testPipeMultiThread)
   pPipe->clearFilters();
 }
 
+class FilterCounterWithCost : public FilterCounter
+{
+protected:
+  int mCost;
+  int mWindowSizeUsec;
+public:
+  FilterCounterWithCost(int nCost, int nWindowSizeUsec = DEFAULT_WINDOW_SIZE_USEC) : FilterCounter(), mCost(nCost), mWindowSizeUsec(nWindowSizeUsec){};
+  virtual ~FilterCounterWithCost(){};
+  virtual int stateResourceConsumption(void){ return mCost; };
+  virtual int getRequiredWindowSizeUsec(void){ return mWindowSizeUsec; };
+};
+
+TEST_F(TestCase_PipeAndFilter, testPipeMultiThreadStages)
+{
+  // Signal flow : Source -> PipeMultiThread(->Filter(cost:4)->Filter(1)->Filter(1)->Filter(1)->Filter(1)->Filter(4)->) -> Sink
+  std::shared_ptr<PipeMultiThread> pPipe = std::make_shared<PipeMultiThread>();
+  pPipe->attachSource( std::make_shared<Source>() );
+  pPipe->attachSink( std::make_shared<Sink>() );
+  std::vector<std::shared_ptr<FilterCounterWithCost>> filters;
+  for( auto nCost : { 4, 1, 1, 1, 1, 4 } ){
+    filters.push_back( std::make_shared<FilterCounterWithCost>( nCost ) );
+    pPipe->addFilterToTail( filters.back() );
+  }
+  // same window size then single stage by default
+  EXPECT_EQ( std::vector<int>({12}), pPipe->getStageResourceConsumption() );
+
+  pPipe->setNumberOfStages( 3 );
+  EXPECT_EQ( std::vector<int>({4, 4, 4}), pPipe->getStageResourceConsumption() );
+  pPipe->setNumberOfStages( 2 );
+  EXPECT_EQ( std::vector<int>({6, 6}), pPipe->getStageResourceConsumption() );
+
+  // the window size change is always the boundary
+  std::shared_ptr<FilterCounterWithCost> pFilter10ms = std::make_shared<FilterCounterWithCost>( 1, 10000 );
+  EXPECT_TRUE( pPipe->addFilterAfterFilter( pFilter10ms, filters[0] ) );
+  EXPECT_EQ( std::vector<int>({4, 1, 8}), pPipe->getStageResourceConsumption() );
+  EXPECT_TRUE( pPipe->removeFilter( pFilter10ms ) );
+  EXPECT_EQ( std::vector<int>({6, 6}), pPipe->getStageResourceConsumption() );
+
+  // the audio goes through the all stages
+  pPipe->run();
+  for(int i=0; i<1000 && !filters.back()->mCount; i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  for( auto& pFilter : filters ){
+    EXPECT_GT( pFilter->mCount, 0 );
+  }
+  // re-partition during running
+  pPipe->setNumberOfStages( 3 );
+  EXPECT_TRUE( pPipe->isRunning() );
+  EXPECT_EQ( std::vector<int>({4, 4, 4}), pPipe->getStageResourceConsumption() );
+  pPipe->stop();
+  EXPECT_FALSE( pPipe->isRunning() );
+  pPipe->clearFilters();
+}
+
+TEST_F(TestCase_PipeAndFilter, testBlockSizeAdapterFilter)
+{
+  // 5msec pipe window & 7msec filter : the delay is 7 - gcd(5, 7) = 6msec instead of the 35msec LCM window
+  EXPECT_EQ( 6000, BlockSizeAdapterFilter::getAdditionalLatency( 5000, 7000 ) );
+  EXPECT_EQ( 0, BlockSizeAdapterFilter::getAdditionalLatency( 10000, 5000 ) );
+  EXPECT_EQ( 288, BlockSizeAdapterFilter::getAdditionalLatency( 240, 336 ) );
+
+  std::shared_ptr<FilterCounterWithCost> pFilter7ms = std::make_shared<FilterCounterWithCost>( 1, 7000 );
+  BlockSizeAdapterFilter adapter( pFilter7ms, 5000 );
+  EXPECT_EQ( 5000, adapter.getRequiredWindowSizeUsec() );
+  EXPECT_EQ( pFilter7ms->getLatencyUSec() + 6000, adapter.getLatencyUSec() );
+
+  // the ramp goes through the 7msec filter and comes out with the exact delay
+  AudioFormat format;
+  int nChannels = format.getNumberOfChannels();
+  int nSamples = 240, nDelaySamples = 288, nLoop = 50;
+  AudioBuffer inBuf( format, nSamples );
+  AudioBuffer outBuf( format, nSamples );
+  int16_t value = 1;
+  int nOutSamples = 0;
+  bool bMatched = true;
+  for( int i=0; i<nLoop; i++ ){
+    int16_t* pIn = reinterpret_cast<int16_t*>( inBuf.getRawBufferPointer() );
+    for( int j=0; j<nSamples*nChannels; j++ ){
+      pIn[j] = value++;
+    }
+    adapter.process( inBuf, outBuf );
+    EXPECT_EQ( nSamples, outBuf.getNumberOfSamples() );
+    int16_t* pOut = reinterpret_cast<int16_t*>( outBuf.getRawBufferPointer() );
+    for( int j=0; j<nSamples; j++, nOutSamples++ ){
+      int16_t expected = ( nOutSamples < nDelaySamples ) ? 0 : ( ( nOutSamples - nDelaySamples ) * nChannels + 1 );
+      bMatched = bMatched && ( pOut[j*nChannels] == expected );
+    }
+  }
+  EXPECT_TRUE( bMatched );
+  EXPECT_EQ( nSamples * nLoop / 336, pFilter7ms->mCount );
+
+  // Pipe processes by the 5msec window in the block size adapter mode
+  std::shared_ptr<FilterCounterWithCost> pFilter5ms = std::make_shared<FilterCounterWithCost>( 1, 5000 );
+  pFilter7ms = std::make_shared<FilterCounterWithCost>( 1, 7000 );
+  std::shared_ptr<Pipe> pPipe = std::make_shared<Pipe>();
+  pPipe->attachSource( std::make_shared<Source>() );
+  pPipe->attachSink( std::make_shared<Sink>() );
+  pPipe->addFilterToTail( pFilter5ms );
+  pPipe->addFilterToTail( pFilter7ms );
+  EXPECT_EQ( 35000, pPipe->getWindowSizeUsec() );
+  pPipe->setBlockSizeAdapterEnabled( true );
+  EXPECT_EQ( 5000, pPipe->getWindowSizeUsec() );
+  EXPECT_EQ( 5000 + 6000, pPipe->getLatencyUSec() - pFilter5ms->getExpectedProcessingUSec() - pFilter7ms->getExpectedProcessingUSec() );
+  pPipe->run();
+  for(int i=0; i<1000 && pFilter7ms->mCount < 10; i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  pPipe->stop();
+  EXPECT_GE( pFilter7ms->mCount, 10 );
+  EXPECT_GT( pFilter5ms->mCount, pFilter7ms->mCount );
+  EXPECT_TRUE( pPipe->isFilterIncluded( pFilter7ms ) );
+  pPipe->clearFilters();
+
+  // PipeMultiThread keeps the different window size filters in one stage
+  std::shared_ptr<PipeMultiThread> pMultiPipe = std::make_shared<PipeMultiThread>();
+  pMultiPipe->attachSource( std::make_shared<Source>() );
+  pMultiPipe->attachSink( std::make_shared<Sink>() );
+  pMultiPipe->addFilterToTail( std::make_shared<FilterCounterWithCost>( 1, 5000 ) );
+  pMultiPipe->addFilterToTail( std::make_shared<FilterCounterWithCost>( 1, 7000 ) );
+  EXPECT_EQ( std::vector<int>({1, 1}), pMultiPipe->getStageResourceConsumption() );
+  pMultiPipe->setBlockSizeAdapterEnabled( true );
+  EXPECT_EQ( std::vector<int>({2}), pMultiPipe->getStageResourceConsumption() );
+  EXPECT_EQ( 5000, pMultiPipe->getWindowSizeUsec() );
+  pMultiPipe->clearFilters();
+}
+
+class FilterAddValue : public Filter
+{
+protected:
+  int16_t mValue;
+public:
+  FilterAddValue(int16_t value) : mValue(value){};
+  virtual ~FilterAddValue(){};
+  virtual void process(AudioBuffer& inBuf, AudioBuffer& outBuf){
+    outBuf = inBuf;
+    int16_t* pData = reinterpret_cast<int16_t*>( outBuf.getRawBufferPointer() );
+    for( int i=0, c=outBuf.getRawBufferSize()/sizeof(int16_t); i<c; i++ ){
+      pData[i] += mValue;
+    }
+  };
+};
+
+TEST_F(TestCase_PipeAndFilter, testGraphPipe)
+{
+  class ZeroSource : public Source
+  {
+  protected:
+    virtual void readPrimitive(IAudioBuffer& buf){
+      ByteBuffer zero( buf.getRawBufferSize(), 0 );
+      buf.setRawBuffer( zero );
+    };
+  };
+  class SinkLastValue : public Sink
+  {
+  public:
+    std::atomic<int> mCount;
+    std::atomic<int16_t> mValue;
+    SinkLastValue() : Sink(), mCount(0), mValue(-1){};
+  protected:
+    virtual void writePrimitive(IAudioBuffer& buf){
+      mValue = *reinterpret_cast<int16_t*>( buf.getRawBufferPointer() );
+      mCount++;
+    };
+  };
+  auto runAndGetValue = [](std::shared_ptr<GraphPipe> pPipe){
+    std::shared_ptr<SinkLastValue> pSink = std::make_shared<SinkLastValue>();
+    pPipe->attachSink( pSink );
+    pPipe->run();
+    for( int i=0; i<1000 && pSink->mCount < 3; i++ ){
+      std::this_thread::sleep_for(std::chrono::microseconds(1000));
+    }
+    pPipe->stop();
+    pPipe->detachSink();
+    return (int)pSink->mValue;
+  };
+
+  std::shared_ptr<GraphPipe> pPipe = std::make_shared<GraphPipe>();
+  pPipe->attachSource( std::make_shared<ZeroSource>() );
+
+  // the linear chain as Pipe : Source -> +1 -> +2 -> Sink
+  std::shared_ptr<IFilter> pFilter1 = std::make_shared<FilterAddValue>( 1 );
+  std::shared_ptr<IFilter> pFilter2 = std::make_shared<FilterAddValue>( 2 );
+  pPipe->addFilterToTail( pFilter1 );
+  pPipe->addFilterToTail( pFilter2 );
+  EXPECT_TRUE( pPipe->isFilterIncluded( pFilter2 ) );
+  EXPECT_EQ( 2, pPipe->getNumberOfBuffers() );
+  EXPECT_EQ( 3, runAndGetValue( pPipe ) );
+  pPipe->clearFilters();
+
+  // Signal flow
+  //  Source -> +1 -> +10 -> Sink (mixed)
+  //         -> +2 ------->
+  std::shared_ptr<IFilter> pFilter10 = std::make_shared<FilterAddValue>( 10 );
+  EXPECT_TRUE( pPipe->connect( nullptr, pFilter1 ) );
+  EXPECT_TRUE( pPipe->connect( nullptr, pFilter2 ) );
+  EXPECT_TRUE( pPipe->connect( pFilter1, pFilter10 ) );
+  EXPECT_TRUE( pPipe->connect( pFilter10, nullptr ) );
+  EXPECT_TRUE( pPipe->connect( pFilter2, nullptr ) );
+  EXPECT_TRUE( pPipe->disconnect( nullptr, nullptr ) );
+  EXPECT_FALSE( pPipe->connect( pFilter1, pFilter10 ) );
+  EXPECT_FALSE( pPipe->connect( pFilter10, pFilter1 ) ); // cycle
+  EXPECT_EQ( 3, pPipe->getNumberOfBuffers() );
+  EXPECT_EQ( 5, pPipe->getConnections().size() );
+  pPipe->dump();
+  EXPECT_EQ( 13, runAndGetValue( pPipe ) );
+
+  // the fan-in filter : (+1 & +2) -> +10 -> Sink
+  EXPECT_TRUE( pPipe->disconnect( pFilter2, nullptr ) );
+  EXPECT_TRUE( pPipe->connect( pFilter2, pFilter10 ) );
+  EXPECT_EQ( 13, runAndGetValue( pPipe ) );
+
+  // removing the filter connects its inputs to its outputs : (+1 & +2) -> Sink
+  EXPECT_TRUE( pPipe->removeFilter( pFilter10 ) );
+  EXPECT_FALSE( pPipe->isFilterIncluded( pFilter10 ) );
+  EXPECT_EQ( 3, runAndGetValue( pPipe ) );
+
+  // the filter which doesn't reach to the sink isn't processed
+  EXPECT_TRUE( pPipe->disconnect( pFilter1, nullptr ) );
+  EXPECT_TRUE( pPipe->isFilterIncluded( pFilter1 ) );
+  EXPECT_EQ( 2, runAndGetValue( pPipe ) );
+  pPipe->clearFilters();
+}
+
+TEST_F(TestCase_PipeAndFilter, testNegotiatedFormatCache)
+{
+  class FormatQueryCountingSource : public TestSource
+  {
+  public:
+    std::atomic<int> mFormatQueries;
+    FormatQueryCountingSource() : TestSource(), mFormatQueries(0){};
+    virtual AudioFormat getAudioFormat(void){ mFormatQueries++; return TestSource::getAudioFormat(); };
+  };
+  class FormatRecordingSink : public TestSink
+  {
+  public:
+    std::atomic<int> mCount;
+    std::atomic<AudioFormat::ENCODING> mEncoding;
+    FormatRecordingSink() : TestSink(), mCount(0), mEncoding(AudioFormat::ENCODING::PCM_UNKNOWN){};
+  protected:
+    virtual void writePrimitive(IAudioBuffer& buf){ mEncoding = buf.getAudioFormat().getEncoding(); mCount++; };
+  };
+  class FilterTwoFormats : public FilterCounterWithCost
+  {
+  public:
+    FilterTwoFormats() : FilterCounterWithCost( 1, 1000 ){};
+    virtual std::vector<AudioFormat> getSupportedAudioFormats(void){
+      return std::vector<AudioFormat>{ AudioFormat(), AudioFormat( AudioFormat::ENCODING::PCM_32BIT ) };
+    };
+  };
+
+  std::shared_ptr<FormatQueryCountingSource> pSource = std::make_shared<FormatQueryCountingSource>();
+  std::shared_ptr<FormatRecordingSink> pSink = std::make_shared<FormatRecordingSink>();
+  std::shared_ptr<Pipe> pPipe = std::make_shared<Pipe>();
+  pPipe->attachSource( pSource );
+  pPipe->attachSink( pSink );
+  pPipe->addFilterToTail( std::make_shared<FilterTwoFormats>() );
+  auto waitWrites = [&](int nCount){
+    for( int i=0; i<1000 && pSink->mCount < nCount; i++ ){
+      std::this_thread::sleep_for(std::chrono::microseconds(1000));
+    }
+  };
+
+  // the format is negotiated once then the steady state doesn't query it
+  pPipe->run();
+  waitWrites( 20 );
+  int nFormatQueries = pSource->mFormatQueries;
+  waitWrites( 100 );
+  EXPECT_GE( pSink->mCount, 100 );
+  EXPECT_EQ( nFormatQueries, pSource->mFormatQueries );
+  EXPECT_EQ( AudioFormat::ENCODING::PCM_16BIT, pSink->mEncoding );
+
+  // the sink's AudioFormatListener notification invalidates the negotiated format
+  EXPECT_TRUE( pSink->setAudioFormat( AudioFormat( AudioFormat::ENCODING::PCM_32BIT ) ) );
+  for( int i=0; i<1000 && pSink->mEncoding != AudioFormat::ENCODING::PCM_32BIT; i++ ){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  EXPECT_EQ( AudioFormat::ENCODING::PCM_32BIT, pSink->mEncoding );
+  EXPECT_GT( pSource->mFormatQueries, nFormatQueries );
+  pPipe->stop();
+  pPipe->clearFilters();
+}
+
+TEST_F(TestCase_PipeAndFilter, testCompressedPassthroughBufferReuse)
+{
+  class VariableFrameSource : public CompressedSource
+  {
+  public:
+    std::atomic<int> mCount;
+    std::atomic<bool> mChunkSizeRestored;
+    std::atomic<int> mMinCapacity;
+    VariableFrameSource() : CompressedSource(), mCount(0), mChunkSizeRestored(true), mMinCapacity(INT_MAX){};
+    virtual void readPrimitive(IAudioBuffer& buf){
+      ByteBuffer& frame = buf.getRawBuffer();
+      // the frame buffer is given with the chunk size and keeps the memory of the previous larger frame
+      mChunkSizeRestored = mChunkSizeRestored && ( frame.size() == 256 );
+      if( mCount ){
+        mMinCapacity = std::min( (int)frame.capacity(), (int)mMinCapacity );
+      }
+      frame.assign( ( mCount++ % 2 ) ? 100 : 1024, 0x55 );
+      buf.setAudioFormat( mFormat );
+    };
+  };
+  class CompressedFrameCountingSink : public CompressedSink
+  {
+  public:
+    std::atomic<int> mCount;
+    std::atomic<int> mBytes;
+    CompressedFrameCountingSink() : CompressedSink(), mCount(0), mBytes(0){};
+  protected:
+    virtual void writePrimitive(IAudioBuffer& buf){ mBytes += buf.getRawBufferSize(); mCount++; };
+  };
+
+  // Signal flow : CompressedSource -> Pipe -> Sink. the frames go through the reused frame buffer.
+  std::shared_ptr<VariableFrameSource> pSource = std::make_shared<VariableFrameSource>();
+  std::shared_ptr<CompressedFrameCountingSink> pSink = std::make_shared<CompressedFrameCountingSink>();
+  EXPECT_TRUE( pSink->setAudioFormat( AudioFormat( AudioFormat::ENCODING::COMPRESSED ) ) );
+  std::shared_ptr<Pipe> pPipe = std::make_shared<Pipe>();
+  pPipe->attachSource( pSource );
+  pPipe->attachSink( pSink );
+  pPipe->run();
+  for( int i=0; i<1000 && pSink->mCount < 100; i++ ){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  pPipe->stop();
+  EXPECT_GE( pSink->mCount, 100 );
+  EXPECT_GE( pSink->mBytes, 50 * ( 1024 + 100 ) );
+  EXPECT_TRUE( pSource->mChunkSizeRestored );
+  EXPECT_GE( pSource->mMinCapacity, 1024 );
+}
+
 TEST_F(TestCase_PipeAndFilter, testMultipleSink)
 {
   class TestSink : public Sink
@@ -469,6 +1017,184 @@ TEST_F(TestCase_PipeAndFilter, testPipeMixer)
   pSink->dump();
 }
 
+class SinkWriteCounter : public Sink
+{
+public:
+  std::atomic<int> mCount;
+  std::mutex mMutex;
+  std::set<std::thread::id> mThreadIds;
+  SinkWriteCounter() : Sink(), mCount(0){};
+  virtual ~SinkWriteCounter(){};
+protected:
+  virtual void writePrimitive(IAudioBuffer& buf){
+    mMutex.lock();
+    mThreadIds.insert( std::this_thread::get_id() );
+    mMutex.unlock();
+    mCount++;
+  };
+};
+
+TEST_F(TestCase_PipeAndFilter, testPipeMixerDeadline)
+{
+  class SlowSource : public Source
+  {
+  protected:
+    virtual void readPrimitive(IAudioBuffer& buf){
+      std::this_thread::sleep_for(std::chrono::microseconds(50000));
+      Source::readPrimitive( buf );
+    };
+  };
+  class SinkWindowCounter : public TestSink
+  {
+  public:
+    std::atomic<int> mCount;
+    std::atomic<int> mSamples;
+    SinkWindowCounter(int nLatencyUsec) : TestSink(nLatencyUsec), mCount(0), mSamples(0){};
+  protected:
+    virtual void writePrimitive(IAudioBuffer& buf){
+      AudioBuffer* pBuf = dynamic_cast<AudioBuffer*>( &buf );
+      mSamples = pBuf ? pBuf->getNumberOfSamples() : 0;
+      mCount++;
+    };
+  };
+
+  // Signal flow
+  //  Source1 ----> Pipe1 -> |PipeMixer | -> Sink
+  //  SlowSource -> Pipe2 -> |(mix here)|
+  // the mixer doesn't wait for the slow pipe more than the period which is the sink's latency
+  std::shared_ptr<PipeMixer> pPipeMixer = std::make_shared<PipeMixer>();
+  std::shared_ptr<SinkWindowCounter> pSink = std::make_shared<SinkWindowCounter>( 5000 );
+  pPipeMixer->attachSink( pSink );
+  pPipeMixer->setDeadlineMixEnabled( true );
+  pPipeMixer->setUnderrunConcealment( PipeMixer::CONCEALMENT::CONCEAL_REPEAT );
+  EXPECT_TRUE( pPipeMixer->getDeadlineMixEnabled() );
+
+  std::shared_ptr<IPipe> pPipe1 = std::make_shared<Pipe>();
+  pPipe1->attachSource( std::make_shared<Source>() );
+  pPipe1->attachSink( pPipeMixer->allocateSinkAdaptor( pPipe1 ) );
+  pPipe1->addFilterToTail( std::make_shared<FilterCounter>() );
+
+  std::shared_ptr<IPipe> pPipe2 = std::make_shared<Pipe>();
+  pPipe2->attachSource( std::make_shared<SlowSource>() );
+  pPipe2->attachSink( pPipeMixer->allocateSinkAdaptor( pPipe2 ) );
+  pPipe2->addFilterToTail( std::make_shared<FilterCounter>() );
+  EXPECT_EQ( 0, pPipeMixer->getUnderrunCount( pPipe2->getSinkRef() ) );
+  EXPECT_EQ( -1, pPipeMixer->getUnderrunCount( std::make_shared<InterPipeBridge>() ) );
+
+  pPipe1->run();
+  pPipe2->run();
+  pPipeMixer->run();
+  std::this_thread::sleep_for(std::chrono::microseconds(200000));
+  pPipeMixer->stop();
+  pPipe1->stop();
+  pPipe2->stop();
+
+  // 200msec / 5msec windows are mixed although the slow pipe provides 10msec per 50msec
+  EXPECT_GE( pSink->mCount, 20 );
+  EXPECT_EQ( 240, pSink->mSamples );
+  int nSlowUnderruns = pPipeMixer->getUnderrunCount( pPipe2->getSinkRef() );
+  EXPECT_GT( nSlowUnderruns, 0 );
+  EXPECT_LT( pPipeMixer->getUnderrunCount( pPipe1->getSinkRef() ), nSlowUnderruns );
+
+  pPipeMixer->releaseSinkAdaptor( pPipe1->detachSink() );
+  pPipeMixer->releaseSinkAdaptor( pPipe2->detachSink() );
+  pPipe1->clearFilters();
+  pPipe2->clearFilters();
+}
+
+TEST_F(TestCase_PipeAndFilter, testPullScheduler)
+{
+  // Signal flow
+  //  Source1 -> Pipe1(->FilterCounter->) -> |PipeMixer | -> Sink
+  //  Source2 -> Pipe2(->FilterCounter->) -> |(mix here)|
+  // the all are run by the mixer's period on the scheduler's thread
+  std::shared_ptr<PullScheduler> pScheduler = std::make_shared<PullScheduler>();
+  std::shared_ptr<PipeMixer> pPipeMixer = std::make_shared<PipeMixer>();
+  std::shared_ptr<SinkWriteCounter> pSink = std::make_shared<SinkWriteCounter>();
+  pPipeMixer->attachSink( pSink );
+
+  std::shared_ptr<FilterCounter> pCounter1 = std::make_shared<FilterCounter>();
+  std::shared_ptr<IPipe> pPipe1 = std::make_shared<Pipe>();
+  pPipe1->attachSource( std::make_shared<Source>() );
+  pPipe1->attachSink( pPipeMixer->allocateSinkAdaptor( pPipe1 ) );
+  pPipe1->addFilterToTail( pCounter1 );
+
+  std::shared_ptr<FilterCounter> pCounter2 = std::make_shared<FilterCounter>();
+  std::shared_ptr<IPipe> pPipe2 = std::make_shared<Pipe>();
+  pPipe2->attachSource( std::make_shared<Source>() );
+  pPipe2->attachSink( pPipeMixer->allocateSinkAdaptor( pPipe2 ) );
+  pPipe2->addFilterToTail( pCounter2 );
+
+  // the mixer is attached first but it's processed after the pipes
+  pPipeMixer->setPullScheduler( pScheduler );
+  pPipe1->setPullScheduler( pScheduler );
+  pPipe2->setPullScheduler( pScheduler );
+  pPipeMixer->run();
+  pPipe1->run();
+  pPipe2->run();
+  EXPECT_TRUE( pPipeMixer->isRunning() );
+  EXPECT_TRUE( pPipe1->isRunning() );
+  EXPECT_EQ( 3, pScheduler->getNumberOfRunners() );
+  // the shortest period is the pipe's window
+  EXPECT_EQ( pPipe1->getWindowSizeUsec(), pScheduler->getPeriodUsec() );
+
+  // nothing runs until the scheduler runs
+  std::this_thread::sleep_for(std::chrono::microseconds(10000));
+  EXPECT_EQ( 0, pCounter1->mCount );
+  EXPECT_EQ( 0, pSink->mCount );
+
+  pScheduler->run();
+  std::this_thread::sleep_for(std::chrono::microseconds(200000));
+  pScheduler->stop();
+
+  // paced by the period instead of the free run
+  EXPECT_GE( pSink->mCount, 5 );
+  EXPECT_LE( pSink->mCount, 60 );
+  EXPECT_GE( pCounter1->mCount, 5 );
+  EXPECT_LE( pCounter1->mCount, 60 );
+  EXPECT_LE( std::abs( pCounter1->mCount - pCounter2->mCount ), 1 );
+  EXPECT_EQ( 1, pSink->mThreadIds.size() );
+
+  pPipe1->stop();
+  pPipe2->stop();
+  pPipeMixer->stop();
+  EXPECT_FALSE( pPipe1->isRunning() );
+  EXPECT_FALSE( pPipeMixer->isRunning() );
+  EXPECT_EQ( 0, pScheduler->getNumberOfRunners() );
+
+  pPipe1->clearFilters();
+  pPipe2->clearFilters();
+
+  // Source -> Pipe -> MixerSplitter -> Sink. the MixerSplitter's mixer is run by the same scheduler
+  std::shared_ptr<MixerSplitter> pMixerSplitter = std::make_shared<MixerSplitter>();
+  std::shared_ptr<SinkWriteCounter> pSplitterSink = std::make_shared<SinkWriteCounter>();
+  pMixerSplitter->attachSink( pSplitterSink );
+  std::shared_ptr<IPipe> pPipe3 = std::make_shared<Pipe>();
+  pPipe3->attachSource( std::make_shared<Source>() );
+  std::shared_ptr<ISink> pSinkAdaptor = pMixerSplitter->allocateSinkAdaptor( AudioFormat(), pPipe3 );
+  pPipe3->attachSink( pSinkAdaptor );
+  pMixerSplitter->map( pSinkAdaptor, pSplitterSink );
+
+  pPipe3->setPullScheduler( pScheduler );
+  pMixerSplitter->setPullScheduler( pScheduler );
+  pPipe3->run();
+  pMixerSplitter->run();
+  pScheduler->run();
+  for(int i=0; i<1000 && pSplitterSink->mCount < 5; i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  EXPECT_GE( pSplitterSink->mCount, 5 );
+  EXPECT_EQ( 1, pSplitterSink->mThreadIds.size() );
+  // the pipe, the splitter and the splitter's mixer
+  EXPECT_EQ( 3, pScheduler->getNumberOfRunners() );
+
+  pMixerSplitter->stop();
+  pPipe3->stop();
+  pScheduler->stop();
+  EXPECT_FALSE( pMixerSplitter->isRunning() );
+  EXPECT_EQ( 0, pScheduler->getNumberOfRunners() );
+}
+
 TEST_F(TestCase_PipeAndFilter, testMixerSplitter)
 {
   // Signal flow
@@ -573,6 +1299,55 @@ TEST_F(TestCase_PipeAndFilter, testMixerSplitter)
   pMixerSplitter->dump();
 }
 
+TEST_F(TestCase_PipeAndFilter, testMixerSplitterRouteChange)
+{
+  // Source -> Pipe -> MixerSplitter -> Sink. the route is changed while the MixerSplitter is running
+  std::shared_ptr<MixerSplitter> pMixerSplitter = std::make_shared<MixerSplitter>();
+  std::shared_ptr<SinkWriteCounter> pSink = std::make_shared<SinkWriteCounter>();
+  pMixerSplitter->attachSink( pSink );
+
+  std::shared_ptr<IPipe> pPipe = std::make_shared<Pipe>();
+  pPipe->attachSource( std::make_shared<Source>() );
+  pPipe->addFilterToTail( std::make_shared<FilterIncrement>() );
+  std::shared_ptr<ISink> pSinkAdaptor = pMixerSplitter->allocateSinkAdaptor( AudioFormat(), pPipe );
+  pPipe->attachSink( pSinkAdaptor );
+
+  auto waitForWrite = [&](int nCount){
+    for(int i=0; i<1000 && pSink->mCount <= nCount; i++){
+      std::this_thread::sleep_for(std::chrono::microseconds(1000));
+    }
+    return pSink->mCount > nCount;
+  };
+  auto isWriteStopped = [&](void){
+    std::this_thread::sleep_for(std::chrono::microseconds(20000));
+    int nCount = pSink->mCount;
+    std::this_thread::sleep_for(std::chrono::microseconds(20000));
+    return nCount == pSink->mCount;
+  };
+
+  pPipe->run();
+  pMixerSplitter->run();
+  EXPECT_TRUE( isWriteStopped() );
+  EXPECT_EQ( 0, pSink->mCount );
+
+  // map() is applied to the running MixerSplitter
+  EXPECT_TRUE( pMixerSplitter->map( pSinkAdaptor, pSink ) );
+  EXPECT_TRUE( waitForWrite( 0 ) );
+
+  // unmap() releases the sink adaptor from the sink's mixer
+  EXPECT_TRUE( pMixerSplitter->unmap( pSinkAdaptor ) );
+  EXPECT_TRUE( isWriteStopped() );
+
+  // map() again restarts the mixer
+  EXPECT_TRUE( pMixerSplitter->map( pSinkAdaptor, pSink ) );
+  EXPECT_TRUE( waitForWrite( pSink->mCount ) );
+
+  pMixerSplitter->stop();
+  pPipe->stop();
+  EXPECT_FALSE( pMixerSplitter->isRunning() );
+  pMixerSplitter->releaseSinkAdaptor( pPipe->detachSink() );
+}
+
 TEST_F(TestCase_PipeAndFilter, testPatchPanel)
 {
   std::cout << "--- case 1: Source-Sink 1:1" << std::endl;
@@ -921,6 +1696,54 @@ TEST_F(TestCase_PipeAndFilter, testDelayFilter)
 }
 
 
+TEST_F(TestCase_PipeAndFilter, testDelayLine)
+{
+  const int nSamples = 1000;
+  const AudioFormat::ENCODING encodings[] = { AudioFormat::ENCODING::PCM_8BIT, AudioFormat::ENCODING::PCM_16BIT, AudioFormat::ENCODING::PCM_24BIT_PACKED, AudioFormat::ENCODING::PCM_32BIT };
+  const std::vector<std::vector<int>> delays = { {0, 3, 17}, {5, 5, 5}, {0, 0, 0}, {1, 257, 64} };
+
+  for(auto encoding : encodings){
+    AudioFormat format( encoding, 48000, AudioFormat::CHANNEL::CHANNEL_2_1CH );
+    int nSampleByte = format.getSampleByte();
+    int nChannels = format.getNumberOfChannels();
+    ByteBuffer src( nSamples * nChannels * nSampleByte );
+    for(size_t i=0; i<src.size(); i++){
+      src[i] = (uint8_t)( i * 13 + 7 );
+    }
+
+    for(auto& delay : delays){
+      // process by the various chunk sizes. the odd chunks are in place
+      DelayLine delayLine( format, delay );
+      ByteBuffer out( src.size() );
+      for(int i=0, nChunk=1, n=0; i<nSamples; i+=nChunk, nChunk=(nChunk*5+3)%97+1, n++){
+        nChunk = std::min( nChunk, nSamples-i );
+        int nOffset = i * nChannels * nSampleByte;
+        if( n % 2 ){
+          memcpy( out.data() + nOffset, src.data() + nOffset, nChunk * nChannels * nSampleByte );
+          delayLine.process( out.data() + nOffset, out.data() + nOffset, nChunk );
+        } else {
+          delayLine.process( src.data() + nOffset, out.data() + nOffset, nChunk );
+        }
+      }
+
+      // out[i][ch] = src[i-delay][ch] and 0 before it
+      bool bMatched = true;
+      for(int i=0; i<nSamples; i++){
+        for(int ch=0; ch<nChannels; ch++){
+          uint8_t* pOut = out.data() + ( i * nChannels + ch ) * nSampleByte;
+          int nSrcSample = i - delay[ch];
+          for(int b=0; b<nSampleByte; b++){
+            uint8_t expected = ( nSrcSample >= 0 ) ? src[ ( nSrcSample * nChannels + ch ) * nSampleByte + b ] : 0;
+            bMatched = bMatched && ( pOut[b] == expected );
+          }
+        }
+      }
+      EXPECT_TRUE( bMatched );
+    }
+  }
+}
+
+
 TEST_F(TestCase_PipeAndFilter, testSinkMute)
 {
   // Signal flow
@@ -1045,6 +1868,56 @@ TEST_F(TestCase_PipeAndFilter, testPerChannelVolumeWithSink)
   pPipe->clearFilters();
 }
 
+TEST_F(TestCase_PipeAndFilter, testSinkVolumeRamp)
+{
+  class LastBufferSink : public Sink
+  {
+  public:
+    std::vector<int16_t> mLastSamples;
+  protected:
+    virtual void writePrimitive(IAudioBuffer& buf){
+      int16_t* pSamples = reinterpret_cast<int16_t*>( buf.getRawBufferPointer() );
+      mLastSamples.assign( pSamples, pSamples + buf.getRawBufferSize() / sizeof(int16_t) );
+    };
+  };
+
+  AudioFormat format( AudioFormat::ENCODING::PCM_16BIT );
+  AudioBuffer buf( format, 256 );
+  int16_t* pRawBuf = reinterpret_cast<int16_t*>( buf.getRawBufferPointer() );
+  for(int i=0; i<256*format.getNumberOfChannels(); i++){
+    pRawBuf[i] = 10000;
+  }
+  std::shared_ptr<LastBufferSink> pSink = std::make_shared<LastBufferSink>();
+
+  // the volume set before the playback is applied from the first sample without the ramp
+  pSink->setVolume( 50.0f );
+  pSink->write( buf );
+  ASSERT_EQ( 256*2, pSink->mLastSamples.size() );
+  EXPECT_NEAR( 5000, pSink->mLastSamples.front(), 1 );
+  EXPECT_NEAR( 5000, pSink->mLastSamples.back(), 1 );
+
+  // the later change ramps from the applied volume
+  pSink->setVolume( 100.0f );
+  pSink->write( buf );
+  EXPECT_LT( pSink->mLastSamples.front(), 5100 );
+  EXPECT_GT( pSink->mLastSamples.back(), 9900 );
+  pSink->write( buf );
+  EXPECT_EQ( 10000, pSink->mLastSamples.front() );
+  pSink->setVolume( 50.0f );
+  pSink->write( buf );
+  EXPECT_GT( pSink->mLastSamples.front(), 9900 );
+  EXPECT_LT( pSink->mLastSamples.back(), 5100 );
+
+  // the unmute ramps from zero
+  pSink->setMuteEnabled( true, true );
+  pSink->write( buf );
+  EXPECT_EQ( 0, pSink->mLastSamples.front() );
+  pSink->setMuteEnabled( false );
+  pSink->write( buf );
+  EXPECT_LT( pSink->mLastSamples.front(), 100 );
+  EXPECT_NEAR( 5000, pSink->mLastSamples.back(), 100 );
+}
+
 TEST_F(TestCase_PipeAndFilter, testPerChannelVolumeWithMultiSink)
 {
   class TestSink : public Sink
@@ -1251,6 +2124,71 @@ TEST_F(TestCase_PipeAndFilter, testChannelDemuxMux2)
   }
 }
 
+TEST_F(TestCase_PipeAndFilter, testChannelParallelFilter)
+{
+  // FilterIncrement per channel group which records the running thread
+  class FilterIncrementOnThread : public FilterIncrement
+  {
+  public:
+    std::thread::id mThreadId;
+    int mChannels;
+    FilterIncrementOnThread() : FilterIncrement(), mChannels(0){};
+    virtual void process(AudioBuffer& inBuf, AudioBuffer& outBuf){
+      mThreadId = std::this_thread::get_id();
+      mChannels = inBuf.getAudioFormat().getNumberOfChannels();
+      std::this_thread::sleep_for(std::chrono::microseconds(5000));
+      FilterIncrement::process( inBuf, outBuf );
+    };
+  };
+
+  AudioFormat format( AudioFormat::ENCODING::PCM_16BIT, AudioFormat::SAMPLING_RATE::SAMPLING_RATE_48_KHZ, AudioFormat::CHANNEL::CHANNEL_7_1CH );
+  std::vector<std::shared_ptr<FilterIncrementOnThread>> filters;
+  std::vector<std::shared_ptr<IFilter>> groupFilters;
+  for( int i=0; i<3; i++ ){
+    filters.push_back( std::make_shared<FilterIncrementOnThread>() );
+    groupFilters.push_back( filters.back() );
+  }
+  std::shared_ptr<ChannelParallelFilter> pFilter = std::make_shared<ChannelParallelFilter>( format, groupFilters, std::make_shared<ThreadPoolExecutor>(3) );
+
+  // 8ch is divided into 2ch, 3ch and 3ch in the interleaved order
+  std::vector<std::vector<AudioFormat::CH>> groups = pFilter->getChannelGroups();
+  EXPECT_EQ( 3, groups.size() );
+  int nChannels = 0;
+  for( auto& aGroup : groups ){
+    for( auto& aChannel : aGroup ){
+      EXPECT_EQ( nChannels++, format.getOffSetInSample( aChannel ) );
+    }
+  }
+  EXPECT_EQ( 8, nChannels );
+  EXPECT_EQ( 1, ChannelParallelFilter::getChannelGroups( AudioFormat(), 4 )[0].size() );
+  EXPECT_EQ( 2, ChannelParallelFilter::getChannelGroups( AudioFormat(), 4 ).size() );
+
+  AudioBuffer inBuf( format, 256 );
+  AudioBuffer outBuf( format, 256 );
+  uint8_t* pRawInBuf = inBuf.getRawBufferPointer();
+  for( int i=0, c=inBuf.getRawBufferSize(); i<c; i++ ){
+    pRawInBuf[i] = i % 256;
+  }
+  pFilter->process( inBuf, outBuf );
+
+  // same result as FilterIncrement for the whole channels
+  EXPECT_TRUE( format.equal( outBuf.getAudioFormat() ) );
+  EXPECT_EQ( inBuf.getRawBufferSize(), outBuf.getRawBufferSize() );
+  uint8_t* pRawOutBuf = outBuf.getRawBufferPointer();
+  for( int i=0, c=outBuf.getRawBufferSize(); i<c; i++ ){
+    EXPECT_EQ( (uint8_t)( ( i + 1 ) % 256 ), pRawOutBuf[i] );
+  }
+
+  // the groups ran on the several threads
+  std::vector<std::thread::id> threads;
+  for( auto& aFilter : filters ){
+    threads.push_back( aFilter->mThreadId );
+    EXPECT_EQ( groups[threads.size()-1].size(), aFilter->mChannels );
+  }
+  std::sort( threads.begin(), threads.end() );
+  EXPECT_GT( std::unique( threads.begin(), threads.end() ) - threads.begin(), 1 );
+}
+
 TEST_F(TestCase_PipeAndFilter, testAudioBaseFormatChanged)
 {
   class MyAudioFormatListener : public AudioBase::AudioFormatListener
@@ -1273,6 +2211,98 @@ TEST_F(TestCase_PipeAndFilter, testAudioBaseFormatChanged)
   EXPECT_TRUE( pSink->getAudioFormat().equal( pMyListener->mFormat ) );
 }
 
+class AudioFormatChangeCounter : public AudioBase::AudioFormatListener
+{
+public:
+  std::atomic<int> mCount;
+  AudioFormat mFormat;
+  AudioFormatChangeCounter():mCount(0){};
+  virtual ~AudioFormatChangeCounter(){};
+  virtual void onFormatChanged(AudioFormat format){
+    mFormat = format;
+    mCount++;
+  };
+};
+
+class AnyFormatSink : public Sink
+{
+public:
+  AnyFormatSink():Sink(){};
+  virtual ~AnyFormatSink(){};
+  virtual bool isAvailableFormat(AudioFormat format){ return true; };
+};
+
+TEST_F(TestCase_PipeAndFilter, testPipedSinkFormatChanged)
+{
+  // the inner sink's format change is notified as the PipedSink's one
+  AudioFormat format( AudioFormat::ENCODING::PCM_16BIT, 96000 );
+  std::shared_ptr<ISink> pInnerSink = std::make_shared<AnyFormatSink>();
+  std::shared_ptr<PipedSink> pPipedSink = std::make_shared<PipedSink>( pInnerSink );
+  std::shared_ptr<AudioFormatChangeCounter> pListener = std::make_shared<AudioFormatChangeCounter>();
+  pPipedSink->registerAudioFormatListener( pListener );
+
+  EXPECT_TRUE( pInnerSink->setAudioFormat( format ) );
+  EXPECT_EQ( 1, pListener->mCount );
+  EXPECT_TRUE( format.equal( pListener->mFormat ) );
+  EXPECT_TRUE( format.equal( pPipedSink->getAudioFormat() ) );
+
+  // the detached sink isn't forwarded
+  pPipedSink->detachSink();
+  EXPECT_TRUE( pInnerSink->setAudioFormat( AudioFormat() ) );
+  EXPECT_EQ( 1, pListener->mCount );
+}
+
+TEST_F(TestCase_PipeAndFilter, testReferenceSoundSinkSourceFormatChanged)
+{
+  // the inner sink's format change is notified and followed by the ReferenceSoundSinkSource without the query
+  AudioFormat format( AudioFormat::ENCODING::PCM_16BIT, 96000 );
+  std::shared_ptr<ISink> pInnerSink = std::make_shared<AnyFormatSink>();
+  std::shared_ptr<ReferenceSoundSinkSource> pRefSink = std::make_shared<ReferenceSoundSinkSource>( pInnerSink );
+  std::shared_ptr<AudioFormatChangeCounter> pListener = std::make_shared<AudioFormatChangeCounter>();
+  std::shared_ptr<ISource> pRefSource = pRefSink;
+  pRefSource->registerAudioFormatListener( pListener );
+
+  EXPECT_TRUE( pInnerSink->setAudioFormat( format ) );
+  EXPECT_EQ( 1, pListener->mCount );
+  EXPECT_TRUE( format.equal( pListener->mFormat ) );
+  EXPECT_TRUE( format.equal( pRefSource->getAudioFormat() ) );
+
+  // the set through the ReferenceSoundSinkSource is notified once
+  EXPECT_TRUE( pRefSink->setAudioFormat( AudioFormat() ) );
+  EXPECT_EQ( 2, pListener->mCount );
+  EXPECT_TRUE( AudioFormat().equal( pInnerSink->getAudioFormat() ) );
+}
+
+TEST_F(TestCase_PipeAndFilter, testInterPipeBridgeFormatChanged)
+{
+  // the downstream pipe listens to the ISource side and the upstream pipe's side sets the format through the ISink side
+  AudioFormat format( AudioFormat::ENCODING::PCM_16BIT, 96000 );
+  std::shared_ptr<InterPipeBridge> pBridge = std::make_shared<InterPipeBridge>();
+  std::shared_ptr<ISource> pSourceSide = pBridge;
+  std::shared_ptr<ISink> pSinkSide = pBridge;
+  std::shared_ptr<AudioFormatChangeCounter> pSourceListener = std::make_shared<AudioFormatChangeCounter>();
+  std::shared_ptr<AudioFormatChangeCounter> pSinkListener = std::make_shared<AudioFormatChangeCounter>();
+  pSourceSide->registerAudioFormatListener( pSourceListener );
+  pSinkSide->registerAudioFormatListener( pSinkListener );
+
+  EXPECT_TRUE( pSinkSide->setAudioFormat( format ) );
+  EXPECT_EQ( 1, pSourceListener->mCount );
+  EXPECT_EQ( 1, pSinkListener->mCount );
+  EXPECT_TRUE( format.equal( pSourceListener->mFormat ) );
+  EXPECT_TRUE( format.equal( pSourceSide->getAudioFormat() ) );
+
+  // the same format through the other side isn't notified again
+  EXPECT_TRUE( pSourceSide->setAudioFormat( format ) );
+  EXPECT_EQ( 1, pSourceListener->mCount );
+  EXPECT_TRUE( pSourceSide->setAudioFormat( AudioFormat() ) );
+  EXPECT_EQ( 2, pSourceListener->mCount );
+  EXPECT_EQ( 2, pSinkListener->mCount );
+
+  pSourceSide->unregisterAudioFormatListener( pSourceListener );
+  EXPECT_TRUE( pSinkSide->setAudioFormat( format ) );
+  EXPECT_EQ( 2, pSourceListener->mCount );
+}
+
 TEST_F(TestCase_PipeAndFilter, testFilterExample16)
 {
   std::shared_ptr<IPipe> pPipe = std::make_shared<Pipe>();
@@ -29,10 +29,21 @@ protected:
 
   void testAddFilters(void);
   void testAttachSourceSinkToPipe(void);
+  void testPipeFilterHotSwap(void);
 
+  void testPipeIoPipelining(void);
+  void testPipeIoPipeliningWindowChange(void);
   void testInterPipeBridge(void);
+  void testPipeExecutor(void);
 
   void testPipeMultiThread(void);
+  void testPipeMultiThreadStages(void);
+  void testBlockSizeAdapterFilter(void);
+  void testGraphPipe(void);
+  void testNegotiatedFormatCache(void);
+  void testCompressedPassthroughBufferReuse(void);
+  void testPipeMixerDeadline(void);
+  void testMixerSplitterRouteChange(void);
   void testMultipleSink(void);
   void testMultipleSink_Same(void);
   void testMultipleSink_Format(void);
@@ -43,6 +54,7 @@ protected:
   void testPipedSink(void);
   void testPipedSource(void);
   void testPipeMixer(void);
+  void testPullScheduler(void);
   void testMixerSplitter(void);
   void testPatchPanel(void);
 
@@ -51,6 +63,7 @@ protected:
   void testEncoder(void);
 
   void testDelayFilter(void);
+  void testDelayLine(void);
 
   void testSinkMute(void);
   void testSourceMute(void);
@@ -60,14 +73,19 @@ protected:
   void testAecSourceDelayOnly(void);
 
   void testPerChannelVolumeWithSink(void);
+  void testSinkVolumeRamp(void);
   void testPerChannelVolumeWithMultiSink(void);
 
   void testEncodedSink(void);
 
   void testChannelDemuxMux(void);
   void testChannelDemuxMux2(void);
+  void testChannelParallelFilter(void);
 
   void testAudioBaseFormatChanged(void);
+  void testPipedSinkFormatChanged(void);
+  void testReferenceSoundSinkSourceFormatChanged(void);
+  void testInterPipeBridgeFormatChanged(void);
 
   void testFilterExample16(void);
   void testFilterExample32(void);
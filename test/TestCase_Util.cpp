@@ -117,6 +117,645 @@ TEST_F(TestCase_Util, testFifoBuffer)
   EXPECT_TRUE( bResult );
 }
 
+TEST_F(TestCase_Util, testRingFifoBuffer)
+{
+  AudioFormat defaultFormat;
+  RingFifoBuffer fifoBuf( defaultFormat );
+  int nSize = 256;
+  fifoBuf.setFifoSizeLimit( nSize*3 );
+  AudioBuffer readBuf( defaultFormat, nSize );
+  AudioBuffer writeBuf( defaultFormat, nSize );
+
+  EXPECT_TRUE( fifoBuf.write( writeBuf ) );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), nSize );
+  EXPECT_EQ( fifoBuf.getCapacity(), nSize*3*defaultFormat.getChannelsSampleByte() );
+
+  EXPECT_TRUE( fifoBuf.write( writeBuf ) );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), nSize*2 );
+
+  EXPECT_TRUE( fifoBuf.read( readBuf ) );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), nSize );
+
+  EXPECT_TRUE( fifoBuf.read( readBuf ) );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), 0 );
+
+  // producer & consumer with different window size and wrap around
+  int nWriteSamples = 96, nReadSamples = 160, nLoop = 200;
+  AudioBuffer smallReadBuf( defaultFormat, nReadSamples );
+  std::atomic<bool> bMatched = true;
+  std::thread consumer([&]{
+    int16_t expected = 0;
+    for(int i=0; i<nWriteSamples*nLoop/nReadSamples; i++){
+      fifoBuf.read( smallReadBuf );
+      int16_t* pData = reinterpret_cast<int16_t*>( smallReadBuf.getRawBufferPointer() );
+      for(int j=0, c=nReadSamples*defaultFormat.getNumberOfChannels(); j<c; j++){
+        bMatched = bMatched && ( pData[j] == expected++ );
+      }
+    }
+  });
+  AudioBuffer smallWriteBuf( defaultFormat, nWriteSamples );
+  int16_t value = 0;
+  for(int i=0; i<nLoop; i++){
+    int16_t* pData = reinterpret_cast<int16_t*>( smallWriteBuf.getRawBufferPointer() );
+    for(int j=0, c=nWriteSamples*defaultFormat.getNumberOfChannels(); j<c; j++){
+      pData[j] = value++;
+    }
+    EXPECT_TRUE( fifoBuf.write( smallWriteBuf ) );
+  }
+  consumer.join();
+  EXPECT_TRUE( bMatched );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), 0 );
+
+  // reader blocked then writer unblocks it
+  std::atomic<bool> bResult = false;
+  std::thread thx([&]{ bResult = fifoBuf.read( readBuf );});
+  std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  EXPECT_TRUE( fifoBuf.write( writeBuf ) );
+  thx.join();
+  EXPECT_TRUE( bResult );
+}
+
+TEST_F(TestCase_Util, testHandoffFifoBuffer)
+{
+  AudioFormat defaultFormat;
+  HandoffFifoBuffer fifoBuf( defaultFormat );
+  int nSize = 256;
+  AudioBuffer readBuf( defaultFormat, nSize );
+  AudioBuffer writeBuf( defaultFormat, nSize );
+
+  // the written memory is passed to the reader as is
+  uint8_t* pWrittenMemory = writeBuf.getRawBufferPointer();
+  uint8_t* pReaderMemory = readBuf.getRawBufferPointer();
+  EXPECT_TRUE( fifoBuf.write( writeBuf, true ) );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), nSize );
+  EXPECT_EQ( writeBuf.getNumberOfSamples(), nSize );
+  EXPECT_NE( writeBuf.getRawBufferPointer(), pWrittenMemory );
+  EXPECT_TRUE( fifoBuf.read( readBuf, true ) );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), 0 );
+  EXPECT_EQ( readBuf.getRawBufferPointer(), pWrittenMemory );
+
+  // the reader's memory is given back to the writer when the writer comes back to the first slot
+  for(int i=1; i<fifoBuf.getNumberOfSlots(); i++){
+    EXPECT_TRUE( fifoBuf.write( writeBuf, true ) );
+    EXPECT_TRUE( fifoBuf.read( readBuf, true ) );
+  }
+  EXPECT_TRUE( fifoBuf.write( writeBuf, true ) );
+  EXPECT_EQ( writeBuf.getRawBufferPointer(), pReaderMemory );
+  EXPECT_TRUE( fifoBuf.read( readBuf, true ) );
+
+  // handoff writer & copying reader with different window size
+  int nWriteSamples = 96, nReadSamples = 160, nLoop = 200;
+  AudioBuffer smallReadBuf( defaultFormat, nReadSamples );
+  std::atomic<bool> bMatched = true;
+  std::thread consumer([&]{
+    int16_t expected = 0;
+    for(int i=0; i<nWriteSamples*nLoop/nReadSamples; i++){
+      fifoBuf.read( smallReadBuf, true );
+      int16_t* pData = reinterpret_cast<int16_t*>( smallReadBuf.getRawBufferPointer() );
+      for(int j=0, c=nReadSamples*defaultFormat.getNumberOfChannels(); j<c; j++){
+        bMatched = bMatched && ( pData[j] == expected++ );
+      }
+    }
+  });
+  AudioBuffer smallWriteBuf( defaultFormat, nWriteSamples );
+  int16_t value = 0;
+  for(int i=0; i<nLoop; i++){
+    int16_t* pData = reinterpret_cast<int16_t*>( smallWriteBuf.getRawBufferPointer() );
+    for(int j=0, c=nWriteSamples*defaultFormat.getNumberOfChannels(); j<c; j++){
+      pData[j] = value++;
+    }
+    EXPECT_TRUE( fifoBuf.write( smallWriteBuf, true ) );
+  }
+  consumer.join();
+  EXPECT_TRUE( bMatched );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), 0 );
+
+  // reader blocked then writer unblocks it
+  std::atomic<bool> bResult = false;
+  std::thread thx([&]{ bResult = fifoBuf.read( readBuf, true );});
+  std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  EXPECT_TRUE( fifoBuf.write( writeBuf ) );
+  thx.join();
+  EXPECT_TRUE( bResult );
+}
+
+TEST_F(TestCase_Util, testAudioBufferPool)
+{
+  AudioBufferPool pool(2);
+  AudioFormat format;
+  int nSamples = 240;
+
+  std::shared_ptr<AudioBuffer> pBuf1 = pool.acquire( format, nSamples );
+  std::shared_ptr<AudioBuffer> pBuf2 = pool.acquire( format, nSamples );
+  EXPECT_NE( pBuf1, pBuf2 );
+  EXPECT_EQ( pBuf1->getNumberOfSamples(), nSamples );
+  EXPECT_EQ( pool.getPooledBufferCount(), 2 );
+
+  // exceeded the pool limit then not pooled buffer is returned
+  std::shared_ptr<AudioBuffer> pBuf3 = pool.acquire( format, nSamples );
+  EXPECT_NE( pBuf3, pBuf1 );
+  EXPECT_NE( pBuf3, pBuf2 );
+  EXPECT_EQ( pool.getPooledBufferCount(), 2 );
+
+  // released buffer is recycled even if the user changed the size
+  AudioBuffer* pRawBuf1 = pBuf1.get();
+  pBuf1->getRawBufferPointer()[0] = 1;
+  pBuf1->resize( nSamples / 2, false );
+  pBuf1.reset();
+  std::shared_ptr<AudioBuffer> pBuf4 = pool.acquire( format, nSamples, true );
+  EXPECT_EQ( pBuf4.get(), pRawBuf1 );
+  EXPECT_EQ( pBuf4->getNumberOfSamples(), nSamples );
+  EXPECT_EQ( pBuf4->getRawBufferPointer()[0], 0 );
+
+  // different key
+  std::shared_ptr<AudioBuffer> pBuf5 = pool.acquire( AudioFormat(AudioFormat::ENCODING::PCM_FLOAT), nSamples );
+  EXPECT_TRUE( pBuf5->getAudioFormat().equal( AudioFormat(AudioFormat::ENCODING::PCM_FLOAT) ) );
+  EXPECT_EQ( pool.getPooledBufferCount(), 3 );
+}
+
+TEST_F(TestCase_Util, testMixerPrimitive)
+{
+  // odd size to exercise the scalar tail of the vector kernels
+  const int nChannelSamples = 133;
+  std::vector<int8_t> in8a(nChannelSamples), in8b(nChannelSamples), out8(nChannelSamples), expected8(nChannelSamples);
+  std::vector<int16_t> in16a(nChannelSamples), in16b(nChannelSamples), out16(nChannelSamples), expected16(nChannelSamples);
+  std::vector<int32_t> in32a(nChannelSamples), in32b(nChannelSamples), out32(nChannelSamples), expected32(nChannelSamples);
+  std::vector<float> inFa(nChannelSamples), inFb(nChannelSamples), outF(nChannelSamples), expectedF(nChannelSamples);
+  std::vector<int8_t> in24a(nChannelSamples*3), in24b(nChannelSamples*3), out24(nChannelSamples*3), expected24(nChannelSamples*3);
+
+  uint32_t seed = 12345;
+  auto random = [&]{ seed = seed * 1103515245 + 12345; return (int32_t)seed; };
+  for(int i=0; i<nChannelSamples; i++){
+    // every 4th sample is the saturating case
+    bool bSaturate = !(i % 4);
+    int32_t a = random(), b = random();
+    in8a[i] = bSaturate ? INT8_MAX : a >> 24;
+    in8b[i] = bSaturate ? ( (i % 8) ? 1 : INT8_MAX ) : b >> 24;
+    in16a[i] = bSaturate ? INT16_MIN : a >> 16;
+    in16b[i] = bSaturate ? -1 : b >> 16;
+    in32a[i] = bSaturate ? INT32_MAX : a;
+    in32b[i] = bSaturate ? ( (i % 8) ? INT32_MAX : 1 ) : b;
+    inFa[i] = bSaturate ? 0.9f : (float)( a >> 8 ) / 8388608.0f;
+    inFb[i] = bSaturate ? 0.2f : (float)( b >> 8 ) / 8388608.0f;
+    for(int j=0; j<3; j++){
+      in24a[i*3+j] = bSaturate ? ( j == 2 ? 0x80 : 0x00 ) : ( a >> (j*8) ) & 0xFF;
+      in24b[i*3+j] = bSaturate ? (int8_t)0xFF : ( b >> (j*8) ) & 0xFF;
+    }
+  }
+
+  MixerPrimitive::SIMD defaultSimd = MixerPrimitive::getSimd();
+  EXPECT_TRUE( MixerPrimitive::isSimdSupported( defaultSimd ) );
+  EXPECT_TRUE( MixerPrimitive::setSimd( MixerPrimitive::SIMD::SCALAR ) );
+  MixerPrimitive::mix( in8a.data(), in8b.data(), expected8.data(), nChannelSamples );
+  MixerPrimitive::mix( in16a.data(), in16b.data(), expected16.data(), nChannelSamples );
+  MixerPrimitive::mix( in32a.data(), in32b.data(), expected32.data(), nChannelSamples );
+  MixerPrimitive::mix( inFa.data(), inFb.data(), expectedF.data(), nChannelSamples );
+  MixerPrimitive::mix24( in24a.data(), in24b.data(), expected24.data(), nChannelSamples );
+
+  // saturation by the scalar kernel
+  EXPECT_EQ( expected8[0], INT8_MAX );
+  EXPECT_EQ( expected16[0], INT16_MIN );
+  EXPECT_EQ( expected32[4], INT32_MAX );
+  EXPECT_EQ( expectedF[0], 1.0f );
+  // 0x800000 + 0xFFFFFF = -8388608 + -1
+  EXPECT_EQ( (uint8_t)expected24[0], 0x00 );
+  EXPECT_EQ( (uint8_t)expected24[1], 0x00 );
+  EXPECT_EQ( (uint8_t)expected24[2], 0x80 );
+
+  // the vector kernels are bit-exact to the scalar kernel
+  for( auto simd : { MixerPrimitive::SIMD::SSE2, MixerPrimitive::SIMD::AVX2 } ){
+    if( MixerPrimitive::setSimd( simd ) ){
+      MixerPrimitive::mix( in8a.data(), in8b.data(), out8.data(), nChannelSamples );
+      MixerPrimitive::mix( in16a.data(), in16b.data(), out16.data(), nChannelSamples );
+      MixerPrimitive::mix( in32a.data(), in32b.data(), out32.data(), nChannelSamples );
+      MixerPrimitive::mix( inFa.data(), inFb.data(), outF.data(), nChannelSamples );
+      MixerPrimitive::mix24( in24a.data(), in24b.data(), out24.data(), nChannelSamples );
+      EXPECT_EQ( out8, expected8 );
+      EXPECT_EQ( out16, expected16 );
+      EXPECT_EQ( out32, expected32 );
+      EXPECT_EQ( outF, expectedF );
+      EXPECT_EQ( out24, expected24 );
+    }
+  }
+
+  // N-way mix saturates once : INT16_MAX + INT16_MAX + INT16_MIN = 32766 (the pairwise saturation gives -1)
+  const int nInputs = 5;
+  std::vector<std::vector<int16_t>> in16(nInputs, std::vector<int16_t>(nChannelSamples));
+  std::vector<std::vector<float>> inF(nInputs, std::vector<float>(nChannelSamples));
+  std::vector<const int16_t*> pIn16;
+  std::vector<const float*> pInF;
+  for(int j=0; j<nInputs; j++){
+    for(int i=0; i<nChannelSamples; i++){
+      in16[j][i] = (j < 3 && !(i % 4)) ? ( (j == 2) ? INT16_MIN : INT16_MAX ) : random() >> 19;
+      inF[j][i] = (float)( random() >> 8 ) / 8388608.0f;
+    }
+    pIn16.push_back( in16[j].data() );
+    pInF.push_back( inF[j].data() );
+  }
+  for( auto simd : { MixerPrimitive::SIMD::SCALAR, MixerPrimitive::SIMD::SSE2, MixerPrimitive::SIMD::AVX2 } ){
+    if( MixerPrimitive::setSimd( simd ) ){
+      EXPECT_TRUE( MixerPrimitive::mix( std::span<const int16_t* const>( pIn16.data(), 3 ), out16.data(), nChannelSamples ) );
+      EXPECT_EQ( out16[0], 32766 );
+      EXPECT_TRUE( MixerPrimitive::mix( pIn16, out16.data(), nChannelSamples ) );
+      EXPECT_TRUE( MixerPrimitive::mix( pInF, outF.data(), nChannelSamples ) );
+      for(int i=0; i<nChannelSamples; i++){
+        int32_t sum = 0;
+        float sumF = 0.0f;
+        for(int j=0; j<nInputs; j++){
+          sum += in16[j][i];
+          sumF += inF[j][i];
+        }
+        EXPECT_EQ( out16[i], std::max<int32_t>( INT16_MIN, std::min<int32_t>( sum, INT16_MAX ) ) );
+        EXPECT_NEAR( outF[i], std::max( -1.0f, std::min( sumF, 1.0f ) ), 1.0e-6f );
+      }
+    }
+  }
+
+  // the 8bit, 32bit and 24bit N-way vector kernels give the same result as the scalar one
+  std::vector<const int8_t*> pIn8 = { in8a.data(), in8b.data(), in8a.data() };
+  std::vector<const int32_t*> pIn32 = { in32a.data(), in32b.data(), in32a.data() };
+  std::vector<const int8_t*> pIn24 = { in24a.data(), in24b.data(), in24a.data() };
+  EXPECT_TRUE( MixerPrimitive::setSimd( MixerPrimitive::SIMD::SCALAR ) );
+  MixerPrimitive::mix( pIn8, expected8.data(), nChannelSamples );
+  MixerPrimitive::mix( pIn32, expected32.data(), nChannelSamples );
+  MixerPrimitive::mix24( pIn24, expected24.data(), nChannelSamples );
+  for( auto simd : { MixerPrimitive::SIMD::SSE2, MixerPrimitive::SIMD::AVX2 } ){
+    if( MixerPrimitive::setSimd( simd ) ){
+      EXPECT_TRUE( MixerPrimitive::mix( pIn8, out8.data(), nChannelSamples ) );
+      EXPECT_TRUE( MixerPrimitive::mix( pIn32, out32.data(), nChannelSamples ) );
+      EXPECT_TRUE( MixerPrimitive::mix24( pIn24, out24.data(), nChannelSamples ) );
+      EXPECT_EQ( out8, expected8 );
+      EXPECT_EQ( out32, expected32 );
+      EXPECT_EQ( out24, expected24 );
+    }
+  }
+
+  EXPECT_TRUE( MixerPrimitive::setSimd( defaultSimd ) );
+}
+
+TEST_F(TestCase_Util, testVolumePrimitive)
+{
+  // 3 channels and the odd size to exercise the scalar tail of the vector kernels
+  const int nChannels = 3;
+  const int nFrames = 111;
+  const int nChannelSamples = nChannels * nFrames;
+  std::vector<int8_t> in8(nChannelSamples), out8(nChannelSamples), expected8(nChannelSamples);
+  std::vector<int16_t> in16(nChannelSamples), out16(nChannelSamples), expected16(nChannelSamples);
+  std::vector<int32_t> in32(nChannelSamples), out32(nChannelSamples), expected32(nChannelSamples);
+  std::vector<float> inF(nChannelSamples), outF(nChannelSamples), expectedF(nChannelSamples);
+  std::vector<int8_t> in24(nChannelSamples*3), out24(nChannelSamples*3), expected24(nChannelSamples*3);
+
+  uint32_t seed = 12345;
+  auto random = [&]{ seed = seed * 1103515245 + 12345; return (int32_t)seed; };
+  for(int i=0; i<nChannelSamples; i++){
+    int32_t a = random();
+    in8[i] = a >> 24;
+    in16[i] = a >> 16;
+    in32[i] = a;
+    inF[i] = (float)( a >> 8 ) / 8388608.0f;
+    for(int j=0; j<3; j++){
+      in24[i*3+j] = ( a >> (j*8) ) & 0xFF;
+    }
+  }
+  // the 3rd channel ramps up beyond 100% to saturate
+  std::vector<float> startVolumes = { 100.0f, 50.0f, 100.0f };
+  std::vector<float> endVolumes = { 0.0f, 50.0f, 300.0f };
+
+  VolumePrimitive::SIMD defaultSimd = VolumePrimitive::getSimd();
+  EXPECT_TRUE( VolumePrimitive::setSimd( VolumePrimitive::SIMD::SCALAR ) );
+  EXPECT_TRUE( VolumePrimitive::volume( in8.data(), expected8.data(), startVolumes, endVolumes, nChannelSamples ) );
+  EXPECT_TRUE( VolumePrimitive::volume( in16.data(), expected16.data(), startVolumes, endVolumes, nChannelSamples ) );
+  EXPECT_TRUE( VolumePrimitive::volume( in32.data(), expected32.data(), startVolumes, endVolumes, nChannelSamples ) );
+  EXPECT_TRUE( VolumePrimitive::volume( inF.data(), expectedF.data(), startVolumes, endVolumes, nChannelSamples ) );
+  EXPECT_TRUE( VolumePrimitive::volume24( in24.data(), expected24.data(), startVolumes, endVolumes, nChannelSamples ) );
+
+  // linear ramp from the start volume toward the end volume
+  for(int frame=0; frame<nFrames; frame++){
+    float gain = 1.0f - (float)frame / nFrames;
+    int i = frame * nChannels;
+    EXPECT_NEAR( expected16[i], in16[i] * gain, 2.0f );
+    EXPECT_NEAR( expected16[i+1], in16[i+1] * 0.5f, 1.0f );
+    EXPECT_NEAR( expectedF[i], inF[i] * gain, 1.0e-5f );
+  }
+  EXPECT_EQ( expected16[0], in16[0] );
+  for(int i=2; i<nChannelSamples; i+=nChannels){
+    EXPECT_GE( expected32[i] ^ in32[i], 0 ); // same sign
+    EXPECT_LE( std::abs( expectedF[i] ), 1.0f );
+  }
+
+  // the vector kernels are bit-exact to the scalar kernel
+  for( auto simd : { VolumePrimitive::SIMD::SSE2, VolumePrimitive::SIMD::AVX2 } ){
+    if( VolumePrimitive::setSimd( simd ) ){
+      VolumePrimitive::volume( in8.data(), out8.data(), startVolumes, endVolumes, nChannelSamples );
+      VolumePrimitive::volume( in16.data(), out16.data(), startVolumes, endVolumes, nChannelSamples );
+      VolumePrimitive::volume( in32.data(), out32.data(), startVolumes, endVolumes, nChannelSamples );
+      VolumePrimitive::volume( inF.data(), outF.data(), startVolumes, endVolumes, nChannelSamples );
+      VolumePrimitive::volume24( in24.data(), out24.data(), startVolumes, endVolumes, nChannelSamples );
+      EXPECT_EQ( out8, expected8 );
+      EXPECT_EQ( out16, expected16 );
+      EXPECT_EQ( out32, expected32 );
+      EXPECT_EQ( outF, expectedF );
+      EXPECT_EQ( out24, expected24 );
+    }
+  }
+
+  // the constant volume
+  EXPECT_TRUE( VolumePrimitive::volume( in16.data(), out16.data(), std::vector<float>( nChannels, 50.0f ), nChannelSamples ) );
+  for(int i=0; i<nChannelSamples; i++){
+    EXPECT_EQ( out16[i], (int16_t)( in16[i] * 0.5f ) );
+  }
+
+  EXPECT_TRUE( VolumePrimitive::setSimd( defaultSimd ) );
+}
+
+TEST_F(TestCase_Util, testPcmFormatConvert)
+{
+  // odd size to exercise the scalar tail of the vector kernels
+  const int nSamples = 37;
+  std::vector<uint8_t> inPcm(nSamples*4), inFloat(nSamples*4);
+  uint32_t seed = 12345;
+  auto random = [&]{ seed = seed * 1103515245 + 12345; return (int32_t)seed; };
+  float* pInFloat = reinterpret_cast<float*>( inFloat.data() );
+  for(int i=0; i<nSamples; i++){
+    int32_t sample = random();
+    memcpy( inPcm.data()+i*4, &sample, sizeof(int32_t) );
+    pInFloat[i] = (float)( random() >> 8 ) / 8388608.0f;
+  }
+  // the full scale
+  pInFloat[0] = 1.0f;
+  pInFloat[1] = -1.0f;
+
+  struct CONVERT {
+    void (*convert)(uint8_t* pSrc, uint8_t* pDst, int nSamples);
+    bool bFloatSrc;
+    int nDstSampleByte;
+  };
+  const std::vector<CONVERT> converts = {
+    { PcmFormatConvert::convertPcm8ToPcm16, false, 2 }, { PcmFormatConvert::convertPcm8ToPcm24, false, 3 }, { PcmFormatConvert::convertPcm8ToPcm32, false, 4 }, { PcmFormatConvert::convertPcm8ToFloat, false, 4 },
+    { PcmFormatConvert::convertPcm16ToPcm8, false, 1 }, { PcmFormatConvert::convertPcm16ToPcm24, false, 3 }, { PcmFormatConvert::convertPcm16ToPcm32, false, 4 }, { PcmFormatConvert::convertPcm16ToFloat, false, 4 },
+    { PcmFormatConvert::convertPcm24ToPcm8, false, 1 }, { PcmFormatConvert::convertPcm24ToPcm16, false, 2 }, { PcmFormatConvert::convertPcm24ToPcm32, false, 4 }, { PcmFormatConvert::convertPcm24ToFloat, false, 4 },
+    { PcmFormatConvert::convertPcm32ToPcm8, false, 1 }, { PcmFormatConvert::convertPcm32ToPcm16, false, 2 }, { PcmFormatConvert::convertPcm32ToPcm24, false, 3 }, { PcmFormatConvert::convertPcm32ToFloat, false, 4 },
+    { PcmFormatConvert::convertFloatToPcm8, true, 1 }, { PcmFormatConvert::convertFloatToPcm16, true, 2 }, { PcmFormatConvert::convertFloatToPcm24, true, 3 }, { PcmFormatConvert::convertFloatToPcm32, true, 4 }
+  };
+
+  PcmFormatConvert::SIMD defaultSimd = PcmFormatConvert::getSimd();
+  std::vector<std::vector<uint8_t>> expected;
+  EXPECT_TRUE( PcmFormatConvert::setSimd( PcmFormatConvert::SIMD::SCALAR ) );
+  for( auto& aConvert : converts ){
+    std::vector<uint8_t> out( nSamples * aConvert.nDstSampleByte );
+    aConvert.convert( aConvert.bFloatSrc ? inFloat.data() : inPcm.data(), out.data(), nSamples );
+    expected.push_back( out );
+  }
+
+  // the vector kernels are bit-exact to the scalar kernel
+  for( auto simd : { PcmFormatConvert::SIMD::SSE2, PcmFormatConvert::SIMD::AVX2 } ){
+    if( PcmFormatConvert::setSimd( simd ) ){
+      for(size_t i=0; i<converts.size(); i++){
+        std::vector<uint8_t> out( nSamples * converts[i].nDstSampleByte );
+        converts[i].convert( converts[i].bFloatSrc ? inFloat.data() : inPcm.data(), out.data(), nSamples );
+        EXPECT_EQ( out, expected[i] );
+      }
+    }
+  }
+
+  // 24bit -> float takes each sample and the 32bit <-> float is the signed full scale
+  std::vector<uint8_t> pcm24(nSamples*3), pcm32(nSamples*4), floatBuf(nSamples*4);
+  for( auto simd : { PcmFormatConvert::SIMD::SCALAR, PcmFormatConvert::SIMD::SSE2, PcmFormatConvert::SIMD::AVX2 } ){
+    if( PcmFormatConvert::setSimd( simd ) ){
+      PcmFormatConvert::convertFloatToPcm32( inFloat.data(), pcm32.data(), nSamples );
+      int32_t* pPcm32 = reinterpret_cast<int32_t*>( pcm32.data() );
+      EXPECT_GT( pPcm32[0], INT32_MAX - 256 );
+      EXPECT_EQ( pPcm32[1], INT32_MIN );
+      PcmFormatConvert::convertPcm32ToPcm24( pcm32.data(), pcm24.data(), nSamples );
+      PcmFormatConvert::convertPcm24ToFloat( pcm24.data(), floatBuf.data(), nSamples );
+      float* pFloat = reinterpret_cast<float*>( floatBuf.data() );
+      for(int i=0; i<nSamples; i++){
+        EXPECT_NEAR( pFloat[i], pInFloat[i], 1.0f / 8388608.0f );
+      }
+    }
+  }
+
+  EXPECT_TRUE( PcmFormatConvert::setSimd( defaultSimd ) );
+}
+
+TEST_F(TestCase_Util, testPcmSamplingRateConverter)
+{
+  const int nSrcSamples = 4800;
+  const int srcRate = 48000;
+  const int dstRate = 44100;
+  std::vector<float> src(nSrcSamples*2);
+  for(int i=0; i<nSrcSamples; i++){
+    src[i*2] = 0.5f * std::sin( 2.0 * M_PI * 1000.0 * i / srcRate );
+    src[i*2+1] = 0.5f * std::sin( 2.0 * M_PI * 3000.0 * i / srcRate );
+  }
+
+  // whole at once
+  PcmSamplingRateConverter converter( AudioFormat::ENCODING::PCM_FLOAT, srcRate, dstRate, 2 );
+  EXPECT_TRUE( converter.isAvailable() );
+  std::vector<float> whole( converter.getMaxOutputSamples( nSrcSamples ) * 2 );
+  int nWholeSamples = converter.convert( reinterpret_cast<uint8_t*>(src.data()), reinterpret_cast<uint8_t*>(whole.data()), nSrcSamples );
+  EXPECT_NEAR( nWholeSamples, nSrcSamples * dstRate / srcRate, 1 );
+
+  // the output is same as the whole conversion even if it's split at any boundary
+  converter.reset();
+  std::vector<float> chunked;
+  for(int i=0, nChunk=1; i<nSrcSamples; i+=nChunk, nChunk=(nChunk*7+3)%500+1){
+    nChunk = std::min( nChunk, nSrcSamples-i );
+    std::vector<float> out( converter.getMaxOutputSamples( nChunk ) * 2 );
+    int nOutSamples = converter.convert( reinterpret_cast<uint8_t*>(src.data()+i*2), reinterpret_cast<uint8_t*>(out.data()), nChunk );
+    chunked.insert( chunked.end(), out.begin(), out.begin() + nOutSamples * 2 );
+  }
+  whole.resize( nWholeSamples * 2 );
+  EXPECT_EQ( chunked, whole );
+
+  // the output is the delayed input sampled at dstRate
+  double delay = ( 147.0 * 128.0 - 1.0 ) / ( 2.0 * 147.0 ); // (interpolation * taps - 1) / 2 / interpolation
+  for(int i=200; i<nWholeSamples; i++){
+    double t = ( (double)i * srcRate / dstRate - delay ) / srcRate;
+    EXPECT_NEAR( whole[i*2], 0.5 * std::sin( 2.0 * M_PI * 1000.0 * t ), 2.0e-3 );
+    EXPECT_NEAR( whole[i*2+1], 0.5 * std::sin( 2.0 * M_PI * 3000.0 * t ), 2.0e-3 );
+  }
+
+  // the integer pcm through AudioFormatAdaptor keeps the converter in the caller side
+  std::shared_ptr<PcmSamplingRateConverter> pConverter;
+  AudioBuffer srcBuf( AudioFormat( AudioFormat::ENCODING::PCM_16BIT, 16000, AudioFormat::CHANNEL::CHANNEL_STEREO ), 160 );
+  AudioBuffer dstBuf( AudioFormat( AudioFormat::ENCODING::PCM_16BIT, 48000, AudioFormat::CHANNEL::CHANNEL_STEREO ), 160 );
+  EXPECT_TRUE( AudioFormatAdaptor::convert( srcBuf, dstBuf, pConverter ) );
+  EXPECT_TRUE( pConverter != nullptr );
+  EXPECT_EQ( dstBuf.getNumberOfSamples(), 480 );
+  std::shared_ptr<PcmSamplingRateConverter> pPrevConverter = pConverter;
+  EXPECT_TRUE( AudioFormatAdaptor::convert( srcBuf, dstBuf, pConverter ) );
+  EXPECT_EQ( pConverter, pPrevConverter );
+}
+
+TEST_F(TestCase_Util, testChannelRemapper)
+{
+  const int nSamples = 64;
+
+  // 5.1ch 24bit -> stereo : L<-SL, R<-SR
+  AudioFormat srcFormat( AudioFormat::ENCODING::PCM_24BIT_PACKED, 48000, AudioFormat::CHANNEL::CHANNEL_5_1CH );
+  AudioBuffer srcBuf( srcFormat, nSamples );
+  uint8_t* pSrc = srcBuf.getRawBufferPointer();
+  for(int i=0; i<srcBuf.getRawBufferSize(); i++){
+    pSrc[i] = (uint8_t)(i * 7 + 1);
+  }
+  AudioFormat stereoFormat( AudioFormat::ENCODING::PCM_24BIT_PACKED, 48000, AudioFormat::CHANNEL::CHANNEL_STEREO );
+  AudioFormat::ChannelMapper mapper;
+  mapper.insert_or_assign( AudioFormat::CH::L, AudioFormat::CH::SL );
+  mapper.insert_or_assign( AudioFormat::CH::R, AudioFormat::CH::SR );
+  AudioBuffer stereoBuf = srcBuf.getSelectedChannelData( stereoFormat, mapper );
+  EXPECT_TRUE( stereoBuf.getAudioFormat().equal( stereoFormat ) );
+  EXPECT_EQ( stereoBuf.getNumberOfSamples(), nSamples );
+  uint8_t* pStereo = stereoBuf.getRawBufferPointer();
+  bool bMatched = true;
+  for(int i=0; i<nSamples; i++){
+    bMatched = bMatched && !memcmp( pStereo + i*6, pSrc + i*18 + 3*3, 3 ) && !memcmp( pStereo + i*6 + 3, pSrc + i*18 + 4*3, 3 );
+  }
+  EXPECT_TRUE( bMatched );
+
+  // 5.1ch 16bit -> 5.1ch : swap FL and FR. the unmapped channels are 0
+  AudioFormat format16( AudioFormat::ENCODING::PCM_16BIT, 48000, AudioFormat::CHANNEL::CHANNEL_5_1CH );
+  AudioBuffer srcBuf16( format16, nSamples );
+  int16_t* pSrc16 = reinterpret_cast<int16_t*>( srcBuf16.getRawBufferPointer() );
+  for(int i=0; i<nSamples*6; i++){
+    pSrc16[i] = (int16_t)( i + 1 );
+  }
+  AudioFormat::ChannelMapper swapMapper;
+  swapMapper.insert_or_assign( AudioFormat::CH::FL, AudioFormat::CH::FR );
+  swapMapper.insert_or_assign( AudioFormat::CH::FR, AudioFormat::CH::FL );
+  swapMapper.insert_or_assign( AudioFormat::CH::SW, AudioFormat::CH::SW );
+  ChannelRemapper remapper( format16, format16, swapMapper );
+  EXPECT_FALSE( remapper.isThrough() );
+  EXPECT_TRUE( remapper.isSameConfiguration( format16, format16, swapMapper ) );
+  EXPECT_FALSE( remapper.isSameConfiguration( format16, format16, mapper ) );
+  AudioBuffer dstBuf16;
+  remapper.process( srcBuf16, dstBuf16 );
+  EXPECT_EQ( dstBuf16.getNumberOfSamples(), nSamples );
+  int16_t* pDst16 = reinterpret_cast<int16_t*>( dstBuf16.getRawBufferPointer() );
+  bMatched = true;
+  for(int i=0; i<nSamples; i++){
+    int16_t* pIn = pSrc16 + i*6;
+    int16_t* pOut = pDst16 + i*6;
+    bMatched = bMatched && ( pOut[0] == pIn[2] ) && ( pOut[1] == 0 ) && ( pOut[2] == pIn[0] ) && ( pOut[3] == 0 ) && ( pOut[4] == 0 ) && ( pOut[5] == pIn[5] );
+  }
+  EXPECT_TRUE( bMatched );
+
+  // same channel map is just a copy
+  AudioFormat::ChannelMapper sameMapper = format16.getSameChannelMapper();
+  ChannelRemapper throughRemapper( format16, format16, sameMapper );
+  EXPECT_TRUE( throughRemapper.isThrough() );
+  throughRemapper.process( srcBuf16, dstBuf16 );
+  EXPECT_EQ( dstBuf16.getRawBuffer(), srcBuf16.getRawBuffer() );
+}
+
+TEST_F(TestCase_Util, testChannelConverterMatrix)
+{
+  // the mixed output channel never exceeds the full scale
+  for(int s=0; s<AudioFormat::CHANNEL::CHANNEL_UNKNOWN; s++){
+    for(int d=0; d<AudioFormat::CHANNEL::CHANNEL_UNKNOWN; d++){
+      const ChannelConverter::ChannelMatrix* pMatrix = ChannelConverter::getChannelMatrix( (AudioFormat::CHANNEL)s, (AudioFormat::CHANNEL)d );
+      if( pMatrix ){
+        for(int j=0; j<pMatrix->nDstChannels; j++){
+          float sum = 0.0f;
+          for(int i=0; i<pMatrix->nSrcChannels; i++){
+            sum += pMatrix->getGain( j, i );
+          }
+          EXPECT_LE( sum, 1.0f + 1.0e-6f );
+        }
+      }
+    }
+  }
+
+  // 5.1ch -> stereo : L = FL + 0.707C + 0.707SL + 0.5SW normalized. C and SW go to the both
+  const ChannelConverter::ChannelMatrix* pDownmix = ChannelConverter::getChannelMatrix( AudioFormat::CHANNEL::CHANNEL_5_1CH, AudioFormat::CHANNEL::CHANNEL_STEREO );
+  ASSERT_TRUE( pDownmix != nullptr );
+  EXPECT_FALSE( pDownmix->bRouting );
+  AudioBuffer srcBuf( AudioFormat( AudioFormat::ENCODING::PCM_FLOAT, 48000, AudioFormat::CHANNEL::CHANNEL_5_1CH ), 1 );
+  float* pSrc = reinterpret_cast<float*>( srcBuf.getRawBufferPointer() );
+  const float in[6] = { 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f }; // FL, C, FR, SL, SR, SW
+  memcpy( pSrc, in, sizeof(in) );
+  AudioBuffer dstBuf;
+  EXPECT_TRUE( ChannelConverter::channelConversion( srcBuf, dstBuf, AudioFormat::CHANNEL::CHANNEL_STEREO ) );
+  float* pDst = reinterpret_cast<float*>( dstBuf.getRawBufferPointer() );
+  float sum = 1.0f + 0.70710678f * 2 + 0.5f;
+  EXPECT_NEAR( pDst[0], ( in[0] + 0.70710678f * ( in[1] + in[3] ) + 0.5f * in[5] ) / sum, 1.0e-6f );
+  EXPECT_NEAR( pDst[1], ( in[2] + 0.70710678f * ( in[1] + in[4] ) + 0.5f * in[5] ) / sum, 1.0e-6f );
+
+  // the upmix is the exact copy
+  AudioBuffer monoBuf( AudioFormat( AudioFormat::ENCODING::PCM_32BIT, 48000, AudioFormat::CHANNEL::CHANNEL_MONO ), 16 );
+  int32_t* pMono = reinterpret_cast<int32_t*>( monoBuf.getRawBufferPointer() );
+  for(int i=0; i<16; i++){
+    pMono[i] = 0x7FFFFF01 - i * 0x10000001;
+  }
+  AudioBuffer stereoBuf;
+  EXPECT_TRUE( ChannelConverter::channelConversion( monoBuf, stereoBuf, AudioFormat::CHANNEL::CHANNEL_STEREO ) );
+  int32_t* pStereo = reinterpret_cast<int32_t*>( stereoBuf.getRawBufferPointer() );
+  for(int i=0; i<16; i++){
+    EXPECT_EQ( pStereo[i*2], pMono[i] );
+    EXPECT_EQ( pStereo[i*2+1], pMono[i] );
+  }
+
+  // the vector kernels are same as the scalar for every encoding and the tail
+  ChannelConverter::SIMD simd = ChannelConverter::getSimd();
+  const AudioFormat::ENCODING encodings[] = { AudioFormat::ENCODING::PCM_8BIT, AudioFormat::ENCODING::PCM_16BIT, AudioFormat::ENCODING::PCM_24BIT_PACKED, AudioFormat::ENCODING::PCM_32BIT, AudioFormat::ENCODING::PCM_FLOAT };
+  const ChannelConverter::ChannelMatrix* pMatrices[] = { pDownmix, ChannelConverter::getChannelMatrix( AudioFormat::CHANNEL::CHANNEL_7_1CH, AudioFormat::CHANNEL::CHANNEL_MONO ), ChannelConverter::getChannelMatrix( AudioFormat::CHANNEL::CHANNEL_STEREO, AudioFormat::CHANNEL::CHANNEL_5_1CH ) };
+  for(auto encoding : encodings){
+    for(auto pMatrix : pMatrices){
+      ASSERT_TRUE( pMatrix != nullptr );
+      int nSamples = 301;
+      int nSampleByte = AudioFormat::getSampleByte( encoding );
+      ByteBuffer src( nSamples * pMatrix->nSrcChannels * nSampleByte );
+      for(size_t i=0; i<src.size(); i++){
+        src[i] = (uint8_t)( i * 37 + 11 );
+      }
+      if( encoding == AudioFormat::ENCODING::PCM_FLOAT ){
+        float* pSrcF = reinterpret_cast<float*>( src.data() );
+        for(int i=0; i<nSamples * pMatrix->nSrcChannels; i++){
+          pSrcF[i] = std::sin( i * 0.1f );
+        }
+      }
+      ByteBuffer expected( nSamples * pMatrix->nDstChannels * nSampleByte );
+      ChannelConverter::setSimd( ChannelConverter::SIMD::SCALAR );
+      EXPECT_TRUE( ChannelConverter::mix( src.data(), expected.data(), encoding, *pMatrix, nSamples ) );
+      for(auto aSimd : { ChannelConverter::SIMD::SSE2, ChannelConverter::SIMD::AVX2 }){
+        if( ChannelConverter::setSimd( aSimd ) ){
+          ByteBuffer out( expected.size() );
+          EXPECT_TRUE( ChannelConverter::mix( src.data(), out.data(), encoding, *pMatrix, nSamples ) );
+          EXPECT_EQ( out, expected );
+        }
+      }
+    }
+  }
+  ChannelConverter::setSimd( simd );
+}
+
+TEST_F(TestCase_Util, testThreadPoolExecutor)
+{
+  std::shared_ptr<ThreadPoolExecutor> pExecutor = std::make_shared<ThreadPoolExecutor>(4);
+  EXPECT_EQ( 4, pExecutor->getNumberOfThreads() );
+  EXPECT_FALSE( pExecutor->isWorkerThread() );
+
+  // the tasks from the outside and the tasks from the workers which are stolen by the idle workers
+  const int nTasks = 1000;
+  std::atomic<int> nExecuted = 0;
+  std::atomic<int> nOnWorker = 0;
+  for(int i=0; i<nTasks; i++){
+    pExecutor->execute( [&](){
+      nOnWorker += pExecutor->isWorkerThread() ? 1 : 0;
+      pExecutor->execute( [&](){ nExecuted++; } );
+      nExecuted++;
+    } );
+  }
+  for(int i=0; i<1000 && nExecuted < nTasks*2; i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  EXPECT_EQ( nTasks*2, nExecuted );
+  EXPECT_EQ( nTasks, nOnWorker );
+
+  EXPECT_NE( nullptr, ThreadPoolExecutor::getDefaultExecutor() );
+  EXPECT_EQ( ThreadPoolExecutor::getDefaultExecutor(), ThreadPoolExecutor::getDefaultExecutor() );
+}
+
 TEST_F(TestCase_Util, testThreadBase)
 {
   class MyThread : public ThreadBase
@@ -151,6 +790,122 @@ TEST_F(TestCase_Util, testThreadBase)
   EXPECT_FALSE( pListenr->bIsRunning );
 }
 
+TEST_F(TestCase_Util, testThreadBaseStop)
+{
+  class FifoReader : public ThreadBase
+  {
+  public:
+    RingFifoBuffer mFifo;
+    std::atomic<int> mCount;
+    FifoReader():ThreadBase(), mCount(0){};
+    virtual ~FifoReader(){ stop(); };
+  protected:
+    virtual void process(void)
+    {
+      AudioBuffer buf( AudioFormat(), 256 );
+      while( mbIsRunning ){
+        mFifo.read( buf );
+        mCount++;
+      }
+    }
+    virtual void unlockToStop(void){ mFifo.unlock(); };
+  };
+
+  // stop() returns as soon as the blocked thread is unlocked instead of the polling
+  std::shared_ptr<FifoReader> pRunner = std::make_shared<FifoReader>();
+  auto start = std::chrono::steady_clock::now();
+  for(int i=0; i<200; i++){
+    pRunner->run();
+    EXPECT_TRUE( pRunner->isRunning() );
+    pRunner->stop();
+    EXPECT_FALSE( pRunner->isRunning() );
+  }
+  auto elapsedUsec = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+  std::cout << "200 run/stop : " << elapsedUsec << "usec" << std::endl;
+  EXPECT_LT( elapsedUsec, 1000000 );
+
+  // unlock() releases the blocked read only. the read after that blocks as usual.
+  AudioFormat defaultFormat;
+  RingFifoBuffer fifoBuf( defaultFormat );
+  AudioBuffer readBuf( defaultFormat, 256 );
+  AudioBuffer writeBuf( defaultFormat, 256 );
+  std::atomic<bool> bReturned = false;
+  std::thread blocked([&]{ fifoBuf.read( readBuf ); bReturned = true; });
+  std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  EXPECT_FALSE( bReturned );
+  fifoBuf.unlock();
+  blocked.join();
+  EXPECT_TRUE( bReturned );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), 0 );
+
+  bReturned = false;
+  std::thread reader([&]{ fifoBuf.read( readBuf ); bReturned = true; });
+  std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  EXPECT_FALSE( bReturned );
+  EXPECT_TRUE( fifoBuf.write( writeBuf ) );
+  reader.join();
+  EXPECT_TRUE( bReturned );
+  EXPECT_EQ( fifoBuf.getBufferedSamples(), 0 );
+}
+
+TEST_F(TestCase_Util, testThreadPolicy)
+{
+  class MyThread : public ThreadBase
+  {
+  public:
+    std::atomic<int> mCpu;
+    MyThread():mCpu(-1){};
+    virtual void process(void)
+    {
+#if __linux__
+      mCpu = sched_getcpu();
+#endif /* __linux__ */
+    }
+  };
+
+  // the default policy comes from ParameterManager
+  std::shared_ptr<ParameterManager> pParams = ParameterManager::getManager().lock();
+  EXPECT_TRUE( ThreadBase::getDefaultThreadPolicy().isDefault() );
+  pParams->setParameter( "thread.policy.scheduling", "fifo" );
+  pParams->setParameterInt( "thread.policy.priority", 80 );
+  pParams->setParameter( "thread.policy.affinity", "0,1" );
+  ThreadPolicy policy = ThreadBase::getDefaultThreadPolicy();
+  EXPECT_EQ( ThreadPolicy::SCHEDULING_FIFO, policy.scheduling );
+  EXPECT_EQ( 80, policy.priority );
+  EXPECT_EQ( std::vector<int>({0, 1}), policy.cpus );
+  EXPECT_FALSE( policy.bLockMemory );
+  pParams->setParameter( "thread.policy.scheduling", "default" );
+  pParams->setParameter( "thread.policy.affinity", "" );
+  EXPECT_TRUE( ThreadBase::getDefaultThreadPolicy().isDefault() );
+
+  // the global default and the per instance policy
+  ThreadBase::setDefaultThreadPolicy( ThreadPolicy( ThreadPolicy::SCHEDULING_RR, 10 ) );
+  std::shared_ptr<MyThread> pRunner = std::make_shared<MyThread>();
+  EXPECT_EQ( ThreadPolicy::SCHEDULING_RR, pRunner->getThreadPolicy().scheduling );
+  ThreadBase::resetDefaultThreadPolicy();
+  EXPECT_TRUE( pRunner->getThreadPolicy().isDefault() );
+
+  // the thread runs even if the policy can't be applied by the privilege
+  int nCpu = 0;
+#if __linux__
+  nCpu = sched_getcpu(); // the available cpu
+#endif /* __linux__ */
+  pRunner->setThreadPolicy( ThreadPolicy( ThreadPolicy::SCHEDULING_FIFO, 1, {nCpu} ) );
+  EXPECT_EQ( std::vector<int>({nCpu}), pRunner->getThreadPolicy().cpus );
+  pRunner->run();
+  for(int i=0; i<1000 && pRunner->isRunning(); i++){
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+  pRunner->stop();
+#if __linux__
+  EXPECT_EQ( nCpu, pRunner->mCpu );
+#endif /* __linux__ */
+  pRunner->resetThreadPolicy();
+  EXPECT_TRUE( pRunner->getThreadPolicy().isDefault() );
+
+  pParams->resetAllOfParams();
+}
+
 TEST_F(TestCase_Util, testPcmEncodingConversion)
 {
   int nSamples = 256;
@@ -230,7 +985,7 @@ TEST_F(TestCase_Util, testPcmChannelConversion)
   int nDstChannels = dstBuf.getAudioFormat().getNumberOfChannels();
 #if !defined(USE_TINY_CC_IMPL) || USE_TINY_CC_IMPL
   for(int i=0, c=srcBuf.getNumberOfSamples(); i<c; i++){
-    EXPECT_EQ( *(pRawSrcBuf+(int)(i*nSrcChannels+1)), *(pDstBuf+(int)(i*nDstChannels)) ); // R is used in the mono as current tentative impl. but the replaced impl. should be Ok not to follow.
+    EXPECT_NEAR( ( *(pRawSrcBuf+(int)(i*nSrcChannels)) + *(pRawSrcBuf+(int)(i*nSrcChannels+1)) ) / 2.0f, *(pDstBuf+(int)(i*nDstChannels)), 1.0f ); // (L+R)/2
   }
 #endif /* USE_TINY_CC_IMPL */
 
@@ -30,8 +30,20 @@ protected:
   void testStringTokenizer(void);
 
   void testFifoBuffer(void);
-
+  void testRingFifoBuffer(void);
+  void testHandoffFifoBuffer(void);
+  void testAudioBufferPool(void);
+  void testMixerPrimitive(void);
+  void testVolumePrimitive(void);
+  void testPcmFormatConvert(void);
+  void testPcmSamplingRateConverter(void);
+  void testChannelRemapper(void);
+  void testChannelConverterMatrix(void);
+
+  void testThreadPoolExecutor(void);
   void testThreadBase(void);
+  void testThreadBaseStop(void);
+  void testThreadPolicy(void);
 
   void testPcmEncodingConversion(void);
   void testPcmSamplingRateConversion(void);